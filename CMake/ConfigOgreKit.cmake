@@ -55,6 +55,7 @@ macro (configure_ogrekit ROOT OGREPATH OGRE_BACKEND)
 	option(OGREKIT_COMPILE_OPENSTEER		"Enable / Disable OpenSteer build" OFF)
 	option(OGREKIT_USE_PROCESSMANAGER       "Enable / Disable ProcessManager build" ON)
 	option(OGREKIT_COMPILE_SOFTBODY			"Enable / Disable Bullet Softbody build" OFF)
+	option(OGREKIT_BULLET_MULTITHREADED		"Allow stepping Bullet on worker threads (disables the Bullet profiler)" OFF)
 	option(OGREKIT_USE_NNODE				"Use Logic Node (It's Nodal Logic, not Blender LogicBrick)" OFF)
 	option(OGREKIT_USE_PARTICLE				"Use Paritcle" ON)
 	option(OGREKIT_COMPILE_OGRE_COMPONENTS	"Enable compile additional Ogre components (RTShader, Terrain, Paging, ... etc)" OFF)
@@ -400,6 +400,11 @@ void gkSteeringObject::measurePathCurvature (const float elapsedTime)
 
 bool gkSteeringObject::update(gkScalar tick)
 {
+	// throttled by activity culling
+	tick = m_obj->getActivityTick(tick);
+	if (tick <= 0)
+		return false;
+
 	if (!inGoal())
 	{
 		STATE newState = UNKNOWN;
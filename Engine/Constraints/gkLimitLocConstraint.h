@@ -57,6 +57,17 @@ public:
 
 	GK_INLINE void clearAxis(void) {m_flag[0] = m_flag[1] = 0;}
 
+	///Axis bits (x 1, y 2, z 4) set by the setMin / setMax calls.
+	GK_INLINE short getMinFlag(void) const {return m_flag[0];}
+	GK_INLINE short getMaxFlag(void) const {return m_flag[1];}
+
+	GK_INLINE gkScalar getMinX(void) const {return x[0];}
+	GK_INLINE gkScalar getMaxX(void) const {return x[1];}
+	GK_INLINE gkScalar getMinY(void) const {return y[0];}
+	GK_INLINE gkScalar getMaxY(void) const {return y[1];}
+	GK_INLINE gkScalar getMinZ(void) const {return z[0];}
+	GK_INLINE gkScalar getMaxZ(void) const {return z[1];}
+
 private:
 	short m_flag[2];
 
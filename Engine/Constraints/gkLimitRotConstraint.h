@@ -46,6 +46,14 @@ public:
 	GK_INLINE void setLimitZ(const gkVector2& v) {m_flag |= 4; mZBounds = v;}
 	GK_INLINE void clearAxis(void) {m_flag = 0;}
 
+	GK_INLINE bool hasLimitX(void) const {return (m_flag & 1) != 0;}
+	GK_INLINE bool hasLimitY(void) const {return (m_flag & 2) != 0;}
+	GK_INLINE bool hasLimitZ(void) const {return (m_flag & 4) != 0;}
+
+	GK_INLINE const gkVector2& getLimitX(void) const {return mXBounds;}
+	GK_INLINE const gkVector2& getLimitY(void) const {return mYBounds;}
+	GK_INLINE const gkVector2& getLimitZ(void) const {return mZBounds;}
+
 private:
 
 	short m_flag;
@@ -42,6 +42,7 @@ public:
 
 
 	GK_INLINE void setLimit(const gkVector2& v) {m_lim = v;}
+	GK_INLINE const gkVector2& getLimit(void) const {return m_lim;}
 
 private:
 	gkVector2 m_lim;
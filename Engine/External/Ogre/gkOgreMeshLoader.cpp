@@ -28,11 +28,17 @@
 #include "gkOgreMaterialLoader.h"
 #include "gkMesh.h"
 #include "gkSkeletonResource.h"
+#include "gkMeshSimplifier.h"
+#include "gkEngine.h"
+#include "gkUserDefs.h"
+#include "gkLogger.h"
 
 #include "OgreMesh.h"
 #include "OgreSubMesh.h"
 #include "OgreMeshManager.h"
 #include "OgreHardwareBufferManager.h"
+#include "OgreLodStrategyManager.h"
+#include "OgreLodStrategy.h"
 
 
 static const UTuint16 gk16BitClamp = (0xFFFF) - 1;
@@ -62,6 +68,128 @@ gkMeshLoader::~gkMeshLoader()
 
 
 
+void gkMeshLoader::fillIndexData(Ogre::IndexData* data, gkSubMesh::Triangles& tris, Ogre::HardwareIndexBuffer::IndexType type)
+{
+	UTsize iBufSize = tris.size() * 3;
+
+	Ogre::HardwareIndexBufferSharedPtr indexBuffer = Ogre::HardwareBufferManager::getSingleton().createIndexBuffer(type,
+	        iBufSize,
+	        Ogre::HardwareBuffer::HBU_STATIC_WRITE_ONLY);
+
+	//
+	data->indexStart = 0;
+	data->indexCount = iBufSize;
+	data->indexBuffer = indexBuffer;
+
+
+	// build index items
+	bool using32 = type == Ogre::HardwareIndexBuffer::IT_32BIT;
+
+	unsigned int* indices32 = 0;
+	unsigned short* indices16 = 0;
+
+	if (!using32)
+		indices16 = static_cast<unsigned short*>(indexBuffer->lock(Ogre::HardwareBuffer::HBL_NORMAL));
+	else
+		indices32 = static_cast<unsigned int*>(indexBuffer->lock(Ogre::HardwareBuffer::HBL_NORMAL));
+
+
+	UTsize iBufTot = tris.size();
+
+	gkTriangle* ibuf = tris.ptr();
+
+	for (UTsize cur = 0; cur < iBufTot; cur++)
+	{
+		const gkTriangle& i = ibuf[cur];
+		if (using32)
+		{
+			*indices32++ = (unsigned int)i.i0;
+			*indices32++ = (unsigned int)i.i1;
+			*indices32++ = (unsigned int)i.i2;
+		}
+		else
+		{
+			*indices16++ = (unsigned short)i.i0;
+			*indices16++ = (unsigned short)i.i1;
+			*indices16++ = (unsigned short)i.i2;
+		}
+	}
+	indexBuffer->unlock();
+}
+
+
+
+void gkMeshLoader::loadLodLevels(Ogre::Mesh* omesh)
+{
+	const gkUserDefs& defs = gkEngine::getSingleton().getUserDefs();
+
+	gkMesh::LodValues values = m_mesh->getLodValues();
+	if (values.empty())
+		gkMesh::parseLodValues(defs.meshLodValues, values);
+
+	gkScalar reduction = defs.meshLodReduction;
+	if (values.empty() || reduction <= 0.f || reduction >= 1.f || m_mesh->m_submeshes.empty())
+		return;
+
+
+	Ogre::LodStrategy* strategy = Ogre::LodStrategyManager::getSingleton().getStrategy(defs.meshLodStrategy);
+	if (!strategy)
+		strategy = Ogre::LodStrategyManager::getSingleton().getDefaultStrategy();
+
+
+	const unsigned short levels = (unsigned short)values.size();
+
+	omesh->_setLodInfo(levels + 1, false);
+	omesh->setLodStrategy(strategy);
+
+	unsigned short l;
+	for (l = 0; l < levels; ++l)
+	{
+		Ogre::MeshLodUsage usage;
+		usage.userValue = values[l];
+		usage.value = strategy->transformUserValue(values[l]);
+		usage.edgeData = 0;
+		omesh->_setLodUsage(l + 1, usage);
+	}
+
+
+	UTsize reduced = 0, total = 0;
+
+	for (unsigned short s = 0; s < (unsigned short)m_mesh->m_submeshes.size(); ++s)
+	{
+		gkSubMesh* gks = m_mesh->m_submeshes[s];
+
+		Ogre::HardwareIndexBuffer::IndexType buff_type = omesh->getSubMesh(s)->indexData->indexBuffer->getType();
+
+		gkMeshSimplifier simplifier(gks);
+		gkSubMesh::Triangles tris, last = gks->getIndexBuffer();
+
+		gkScalar target = (gkScalar)last.size();
+
+		for (l = 0; l < levels; ++l)
+		{
+			target *= reduction;
+			simplifier.simplify((UTsize)target, tris);
+
+			// nothing left to collapse, repeat the previous level
+			if (!tris.empty())
+				last = tris;
+
+			Ogre::IndexData* data = OGRE_NEW Ogre::IndexData();
+			fillIndexData(data, last, buff_type);
+			omesh->_setSubMeshLodFaceList(s, l + 1, data);
+		}
+
+		total += gks->getIndexBuffer().size();
+		reduced += last.size();
+	}
+
+	gkLogMessage("MeshLoader: " << m_mesh->getResourceName().getName() << " " << (levels + 1) << " LOD levels, "
+	             << total << " to " << reduced << " triangles.");
+}
+
+
+
 void gkMeshLoader::loadSubMesh(Ogre::SubMesh* submesh, gkSubMesh* gks)
 {
 	UTsize iBufSize = gks->getIndexBuffer().size() * 3, vBufSize = gks->getVertexBuffer().size();
@@ -123,50 +251,7 @@ void gkMeshLoader::loadSubMesh(Ogre::SubMesh* submesh, gkSubMesh* gks)
 	Ogre::HardwareIndexBuffer::IndexType buff_type = (iBufSize > gk16BitClamp) ?
 	        Ogre::HardwareIndexBuffer::IT_32BIT : Ogre::HardwareIndexBuffer::IT_16BIT;
 
-	Ogre::HardwareIndexBufferSharedPtr indexBuffer = Ogre::HardwareBufferManager::getSingleton().createIndexBuffer(buff_type,
-	        iBufSize,
-	        Ogre::HardwareBuffer::HBU_STATIC_WRITE_ONLY);
-
-	//
-	submesh->indexData->indexCount = iBufSize;
-	submesh->indexData->indexBuffer = indexBuffer;
-
-
-	// build index items
-	{
-		bool using32 = buff_type == Ogre::HardwareIndexBuffer::IT_32BIT;
-
-		unsigned int* indices32 = 0;
-		unsigned short* indices16 = 0;
-
-		if (!using32)
-			indices16 = static_cast<unsigned short*>(indexBuffer->lock(Ogre::HardwareBuffer::HBL_NORMAL));
-		else
-			indices32 = static_cast<unsigned int*>(indexBuffer->lock(Ogre::HardwareBuffer::HBL_NORMAL));
-
-
-		UTsize iBufTot = iBufSize / 3;
-
-		gkTriangle* ibuf = gks->getIndexBuffer().ptr();
-
-		for (UTsize cur = 0; cur < iBufTot; cur++)
-		{
-			const gkTriangle& i = ibuf[cur];
-			if (using32)
-			{
-				*indices32++ = (unsigned int)i.i0;
-				*indices32++ = (unsigned int)i.i1;
-				*indices32++ = (unsigned int)i.i2;
-			}
-			else
-			{
-				*indices16++ = (unsigned short)i.i0;
-				*indices16++ = (unsigned short)i.i1;
-				*indices16++ = (unsigned short)i.i2;
-			}
-		}
-		indexBuffer->unlock();
-	}
+	fillIndexData(submesh->indexData, gks->getIndexBuffer(), buff_type);
 
 	// build vertex items
 	{
@@ -311,4 +396,6 @@ void gkMeshLoader::loadResource(Ogre::Resource* res)
 	if (tangentLayer!=-1){
 		omesh->buildTangentVectors(Ogre::VES_TANGENT, tangentUV,tangentLayer, true, false, true);
 	}
+
+	loadLodLevels(omesh);
 }
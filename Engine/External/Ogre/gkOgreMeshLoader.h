@@ -28,9 +28,9 @@
 #define _gkOgreMeshLoader_h_
 
 #include "OgreResource.h"
+#include "OgreHardwareIndexBuffer.h"
 #include "utCommon.h"
-class gkMesh;
-class gkSubMesh;
+#include "gkMesh.h"
 
 
 
@@ -44,6 +44,11 @@ public:
 
 private:
 	void loadSubMesh(Ogre::SubMesh* submesh, gkSubMesh* gks);
+
+	///Generated detail levels, see gkMesh::setLodValues and gkUserDefs::meshLodValues.
+	void loadLodLevels(Ogre::Mesh* omesh);
+
+	static void fillIndexData(Ogre::IndexData* data, gkSubMesh::Triangles& tris, Ogre::HardwareIndexBuffer::IndexType type);
 	void loadResource(Ogre::Resource* res);
 
 	gkMesh* m_mesh;
@@ -0,0 +1,1116 @@
+/*
+-------------------------------------------------------------------------------
+    This file is part of OgreKit.
+    http://gamekit.googlecode.com/
+
+    Copyright (c) 2006-2013 Charlie C.
+
+    Contributor(s): none yet.
+-------------------------------------------------------------------------------
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#include "gkLogicBrickCooker.h"
+#include "Loaders/Blender2/gkBlendPackageDefs.h"
+#include "OgreKit.h"
+
+
+// Brick codes of the cooked format, append only.
+enum gkCookedBrickType
+{
+	CB_UNKNOWN = -1,
+
+	// actuators
+	CB_EDIT_OBJECT = 0,
+	CB_STATE,
+	CB_PROPERTY,
+	CB_MOTION,
+	CB_ACTION,
+	CB_GAME,
+	CB_VISIBILITY,
+	CB_MESSAGE_ACT,
+	CB_RANDOM_ACT,
+	CB_PARENT,
+	CB_SCENE,
+	CB_SOUND,
+
+	// controllers
+	CB_LOGIC_OP = 100,
+	CB_EXPRESSION,
+	CB_SCRIPT,
+
+	// sensors
+	CB_RAY = 200,
+	CB_RADAR,
+	CB_COLLISION,
+	CB_ALWAYS,
+	CB_PROPERTY_SENS,
+	CB_MOUSE,
+	CB_KEYBOARD,
+	CB_NEAR,
+	CB_JOYSTICK,
+	CB_RANDOM_SENS,
+	CB_DELAY,
+	CB_ACTUATOR,
+	CB_MESSAGE_SENS,
+};
+
+
+// Code of the bricks the logic converter creates, CB_UNKNOWN for any other.
+static int gkLogicBrickCooker_getType(gkLogicBrick* brick)
+{
+	if (dynamic_cast<gkEditObjectActuator*>(brick))  return CB_EDIT_OBJECT;
+	if (dynamic_cast<gkStateActuator*>(brick))       return CB_STATE;
+	if (dynamic_cast<gkPropertyActuator*>(brick))    return CB_PROPERTY;
+	if (dynamic_cast<gkMotionActuator*>(brick))      return CB_MOTION;
+	if (dynamic_cast<gkActionActuator*>(brick))      return CB_ACTION;
+	if (dynamic_cast<gkGameActuator*>(brick))        return CB_GAME;
+	if (dynamic_cast<gkVisibilityActuator*>(brick))  return CB_VISIBILITY;
+	if (dynamic_cast<gkMessageActuator*>(brick))     return CB_MESSAGE_ACT;
+	if (dynamic_cast<gkRandomActuator*>(brick))      return CB_RANDOM_ACT;
+	if (dynamic_cast<gkParentActuator*>(brick))      return CB_PARENT;
+	if (dynamic_cast<gkSceneActuator*>(brick))       return CB_SCENE;
+#ifdef OGREKIT_OPENAL_SOUND
+	if (dynamic_cast<gkSoundActuator*>(brick))       return CB_SOUND;
+#endif
+
+	if (dynamic_cast<gkLogicOpController*>(brick))   return CB_LOGIC_OP;
+#ifdef OGREKIT_USE_LUA
+	if (dynamic_cast<gkExpressionController*>(brick)) return CB_EXPRESSION;
+	if (dynamic_cast<gkScriptController*>(brick))    return CB_SCRIPT;
+#endif
+
+	// radar sensors are ray sensors too
+	if (dynamic_cast<gkRadarSensor*>(brick))         return CB_RADAR;
+	if (dynamic_cast<gkRaySensor*>(brick))           return CB_RAY;
+	if (dynamic_cast<gkCollisionSensor*>(brick))     return CB_COLLISION;
+	if (dynamic_cast<gkAlwaysSensor*>(brick))        return CB_ALWAYS;
+	if (dynamic_cast<gkPropertySensor*>(brick))      return CB_PROPERTY_SENS;
+	if (dynamic_cast<gkMouseSensor*>(brick))         return CB_MOUSE;
+	if (dynamic_cast<gkKeyboardSensor*>(brick))      return CB_KEYBOARD;
+	if (dynamic_cast<gkNearSensor*>(brick))          return CB_NEAR;
+	if (dynamic_cast<gkJoystickSensor*>(brick))      return CB_JOYSTICK;
+	if (dynamic_cast<gkRandomSensor*>(brick))        return CB_RANDOM_SENS;
+	if (dynamic_cast<gkDelaySensor*>(brick))         return CB_DELAY;
+	if (dynamic_cast<gkActuatorSensor*>(brick))      return CB_ACTUATOR;
+	if (dynamic_cast<gkMessageSensor*>(brick))       return CB_MESSAGE_SENS;
+
+	return CB_UNKNOWN;
+}
+
+
+
+static void gkLogicBrickCooker_writeBrick(utMemoryStream& stream, gkLogicBrick* brick, int type)
+{
+	gkCookedWrite(stream, type);
+	gkCookedWrite(stream, brick->getName());
+	gkCookedWrite(stream, brick->getMask());
+	gkCookedWrite(stream, brick->getDebugMask());
+	gkCookedWrite(stream, brick->getPriority());
+}
+
+
+static void gkLogicBrickCooker_writeActuator(utMemoryStream& stream, gkLogicActuator* la)
+{
+	int type = gkLogicBrickCooker_getType(la);
+	gkLogicBrickCooker_writeBrick(stream, la, type);
+
+	switch (type)
+	{
+	case CB_EDIT_OBJECT:
+		{
+			gkEditObjectActuator* ea = static_cast<gkEditObjectActuator*>(la);
+			gkCookedWrite(stream, ea->getMode());
+			gkCookedWrite(stream, ea->getDynMode());
+			gkCookedWrite(stream, ea->getObject());
+			gkCookedWrite(stream, ea->getLinV());
+			gkCookedWrite(stream, ea->getLinVL());
+			gkCookedWrite(stream, ea->getAngV());
+			gkCookedWrite(stream, ea->getAngVL());
+			gkCookedWrite(stream, ea->getLifeSpan());
+		} break;
+	case CB_STATE:
+		{
+			gkStateActuator* sa = static_cast<gkStateActuator*>(la);
+			gkCookedWrite(stream, sa->getOp());
+			gkCookedWrite(stream, sa->getMask());
+		} break;
+	case CB_PROPERTY:
+		{
+			gkPropertyActuator* pa = static_cast<gkPropertyActuator*>(la);
+			gkCookedWrite(stream, pa->getType());
+			gkCookedWrite(stream, pa->getProperty());
+			gkCookedWrite(stream, pa->getValue());
+			gkCookedWrite(stream, pa->getObject());
+		} break;
+	case CB_MOTION:
+		{
+			gkMotionActuator* ma = static_cast<gkMotionActuator*>(la);
+			gkCookedWrite(stream, ma->getType());
+			gkCookedWrite(stream, ma->getTranslation());
+			gkCookedWrite(stream, ma->isTranslationLocal());
+			gkCookedWrite(stream, ma->getRotation());
+			gkCookedWrite(stream, ma->isRotationLocal());
+			gkCookedWrite(stream, ma->getForce());
+			gkCookedWrite(stream, ma->isForceLocal());
+			gkCookedWrite(stream, ma->getTorque());
+			gkCookedWrite(stream, ma->isTorqueLocal());
+			gkCookedWrite(stream, ma->getLinearVelocity());
+			gkCookedWrite(stream, ma->isLinearVelocityLocal());
+			gkCookedWrite(stream, ma->getAngularVelocity());
+			gkCookedWrite(stream, ma->isAngularVelocityLocal());
+			gkCookedWrite(stream, ma->getIncrementalVelocity());
+			gkCookedWrite(stream, ma->getDamping());
+		} break;
+	case CB_ACTION:
+		{
+			gkActionActuator* aa = static_cast<gkActionActuator*>(la);
+			gkCookedWrite(stream, aa->getStart());
+			gkCookedWrite(stream, aa->getEnd());
+			gkCookedWrite(stream, aa->getBlend());
+			gkCookedWrite(stream, aa->getMode());
+			gkCookedWrite(stream, aa->getPriority());
+			gkCookedWrite(stream, aa->getReset());
+			gkCookedWrite(stream, aa->getAnimation());
+			gkCookedWrite(stream, aa->getProperty());
+		} break;
+	case CB_GAME:
+		{
+			gkGameActuator* ga = static_cast<gkGameActuator*>(la);
+			gkCookedWrite(stream, ga->getMode());
+			gkCookedWrite(stream, ga->getGameFile());
+		} break;
+	case CB_VISIBILITY:
+		{
+			gkCookedWrite(stream, static_cast<gkVisibilityActuator*>(la)->getFlag());
+		} break;
+	case CB_MESSAGE_ACT:
+		{
+			gkMessageActuator* ma = static_cast<gkMessageActuator*>(la);
+			gkCookedWrite(stream, ma->getTo());
+			gkCookedWrite(stream, ma->getSubject());
+			gkCookedWrite(stream, ma->getBodyType());
+			gkCookedWrite(stream, ma->getBodyText());
+			gkCookedWrite(stream, ma->getBodyProperty());
+		} break;
+	case CB_RANDOM_ACT:
+		{
+			gkRandomActuator* ra = static_cast<gkRandomActuator*>(la);
+			gkCookedWrite(stream, ra->getSeed());
+			gkCookedWrite(stream, ra->getDistribution());
+			gkCookedWrite(stream, ra->getProperty());
+			gkCookedWrite(stream, ra->getMin());
+			gkCookedWrite(stream, ra->getMax());
+			gkCookedWrite(stream, ra->getConstant());
+			gkCookedWrite(stream, ra->getMean());
+			gkCookedWrite(stream, ra->getDeviation());
+			gkCookedWrite(stream, ra->getHalfLife());
+		} break;
+	case CB_PARENT:
+		{
+			gkParentActuator* pa = static_cast<gkParentActuator*>(la);
+			gkCookedWrite(stream, pa->getMode());
+			gkCookedWrite(stream, pa->getParent());
+			gkCookedWrite(stream, pa->getCompound());
+			gkCookedWrite(stream, pa->getGhost());
+		} break;
+	case CB_SCENE:
+		{
+			gkSceneActuator* sa = static_cast<gkSceneActuator*>(la);
+			gkCookedWrite(stream, sa->getMode());
+			gkCookedWrite(stream, sa->getScene());
+			gkCookedWrite(stream, sa->getCamera());
+		} break;
+#ifdef OGREKIT_OPENAL_SOUND
+	case CB_SOUND:
+		{
+			gkSoundActuator* sa = static_cast<gkSoundActuator*>(la);
+			gkSoundProperties& props = sa->getProperties();
+			gkCookedWrite(stream, sa->getMode());
+			gkCookedWrite(stream, sa->getSoundFile());
+			gkCookedWrite(stream, props.m_volume);
+			gkCookedWrite(stream, props.m_pitch);
+			gkCookedWrite(stream, props.m_3dSound);
+			gkCookedWrite(stream, props.m_gainClamp);
+			gkCookedWrite(stream, props.m_refDistance);
+			gkCookedWrite(stream, props.m_maxDistance);
+			gkCookedWrite(stream, props.m_rolloff);
+			gkCookedWrite(stream, props.m_coneAngle);
+			gkCookedWrite(stream, props.m_coneOuterGain);
+		} break;
+#endif
+	}
+}
+
+
+static void gkLogicBrickCooker_writeController(utMemoryStream& stream, gkLogicController* lc)
+{
+	int type = gkLogicBrickCooker_getType(lc);
+	gkLogicBrickCooker_writeBrick(stream, lc, type);
+
+	switch (type)
+	{
+	case CB_LOGIC_OP:
+		{
+			gkCookedWrite(stream, static_cast<gkLogicOpController*>(lc)->getOp());
+		} break;
+#ifdef OGREKIT_USE_LUA
+	case CB_EXPRESSION:
+		{
+			gkExpressionController* ec = static_cast<gkExpressionController*>(lc);
+			gkCookedWrite(stream, ec->isModule());
+			gkCookedWrite(stream, ec->getExpression());
+		} break;
+	case CB_SCRIPT:
+		{
+			gkScriptController* sc = static_cast<gkScriptController*>(lc);
+			gkCookedWrite(stream, sc->isModule());
+			gkCookedWrite(stream, sc->getScript() ? sc->getScript()->getName() : gkString());
+		} break;
+#endif
+	}
+
+	gkActuators& acts = lc->getActuators();
+	gkCookedWrite(stream, (UTuint32)acts.size());
+	for (UTsize i = 0; i < acts.size(); ++i)
+	{
+		gkCookedWrite(stream, acts[i]->getObject()->getName());
+		gkCookedWrite(stream, acts[i]->getName());
+	}
+}
+
+
+static void gkLogicBrickCooker_writeSensor(utMemoryStream& stream, gkLogicSensor* ls)
+{
+	int type = gkLogicBrickCooker_getType(ls);
+	gkLogicBrickCooker_writeBrick(stream, ls, type);
+
+	gkCookedWrite(stream, ls->isDetector());
+	gkCookedWrite(stream, ls->isTap());
+	gkCookedWrite(stream, ls->getFrequency());
+	gkCookedWrite(stream, ls->isInverse());
+	gkCookedWrite(stream, ls->getMode());
+
+	switch (type)
+	{
+	case CB_RAY:
+	case CB_RADAR:
+		{
+			gkRaySensor* rs = static_cast<gkRaySensor*>(ls);
+			gkCookedWrite(stream, rs->getRange());
+			gkCookedWrite(stream, rs->getAxis());
+			gkCookedWrite(stream, rs->getMaterial());
+			gkCookedWrite(stream, rs->getProperty());
+			gkCookedWrite(stream, rs->getXray());
+
+			if (type == CB_RADAR)
+				gkCookedWrite(stream, static_cast<gkRadarSensor*>(ls)->getAngle());
+		} break;
+	case CB_COLLISION:
+		{
+			gkCollisionSensor* cs = static_cast<gkCollisionSensor*>(ls);
+			gkCookedWrite(stream, cs->getMaterial());
+			gkCookedWrite(stream, cs->getProperty());
+		} break;
+	case CB_PROPERTY_SENS:
+		{
+			gkPropertySensor* ps = static_cast<gkPropertySensor*>(ls);
+			gkCookedWrite(stream, ps->getType());
+			gkCookedWrite(stream, ps->getProperty());
+			gkCookedWrite(stream, ps->getValue());
+			gkCookedWrite(stream, ps->getMaxValue());
+		} break;
+	case CB_MOUSE:
+		{
+			gkCookedWrite(stream, static_cast<gkMouseSensor*>(ls)->getType());
+		} break;
+	case CB_KEYBOARD:
+		{
+			gkKeyboardSensor* ks = static_cast<gkKeyboardSensor*>(ls);
+			gkCookedWrite(stream, ks->getKey());
+			gkCookedWrite(stream, ks->getMod0());
+			gkCookedWrite(stream, ks->getMod1());
+			gkCookedWrite(stream, ks->getAllKeys());
+		} break;
+	case CB_NEAR:
+		{
+			gkNearSensor* ns = static_cast<gkNearSensor*>(ls);
+			gkCookedWrite(stream, ns->getRange());
+			gkCookedWrite(stream, ns->getResetRange());
+			gkCookedWrite(stream, ns->getMaterial());
+			gkCookedWrite(stream, ns->getProperty());
+		} break;
+	case CB_JOYSTICK:
+		{
+			gkJoystickSensor* js = static_cast<gkJoystickSensor*>(ls);
+			gkCookedWrite(stream, js->getJoystickIndex());
+			gkCookedWrite(stream, js->getElementIndex());
+			gkCookedWrite(stream, js->getAxisThreshold());
+			gkCookedWrite(stream, js->getAllElementEvents());
+			gkCookedWrite(stream, js->getEventType());
+			gkCookedWrite(stream, js->getAxisDirection());
+		} break;
+	case CB_RANDOM_SENS:
+		{
+			gkCookedWrite(stream, static_cast<gkRandomSensor*>(ls)->getSeed());
+		} break;
+	case CB_DELAY:
+		{
+			gkDelaySensor* ds = static_cast<gkDelaySensor*>(ls);
+			gkCookedWrite(stream, ds->getDelay());
+			gkCookedWrite(stream, ds->getDuration());
+			gkCookedWrite(stream, ds->getRepeat());
+		} break;
+	case CB_ACTUATOR:
+		{
+			gkCookedWrite(stream, static_cast<gkActuatorSensor*>(ls)->getActuatorName());
+		} break;
+	case CB_MESSAGE_SENS:
+		{
+			gkCookedWrite(stream, static_cast<gkMessageSensor*>(ls)->getSubject());
+		} break;
+	}
+
+	gkControllers& conts = ls->getControllers();
+	gkCookedWrite(stream, (UTuint32)conts.size());
+	for (UTsize i = 0; i < conts.size(); ++i)
+	{
+		gkCookedWrite(stream, conts[i]->getObject()->getName());
+		gkCookedWrite(stream, conts[i]->getName());
+	}
+}
+
+
+
+gkLogicBrickCooker::gkLogicBrickCooker(gkScene* scene)
+	:	m_scene(scene)
+{
+	GK_ASSERT(m_scene);
+}
+
+
+gkLogicBrickCooker::~gkLogicBrickCooker()
+{
+}
+
+
+bool gkLogicBrickCooker::canWrite(gkGameObject* gobj)
+{
+	gkLogicLink* lnk = gobj->getLogicBricks();
+	if (!lnk)
+		return true;
+
+	gkLogicLink::BrickList* lists[3] = {&lnk->getActuators(), &lnk->getControllers(), &lnk->getSensors()};
+	for (int i = 0; i < 3; ++i)
+	{
+		utListIterator<gkLogicLink::BrickList> it(*lists[i]);
+		while (it.hasMoreElements())
+		{
+			if (gkLogicBrickCooker_getType(it.getNext()) == CB_UNKNOWN)
+				return false;
+		}
+	}
+	return true;
+}
+
+
+void gkLogicBrickCooker::write(gkGameObject* gobj, utMemoryStream& stream)
+{
+	gkLogicLink* lnk = gobj->getLogicBricks();
+	GK_ASSERT(lnk && canWrite(gobj));
+
+	gkCookedWrite(stream, lnk->getState());
+	gkCookedWrite(stream, gobj->getState());
+
+	// same order as gkLogicLoader creates them
+	gkCookedWrite(stream, (UTuint32)lnk->getActuators().size());
+	utListIterator<gkLogicLink::BrickList> acts(lnk->getActuators());
+	while (acts.hasMoreElements())
+		gkLogicBrickCooker_writeActuator(stream, static_cast<gkLogicActuator*>(acts.getNext()));
+
+	gkCookedWrite(stream, (UTuint32)lnk->getControllers().size());
+	utListIterator<gkLogicLink::BrickList> conts(lnk->getControllers());
+	while (conts.hasMoreElements())
+		gkLogicBrickCooker_writeController(stream, static_cast<gkLogicController*>(conts.getNext()));
+
+	gkCookedWrite(stream, (UTuint32)lnk->getSensors().size());
+	utListIterator<gkLogicLink::BrickList> sens(lnk->getSensors());
+	while (sens.hasMoreElements())
+		gkLogicBrickCooker_writeSensor(stream, static_cast<gkLogicSensor*>(sens.getNext()));
+}
+
+
+
+bool gkLogicBrickCooker::read(gkGameObject* gobj, gkCookedReader& reader)
+{
+	GK_ASSERT(gobj && !gobj->getLogicBricks());
+
+	ObjectState ostate = {gobj, 0, 0};
+	reader.read(ostate.m_linkState);
+	reader.read(ostate.m_state);
+	if (!reader.ok())
+		return false;
+
+	gkLogicLink* lnk = m_scene->getLogicBrickManager()->createLink();
+	lnk->setState(ostate.m_linkState);
+	gobj->setState(ostate.m_state);
+	lnk->setObject(gobj);
+	gobj->attachLogic(lnk);
+	m_objects.push_back(ostate);
+
+	const gkString& groupName = gobj->getGroupName();
+
+	UTuint32 count = 0, i, j;
+
+	reader.readCount(count);
+	for (i = 0; i < count && reader.ok(); ++i)
+	{
+		BrickState bstate;
+		int type = CB_UNKNOWN;
+		gkString name;
+		reader.read(type);
+		reader.read(name);
+		reader.read(bstate.m_mask);
+		reader.read(bstate.m_debugMask);
+		reader.read(bstate.m_priority);
+
+		gkLogicActuator* la = 0;
+		switch (type)
+		{
+		case CB_EDIT_OBJECT:
+			{
+				gkEditObjectActuator* ea = new gkEditObjectActuator(gobj, lnk, name);
+				la = ea;
+
+				int mode = 0, dyn = 0, life = 0;
+				gkString object;
+				gkVector3 linv, angv;
+				bool linvl = false, angvl = false;
+				reader.read(mode);
+				reader.read(dyn);
+				reader.read(object);
+				reader.read(linv);
+				reader.read(linvl);
+				reader.read(angv);
+				reader.read(angvl);
+				reader.read(life);
+
+				ea->setMode(mode);
+				ea->setDynMode(dyn);
+				ea->setObject(object);
+				ea->setLinV(linv);
+				ea->setLinVL(linvl);
+				ea->setAngV(angv);
+				ea->setAngVL(angvl);
+				ea->setLifeSpan(life);
+			} break;
+		case CB_STATE:
+			{
+				gkStateActuator* sa = new gkStateActuator(gobj, lnk, name);
+				la = sa;
+
+				int op = 0, mask = 0;
+				reader.read(op);
+				reader.read(mask);
+				sa->setOp(op);
+				sa->setMask(mask);
+			} break;
+		case CB_PROPERTY:
+			{
+				gkPropertyActuator* pa = new gkPropertyActuator(gobj, lnk, name);
+				la = pa;
+
+				int op = 0;
+				gkString prop, value, object;
+				reader.read(op);
+				reader.read(prop);
+				reader.read(value);
+				reader.read(object);
+				pa->setType(op);
+				pa->setProperty(prop);
+				pa->setValue(value);
+				pa->setObject(object);
+			} break;
+		case CB_MOTION:
+			{
+				gkMotionActuator* ma = new gkMotionActuator(gobj, lnk, name);
+				la = ma;
+
+				int mtype = 0;
+				gkVector3 v;
+				bool local = false, inc = false;
+				gkScalar damping = 0;
+
+				reader.read(mtype);
+				ma->setType(mtype);
+				reader.read(v); reader.read(local); ma->setTranslation(v, local);
+				reader.read(v); reader.read(local); ma->setRotation(v, local);
+				reader.read(v); reader.read(local); ma->setForce(v, local);
+				reader.read(v); reader.read(local); ma->setTorque(v, local);
+				reader.read(v); reader.read(local); ma->setLinearVelocity(v, local);
+				reader.read(v); reader.read(local); ma->setAngularVelocity(v, local);
+				reader.read(inc);
+				reader.read(damping);
+				ma->setIncrementalVelocity(inc);
+				ma->setDamping(damping);
+			} break;
+		case CB_ACTION:
+			{
+				gkActionActuator* aa = new gkActionActuator(gobj, lnk, name);
+				la = aa;
+
+				int start = 0, end = 0, mode = 0, prio = 0;
+				gkScalar blend = 0;
+				bool reset = false;
+				gkString anim, prop;
+				reader.read(start);
+				reader.read(end);
+				reader.read(blend);
+				reader.read(mode);
+				reader.read(prio);
+				reader.read(reset);
+				reader.read(anim);
+				reader.read(prop);
+
+				aa->setStart(start);
+				aa->setEnd(end);
+				aa->setBlend(blend);
+				aa->setMode(mode);
+				aa->setPriority(prio);
+				aa->setReset(reset);
+				aa->setAnimation(anim);
+				aa->setProperty(prop);
+			} break;
+		case CB_GAME:
+			{
+				gkGameActuator* ga = new gkGameActuator(gobj, lnk, name);
+				la = ga;
+
+				int mode = 0;
+				gkString file;
+				reader.read(mode);
+				reader.read(file);
+				ga->setMode(mode);
+				ga->setGameFile(file);
+			} break;
+		case CB_VISIBILITY:
+			{
+				gkVisibilityActuator* va = new gkVisibilityActuator(gobj, lnk, name);
+				la = va;
+
+				int flag = 0;
+				reader.read(flag);
+				va->setFlag(flag);
+			} break;
+		case CB_MESSAGE_ACT:
+			{
+				gkMessageActuator* ma = new gkMessageActuator(gobj, lnk, name);
+				la = ma;
+
+				gkString to, subject, text, prop;
+				int body = 0;
+				reader.read(to);
+				reader.read(subject);
+				reader.read(body);
+				reader.read(text);
+				reader.read(prop);
+				ma->setTo(to);
+				ma->setSubject(subject);
+				ma->setBodyType(body);
+				ma->setBodyText(text);
+				ma->setBodyProperty(prop);
+			} break;
+		case CB_RANDOM_ACT:
+			{
+				gkRandomActuator* ra = new gkRandomActuator(gobj, lnk, name);
+				la = ra;
+
+				int seed = 0, dist = 0;
+				gkString prop;
+				float vmin = 0, vmax = 0, constant = 0, mean = 0, deviation = 0, halflife = 0;
+				reader.read(seed);
+				reader.read(dist);
+				reader.read(prop);
+				reader.read(vmin);
+				reader.read(vmax);
+				reader.read(constant);
+				reader.read(mean);
+				reader.read(deviation);
+				reader.read(halflife);
+
+				ra->setSeed(seed);
+				ra->setDistribution(dist);
+				ra->setProperty(prop);
+				ra->setMin(vmin);
+				ra->setMax(vmax);
+				ra->setConstant(constant);
+				ra->setMean(mean);
+				ra->setDeviation(deviation);
+				ra->setHalfLife(halflife);
+			} break;
+		case CB_PARENT:
+			{
+				gkParentActuator* pa = new gkParentActuator(gobj, lnk, name);
+				la = pa;
+
+				int mode = 0;
+				gkString parent;
+				bool compound = false, ghost = false;
+				reader.read(mode);
+				reader.read(parent);
+				reader.read(compound);
+				reader.read(ghost);
+				pa->setMode(mode);
+				pa->setParent(parent);
+				pa->setCompound(compound);
+				pa->setGhost(ghost);
+			} break;
+		case CB_SCENE:
+			{
+				gkSceneActuator* sa = new gkSceneActuator(gobj, lnk, name);
+				la = sa;
+
+				int mode = 0;
+				gkString scene, camera;
+				reader.read(mode);
+				reader.read(scene);
+				reader.read(camera);
+				sa->setMode(mode);
+				sa->setScene(scene);
+				sa->setCamera(camera);
+			} break;
+		case CB_SOUND:
+			{
+				int mode = 0;
+				gkString file;
+				gkScalar volume = 1, pitch = 0, refDistance = 1, maxDistance = 0, rolloff = 1, coneOuterGain = 0;
+				bool sound3d = false;
+				gkVector2 gainClamp, coneAngle;
+				reader.read(mode);
+				reader.read(file);
+				reader.read(volume);
+				reader.read(pitch);
+				reader.read(sound3d);
+				reader.read(gainClamp);
+				reader.read(refDistance);
+				reader.read(maxDistance);
+				reader.read(rolloff);
+				reader.read(coneAngle);
+				reader.read(coneOuterGain);
+
+#ifdef OGREKIT_OPENAL_SOUND
+				gkSoundActuator* sa = new gkSoundActuator(gobj, lnk, name);
+				la = sa;
+
+				gkSoundProperties& props = sa->getProperties();
+				props.m_volume        = volume;
+				props.m_pitch         = pitch;
+				props.m_3dSound       = sound3d;
+				props.m_gainClamp     = gainClamp;
+				props.m_refDistance   = refDistance;
+				props.m_maxDistance   = maxDistance;
+				props.m_rolloff       = rolloff;
+				props.m_coneAngle     = coneAngle;
+				props.m_coneOuterGain = coneOuterGain;
+
+				sa->setMode(mode);
+				sa->setSoundFile(file);
+#endif
+			} break;
+		default:
+			return false;
+		}
+
+		if (la)
+		{
+			bstate.m_brick = la;
+			m_bricks.push_back(bstate);
+			lnk->push(la);
+		}
+	}
+
+
+	reader.readCount(count);
+	for (i = 0; i < count && reader.ok(); ++i)
+	{
+		BrickState bstate;
+		int type = CB_UNKNOWN;
+		gkString name;
+		reader.read(type);
+		reader.read(name);
+		reader.read(bstate.m_mask);
+		reader.read(bstate.m_debugMask);
+		reader.read(bstate.m_priority);
+
+		gkLogicController* lc = 0;
+		switch (type)
+		{
+		case CB_LOGIC_OP:
+			{
+				gkLogicOpController* oc = new gkLogicOpController(gobj, lnk, name);
+				lc = oc;
+
+				int op = 0;
+				reader.read(op);
+				oc->setOp(op);
+			} break;
+		case CB_EXPRESSION:
+			{
+				bool module = false;
+				gkString expr;
+				reader.read(module);
+				reader.read(expr);
+
+#ifdef OGREKIT_USE_LUA
+				gkExpressionController* ec = new gkExpressionController(gobj, lnk, name);
+				lc = ec;
+
+				ec->setModule(module);
+				if (!expr.empty())
+					ec->setExpression(expr);
+#endif
+			} break;
+		case CB_SCRIPT:
+			{
+				bool module = false;
+				gkString script;
+				reader.read(module);
+				reader.read(script);
+
+#ifdef OGREKIT_USE_LUA
+				gkScriptController* sc = new gkScriptController(gobj, lnk, name);
+				lc = sc;
+
+				sc->setModule(module);
+				if (!script.empty())
+				{
+					gkLuaManager& lua = gkLuaManager::getSingleton();
+					gkResourceName scriptName(script, groupName);
+					if (lua.exists(scriptName))
+						sc->setScript(lua.getByName<gkLuaScript>(scriptName));
+					else
+						sc->setScript(lua.create<gkLuaScript>(scriptName));
+				}
+#endif
+			} break;
+		default:
+			return false;
+		}
+
+		UTuint32 links = 0;
+		reader.readCount(links, 2 * sizeof(UTuint32));
+		for (j = 0; j < links && reader.ok(); ++j)
+		{
+			ControllerLink link;
+			reader.read(link.m_object);
+			reader.read(link.m_actuator);
+
+			if (lc)
+			{
+				link.m_controller = lc;
+				m_controllerLinks.push_back(link);
+			}
+		}
+
+		if (lc)
+		{
+			bstate.m_brick = lc;
+			m_bricks.push_back(bstate);
+			lnk->push(lc);
+		}
+	}
+
+
+	reader.readCount(count);
+	for (i = 0; i < count && reader.ok(); ++i)
+	{
+		BrickState bstate;
+		int type = CB_UNKNOWN;
+		gkString name;
+		reader.read(type);
+		reader.read(name);
+		reader.read(bstate.m_mask);
+		reader.read(bstate.m_debugMask);
+		reader.read(bstate.m_priority);
+
+		bool detector = false, tap = false, inverse = false;
+		int freq = 0, mode = 0;
+		reader.read(detector);
+		reader.read(tap);
+		reader.read(freq);
+		reader.read(inverse);
+		reader.read(mode);
+
+		gkLogicSensor* ls = 0;
+		switch (type)
+		{
+		case CB_RAY:
+		case CB_RADAR:
+			{
+				gkRaySensor* rs;
+				if (type == CB_RADAR)
+					rs = new gkRadarSensor(gobj, lnk, name);
+				else
+					rs = new gkRaySensor(gobj, lnk, name);
+				ls = rs;
+
+				gkScalar range = 0;
+				int axis = 0;
+				gkString material, prop;
+				bool xray = false;
+				reader.read(range);
+				reader.read(axis);
+				reader.read(material);
+				reader.read(prop);
+				reader.read(xray);
+
+				rs->setRange(range);
+				rs->setAxis(axis);
+				if (!material.empty())
+					rs->setMaterial(material);
+				if (!prop.empty())
+					rs->setProperty(prop);
+				rs->setXray(xray);
+
+				if (type == CB_RADAR)
+				{
+					gkScalar angle = 0;
+					reader.read(angle);
+					static_cast<gkRadarSensor*>(rs)->setAngle(angle);
+				}
+			} break;
+		case CB_COLLISION:
+			{
+				gkCollisionSensor* cs = new gkCollisionSensor(gobj, lnk, name);
+				ls = cs;
+
+				gkString material, prop;
+				reader.read(material);
+				reader.read(prop);
+				cs->setMaterial(material);
+				cs->setProperty(prop);
+			} break;
+		case CB_ALWAYS:
+			{
+				ls = new gkAlwaysSensor(gobj, lnk, name);
+			} break;
+		case CB_PROPERTY_SENS:
+			{
+				gkPropertySensor* ps = new gkPropertySensor(gobj, lnk, name);
+				ls = ps;
+
+				int ptype = 0;
+				gkString prop, value, maxValue;
+				reader.read(ptype);
+				reader.read(prop);
+				reader.read(value);
+				reader.read(maxValue);
+				ps->setType(ptype);
+				ps->setProperty(prop);
+				ps->setValue(value);
+				ps->setMaxValue(maxValue);
+			} break;
+		case CB_MOUSE:
+			{
+				gkMouseSensor* ms = new gkMouseSensor(gobj, lnk, name);
+				ls = ms;
+
+				int mtype = 0;
+				reader.read(mtype);
+				ms->setType(mtype);
+			} break;
+		case CB_KEYBOARD:
+			{
+				gkKeyboardSensor* ks = new gkKeyboardSensor(gobj, lnk, name);
+				ls = ks;
+
+				int key = 0, mod0 = 0, mod1 = 0;
+				bool all = false;
+				reader.read(key);
+				reader.read(mod0);
+				reader.read(mod1);
+				reader.read(all);
+				ks->setKey(key);
+				ks->setMod0(mod0);
+				ks->setMod1(mod1);
+				ks->setAllKeys(all);
+			} break;
+		case CB_NEAR:
+			{
+				gkNearSensor* ns = new gkNearSensor(gobj, lnk, name);
+				ls = ns;
+
+				gkScalar range = 0, resetRange = 0;
+				gkString material, prop;
+				reader.read(range);
+				reader.read(resetRange);
+				reader.read(material);
+				reader.read(prop);
+
+				ns->setRange(range);
+				ns->setResetRange(resetRange);
+				if (!material.empty())
+					ns->setMaterial(material);
+				if (!prop.empty())
+					ns->setProperty(prop);
+			} break;
+		case CB_JOYSTICK:
+			{
+				gkJoystickSensor* js = new gkJoystickSensor(gobj, lnk, name);
+				ls = js;
+
+				unsigned int joystick = 0, element = 0, threshold = 0;
+				bool all = false;
+				int event = 0, direction = 0;
+				reader.read(joystick);
+				reader.read(element);
+				reader.read(threshold);
+				reader.read(all);
+				reader.read(event);
+				reader.read(direction);
+
+				js->setJoystickIndex(joystick);
+				js->setElementIndex(element);
+				js->setAxisThreshold(threshold);
+				js->setAllElementEvents(all);
+				js->setEventType(event);
+				js->setAxisDirection(direction);
+			} break;
+		case CB_RANDOM_SENS:
+			{
+				gkRandomSensor* rs = new gkRandomSensor(gobj, lnk, name);
+				ls = rs;
+
+				UTuint32 seed = 0;
+				reader.read(seed);
+				rs->setSeed(seed);
+			} break;
+		case CB_DELAY:
+			{
+				gkDelaySensor* ds = new gkDelaySensor(gobj, lnk, name);
+				ls = ds;
+
+				unsigned int delay = 0, duration = 0;
+				bool repeat = false;
+				reader.read(delay);
+				reader.read(duration);
+				reader.read(repeat);
+				ds->setDelay(delay);
+				ds->setDuration(duration);
+				ds->setRepeat(repeat);
+			} break;
+		case CB_ACTUATOR:
+			{
+				gkActuatorSensor* as = new gkActuatorSensor(gobj, lnk, name);
+				ls = as;
+
+				gkString actuator;
+				reader.read(actuator);
+				as->setActuatorName(actuator);
+			} break;
+		case CB_MESSAGE_SENS:
+			{
+				gkMessageSensor* ms = new gkMessageSensor(gobj, lnk, name);
+				ls = ms;
+
+				gkString subject;
+				reader.read(subject);
+				ms->setSubject(subject);
+			} break;
+		default:
+			return false;
+		}
+
+		UTuint32 links = 0;
+		reader.readCount(links, 2 * sizeof(UTuint32));
+		for (j = 0; j < links && reader.ok(); ++j)
+		{
+			SensorLink link;
+			link.m_sensor = ls;
+			reader.read(link.m_object);
+			reader.read(link.m_controller);
+			m_sensorLinks.push_back(link);
+		}
+
+		// getFrequency returns the halved rate setFrequency stores
+		ls->setDetector(detector);
+		ls->setTap(tap);
+		ls->setFrequency(freq * 2);
+		ls->invert(inverse);
+		ls->setStartState(lnk->getState());
+		ls->setMode(mode);
+
+		bstate.m_brick = ls;
+		m_bricks.push_back(bstate);
+		lnk->push(ls);
+	}
+
+	return reader.ok();
+}
+
+
+
+void gkLogicBrickCooker::resolveLinks(void)
+{
+	UTsize i;
+	for (i = 0; i < m_controllerLinks.size(); ++i)
+	{
+		ControllerLink& link = m_controllerLinks[i];
+
+		gkGameObject* obj = m_scene->getObject(link.m_object);
+		if (obj && obj->getLogicBricks())
+		{
+			gkLogicActuator* la = obj->getLogicBricks()->findActuator(link.m_actuator);
+			if (la && link.m_controller->getActuators().find(la) == UT_NPOS)
+				link.m_controller->link(la);
+		}
+	}
+
+	for (i = 0; i < m_sensorLinks.size(); ++i)
+	{
+		SensorLink& link = m_sensorLinks[i];
+
+		gkGameObject* obj = m_scene->getObject(link.m_object);
+		if (obj && obj->getLogicBricks())
+		{
+			gkLogicController* lc = obj->getLogicBricks()->findController(link.m_controller);
+			if (lc && link.m_sensor->getControllers().find(lc) == UT_NPOS)
+				link.m_sensor->link(lc);
+		}
+	}
+
+	// linking merges masks and priorities, put back the cooked ones
+	for (i = 0; i < m_bricks.size(); ++i)
+	{
+		BrickState& state = m_bricks[i];
+		state.m_brick->setMask(state.m_mask);
+		state.m_brick->setDebugMask(state.m_debugMask);
+		state.m_brick->setPriority(state.m_priority);
+	}
+
+	for (i = 0; i < m_objects.size(); ++i)
+	{
+		ObjectState& state = m_objects[i];
+		state.m_object->getLogicBricks()->setState(state.m_linkState);
+		state.m_object->setState(state.m_state);
+	}
+
+	m_controllerLinks.clear();
+	m_sensorLinks.clear();
+	m_bricks.clear();
+	m_objects.clear();
+}
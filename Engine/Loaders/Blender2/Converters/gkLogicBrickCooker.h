@@ -0,0 +1,101 @@
+/*
+-------------------------------------------------------------------------------
+    This file is part of OgreKit.
+    http://gamekit.googlecode.com/
+
+    Copyright (c) 2006-2013 Charlie C.
+
+    Contributor(s): none yet.
+-------------------------------------------------------------------------------
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#ifndef _gkLogicBrickCooker_h_
+#define _gkLogicBrickCooker_h_
+
+
+#include "gkCommon.h"
+
+class gkCookedReader;
+class utMemoryStream;
+class gkLogicSensor;
+class gkLogicController;
+class gkLogicBrick;
+
+
+///Writes the logic bricks of converted objects to a cooked package and
+///creates them again from it, see gkBlendPackage.
+///
+///Links between bricks are stored by object and brick name, read resolves
+///them against the objects of the scene once all bricks are created.
+class gkLogicBrickCooker
+{
+public:
+	gkLogicBrickCooker(gkScene* scene);
+	~gkLogicBrickCooker();
+
+	///False if gobj has a brick the cooker does not know.
+	static bool canWrite(gkGameObject* gobj);
+
+	///Writes the logic link of gobj, canWrite has to pass.
+	static void write(gkGameObject* gobj, utMemoryStream& stream);
+
+	///Creates the bricks of one write on gobj.
+	bool read(gkGameObject* gobj, gkCookedReader& reader);
+
+	///Links the bricks created by read, and restores their states.
+	void resolveLinks(void);
+
+private:
+
+	struct SensorLink
+	{
+		gkLogicSensor*  m_sensor;
+		gkString        m_object;
+		gkString        m_controller;
+	};
+
+	struct ControllerLink
+	{
+		gkLogicController*  m_controller;
+		gkString            m_object;
+		gkString            m_actuator;
+	};
+
+	struct BrickState
+	{
+		gkLogicBrick*   m_brick;
+		int             m_mask;
+		int             m_debugMask;
+		int             m_priority;
+	};
+
+	struct ObjectState
+	{
+		gkGameObject*   m_object;
+		int             m_state;
+		int             m_linkState;
+	};
+
+	gkScene*                m_scene;
+	utArray<SensorLink>     m_sensorLinks;
+	utArray<ControllerLink> m_controllerLinks;
+	utArray<BrickState>     m_bricks;
+	utArray<ObjectState>    m_objects;
+};
+
+#endif//_gkLogicBrickCooker_h_
@@ -37,6 +37,11 @@
 #define VEC3CPN(a, b) {a.x= (b[0]/32767.f); a.y= (b[1]/32767.f); a.z= (b[2]/32767.f);}
 
 
+// texture face materials are numbered per process, mesh names repeat across files
+static gkCriticalSection gkMeshConverter_textureFaceCs;
+static int gkMeshConverter_textureFaces = 0;
+
+
 static void gkLoaderUtils_getLayers_legacy(
     Blender::Mesh* mesh,
     Blender::MTFace** eightLayerArray,
@@ -160,8 +165,35 @@ public:
 };
 
 
+gkConvertedMesh::~gkConvertedMesh()
+{
+	for (UTsize i = 0; i < m_submeshes.size(); ++i)
+		delete m_submeshes[i];
+}
+
+
+void gkConvertedMesh::moveTo(gkMesh* mesh)
+{
+	for (UTsize i = 0; i < m_groups.size(); ++i)
+		mesh->createVertexGroup(m_groups[i]);
+
+	for (UTsize i = 0; i < m_submeshes.size(); ++i)
+		mesh->addSubMesh(m_submeshes[i]);
+
+	m_groups.clear();
+	m_submeshes.clear();
+}
+
+
+
 gkBlenderMeshConverter::gkBlenderMeshConverter(gkMesh* gmesh, Blender::Object* bobject, Blender::Mesh* bmesh)
-	:   m_gmesh(gmesh), m_bmesh(bmesh), m_bobj(bobject)
+	:   m_gmesh(gmesh), m_local(bobject), m_dest(&m_local), m_bmesh(bmesh), m_bobj(bobject)
+{
+}
+
+
+gkBlenderMeshConverter::gkBlenderMeshConverter(gkConvertedMesh* dest, Blender::Object* bobject, Blender::Mesh* bmesh)
+	:   m_gmesh(0), m_local(bobject), m_dest(dest), m_bmesh(bmesh), m_bobj(bobject)
 {
 }
 
@@ -295,11 +327,15 @@ void gkBlenderMeshConverter::convertTextureFace(gkMaterialProperties& gma, gkMes
 	gma.m_mode = hk.m_mode;
 	if (imas)
 	{
-		static char buf[32];
-		static int uid = 0;
+		int nr;
+		{
+			gkCriticalSection::Lock lock(gkMeshConverter_textureFaceCs);
+			nr = gkMeshConverter_textureFaces++;
+		}
 
-		sprintf(buf, "TextureFace %i", (uid++));
-		gma.m_name = buf;
+		char buf[32];
+		sprintf(buf, " %i", nr);
+		gma.m_name = gkString("TextureFace ") + GKB_IDNAME(m_bmesh) + buf;
 	}
 
 	if (imas && gma.m_mode & gkMaterialProperties::MA_HASFACETEX)
@@ -545,7 +581,7 @@ bool gkBlenderMeshConverter::convert(void)
 		int dgi = 0;
 		for (Blender::bDeformGroup* dg = (Blender::bDeformGroup*)m_bobj->defbase.first; dg; dg = dg->next, ++dgi)
 		{
-			m_gmesh->createVertexGroup(dg->name);
+			m_dest->m_groups.push_back(dg->name);
 			convertBoneAssignments(dgi, assignMap);
 		}
 	}
@@ -579,6 +615,8 @@ bool gkBlenderMeshConverter::convert(void)
 		iter.getNext();
 	}
 
+	if (m_gmesh)
+		m_dest->moveTo(m_gmesh);
 	return true;
 }
 
@@ -784,7 +822,7 @@ void gkBlenderMeshConverter::convert_bmesh(void)
 			curSubMesh->setTotalLayers(totlayer);
 			curSubMesh->setVertexColors(mloopCol != 0);
 
-			m_gmesh->addSubMesh(curSubMesh);
+			m_dest->m_submeshes.push_back(curSubMesh);
 			tester.item = curSubMesh;
 			m_meshtable.push_back(tester);
 		}
@@ -1003,7 +1041,7 @@ void gkBlenderMeshConverter::convert_legacy(void)
 			curSubMesh->setTotalLayers(totlayer);
 			curSubMesh->setVertexColors(mcol != 0);
 
-			m_gmesh->addSubMesh(curSubMesh);
+			m_dest->m_submeshes.push_back(curSubMesh);
 			tester.item = curSubMesh;
 			m_meshtable.push_back(tester);
 		}
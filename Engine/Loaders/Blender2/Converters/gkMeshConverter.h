@@ -47,11 +47,31 @@ class gkBlendFile;
 class gkMeshPair;
 
 
+///Submeshes and vertex groups converted without a gkMesh, which can only be
+///created on the main thread. Handed over to the mesh with moveTo.
+class gkConvertedMesh
+{
+public:
+	gkConvertedMesh(Blender::Object* bobject = 0) : m_object(bobject) {}
+	~gkConvertedMesh();
+
+	void moveTo(gkMesh* mesh);
+
+	Blender::Object*        m_object;       // materials and groups depend on it
+	gkMesh::SubMeshArray    m_submeshes;
+	utArray<gkString>       m_groups;
+};
+
+
 class gkBlenderMeshConverter
 {
 public:
 
 	gkBlenderMeshConverter(gkMesh* gmesh, Blender::Object* bobject, Blender::Mesh* bmesh);
+
+	///Converts into dest, safe on loader and job pool threads. Converters share
+	///no state, any number may run at once.
+	gkBlenderMeshConverter(gkConvertedMesh* dest, Blender::Object* bobject, Blender::Mesh* bmesh);
 	~gkBlenderMeshConverter();
 
 	// returns false if conversion-failed due to lack of data
@@ -110,6 +130,8 @@ private:
 	void convert_bmesh();
 
 	gkMesh*          m_gmesh;
+	gkConvertedMesh  m_local;
+	gkConvertedMesh* m_dest;
 	Blender::Mesh*   m_bmesh;
 	Blender::Object* m_bobj;
 	utArray<gkMeshPair> m_meshtable;
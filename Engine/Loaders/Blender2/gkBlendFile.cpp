@@ -41,9 +41,12 @@
 
 #include "Converters/gkAnimationConverter.h"
 #include "Converters/gkParticleConverter.h"
+#include "Converters/gkMeshConverter.h"
 
 #include "gkBlenderDefines.h"
 #include "gkBlenderSceneConverter.h"
+#include "gkPackageSceneConverter.h"
+#include "gkBlendPackage.h"
 #include "gkTextureLoader.h"
 #include "gkPath.h"
 #include "gkLogger.h"
@@ -52,6 +55,7 @@
 #include "gkTextFile.h"
 #include "gkEngine.h"
 #include "gkUserDefs.h"
+#include "gkJobPool.h"
 
 #ifdef OGREKIT_OPENAL_SOUND
 # include "Sound/gkSoundManager.h"
@@ -76,7 +80,11 @@ gkBlendFile::gkBlendFile(const gkString& blendToLoad, const gkString& group)
 		m_hasBFont(false),
 		m_file(0),
 		m_memoryBlend(0),
-		m_memoryBlendSize(0)
+		m_memoryBlendSize(0),
+		m_convertOpts(0),
+		m_convertStep(CS_DONE),
+		m_convertCursor(0),
+		m_convertCurScene(0)
 {
 }
 
@@ -89,7 +97,11 @@ gkBlendFile::gkBlendFile(const void* mem, int size, const gkString& group)
 		m_hasBFont(false),
 		m_file(0),
 		m_memoryBlend(mem),
-		m_memoryBlendSize(size)
+		m_memoryBlendSize(size),
+		m_convertOpts(0),
+		m_convertStep(CS_DONE),
+		m_convertCursor(0),
+		m_convertCurScene(0)
 
 {
 }
@@ -102,13 +114,54 @@ gkBlendFile::~gkBlendFile()
 		while (it.hasMoreElements())
 			delete it.getNext();
 	}
+
+	// parsed but never converted
+	delete m_file;
 }
 
 
 
+// Converts the collected meshes, one per job.
+class gkMeshConvertJob : public gkJobPool::Job
+{
+public:
+	gkMeshConvertJob(utArray<gkConvertedMesh*>& meshes) : m_meshes(meshes) {}
+
+	void run(int begin, int end)
+	{
+		for (int i = begin; i < end; ++i)
+		{
+			gkConvertedMesh* converted = m_meshes[i];
+			gkBlenderMeshConverter meconv(converted, converted->m_object, (Blender::Mesh*)converted->m_object->data);
+			meconv.convert();
+		}
+	}
+
+private:
+	utArray<gkConvertedMesh*>& m_meshes;
+};
+
+
+
 bool gkBlendFile::parse(int opts, const gkString& scene)
-{	
+{
+	if (!parseFile(opts))
+		return false;
+
+	prepareMeshes(opts, scene);
+	convert(opts, scene);
+	return true;
+}
+
+
+
+bool gkBlendFile::parseFile(int opts, bool threaded)
+{
+	GK_ASSERT(!m_file);
+
 	m_file = new gkBlendInternalFile();
+	m_file->setLazyLink((opts & gkBlendLoader::LO_LAZY_LINK) != 0);
+	m_file->setThreaded(threaded);
 
 	if (!m_name.empty())
 	{
@@ -128,130 +181,249 @@ bool gkBlendFile::parse(int opts, const gkString& scene)
 
 		}
 	}
+	return true;
+}
 
-	doVersionTests();
 
-	m_findScene = scene;
 
+void gkBlendFile::prepareMeshes(int opts, const gkString& scene)
+{
+	GK_ASSERT(m_file);
+
+	// cooked meshes are loaded by the scene converters, nothing to link here
+	if (m_file->getPackage())
+		return;
+
+	// same scenes as beginConvert
+	utArray<gkConvertedMesh*> meshes;
 	if (opts & gkBlendLoader::LO_ONLY_ACTIVE_SCENE)
-		loadActive();
+	{
+		Blender::FileGlobal* fg = m_file->getFileGlobal();
+		Blender::Scene* sc = fg ? (fg->curscene ? fg->curscene : m_file->getFirstScene()) : 0;
+		if (sc)
+		{
+			m_file->link(sc);
+			gkBlenderSceneConverter::collectMeshes(m_file, sc, meshes);
+		}
+	}
 	else
-		createInstances();
+	{
+		gkBlendListIterator iter = m_file->getSceneList();
+		while (iter.hasMoreElements())
+		{
+			Blender::Scene* sc = (Blender::Scene*)iter.getNext(false);
 
-	delete m_file;
-	m_file = 0;
-	return true;
+			if (scene.empty() || scene == GKB_IDNAME(sc))
+			{
+				m_file->link(sc);
+				gkBlenderSceneConverter::collectMeshes(m_file, sc, meshes);
+			}
+		}
+	}
+
+	if (meshes.empty())
+		return;
+
+	// Each mesh has its own output, the scene converter moves them into the
+	// mesh manager in object order. The job pool only runs loops from the main thread.
+	gkMeshConvertJob job(meshes);
+	if (!m_file->isThreaded() && gkEngine::getSingletonPtr() && meshes.size() > 1)
+		gkEngine::getSingleton().getJobPool()->parallelFor((int)meshes.size(), 1, &job);
+	else
+		job.run(0, (int)meshes.size());
 }
 
-void gkBlendFile::readCurSceneInfo(Blender::Scene* scene)
-{
-	if (!scene) return;
 
-	m_animFps = scene->r.frs_sec / scene->r.frs_sec_base;
 
-	gkUserDefs& defs = gkEngine::getSingleton().getUserDefs();
-	defs.animFps = m_animFps;
-	defs.rtss = (scene->gm.matmode == GAME_MAT_GLSL);
+void gkBlendFile::convert(int opts, const gkString& scene)
+{
+	beginConvert(opts, scene);
+	while (convertStep());
 }
 
 
-void gkBlendFile::loadActive(void)
+
+void gkBlendFile::beginConvert(int opts, const gkString& scene)
 {
-	// Load / convert only the active scene.
+	GK_ASSERT(m_file && m_convertStep == CS_DONE);
+
+	doVersionTests();
+
+	m_findScene = scene;
+	m_convertOpts = opts;
+	m_convertStep = CS_TEXTURES;
+	m_convertCursor = 0;
+	m_convertImages.clear();
+	m_convertScenes.clear();
 
 	Blender::FileGlobal* fg = m_file->getFileGlobal();
-	if (fg)
-	{		
-		if (!fg->curscene)
+
+	if (opts & gkBlendLoader::LO_ONLY_ACTIVE_SCENE)
+	{
+		// Load / convert only the active scene.
+		if (fg && !fg->curscene)
 			fg->curscene = m_file->getFirstScene();
 
-		Blender::Scene* sc = fg->curscene;
+		if (fg && fg->curscene)
+			m_convertScenes.push_back(fg->curscene);
+	}
+	else
+	{
+		gkBlendListIterator iter = m_file->getSceneList();
+		while (iter.hasMoreElements())
+		{
+			Blender::Scene* sc = (Blender::Scene*)iter.getNext(false);
+
+			if (m_findScene.empty() || m_findScene == GKB_IDNAME(sc))
+				m_convertScenes.push_back(sc);
+		}
+	}
+
+	m_convertCurScene = fg ? fg->curscene : 0;
+	readCurSceneInfo(m_convertCurScene);
+
+	gkBlendListIterator iter = m_file->getImageList();
+	while (iter.hasMoreElements())
+	{
+		Blender::Image* ima = (Blender::Image*)iter.getNext(false);
+		// don't try & convert zero users
+		if (ima->id.us > 0)
+		{
+			m_file->link(ima);
+			m_convertImages.push_back(ima);
+		}
+	}
+}
+
 
-		readCurSceneInfo(sc);
 
-		buildAllTextures();
+bool gkBlendFile::convertStep(void)
+{
+	switch (m_convertStep)
+	{
+	case CS_TEXTURES:
+		if (m_convertCursor < m_convertImages.size())
+		{
+			buildTexture(m_convertImages[m_convertCursor++]);
+			return true;
+		}
+		m_convertImages.clear();
+		break;
+	case CS_FONTS:
 		buildAllFonts();
+		break;
+	case CS_TEXTS:
 		buildTextFiles();
+		break;
+	case CS_SOUNDS:
 		buildAllSounds();
-		buildAllActions();
+		break;
+	case CS_ACTIONS:
+		if (!m_file->getPackage() || !m_file->getPackage()->loadAnimations(m_group))
+			buildAllActions();
+		break;
+	case CS_PARTICLES:
 		buildAllParticles();
+		break;
+	case CS_SCENES:
+		if (m_convertCursor < m_convertScenes.size())
+		{
+			convertScene(m_convertScenes[m_convertCursor++]);
+			return true;
+		}
+		break;
+	case CS_GROUP_INSTANCES:
+		// a second pass for creating groupinstances. groups from all scenes have to be converted before the
+		// group-instances can be created.
+		if (m_convertCursor < m_convertScenes.size())
+		{
+			Blender::Scene* sc = m_convertScenes[m_convertCursor++];
 
-		// parse & build
-		if (sc)
+			gkBlendPackage* package = m_file->getPackage();
+			if (package && package->hasScene(GKB_IDNAME(sc)))
+			{
+				gkPackageSceneConverter conv(this, package, GKB_IDNAME(sc));
+				conv.convertGroupInstances();
+			}
+			else
+			{
+				gkBlenderSceneConverter conv(this, sc);
+				conv.convertGroupInstances();
+			}
+			return true;
+		}
+		break;
+	case CS_FINISH:
+		if (m_convertCurScene)
 		{
-			gkBlenderSceneConverter conv(this, sc);
-			conv.convert(false);
-			conv.convertGroupInstances();
-			m_activeScene = (gkScene*)gkSceneManager::getSingleton().getByName(gkResourceName(GKB_IDNAME(sc), m_group));
-			if (m_activeScene)
-				m_scenes.push_back(m_activeScene);
+			// Grab the main scene
+			m_activeScene = (gkScene*) gkSceneManager::getSingleton().getByName(gkResourceName(GKB_IDNAME(m_convertCurScene), m_group));
 		}
+
+		if (m_activeScene == 0 && !m_scenes.empty())
+			m_activeScene = m_scenes.front();
+
+		m_convertScenes.clear();
+		m_convertCurScene = 0;
+
+		delete m_file;
+		m_file = 0;
+		break;
+	default:
+		return false;
 	}
 
+	m_convertCursor = 0;
+	++m_convertStep;
+	return m_convertStep != CS_DONE;
 }
 
 
 
-void gkBlendFile::createInstances(void)
+void gkBlendFile::readCurSceneInfo(Blender::Scene* scene)
 {
-	GK_ASSERT(m_file);
+	if (!scene) return;
 
-	Blender::FileGlobal* fg = m_file->getFileGlobal();
+	m_animFps = scene->r.frs_sec / scene->r.frs_sec_base;
 
-	Blender::Scene* curscene = fg ? fg->curscene : 0;
+	gkUserDefs& defs = gkEngine::getSingleton().getUserDefs();
+	defs.animFps = m_animFps;
+	defs.rtss = (scene->gm.matmode == GAME_MAT_GLSL);
+}
 
-	readCurSceneInfo(curscene);
 
-	// Load / convert all
-	buildAllTextures();
-	buildAllFonts();
-	buildTextFiles();
-	buildAllSounds();
-	buildAllActions();
-	buildAllParticles();
 
-	gkBlendListIterator iter = m_file->getSceneList();
-	while (iter.hasMoreElements())
+void gkBlendFile::convertScene(Blender::Scene* sc)
+{
+	// cooked scenes never touch the blend data
+	gkBlendPackage* package = m_file->getPackage();
+	if (package && package->hasScene(GKB_IDNAME(sc)))
 	{
-		Blender::Scene* sc = (Blender::Scene*)iter.getNext();
-
-		if (m_findScene.empty() || m_findScene == GKB_IDNAME(sc))
-		{			
-			gkBlenderSceneConverter conv(this, sc);
-			conv.convert(false);
-
-			gkScene* gks = (gkScene*)gkSceneManager::getSingleton().getByName(gkResourceName(GKB_IDNAME(sc), m_group));
-			if (gks)
-				m_scenes.push_back(gks);
-		}
+		gkPackageSceneConverter conv(this, package, GKB_IDNAME(sc));
+		conv.convert();
 	}
-	// a second pass for creating groupinstances. groups from all scenes have to be converted before the
-	// group-instances can be created.
-	iter = m_file->getSceneList();
-	while (iter.hasMoreElements())
+	else
 	{
-		Blender::Scene* sc = (Blender::Scene*)iter.getNext();
+		m_file->link(sc);
 
-		if (m_findScene.empty() || m_findScene == GKB_IDNAME(sc))
-		{
-			gkBlenderSceneConverter conv(this, sc);
-			conv.convertGroupInstances();
-		}
+		gkBlenderSceneConverter conv(this, sc);
+		conv.convert(false);
 	}
 
+	gkScene* gks = (gkScene*)gkSceneManager::getSingleton().getByName(gkResourceName(GKB_IDNAME(sc), m_group));
+	if (gks)
+		m_scenes.push_back(gks);
+}
 
-	if (curscene)
-	{
-		// Grab the main scene
-		m_activeScene = (gkScene*) gkSceneManager::getSingleton().getByName(gkResourceName(GKB_IDNAME(curscene), m_group));
-	}
 
-	if (m_activeScene == 0 && !m_scenes.empty())
-		m_activeScene = m_scenes.front();
-}
 
 
 
+gkBlendPackage* gkBlendFile::getPackage(void)
+{
+	return m_file ? m_file->getPackage() : 0;
+}
+
 
 
 gkScene* gkBlendFile::getSceneByName(const gkString& name)
@@ -277,7 +449,14 @@ void gkBlendFile::buildTextFiles(void)
 
 	while (iter.hasMoreElements())
 	{
-		Blender::Text* txt = (Blender::Text*)iter.getNext();
+		Blender::Text* txt = (Blender::Text*)iter.getNext(false);
+		gkResourceName txtName(GKB_IDNAME(txt), m_group);
+
+		if (txtMgr.exists(txtName))
+			continue;
+
+		m_file->link(txt);
+
 		Blender::TextLine* tl = (Blender::TextLine*)txt->lines.first;
 		std::stringstream ss;
 
@@ -290,9 +469,8 @@ void gkBlendFile::buildTextFiles(void)
 		}
 
 		gkString str = ss.str();
-		gkResourceName txtName(GKB_IDNAME(txt), m_group);
 
-		if (!str.empty() && !txtMgr.exists(txtName))
+		if (!str.empty())
 		{
 			gkTextFile* tf = (gkTextFile*)txtMgr.create(txtName);
 			tf->setText(str);
@@ -307,86 +485,76 @@ void gkBlendFile::buildTextFiles(void)
 
 
 
-void gkBlendFile::buildAllTextures(void)
+void gkBlendFile::buildTexture(Blender::Image* ima)
 {
-	gkBlendListIterator iter = m_file->getImageList();
+	gkString name(GKB_IDNAME(ima));
 
-	while (iter.hasMoreElements())	
-	{
-		Blender::Image* ima = (Blender::Image*)iter.getNext();
-		// don't try & convert zero users
-		if (ima->id.us <= 0)
-			continue;
+	Ogre::TexturePtr tex = Ogre::TextureManager::getSingleton().getByName(name, m_group);
 
-		gkString name(GKB_IDNAME(ima));
+	if (tex.isNull())
+	{
+		if (ima->packedfile) // is the texture packed with blender?
+		{
+			gkTextureLoader* loader = new gkTextureLoader(ima);
 
-		Ogre::TexturePtr tex = Ogre::TextureManager::getSingleton().getByName(name, m_group);
+			tex = Ogre::TextureManager::getSingleton().create(GKB_IDNAME(ima), m_group, true, loader);
 
-		if (tex.isNull())
+			if (!tex.isNull())
+				m_loaders.push_back(loader);
+			else
+				delete loader;
+		}
+		else
 		{
-			if (ima->packedfile) // is the texture packed with blender?
+			gkString texName = GKB_IDNAME(ima);
+			bool found = false;
+
+			try
 			{
-				gkTextureLoader* loader = new gkTextureLoader(ima);
+				gkLogger::write("Texture "+texName+" not packed! Try to locate it via ogre-resources in group:'"+m_group+"'",true);
 
-				tex = Ogre::TextureManager::getSingleton().create(GKB_IDNAME(ima), m_group, true, loader);
+				tex = Ogre::TextureManager::getSingleton().load(texName, m_group, Ogre::TEX_TYPE_2D, gkEngine::getSingleton().getUserDefs().defaultMipMap);
 
 				if (!tex.isNull())
-					m_loaders.push_back(loader);
-				else
-					delete loader;
+				{
+					found = true;
+				}
 			}
-			else
+			catch (...)
 			{
-				gkString texName = GKB_IDNAME(ima);
-				bool found = false;
+				gkString texPath(ima->name);
 
-				try
+				if (texPath.find_first_of("//") == 0)
 				{
-					gkLogger::write("Texture "+texName+" not packed! Try to locate it via ogre-resources in group:'"+m_group+"'",true);
+					gkPath blendPath(m_file->getFileGlobal()->filename);
+					gkPath locPath(blendPath.directory());
+					gkPath texDir(texPath.substr(2));
+					locPath.append(texDir.directory());
 
-					tex = Ogre::TextureManager::getSingleton().load(texName, m_group, Ogre::TEX_TYPE_2D, gkEngine::getSingleton().getUserDefs().defaultMipMap);
+					gkLogger::write("Texture "+texName+" not found! Try to add relative FileSystem location in group:'"+m_group+"' " + locPath.getPath() + " - " + blendPath.getPath(), true);
 
-					if (!tex.isNull())
-					{
-						found = true;
-					}
-				}
-				catch (...)
-				{
-					gkString texPath(ima->name);
+					Ogre::Root::getSingleton().addResourceLocation(locPath.getPath(), "FileSystem", m_group);
 
-					if (texPath.find_first_of("//") == 0)
+					try
 					{
-						gkPath blendPath(m_file->getFileGlobal()->filename);
-						gkPath locPath(blendPath.directory());
-						gkPath texDir(texPath.substr(2));
-						locPath.append(texDir.directory());
-
-						gkLogger::write("Texture "+texName+" not found! Try to add relative FileSystem location in group:'"+m_group+"' " + locPath.getPath() + " - " + blendPath.getPath(), true);
+						tex = Ogre::TextureManager::getSingleton().load(texName, m_group, Ogre::TEX_TYPE_2D, gkEngine::getSingleton().getUserDefs().defaultMipMap);
 
-						Ogre::Root::getSingleton().addResourceLocation(locPath.getPath(), "FileSystem", m_group);
-
-						try
+						if (!tex.isNull())
 						{
-							tex = Ogre::TextureManager::getSingleton().load(texName, m_group, Ogre::TEX_TYPE_2D, gkEngine::getSingleton().getUserDefs().defaultMipMap);
-
-							if (!tex.isNull())
-							{
-								found = true;
-							}
+							found = true;
 						}
-						catch (...) {}
 					}
+					catch (...) {}
 				}
+			}
 
-				if (found)
-				{
-					gkLogger::write("FOUND("+texName+")!!!",true);
-				}
-				else
-				{
-					gkLogger::write("NOT FOUND("+texName+")!!!",true);
-				}
+			if (found)
+			{
+				gkLogger::write("FOUND("+texName+")!!!",true);
+			}
+			else
+			{
+				gkLogger::write("NOT FOUND("+texName+")!!!",true);
 			}
 		}
 	}
@@ -401,8 +569,13 @@ void gkBlendFile::buildAllParticles(void)
 	gkBlendListIterator iter = m_file->getParticleList();
 	while (iter.hasMoreElements())	
 	{
-		Blender::ParticleSettings* ps = (Blender::ParticleSettings*)iter.getNext();
+		Blender::ParticleSettings* ps = (Blender::ParticleSettings*)iter.getNext(false);
 
+		// skip zero users
+		if (ps->id.us <= 0)
+			continue;
+
+		m_file->link(ps);
 		conv.convertParticle(ps);
 	}
 #endif
@@ -420,12 +593,14 @@ void gkBlendFile::buildAllSounds(void)
 
 	while (iter.hasMoreElements())	
 	{
-		Blender::bSound* sound = (Blender::bSound*)iter.getNext();
+		Blender::bSound* sound = (Blender::bSound*)iter.getNext(false);
 
 		// skip zero users
 		if (sound->id.us <= 0)
 			continue;
 
+		m_file->link(sound);
+
 		gkPath pth(sound->name);
 		bool isFile = pth.isFile();
 
@@ -480,9 +655,13 @@ void gkBlendFile::buildAllFonts(void)
 	gkBlendListIterator iter = m_file->getVFontList();
 	while (iter.hasMoreElements())	
 	{
-		Blender::VFont* vf = (Blender::VFont*)iter.getNext();
+		Blender::VFont* vf = (Blender::VFont*)iter.getNext(false);
 	
-		if (vf->id.us <= 0 || !vf->packedfile)
+		if (vf->id.us <= 0)
+			continue;
+
+		m_file->link(vf);
+		if (!vf->packedfile)
 			continue;
 
 		Blender::PackedFile* pak = vf->packedfile;
@@ -498,9 +677,20 @@ void gkBlendFile::buildAllFonts(void)
 void gkBlendFile::buildAllActions(void)
 {
 	gkAnimationLoader anims(m_group);
-		
-    gkBlendListIterator iter = m_file->getActionList();
-	anims.convertActions(iter, m_file->getVersion() <= 249, m_animFps);
+	bool pre25compat = m_file->getVersion() <= 249;
+
+	gkBlendListIterator iter = m_file->getActionList();
+	while (iter.hasMoreElements())
+	{
+		Blender::bAction* bact = (Blender::bAction*)iter.getNext(false);
+
+		// skip zero users
+		if (bact->id.us <= 0)
+			continue;
+
+		m_file->link(bact);
+		anims.convertAction(bact, pre25compat, m_animFps);
+	}
 }
 
 
@@ -522,7 +712,7 @@ void gkBlendFile::doVersionTests(void)
 		gkBlendListIterator iter = m_file->getObjectList();
 		while (iter.hasMoreElements())	
 		{
-			Blender::Object* ob = (Blender::Object*)iter.getNext();		
+			Blender::Object* ob = (Blender::Object*)iter.getNext(false);
 
 			if (ob->gameflag & OB_DYNAMIC)
 				ob->body_type = ob->gameflag & OB_RIGID_BODY ? OB_BODY_TYPE_RIGID : OB_BODY_TYPE_DYNAMIC;
@@ -538,8 +728,12 @@ void gkBlendFile::doVersionTests(void)
 		gkBlendListIterator iter = m_file->getObjectList();
 		while (iter.hasMoreElements())	
 		{
-			Blender::Object* ob = (Blender::Object*)iter.getNext();	
-		
+			Blender::Object* ob = (Blender::Object*)iter.getNext(false);
+			if (ob->id.us <= 0)
+				continue;
+
+			// constraints are only reachable once the object is linked
+			m_file->link(ob);
 			for (Blender::bConstraint* bc = (Blender::bConstraint*)ob->constraints.first; bc; bc = bc->next)
 			{
 				// convert rotation types to radians
@@ -566,7 +760,7 @@ void gkBlendFile::doVersionTests(void)
 		gkBlendListIterator iter = m_file->getTextList();
 		while (iter.hasMoreElements())
 		{
-			Blender::Text* txt = (Blender::Text*)iter.getNext();
+			Blender::Text* txt = (Blender::Text*)iter.getNext(false);
 					
 			if (gkString(txt->id.name).find(".bfont"))
 			{
@@ -34,6 +34,7 @@
 
 //class fbtBlend;
 class gkBlendInternalFile;
+class gkBlendPackage;
 
 class gkBlendFile
 {
@@ -52,6 +53,20 @@ public:
 
 	bool parse(int opts, const gkString& scene = "");
 
+	///Split parse for gkBlendLoader::loadFileAsync. parseFile and prepareMeshes
+	///only touch the file and are safe on a loader thread, convert creates the
+	///scenes and resources and has to run on the main thread afterwards.
+	bool parseFile(int opts, bool threaded = false);
+	void prepareMeshes(int opts, const gkString& scene = "");
+	void convert(int opts, const gkString& scene = "");
+
+	///Resumable convert. beginConvert sets the file up, each convertStep then
+	///builds one texture, one resource list or one scene and returns false once
+	///the file is converted. convert runs all steps at once.
+	void beginConvert(int opts, const gkString& scene = "");
+	bool convertStep(void);
+	GK_INLINE bool isConverting(void) const {return m_convertStep != CS_DONE;}
+
 	gkScene* getSceneByName(const gkString& name);
 
 	GK_INLINE gkScene* getMainScene(void) {return m_activeScene;}
@@ -63,6 +78,9 @@ public:
 
 	gkBlendInternalFile* _getInternalFile(void) {GK_ASSERT(m_file); return m_file;}
 
+	///Cooked sections of the file, 0 if it is a plain .blend.
+	gkBlendPackage* getPackage(void);
+
 	///Access to the original group name. Used for placing created resources in the same group.
 	GK_INLINE const gkString& getResourceGroup(void) {return m_group;}
 
@@ -70,17 +88,33 @@ public:
 
 protected:
 
+	enum ConvertStep
+	{
+		CS_TEXTURES,
+		CS_FONTS,
+		CS_TEXTS,
+		CS_SOUNDS,
+		CS_ACTIONS,
+		CS_PARTICLES,
+		CS_SCENES,
+		CS_GROUP_INSTANCES,
+		CS_FINISH,
+		CS_DONE
+	};
+
+	typedef utArray<Blender::Image*> ConvertImages;
+	typedef utArray<Blender::Scene*> ConvertScenes;
+
 	void doVersionTests(void);
 	void buildTextFiles(void);
-	void buildAllTextures(void);
+	void buildTexture(Blender::Image* ima);
 	void buildAllSounds(void);
 	void buildAllFonts(void);
 	void buildAllActions(void);
 	void buildAllParticles(void);
 
 
-	void loadActive(void);
-	void createInstances(void);
+	void convertScene(Blender::Scene* sc);
 
 	void readCurSceneInfo(Blender::Scene* scene);
 
@@ -96,6 +130,13 @@ protected:
 	bool						m_hasBFont;
 	const void*					m_memoryBlend;
 	int							m_memoryBlendSize;
+
+	int							m_convertOpts;
+	int							m_convertStep;
+	UTsize						m_convertCursor;
+	ConvertImages				m_convertImages;
+	ConvertScenes				m_convertScenes;		// Scenes picked by beginConvert.
+	Blender::Scene*				m_convertCurScene;
 };
 
 
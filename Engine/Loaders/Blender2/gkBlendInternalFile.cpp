@@ -32,17 +32,94 @@
 
 #if OGREKIT_USE_BPARSE == 0
 #include "fbtTypes.h"
+#include "gkEngine.h"
+#include "gkUserDefs.h"
+#include "gkJobPool.h"
+#include "gkCriticalSection.h"
+#include "gkBlendPackage.h"
+#include "Converters/gkMeshConverter.h"
+
+
+// Converts the chunks of big files on the engine job pool.
+class gkBlendLinkRunner : public fbtFile::JobRunner
+{
+private:
+	class Job : public gkJobPool::Job
+	{
+	public:
+		Job(fbtFile::Job* job) : m_job(job) {}
+		void run(int begin, int end) { m_job->run(begin, end); }
+
+	private:
+		fbtFile::Job* m_job;
+	};
+
+public:
+	void parallelFor(int count, int grain, fbtFile::Job* job)
+	{
+		Job poolJob(job);
+		gkEngine::getSingleton().getJobPool()->parallelFor(count, grain, &poolJob);
+	}
+};
+
+static gkBlendLinkRunner gkLinkRunner;
+
+
+// Plans of every DNA seen, blend files may be parsed on loader threads.
+class gkBlendLinkPlanCache : public fbtLinkPlanCache
+{
+private:
+	gkCriticalSection m_cs;
+
+public:
+	gkBlendLinkPlanCache(const gkString& dir)
+		:	fbtLinkPlanCache(dir.empty() ? 0 : dir.c_str())
+	{
+	}
+
+	fbtLinkPlan* find(const fbtLinkPlan::Key& key)
+	{
+		gkCriticalSection::Lock guard(m_cs);
+		return fbtLinkPlanCache::find(key);
+	}
+
+	fbtLinkPlan* insert(fbtLinkPlan* plan)
+	{
+		gkCriticalSection::Lock guard(m_cs);
+		return fbtLinkPlanCache::insert(plan);
+	}
+};
+
+// Owned by gkBlendLoader, created before any loader thread starts.
+static gkBlendLinkPlanCache* gkLinkPlanCache = 0;
+
+
+static void gkSetupBlend(fbtBlend* file, bool lazy, bool threaded)
+{
+	file->setLazyLink(lazy);
+	if (gkEngine::getSingletonPtr())
+	{
+		if (!threaded)
+			file->setJobRunner(&gkLinkRunner);
+		file->setLinkPlanCache(gkLinkPlanCache);
+	}
+}
 #endif
 
+#if OGREKIT_USE_BPARSE
 gkBlendListIterator::gkBlendListIterator(List* list)
 	:	m_list(list),
-#if OGREKIT_USE_BPARSE
 		m_index(0)
+{
+}
 #else
-		m_index(list ? list->first : 0)
-#endif
+gkBlendListIterator::gkBlendListIterator(List* list, fbtFile* file)
+	:	m_list(list),
+		m_index(list ? list->first : 0),
+		m_file(file)
 {
 }
+#endif
 
 bool gkBlendListIterator::hasMoreElements() const
 {
@@ -56,13 +133,16 @@ bool gkBlendListIterator::hasMoreElements() const
 }
 
 
-gkBlendListIterator::ListItem* gkBlendListIterator::getNext(void)	 
+gkBlendListIterator::ListItem* gkBlendListIterator::getNext(bool link)	 
 { 
 #if OGREKIT_USE_BPARSE
 	return m_list->at(m_index++);
 #else
 	ListItem* item = m_index;
 	m_index = m_index->next;
+
+	if (link && m_file)
+		m_file->linkBlock(item);
 	return item;
 #endif
 }
@@ -70,16 +150,70 @@ gkBlendListIterator::ListItem* gkBlendListIterator::getNext(void)
 //--
 
 gkBlendInternalFile::gkBlendInternalFile()
-	:	m_file(0)
+	:	m_file(0),
+		m_lazy(false),
+		m_package(0),
+		m_threaded(false)
 {
 }
 
 gkBlendInternalFile::~gkBlendInternalFile()
 {
+	ConvertedMeshes::Iterator it = m_converted.iterator();
+	while (it.hasMoreElements())
+		delete it.getNext().second;
+
+	// reads from m_file's mapping
+	delete m_package;
+	m_package = 0;
+
 	delete m_file;
 	m_file = 0;
 }
 
+
+void gkBlendInternalFile::createLinkPlanCache(const gkString& dir)
+{
+#if OGREKIT_USE_BPARSE == 0
+	if (!gkLinkPlanCache)
+		gkLinkPlanCache = new gkBlendLinkPlanCache(dir);
+#endif
+}
+
+
+void gkBlendInternalFile::destroyLinkPlanCache(void)
+{
+#if OGREKIT_USE_BPARSE == 0
+	delete gkLinkPlanCache;
+	gkLinkPlanCache = 0;
+#endif
+}
+
+
+void gkBlendInternalFile::addConvertedMesh(Blender::Mesh* me, gkConvertedMesh* converted)
+{
+	GK_ASSERT(!hasConvertedMesh(me));
+	m_converted.insert(me, converted);
+}
+
+
+bool gkBlendInternalFile::hasConvertedMesh(Blender::Mesh* me)
+{
+	return m_converted.find(me) != UT_NPOS;
+}
+
+
+gkConvertedMesh* gkBlendInternalFile::takeConvertedMesh(Blender::Mesh* me, Blender::Object* bobj)
+{
+	UTsize pos = m_converted.find(me);
+	if (pos == UT_NPOS || m_converted.at(pos)->m_object != bobj)
+		return 0;
+
+	gkConvertedMesh* converted = m_converted.at(pos);
+	m_converted.remove(me);
+	return converted;
+}
+
 bool gkBlendInternalFile::parse(const gkString& fname)
 {
 	if (fname.empty()) 
@@ -115,7 +249,9 @@ bool gkBlendInternalFile::parse(const gkString& fname)
 #else
 
 	m_file = new fbtBlend();
-	int status = m_file->parse(fname.c_str(), fbtFile::PM_COMPRESSED);
+	gkSetupBlend(m_file, m_lazy, m_threaded);
+
+	int status = m_file->parse(fname.c_str(), fbtFile::PM_MAPPED);
 	if (status != fbtFile::FS_OK)
 	{
 		delete m_file;
@@ -124,6 +260,10 @@ bool gkBlendInternalFile::parse(const gkString& fname)
 		return false;
 	}
 
+	// cooked files are detected on the mapping fbtFile keeps
+	if (m_file->getPackage())
+		m_package = new gkBlendPackage(m_file->getPackage());
+
 #endif
 
 	return true;
@@ -137,6 +277,7 @@ bool gkBlendInternalFile::parse(const void* mem, int size)
 	return false;
 #else
 	m_file = new fbtBlend();
+	gkSetupBlend(m_file, m_lazy, m_threaded);
 
 	// first check to use uncompressed version
 	int status = m_file->parse(mem,size, fbtFile::PM_UNCOMPRESSED,true);
@@ -155,6 +296,9 @@ bool gkBlendInternalFile::parse(const void* mem, int size)
 		return false;
 	}
 
+	if (m_file->getPackage())
+		m_package = new gkBlendPackage(m_file->getPackage());
+
 	return true;
 #endif
 }
@@ -170,6 +314,15 @@ Blender::FileGlobal* gkBlendInternalFile::getFileGlobal()
 #endif
 }
 
+void gkBlendInternalFile::link(void* id)
+{
+	GK_ASSERT(m_file);
+
+#if OGREKIT_USE_BPARSE == 0
+	m_file->linkBlock(id);
+#endif
+}
+
 int gkBlendInternalFile::getVersion()
 {
 	GK_ASSERT(m_file);
@@ -207,7 +360,7 @@ Blender::Scene* gkBlendInternalFile::getFirstScene()
 		gkBlendListIterator gkBlendInternalFile::FNAME() \
 		{ \
 			GK_ASSERT(m_file); \
-			gkBlendListIterator iter(&m_file->FBTNAME); \
+			gkBlendListIterator iter(&m_file->FBTNAME, m_file); \
 			return iter; \
 		}
 
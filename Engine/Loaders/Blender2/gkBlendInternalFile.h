@@ -39,6 +39,9 @@
 
 #include "Blender.h"
 
+class gkBlendPackage;
+class gkConvertedMesh;
+
 
 		 
 class gkBlendListIterator
@@ -57,12 +60,22 @@ public:
 protected:
 	List* m_list;
 	ListIndex m_index;
+#if OGREKIT_USE_BPARSE == 0
+	fbtFile* m_file;
+#endif
 
 public:
+#if OGREKIT_USE_BPARSE
 	gkBlendListIterator(List* list);
+#else
+	gkBlendListIterator(List* list, fbtFile* file = 0);
+#endif
 
 	bool hasMoreElements() const;
-	ListItem* getNext(void);
+
+	/// Items of a lazily linked file only have their values converted
+	/// until they are linked, ID names can be read either way.
+	ListItem* getNext(bool link = true);
 };
 
 
@@ -73,6 +86,12 @@ class gkBlendInternalFile
 #else
 	fbtBlend*					m_file;
 #endif
+	bool						m_lazy;
+	gkBlendPackage*				m_package;	// cooked meshes, 0 for plain blends
+	bool						m_threaded;
+
+	typedef utHashTable<utPointerHashKey, gkConvertedMesh*> ConvertedMeshes;
+	ConvertedMeshes				m_converted;
 
 public:
 	gkBlendInternalFile();
@@ -82,6 +101,30 @@ public:
 
 	bool parse(const void* mem, int size);
 
+	/// Package the file was loaded from, see gkBlendPackage.
+	gkBlendPackage* getPackage(void) {return m_package;}
+
+	/// Has to be set before parsing on a loader thread, the engine job pool
+	/// only takes jobs from the main thread.
+	void setThreaded(bool threaded) {m_threaded = threaded;}
+	bool isThreaded(void) const     {return m_threaded;}
+
+	/// Link plans shared by every parsed file, set up by gkBlendLoader on the
+	/// main thread. Files parsed without it compile their own plans.
+	static void createLinkPlanCache(const gkString& dir);
+	static void destroyLinkPlanCache(void);
+
+	/// Mesh converted ahead on a loader thread, owned by the file.
+	void addConvertedMesh(Blender::Mesh* me, gkConvertedMesh* converted);
+	bool hasConvertedMesh(Blender::Mesh* me);
+
+	/// Converted mesh of me if it was converted for bobj, the caller owns it.
+	gkConvertedMesh* takeConvertedMesh(Blender::Mesh* me, Blender::Object* bobj);
+
+	/// Has to be set before parsing, ignored by bParse.
+	void setLazyLink(bool lazy) {m_lazy = lazy;}
+	void link(void* id);
+
 	Blender::FileGlobal* getFileGlobal();
 	Blender::Scene* getFirstScene();
 
@@ -26,6 +26,8 @@
 */
 #include "gkBlendLoader.h"
 #include "gkBlendFile.h"
+#include "gkBlendPackage.h"
+#include "gkBlendInternalFile.h"
 #include "gkLogger.h"
 #include "gkEngine.h"
 #include "gkUserDefs.h"
@@ -33,22 +35,91 @@
 #include "gkResourceGroupManager.h"
 //#include "bBlenderFile.h"
 #include "Blender.h"
+#include "OgreTimer.h"
+
+
+
+class gkBlendLoadCall : public gkCall
+{
+public:
+
+	gkBlendLoadCall(gkBlendFile* file, int options, const gkString& scene, gkBlendLoader::ASYNC_BOOL_RESULT result)
+		:	m_file(file), m_options(options), m_scene(scene), m_result(result) {}
+
+	~gkBlendLoadCall() {}
+
+	void run()
+	{
+		// Everything that does not need Ogre, the rest is done by gkBlendLoader::tick.
+		bool result = false;
+		try
+		{
+			result = m_file->parseFile(m_options, true);
+			if (result)
+				m_file->prepareMeshes(m_options, m_scene);
+		}
+		catch (...)
+		{
+			result = false;
+		}
+
+		m_result = result;
+	}
+
+private:
+
+	gkBlendFile* m_file;
+	int          m_options;
+	gkString     m_scene;
+
+	gkBlendLoader::ASYNC_BOOL_RESULT m_result;
+};
+
 
 
 gkBlendLoader::gkBlendLoader()
-	:   m_activeFile(0)
+	:   m_activeFile(0),
+	    m_asyncLoader(0)
 {
+	if (gkEngine::getSingletonPtr())
+	{
+		gkEngine::getSingleton().addListener(this);
+
+		// before any loader thread can parse
+		gkBlendInternalFile::createLinkPlanCache(gkEngine::getSingleton().getUserDefs().linkPlanCachePath);
+	}
 }
 
 
 
 gkBlendLoader::~gkBlendLoader()
 {
+	if (gkEngine::getSingletonPtr())
+		gkEngine::getSingleton().removeListener(this);
+
+	if (m_asyncLoader)
+	{
+		m_asyncLoader->join();
+		delete m_asyncLoader;
+		m_asyncLoader = 0;
+	}
+
 	UTsize i;
+	for (i = 0; i < m_loads.size(); i++)
+	{
+		// files still being loaded are not in m_files
+		if (!m_loads[i]->isDone())
+			delete m_loads[i]->m_file;
+		delete m_loads[i];
+	}
+	m_loads.clear();
+
 	for (i = 0; i < m_files.size(); i++)
 		delete m_files[i];
 	m_files.clear();
 	m_activeFile = 0;
+
+	gkBlendInternalFile::destroyLinkPlanCache();
 }
 
 bool gkBlendLoader::hasResourceGroup(const gkString& group, gkBlendFile* exceptFile)
@@ -101,7 +172,9 @@ void gkBlendLoader::unloadGroup(const gkString& group)
 	{
 		if (m_files[i]->getResourceGroup() == group)
 		{
-			gkString resgroup = m_files[i]->getResourceGroup();
+			if (m_activeFile == m_files[i])
+				m_activeFile = NULL;
+
 			delete m_files[i]; m_files[i] = 0;
 		}
 		else
@@ -143,16 +216,11 @@ void gkBlendLoader::unloadFile(gkBlendFile* blendFile)
 		gkResourceGroupManager::getSingleton().destroyResourceGroup(group);
 }
 
-gkBlendFile* gkBlendLoader::loadFromMemory(const void* mem, int memsize, int options, const gkString& scene, const gkString& group)
+gkString gkBlendLoader::createGroup(int options, const gkString& group)
 {
-
-	bool useUniqueGroup = false;
 	gkString groupName = group;
 	if (groupName.empty() && (options & LO_CREATE_UNIQUE_GROUP) != 0)
-	{
 		groupName = gkUtils::getUniqueName("BLEND");
-		useUniqueGroup = true;
-	}
 
 	bool inGlolbalPool = (options & LO_CREATE_PRIVATE_GROUP) == 0;
 
@@ -160,7 +228,13 @@ gkBlendFile* gkBlendLoader::loadFromMemory(const void* mem, int memsize, int opt
 
 	//bParse::bLog::detail = gkEngine::getSingleton().getUserDefs().verbose ? 1 : 0;
 
-	m_activeFile = new gkBlendFile(mem, memsize,groupName);
+	return groupName;
+}
+
+gkBlendFile* gkBlendLoader::loadFromMemory(const void* mem, int memsize, int options, const gkString& scene, const gkString& group)
+{
+
+	m_activeFile = new gkBlendFile(mem, memsize,createGroup(options, group));
 
 	if (m_activeFile->parse(options, scene))
 	{
@@ -185,21 +259,7 @@ gkBlendFile* gkBlendLoader::loadAndCatch(const gkString& fname, int options, con
 			return m_activeFile;
 	}
 
-	bool useUniqueGroup = false;
-	gkString groupName = group;
-	if (groupName.empty() && (options & LO_CREATE_UNIQUE_GROUP) != 0) 
-	{
-		groupName = gkUtils::getUniqueName("BLEND");
-		useUniqueGroup = true;
-	}
-
-	bool inGlolbalPool = (options & LO_CREATE_PRIVATE_GROUP) == 0;
-
-	gkResourceGroupManager::getSingleton().createResourceGroup(groupName, inGlolbalPool);
-
-	//bParse::bLog::detail = gkEngine::getSingleton().getUserDefs().verbose ? 1 : 0;
-
-	m_activeFile = new gkBlendFile(fname, groupName);
+	m_activeFile = new gkBlendFile(fname, createGroup(options, group));
 
 	if (m_activeFile->parse(options, scene))
 	{
@@ -216,6 +276,18 @@ gkBlendFile* gkBlendLoader::loadAndCatch(const gkString& fname, int options, con
 }
 
 
+bool gkBlendLoader::cookFile(const gkString& fname, const gkString& dest)
+{
+	gkBlendFile* file = loadFile(fname, LO_ALL_SCENES | LO_CREATE_UNIQUE_GROUP);
+	if (!file)
+		return false;
+
+	bool result = gkBlendPackage::cook(file, dest);
+	unloadFile(file);
+	return result;
+}
+
+
 gkBlendFile* gkBlendLoader::loadFile(const gkString& fname, const gkString& scene, const gkString& group)
 {
 	return loadFile(fname, LO_ALL_SCENES, scene, group);
@@ -252,4 +324,190 @@ gkBlendFile* gkBlendLoader::loadFile(const gkString& fname, int options, const g
 	return 0;
 }
 
+
+
+gkBlendLoader::AsyncLoad* gkBlendLoader::loadFileAsync(const gkString& fname, int options, const gkString& scene, const gkString& group)
+{
+	AsyncLoad* load = new AsyncLoad(fname, options, scene);
+	m_loads.push_back(load);
+
+	if ((options & LO_IGNORE_CACHE_FILE) != 0)
+	{
+		gkBlendFile* file = getFileByName(fname);
+		if (file != 0)
+		{
+			m_activeFile = file;
+			load->m_file = file;
+			load->m_state = AsyncLoad::AS_DONE;
+			return load;
+		}
+	}
+
+	load->m_file = new gkBlendFile(fname, createGroup(options, group));
+
+	if (!m_asyncLoader)
+		m_asyncLoader = new gkActiveObject("BlendLoader");
+
+	gkPtrRef<gkCall> call(new gkBlendLoadCall(load->m_file, options, scene, load->m_result));
+	m_asyncLoader->enqueue(call);
+	return load;
+}
+
+
+void gkBlendLoader::completeLoad(AsyncLoad* load)
+{
+	GK_ASSERT(load->m_state == AsyncLoad::AS_PARSING);
+
+	// blocks until the loader thread is done with the file
+	bool loaded = load->m_result.getResult() && !load->m_released;
+
+	gkBlendFile* file = load->m_file;
+	if (loaded)
+	{
+		try
+		{
+			file->beginConvert(load->m_options, load->m_scene);
+			load->m_state = AsyncLoad::AS_CONVERTING;
+			return;
+		}
+		catch (Ogre::Exception& e)
+		{
+			gkLogMessage("BlendLoader: Ogre exception: " << e.getDescription());
+		}
+		catch (...)
+		{
+			gkLogMessage("BlendLoader: Unknown exception");
+		}
+	}
+
+	if (!load->m_released)
+		gkLogMessage("BlendLoader: Failed to load " << load->m_name << ".");
+
+	delete file;
+	load->m_file = 0;
+	load->m_state = AsyncLoad::AS_FAILED;
+}
+
+
+bool gkBlendLoader::convertLoad(AsyncLoad* load, unsigned long budget)
+{
+	GK_ASSERT(load->m_state == AsyncLoad::AS_CONVERTING);
+
+	// Scenes already created can't be dropped halfway, a released load is converted to the end as well.
+	gkBlendFile* file = load->m_file;
+	Ogre::Timer timer;
+	bool more = true;
+
+	try
+	{
+		while (more && (budget == 0 || timer.getMicroseconds() < budget))
+			more = file->convertStep();
+	}
+	catch (Ogre::Exception& e)
+	{
+		gkLogMessage("BlendLoader: Ogre exception: " << e.getDescription());
+		more = false;
+		load->m_state = AsyncLoad::AS_FAILED;
+	}
+	catch (...)
+	{
+		gkLogMessage("BlendLoader: Unknown exception");
+		more = false;
+		load->m_state = AsyncLoad::AS_FAILED;
+	}
+
+	if (more)
+		return false;
+
+	if (load->m_state == AsyncLoad::AS_FAILED)
+	{
+		gkLogMessage("BlendLoader: Failed to load " << load->m_name << ".");
+		delete file;
+		load->m_file = 0;
+	}
+	else
+	{
+		m_files.push_back(file);
+		m_activeFile = file;
+		load->m_state = AsyncLoad::AS_DONE;
+	}
+	return true;
+}
+
+
+gkBlendFile* gkBlendLoader::finishLoad(AsyncLoad* load)
+{
+	GK_ASSERT(load && m_loads.find(load) != UT_NPOS);
+
+	if (load->m_state == AsyncLoad::AS_PARSING)
+		completeLoad(load);
+
+	if (load->m_state == AsyncLoad::AS_CONVERTING)
+		convertLoad(load, 0);
+
+	return load->getFile();
+}
+
+
+void gkBlendLoader::releaseLoad(AsyncLoad* load)
+{
+	if (!load)
+		return;
+
+	if (!load->isDone())
+	{
+		// the loader thread or the next ticks still have the file
+		load->m_released = true;
+		return;
+	}
+
+	m_loads.erase(load);
+	delete load;
+}
+
+
+bool gkBlendLoader::isLoading(void)
+{
+	UTsize i;
+	for (i = 0; i < m_loads.size(); i++)
+	{
+		if (!m_loads[i]->isDone())
+			return true;
+	}
+	return false;
+}
+
+
+void gkBlendLoader::tick(gkScalar rate)
+{
+	const unsigned long budget = (unsigned long)(gkEngine::getSingleton().getUserDefs().instancingBudget * 1000.f);
+
+	// One load converts per tick, the others wait for their turn.
+	bool converted = false;
+
+	UTsize i = 0;
+	while (i < m_loads.size())
+	{
+		AsyncLoad* load = m_loads[i];
+
+		if (load->m_state == AsyncLoad::AS_PARSING && load->m_result.hasResult())
+			completeLoad(load);
+
+		if (load->m_state == AsyncLoad::AS_CONVERTING && !converted)
+		{
+			convertLoad(load, budget);
+			converted = budget > 0;
+		}
+
+		if (load->m_released && load->isDone())
+		{
+			m_loads.erase(i);
+			delete load;
+		}
+		else
+			++i;
+	}
+}
+
+
 UT_IMPLEMENT_SINGLETON(gkBlendLoader);
@@ -28,13 +28,17 @@
 #define _gkBlendLoader_h_
 
 #include "gkLoaderCommon.h"
+#include "gkEngine.h"
 #include "utSingleton.h"
+#include "Thread/gkActiveObject.h"
+#include "Thread/gkAsyncResult.h"
 
 
-class gkBlendLoader : public utSingleton<gkBlendLoader>
+class gkBlendLoader : public utSingleton<gkBlendLoader>, public gkEngine::Listener
 {
 public:
 	typedef utArray<gkBlendFile*> FileList;
+	typedef gkAsyncResult<bool>   ASYNC_BOOL_RESULT;
 
 
 	enum LoadOptions
@@ -43,10 +47,55 @@ public:
 		LO_ALL_SCENES				= 1 << 1,	// Load all scenes.
 		LO_IGNORE_CACHE_FILE		= 1 << 2,	// Load the blend file even if loaded.
 		LO_CREATE_UNIQUE_GROUP		= 1 << 3,	// Create unique resource group.
-		LO_CREATE_PRIVATE_GROUP		= 1 << 4	// Create private resource group, so invisible in the global pool.
+		LO_CREATE_PRIVATE_GROUP		= 1 << 4,	// Create private resource group, so invisible in the global pool.
+		LO_LAZY_LINK				= 1 << 5	// Convert only the file data reached from the loaded scenes.
 	};
 
 
+	///A file loaded by loadFileAsync.
+	///
+	///The file is read, linked and its meshes are converted by the loader thread,
+	///the scenes and everything needing Ogre or Bullet are created on the main
+	///thread by the following engine ticks, a few gkBlendFile::convertStep calls
+	///within gkUserDefs::instancingBudget per tick. Objects are instanced by the
+	///scene within the same budget like any other scene.
+	class AsyncLoad
+	{
+	public:
+		enum State
+		{
+			AS_PARSING,     // read by the loader thread
+			AS_CONVERTING,  // converted by the engine ticks
+			AS_DONE,
+			AS_FAILED
+		};
+
+		GK_INLINE const gkString& getFilePath(void) const {return m_name;}
+		GK_INLINE State           getState(void)    const {return m_state;}
+		GK_INLINE bool            isDone(void)      const {return m_state >= AS_DONE;}
+
+		///The loaded file once done, 0 before or on failure.
+		GK_INLINE gkBlendFile*    getFile(void)           {return m_state == AS_DONE ? m_file : 0;}
+
+	private:
+		friend class gkBlendLoader;
+
+		AsyncLoad(const gkString& name, int options, const gkString& scene)
+			:	m_name(name), m_options(options), m_scene(scene),
+			    m_state(AS_PARSING), m_file(0), m_released(false) {}
+
+		const gkString      m_name;
+		const int           m_options;
+		const gkString      m_scene;
+		State               m_state;
+		gkBlendFile*        m_file;
+		bool                m_released;
+		ASYNC_BOOL_RESULT   m_result;
+	};
+
+	typedef utArray<AsyncLoad*> AsyncLoads;
+
+
 public:
 	gkBlendLoader();
 	~gkBlendLoader();
@@ -63,8 +112,30 @@ public:
 	                     );
 
 
+	///Starts loading fname on the loader thread and returns right away. The
+	///load is owned by the loader until releaseLoad is called.
+	AsyncLoad* loadFileAsync(const gkString& fname,
+	                         int options = LO_ONLY_ACTIVE_SCENE,
+	                         const gkString& scene = "",
+	                         const gkString& group = ""
+	                        );
+
+	///Waits for the loader thread and converts the rest of the file now instead of on the next ticks.
+	gkBlendFile* finishLoad(AsyncLoad* load);
+
+	///Forgets the load, a finished file stays loaded. A pending one is dropped when the thread is done with it.
+	void releaseLoad(AsyncLoad* load);
+
+	///Returns true while an async load is read by the loader thread or converted.
+	bool isLoading(void);
+
+
 	gkBlendFile* getFileByName(const gkString& fname);
 
+	///Loads all scenes of fname and writes them as a cooked package to dest,
+	///see gkBlendPackage. Packages load through loadFile like any blend.
+	bool cookFile(const gkString& fname, const gkString& dest);
+
 
 	GK_INLINE FileList&      getFiles(void)          {return m_files;}
 	GK_INLINE gkBlendFile*   getActiveBlend(void)    {return m_activeFile;}
@@ -77,6 +148,9 @@ public:
 
 	UT_DECLARE_SINGLETON(gkBlendLoader);
 
+	///Converts the async loads the loader thread is done with.
+	void tick(gkScalar rate);
+
 	gkBlendFile* loadFromMemory(const void* mem,
 											 int memsize,
 											 int options=LO_ONLY_ACTIVE_SCENE,
@@ -93,9 +167,14 @@ private:
 	                         );
 
 	bool			hasResourceGroup(const gkString& group, gkBlendFile* exceptFile = NULL);
+	gkString		createGroup(int options, const gkString& group);
+	void			completeLoad(AsyncLoad* load);
+	bool			convertLoad(AsyncLoad* load, unsigned long budget);
 
 	gkBlendFile*    m_activeFile;
 	FileList        m_files;
+	AsyncLoads      m_loads;
+	gkActiveObject* m_asyncLoader;	// created by the first async load
 };
 
 
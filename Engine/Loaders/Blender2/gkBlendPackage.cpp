@@ -0,0 +1,626 @@
+/*
+-------------------------------------------------------------------------------
+    This file is part of OgreKit.
+    http://gamekit.googlecode.com/
+
+    Copyright (c) 2006-2013 Charlie C.
+
+    Contributor(s): none yet.
+-------------------------------------------------------------------------------
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#include "gkBlendPackage.h"
+#include "gkBlendPackageDefs.h"
+#include "gkBlendFile.h"
+#include "gkBlendInternalFile.h"
+#include "gkPackageSceneConverter.h"
+#include "gkScene.h"
+#include "gkEntity.h"
+#include "gkMesh.h"
+#include "gkSkeletonResource.h"
+#include "gkSkeletonManager.h"
+#include "gkBone.h"
+#include "gkAnimation.h"
+#include "gkAnimationManager.h"
+#include "gkLogger.h"
+#include "utStreams.h"
+
+#include "fbtPackage.h"
+#include "fbtFile.h"
+
+
+static void gkCookedWriteMaterial(utMemoryStream& stream, const gkMaterialProperties& ma)
+{
+	gkCookedWrite(stream, ma.m_name);
+	gkCookedWrite(stream, ma.m_mode);
+	gkCookedWrite(stream, ma.m_rblend);
+	gkCookedWrite(stream, ma.m_diffuse);
+	gkCookedWrite(stream, ma.m_specular);
+	gkCookedWrite(stream, ma.m_hardness);
+	gkCookedWrite(stream, ma.m_refraction);
+	gkCookedWrite(stream, ma.m_emissive);
+	gkCookedWrite(stream, ma.m_ambient);
+	gkCookedWrite(stream, ma.m_spec);
+	gkCookedWrite(stream, ma.m_alpha);
+	gkCookedWrite(stream, ma.m_depthOffset);
+	gkCookedWrite(stream, ma.m_tangentLayer);
+	gkCookedWrite(stream, ma.m_totaltex);
+
+	for (int i = 0; i < ma.m_totaltex; ++i)
+	{
+		const gkTextureProperties& te = ma.m_textures[i];
+		gkCookedWrite(stream, te.m_name);
+		gkCookedWrite(stream, te.m_image);
+		gkCookedWrite(stream, te.m_color);
+		gkCookedWrite(stream, te.m_layer);
+		gkCookedWrite(stream, te.m_type);
+		gkCookedWrite(stream, te.m_blend);
+		gkCookedWrite(stream, te.m_mode);
+		gkCookedWrite(stream, te.m_texmode);
+		gkCookedWrite(stream, te.m_mix);
+		gkCookedWrite(stream, te.m_normalFactor);
+		gkCookedWrite(stream, te.m_diffuseColorFactor);
+		gkCookedWrite(stream, te.m_diffuseAlpahFactor);
+		gkCookedWrite(stream, te.m_speculaColorFactor);
+		gkCookedWrite(stream, te.m_speculaHardFactor);
+		gkCookedWrite(stream, te.m_scale);
+	}
+}
+
+
+static bool gkCookedReadMaterial(gkCookedReader& reader, gkMaterialProperties& ma)
+{
+	reader.read(ma.m_name);
+	reader.read(ma.m_mode);
+	reader.read(ma.m_rblend);
+	reader.read(ma.m_diffuse);
+	reader.read(ma.m_specular);
+	reader.read(ma.m_hardness);
+	reader.read(ma.m_refraction);
+	reader.read(ma.m_emissive);
+	reader.read(ma.m_ambient);
+	reader.read(ma.m_spec);
+	reader.read(ma.m_alpha);
+	reader.read(ma.m_depthOffset);
+	reader.read(ma.m_tangentLayer);
+
+	if (!reader.read(ma.m_totaltex) || ma.m_totaltex < 0 || ma.m_totaltex > GK_MAX_TEXTURE)
+		return false;
+
+	for (int i = 0; i < ma.m_totaltex; ++i)
+	{
+		gkTextureProperties& te = ma.m_textures[i];
+		reader.read(te.m_name);
+		reader.read(te.m_image);
+		reader.read(te.m_color);
+		reader.read(te.m_layer);
+		reader.read(te.m_type);
+		reader.read(te.m_blend);
+		reader.read(te.m_mode);
+		reader.read(te.m_texmode);
+		reader.read(te.m_mix);
+		reader.read(te.m_normalFactor);
+		reader.read(te.m_diffuseColorFactor);
+		reader.read(te.m_diffuseAlpahFactor);
+		reader.read(te.m_speculaColorFactor);
+		reader.read(te.m_speculaHardFactor);
+		reader.read(te.m_scale);
+	}
+	return reader.ok();
+}
+
+
+
+// indices of a loaded submesh must stay inside its own buffers
+static bool gkBlendPackage_validSubMesh(gkSubMesh* sub, UTsize groups)
+{
+	const UTsize verts = sub->getVertexBuffer().size();
+
+	gkSubMesh::Triangles& tris = sub->getIndexBuffer();
+	for (UTsize i = 0; i < tris.size(); ++i)
+	{
+		const gkTriangle& tri = tris.at(i);
+		if (tri.i0 >= verts || tri.i1 >= verts || tri.i2 >= verts)
+			return false;
+	}
+
+	gkSubMesh::DeformVerts& dverts = sub->getDeformVertexBuffer();
+	for (UTsize i = 0; i < dverts.size(); ++i)
+	{
+		const gkDeformVertex& dv = dverts.at(i);
+		if (dv.vertexId < 0 || (UTsize)dv.vertexId >= verts || dv.group < 0 || (UTsize)dv.group >= groups)
+			return false;
+	}
+	return true;
+}
+
+
+
+gkBlendPackage::gkBlendPackage(fbtPackage* package)
+	:	m_package(package)
+{
+	GK_ASSERT(m_package);
+}
+
+
+gkBlendPackage::~gkBlendPackage()
+{
+}
+
+
+bool gkBlendPackage::loadMesh(gkMesh* mesh)
+{
+	GK_ASSERT(mesh && mesh->m_submeshes.empty());
+
+	const fbtPackage::Section* sec = m_package->find(GK_PACKAGE_MESH, mesh->getResourceName().getName().c_str());
+	if (!sec)
+		return false;
+
+	gkCookedReader reader(m_package->getData(sec), (UTsize)sec->m_len);
+
+	gkCookedMeshHeader header;
+	if (!reader.read(header)
+	        || header.m_version != GK_PACKAGE_MESH_VERSION
+	        || header.m_scalarSize != sizeof(gkScalar)
+	        || header.m_vertexSize != sizeof(gkVertex)
+	        || header.m_deformSize != sizeof(gkDeformVertex))
+	{
+		gkLogMessage("BlendPackage: Mesh " << mesh->getResourceName().getName() << " was cooked by another build, converting it.");
+		return false;
+	}
+
+	for (UTuint32 i = 0; i < header.m_groups && reader.ok(); ++i)
+	{
+		gkString name;
+		if (reader.read(name))
+			mesh->createVertexGroup(name);
+	}
+
+	bool valid = true;
+	for (UTuint32 i = 0; i < header.m_submeshes && reader.ok(); ++i)
+	{
+		gkSubMesh* sub = new gkSubMesh();
+		mesh->addSubMesh(sub);
+
+		int layers = 0;
+		UTuint8 colors = 0;
+		reader.read(layers);
+		reader.read(colors);
+		sub->setTotalLayers(layers);
+		sub->setVertexColors(colors != 0);
+
+		if (gkCookedReadMaterial(reader, sub->getMaterial()))
+		{
+			reader.read(sub->getVertexBuffer());
+			reader.read(sub->getIndexBuffer());
+			reader.read(sub->getDeformVertexBuffer());
+		}
+
+		if (reader.ok() && !gkBlendPackage_validSubMesh(sub, mesh->getGroups().size()))
+		{
+			valid = false;
+			break;
+		}
+	}
+
+	if (!valid || !reader.ok())
+	{
+		gkLogMessage("BlendPackage: Mesh " << mesh->getResourceName().getName() << " is damaged, converting it.");
+
+		// back to empty for the converter
+		for (UTsize i = 0; i < mesh->m_submeshes.size(); ++i)
+			delete mesh->m_submeshes.at(i);
+		for (UTsize i = 0; i < mesh->getGroups().size(); ++i)
+			delete mesh->getGroups().at(i);
+
+		mesh->m_submeshes.clear();
+		mesh->getGroups().clear();
+		return false;
+	}
+	return true;
+}
+
+
+bool gkBlendPackage::getSection(UTuint32 code, const gkString& name, const void*& data, UTsize& len)
+{
+	const fbtPackage::Section* sec = m_package->find(code, name.c_str());
+	if (!sec)
+		return false;
+
+	data = m_package->getData(sec);
+	len  = (UTsize)sec->m_len;
+	return true;
+}
+
+
+bool gkBlendPackage::hasScene(const gkString& name)
+{
+	const UTuint32 codes[3] = {GK_PACKAGE_SCENE, GK_PACKAGE_COLLISION, GK_PACKAGE_LOGIC};
+
+	for (int i = 0; i < 3; ++i)
+	{
+		const void* data;
+		UTsize len;
+		if (!getSection(codes[i], name, data, len))
+			return false;
+
+		gkCookedReader reader(data, len);
+		if (!reader.readHeader())
+		{
+			gkLogMessage("BlendPackage: Scene " << name << " was cooked by another build, converting it.");
+			return false;
+		}
+	}
+	return true;
+}
+
+
+bool gkBlendPackage::loadAnimations(const gkString& group)
+{
+	gkAnimationManager& mgr = gkAnimationManager::getSingleton();
+
+	bool found = false;
+	for (FBTsize i = 0; i < m_package->getSectionCount(); ++i)
+	{
+		const fbtPackage::Section* sec = m_package->getSection(i);
+		if (sec->m_code != GK_PACKAGE_ANIMATION)
+			continue;
+
+		found = true;
+
+		const gkResourceName name(sec->m_name, group);
+		if (mgr.exists(name))
+			continue;
+
+		gkKeyedAnimation* act = mgr.createKeyedAnimation(name);
+		if (!act)
+			continue;
+
+		gkCookedReader reader(m_package->getData(sec), (UTsize)sec->m_len);
+
+		gkScalar length = 0;
+		UTuint32 channels = 0;
+		if (reader.readHeader())
+		{
+			reader.read(length);
+			reader.readCount(channels, 3 * sizeof(UTuint32));
+		}
+		else if (reader.ok())
+		{
+			// the first cooked by another build, actions are converted
+			gkLogMessage("BlendPackage: Animation " << sec->m_name << " was cooked by another build, converting all.");
+			mgr.destroy(act);
+			return false;
+		}
+
+		for (UTuint32 c = 0; c < channels && reader.ok(); ++c)
+		{
+			int kind = 0;
+			gkString chanName;
+			bool euler = false;
+			UTuint32 splines = 0;
+			reader.read(kind);
+			reader.read(chanName);
+			reader.read(euler);
+			reader.readCount(splines, 3 * sizeof(UTuint32));
+			if (!reader.ok())
+				break;
+
+			gkTransformChannel* chan;
+			if (kind == 1)
+				chan = new gkBoneChannel(chanName, act);
+			else
+				chan = new gkObjectChannel(chanName, act);
+
+			chan->setEulerRotation(euler);
+			act->addChannel(chan);
+
+			for (UTuint32 s = 0; s < splines && reader.ok(); ++s)
+			{
+				int code = 0, interp = akBezierSpline::BEZ_LINEAR;
+				utArray<akBezierVertex> verts;
+				reader.read(code);
+				reader.read(interp);
+				if (!reader.read(verts))
+					break;
+
+				akBezierSpline* spline = new akBezierSpline(code);
+				spline->setInterpolationMethod((akBezierSpline::BezierInterpolation)interp);
+				for (UTsize v = 0; v < verts.size(); ++v)
+					spline->addVertex(verts[v]);
+
+				chan->addSpline(spline);
+			}
+		}
+
+		if (!reader.ok())
+		{
+			gkLogMessage("BlendPackage: Animation " << sec->m_name << " is damaged, converting all.");
+			mgr.destroy(act);
+			return false;
+		}
+
+		act->setLength(length);
+	}
+	return found;
+}
+
+
+bool gkBlendPackage::loadSkeleton(gkSkeletonResource* skel)
+{
+	GK_ASSERT(skel && skel->getBoneList().empty());
+
+	const gkString& name = skel->getResourceName().getName();
+
+	const void* data;
+	UTsize len;
+	if (!getSection(GK_PACKAGE_SKELETON, name, data, len))
+		return false;
+
+	gkCookedReader reader(data, len);
+
+	UTuint32 count = 0;
+	if (!reader.readHeader() || !reader.readCount(count, 2 * sizeof(UTuint32)))
+	{
+		gkLogMessage("BlendPackage: Skeleton " << name << " is damaged or cooked by another build.");
+		return false;
+	}
+
+	// parents are set once all bones exist
+	utArray<gkBone*> created;
+	utArray<gkString> parents;
+
+	for (UTuint32 i = 0; i < count && reader.ok(); ++i)
+	{
+		gkString bone, parent;
+		gkTransformState rest;
+		reader.read(bone);
+		reader.read(parent);
+		if (!reader.read(rest))
+			break;
+
+		gkBone* gbone = skel->createBone(bone);
+		if (gbone)
+		{
+			gbone->setRestPosition(rest);
+			created.push_back(gbone);
+			parents.push_back(parent);
+		}
+	}
+
+	if (!reader.ok())
+	{
+		gkLogMessage("BlendPackage: Skeleton " << name << " is damaged.");
+		return false;
+	}
+
+	for (UTsize i = 0; i < created.size(); ++i)
+	{
+		gkBone* parent = parents[i].empty() ? 0 : skel->getBone(parents[i]);
+		if (parent)
+			created[i]->setParent(parent);
+	}
+	return true;
+}
+
+
+
+void gkBlendPackage::writeMesh(gkMesh* mesh, utMemoryStream& stream)
+{
+	gkCookedMeshHeader header;
+	header.m_version    = GK_PACKAGE_MESH_VERSION;
+	header.m_scalarSize = sizeof(gkScalar);
+	header.m_vertexSize = sizeof(gkVertex);
+	header.m_deformSize = sizeof(gkDeformVertex);
+	header.m_groups     = mesh->getGroups().size();
+	header.m_submeshes  = mesh->m_submeshes.size();
+	gkCookedWrite(stream, header);
+
+	for (UTsize i = 0; i < mesh->getGroups().size(); ++i)
+		gkCookedWrite(stream, mesh->getGroups().at(i)->getName());
+
+	gkMesh::SubMeshIterator iter = mesh->getSubMeshIterator();
+	while (iter.hasMoreElements())
+	{
+		gkSubMesh* sub = iter.getNext();
+
+		gkCookedWrite(stream, sub->getUvLayerCount());
+		gkCookedWrite(stream, sub->hasVertexColors());
+		gkCookedWriteMaterial(stream, sub->getMaterial());
+		gkCookedWrite(stream, sub->getVertexBuffer());
+		gkCookedWrite(stream, sub->getIndexBuffer());
+		gkCookedWrite(stream, sub->getDeformVertexBuffer());
+	}
+}
+
+
+void gkBlendPackage::writeAnimation(gkKeyedAnimation* act, utMemoryStream& stream)
+{
+	gkCookedWriteHeader(stream);
+	gkCookedWrite(stream, act->getLength());
+	gkCookedWrite(stream, (UTuint32)act->getNumChannels());
+
+	akKeyedAnimation::Channels::ConstPointer channels = act->getChannels();
+	for (int c = 0; c < act->getNumChannels(); ++c)
+	{
+		const gkTransformChannel* chan = static_cast<const gkTransformChannel*>(channels[c]);
+
+		gkCookedWrite(stream, dynamic_cast<const gkBoneChannel*>(chan) ? 1 : 0);
+		gkCookedWrite(stream, chan->getName());
+		gkCookedWrite(stream, chan->isEulerRotation());
+		gkCookedWrite(stream, (UTuint32)chan->getNumSplines());
+
+		const akBezierSpline** splines = chan->getSplines();
+		for (int s = 0; s < chan->getNumSplines(); ++s)
+		{
+			const akBezierSpline* spline = splines[s];
+			UTuint32 verts = (UTuint32)spline->getNumVerts();
+
+			gkCookedWrite(stream, spline->getCode());
+			gkCookedWrite(stream, (int)spline->getInterpolationMethod());
+			gkCookedWrite(stream, verts);
+			if (verts)
+				stream.write(spline->getVerts(), verts * sizeof(akBezierVertex));
+		}
+	}
+}
+
+
+void gkBlendPackage::writeSkeleton(gkSkeletonResource* skel, utMemoryStream& stream)
+{
+	gkCookedWriteHeader(stream);
+
+	// the rest pose already holds the root transform of linked meshes
+	gkBone::BoneList& bones = skel->getBoneList();
+	gkCookedWrite(stream, (UTuint32)bones.size());
+	for (UTsize i = 0; i < bones.size(); ++i)
+	{
+		gkBone* bone = bones[i];
+		gkCookedWrite(stream, bone->getName());
+		gkCookedWrite(stream, bone->getParent() ? bone->getParent()->getName() : gkString());
+		gkCookedWrite(stream, bone->getRest());
+	}
+}
+
+
+
+bool gkBlendPackage::cook(gkBlendFile* file, const gkString& dest)
+{
+	GK_ASSERT(file);
+
+	if (file->_getInternalFile()->getPackage())
+	{
+		gkLogMessage("BlendPackage: " << file->getFilePath() << " is cooked already.");
+		return false;
+	}
+
+	fbtPackage package;
+	if (!package.addFile(GK_PACKAGE_BLEND, "", file->getFilePath().c_str()))
+	{
+		gkLogMessage("BlendPackage: Cannot read " << file->getFilePath() << ".");
+		return false;
+	}
+
+	// the converter shares meshes by name, one section each
+	utArray<gkMesh*> written;
+
+	gkBlendFile::Scenes::Iterator sit = file->getScenes().iterator();
+	while (sit.hasMoreElements())
+	{
+		gkGameObjectHashMap::Iterator oit = sit.getNext()->getObjects().iterator();
+		while (oit.hasMoreElements())
+		{
+			gkGameObject* obj = oit.getNext().second;
+			if (obj->getType() != GK_ENTITY)
+				continue;
+
+			gkMesh* mesh = static_cast<gkEntity*>(obj)->getEntityProperties().m_mesh;
+			if (!mesh || written.find(mesh) != UT_NPOS)
+				continue;
+
+			const gkString& name = mesh->getResourceName().getName();
+			if (name.size() >= fbtPackage::NAME_LEN)
+			{
+				gkLogMessage("BlendPackage: Mesh name " << name << " is too long, it is converted at load.");
+				continue;
+			}
+
+			written.push_back(mesh);
+
+			utMemoryStream stream(utStream::SM_WRITE);
+			writeMesh(mesh, stream);
+			if (!package.addSection(GK_PACKAGE_MESH, name.c_str(), stream.ptr(), stream.size()))
+			{
+				gkLogMessage("BlendPackage: Out of memory adding mesh " << name << ".");
+				return false;
+			}
+		}
+	}
+
+	const gkString& group = file->getResourceGroup();
+
+	// all or none, a missing animation could not be converted without the others
+	utArray<gkKeyedAnimation*> anims;
+	bool animsFit = true;
+
+	gkResourceManager::ResourceIterator ait = gkAnimationManager::getSingleton().getResourceIterator();
+	while (ait.hasMoreElements())
+	{
+		gkKeyedAnimation* act = dynamic_cast<gkKeyedAnimation*>(ait.getNext().second);
+		if (!act || act->getGroupName() != group)
+			continue;
+
+		if (act->getName().size() >= fbtPackage::NAME_LEN)
+		{
+			gkLogMessage("BlendPackage: Animation name " << act->getName() << " is too long, animations are converted at load.");
+			animsFit = false;
+			break;
+		}
+		anims.push_back(act);
+	}
+
+	UTsize i;
+	for (i = 0; animsFit && i < anims.size(); ++i)
+	{
+		utMemoryStream stream(utStream::SM_WRITE);
+		writeAnimation(anims[i], stream);
+		if (!package.addSection(GK_PACKAGE_ANIMATION, anims[i]->getName().c_str(), stream.ptr(), stream.size()))
+		{
+			gkLogMessage("BlendPackage: Out of memory adding animation " << anims[i]->getName() << ".");
+			return false;
+		}
+	}
+
+	// scenes whose skeleton does not fit are converted at load
+	gkResourceManager::ResourceIterator kit = gkSkeletonManager::getSingleton().getResourceIterator();
+	while (kit.hasMoreElements())
+	{
+		gkSkeletonResource* skel = static_cast<gkSkeletonResource*>(kit.getNext().second);
+		if (skel->getGroupName() != group || skel->getName().size() >= fbtPackage::NAME_LEN)
+			continue;
+
+		utMemoryStream stream(utStream::SM_WRITE);
+		writeSkeleton(skel, stream);
+		if (!package.addSection(GK_PACKAGE_SKELETON, skel->getName().c_str(), stream.ptr(), stream.size()))
+		{
+			gkLogMessage("BlendPackage: Out of memory adding skeleton " << skel->getName() << ".");
+			return false;
+		}
+	}
+
+	UTsize scenes = 0;
+	for (i = 0; i < file->getScenes().size(); ++i)
+	{
+		gkScene* scene = file->getScenes()[i];
+		if (gkPackageSceneConverter::cook(scene, package))
+			++scenes;
+		else
+		{
+			gkLogMessage("BlendPackage: Scene " << scene->getName() << " is converted at load.");
+		}
+	}
+
+	if (package.save(dest.c_str()) != fbtFile::FS_OK)
+	{
+		gkLogMessage("BlendPackage: Writing " << dest << " failed.");
+		return false;
+	}
+
+	gkLogMessage("BlendPackage: Cooked " << scenes << " scenes and " << written.size() << " meshes of " << file->getFilePath() << " to " << dest << ".");
+	return true;
+}
@@ -0,0 +1,81 @@
+/*
+-------------------------------------------------------------------------------
+    This file is part of OgreKit.
+    http://gamekit.googlecode.com/
+
+    Copyright (c) 2006-2013 Charlie C.
+
+    Contributor(s): none yet.
+-------------------------------------------------------------------------------
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#ifndef _gkBlendPackage_h_
+#define _gkBlendPackage_h_
+
+#include "gkLoaderCommon.h"
+
+class fbtPackage;
+class utMemoryStream;
+
+
+///Cooked runtime package of a .blend file, see fbtPackage.
+///
+///A package holds the inflated .blend, which fbtFile parses in place from the
+///mapping, the converted vertex, index and deform buffers and materials of
+///every mesh, the keyed animations and skeletons, and per scene its objects,
+///groups, group instances, collision data and logic bricks. Scenes found in
+///the package are created by gkPackageSceneConverter, the others, and the
+///textures, sounds, fonts and texts of all, are converted from the embedded blend.
+class gkBlendPackage
+{
+public:
+	///Reads from the package fbtFile parsed the blend from, which has to outlive this.
+	gkBlendPackage(fbtPackage* package);
+	~gkBlendPackage();
+
+	///Data of a section in the mapping, false if there is none.
+	bool getSection(UTuint32 code, const gkString& name, const void*& data, UTsize& len);
+
+	///True if all sections of the scene are there and cooked by this build.
+	bool hasScene(const gkString& name);
+
+	///Fills an empty mesh from the section of the same name.
+	///Returns false if the package has none, or was cooked by another build.
+	bool loadMesh(gkMesh* mesh);
+
+	///Creates the cooked animations in group, false if there are none,
+	///or one failed to load, buildAllActions converts the rest then.
+	bool loadAnimations(const gkString& group);
+
+	///Fills an empty skeleton from the section of the same name.
+	bool loadSkeleton(gkSkeletonResource* skel);
+
+	///Writes the blend file was loaded from, and its converted resources and scenes, to dest.
+	static bool cook(gkBlendFile* file, const gkString& dest);
+
+private:
+
+	static void writeMesh(gkMesh* mesh, utMemoryStream& stream);
+	static void writeAnimation(gkKeyedAnimation* act, utMemoryStream& stream);
+	static void writeSkeleton(gkSkeletonResource* skel, utMemoryStream& stream);
+
+	fbtPackage* m_package;
+};
+
+
+#endif//_gkBlendPackage_h_
@@ -0,0 +1,219 @@
+/*
+-------------------------------------------------------------------------------
+    This file is part of OgreKit.
+    http://gamekit.googlecode.com/
+
+    Copyright (c) 2006-2013 Charlie C.
+
+    Contributor(s): none yet.
+-------------------------------------------------------------------------------
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#ifndef _gkBlendPackageDefs_h_
+#define _gkBlendPackageDefs_h_
+
+#include "gkCommon.h"
+#include "gkTransformState.h"
+#include "utStreams.h"
+#include "fbtTypes.h"
+
+
+// Section codes of a cooked package, the name of a section is the name
+// of the resource or scene it holds.
+#define GK_PACKAGE_BLEND        FBT_ID('B', 'L', 'N', 'D')
+#define GK_PACKAGE_MESH         FBT_ID('M', 'E', 'S', 'H')
+#define GK_PACKAGE_ANIMATION    FBT_ID('A', 'N', 'I', 'M')
+#define GK_PACKAGE_SKELETON     FBT_ID('S', 'K', 'E', 'L')
+#define GK_PACKAGE_SCENE        FBT_ID('S', 'C', 'N', 'E')
+#define GK_PACKAGE_INSTANCES    FBT_ID('I', 'N', 'S', 'T')
+#define GK_PACKAGE_COLLISION    FBT_ID('C', 'O', 'L', 'L')
+#define GK_PACKAGE_LOGIC        FBT_ID('L', 'O', 'G', 'C')
+
+#define GK_PACKAGE_MESH_VERSION 1
+#define GK_PACKAGE_DATA_VERSION 1
+
+
+// Start of every mesh section, meshes of other builds are converted again.
+struct gkCookedMeshHeader
+{
+	UTuint32    m_version;
+	UTuint32    m_scalarSize;
+	UTuint32    m_vertexSize;
+	UTuint32    m_deformSize;
+	UTuint32    m_groups;
+	UTuint32    m_submeshes;
+};
+
+
+// Start of every other section.
+struct gkCookedHeader
+{
+	UTuint32    m_version;
+	UTuint32    m_scalarSize;
+};
+
+
+// Bounds checked cursor over a section in the mapping.
+class gkCookedReader
+{
+public:
+	gkCookedReader(const void* data, UTsize size)
+		:	m_pos(static_cast<const char*>(data)), m_end(m_pos + size), m_ok(true)
+	{
+	}
+
+	bool read(void* dest, UTsize nr)
+	{
+		if (!m_ok || (UTsize)(m_end - m_pos) < nr)
+			return m_ok = false;
+
+		memcpy(dest, m_pos, nr);
+		m_pos += nr;
+		return true;
+	}
+
+	template <typename T> bool read(T& v) {return read(&v, sizeof(T));}
+
+	///Any byte but 0 is true, a raw byte is not a valid bool.
+	bool read(bool& v)
+	{
+		UTuint8 b = 0;
+		if (!read(&b, 1))
+			return false;
+		v = b != 0;
+		return true;
+	}
+
+	bool read(gkString& v)
+	{
+		UTuint32 len = 0;
+		if (!read(len) || (UTsize)(m_end - m_pos) < len)
+			return m_ok = false;
+
+		v.assign(m_pos, len);
+		m_pos += len;
+		return true;
+	}
+
+	bool read(gkTransformState& v)
+	{
+		read(v.loc);
+		read(v.rot);
+		return read(v.scl);
+	}
+
+	template <typename T> bool read(utArray<T>& v)
+	{
+		UTuint32 count = 0;
+		if (!read(count) || (UTsize)(m_end - m_pos) / sizeof(T) < count)
+			return m_ok = false;
+
+		v.resize(count);
+		return count == 0 || read(v.ptr(), count * sizeof(T));
+	}
+
+	///Reads a count written by gkCookedWrite, each element takes at least minSize bytes.
+	bool readCount(UTuint32& count, UTsize minSize = 1)
+	{
+		count = 0;
+		if (!read(count) || (UTsize)(m_end - m_pos) / minSize < count)
+			return m_ok = false;
+		return true;
+	}
+
+	///Cursor over a block written by gkCookedWriteBlock, this one moves past it.
+	bool readBlock(gkCookedReader& block)
+	{
+		UTuint32 len = 0;
+		if (!read(len) || (UTsize)(m_end - m_pos) < len)
+			return m_ok = false;
+
+		block = gkCookedReader(m_pos, len);
+		m_pos += len;
+		return true;
+	}
+
+	///Header test, false for sections of other builds.
+	bool readHeader(void)
+	{
+		gkCookedHeader header;
+		return read(header)
+		       && header.m_version     == GK_PACKAGE_DATA_VERSION
+		       && header.m_scalarSize  == sizeof(gkScalar);
+	}
+
+	bool ok(void) const {return m_ok;}
+
+private:
+	const char* m_pos;
+	const char* m_end;
+	bool        m_ok;
+};
+
+
+template <typename T> void gkCookedWrite(utMemoryStream& stream, const T& v)
+{
+	stream.write(&v, sizeof(T));
+}
+
+GK_INLINE void gkCookedWrite(utMemoryStream& stream, const bool& v)
+{
+	UTuint8 b = v ? 1 : 0;
+	stream.write(&b, 1);
+}
+
+GK_INLINE void gkCookedWrite(utMemoryStream& stream, const gkString& v)
+{
+	UTuint32 len = (UTuint32)v.size();
+	stream.write(&len, sizeof(UTuint32));
+	stream.write(v.c_str(), len);
+}
+
+GK_INLINE void gkCookedWrite(utMemoryStream& stream, const gkTransformState& v)
+{
+	gkCookedWrite(stream, v.loc);
+	gkCookedWrite(stream, v.rot);
+	gkCookedWrite(stream, v.scl);
+}
+
+template <typename T> void gkCookedWrite(utMemoryStream& stream, utArray<T>& v)
+{
+	UTuint32 count = (UTuint32)v.size();
+	stream.write(&count, sizeof(UTuint32));
+	if (count)
+		stream.write(v.ptr(), count * sizeof(T));
+}
+
+GK_INLINE void gkCookedWriteBlock(utMemoryStream& stream, utMemoryStream& block)
+{
+	UTuint32 len = (UTuint32)block.size();
+	stream.write(&len, sizeof(UTuint32));
+	if (len)
+		stream.write(block.ptr(), len);
+}
+
+GK_INLINE void gkCookedWriteHeader(utMemoryStream& stream)
+{
+	gkCookedHeader header;
+	header.m_version     = GK_PACKAGE_DATA_VERSION;
+	header.m_scalarSize  = sizeof(gkScalar);
+	gkCookedWrite(stream, header);
+}
+
+
+#endif//_gkBlendPackageDefs_h_
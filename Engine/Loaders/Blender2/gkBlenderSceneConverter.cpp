@@ -28,6 +28,8 @@
 
 #include "gkBlenderDefines.h"
 #include "gkBlenderSceneConverter.h"
+#include "gkBlendInternalFile.h"
+#include "gkBlendPackage.h"
 #include "Converters/gkAnimationConverter.h"
 #include "Converters/gkLogicBrickConverter.h"
 #include "Converters/gkMeshConverter.h"
@@ -138,6 +140,12 @@ void gkBlenderSceneConverter::convertWorld(void)
 		Blender::World* world = m_bscene->world;
 
 		sprops.m_gravity    = gkVector3(0.f, 0.f, -world->gravity);
+
+		sprops.m_activityCulling = (world->mode & WO_ACTIVITY_CULLING) != 0;
+		// one radius in blender, see gkUserDefs::physicsActivityRadius
+		sprops.m_logicRadius     = world->activityBoxRadius;
+		sprops.m_physicsRadius   = world->activityBoxRadius;
+
 		props.m_ambient.r   = world->ambr;
 		props.m_ambient.g   = world->ambg;
 		props.m_ambient.b   = world->ambb;
@@ -422,6 +430,9 @@ void gkBlenderSceneConverter::convertObjectGeneral(gkGameObject* gobj, Blender::
 	if (bobj->restrictflag & OB_RESTRICT_RENDER)
 		props.m_mode |= GK_INVISIBLE;
 
+	if (bobj->gameflag2 & OB_NEVER_DO_ACTIVITY_CULLING)
+		props.m_mode |= GK_NO_ACTIVITY_CULLING;
+
 	gobj->setActiveLayer((m_bscene->lay & bobj->lay) != 0);
 	gobj->setLayer((UTuint32)bobj->lay);
 }
@@ -874,8 +885,24 @@ void gkBlenderSceneConverter::convertObjectMesh(gkGameObject* gobj, Blender::Obj
 	{
 		props.m_mesh = m_gscene->createMesh(GKB_IDNAME(me));
 
-		gkBlenderMeshConverter meconv(props.m_mesh, bobj, me);
-		meconv.convert();
+		// cooked buffers and materials
+		gkBlendInternalFile* internal = m_file->_getInternalFile();
+		gkBlendPackage* package = internal->getPackage();
+		if (!package || !package->loadMesh(props.m_mesh))
+		{
+			// converted ahead on the loader thread
+			gkConvertedMesh* converted = internal->takeConvertedMesh(me, bobj);
+			if (converted)
+			{
+				converted->moveTo(props.m_mesh);
+				delete converted;
+			}
+			else
+			{
+				gkBlenderMeshConverter meconv(props.m_mesh, bobj, me);
+				meconv.convert();
+			}
+		}
 	}
 	else
 		props.m_mesh = m_gscene->getMesh(GKB_IDNAME(me));
@@ -946,6 +973,34 @@ void gkBlenderSceneConverter::convertObjectArmature(gkGameObject* gobj, Blender:
 	}
 }
 
+void gkBlenderSceneConverter::collectMeshes(gkBlendInternalFile* file, Blender::Scene* sc, utArray<gkConvertedMesh*>& meshes)
+{
+	// cooked meshes are cheap enough to load on the main thread
+	if (file->getPackage())
+		return;
+
+	for (Blender::Base* base = (Blender::Base*)sc->base.first; base; base = base->next)
+	{
+		Blender::Object* bobj = base->object;
+		if (!bobj || bobj->type != OB_MESH || !bobj->data)
+			continue;
+
+		// same objects as convert, group instances keep the objects of their group
+		if ((bobj->transflag & OB_DUPLIGROUP) && bobj->dup_group != 0)
+			continue;
+
+		Blender::Mesh* me = (Blender::Mesh*)bobj->data;
+		if (file->hasConvertedMesh(me))
+			continue;
+
+		gkConvertedMesh* converted = new gkConvertedMesh(bobj);
+		file->addConvertedMesh(me, converted);
+		meshes.push_back(converted);
+	}
+}
+
+
+
 void gkBlenderSceneConverter::convert(bool createGroupInstances)
 {
 	if (m_gscene)
@@ -32,6 +32,8 @@
 #include "gkMathUtils.h"
 
 class gkLogicLoader;
+class gkBlendInternalFile;
+class gkConvertedMesh;
 
 
 class gkBlenderSceneConverter
@@ -49,6 +51,11 @@ public:
 	// mandatory
 	void convertGroupInstances(void);
 
+	// adds the meshes of sc not yet in the file to it and to meshes, still to be converted.
+	// mesh conversion is the only part of convert that runs without Ogre, it is done ahead
+	// on a loader thread or the job pool. convert picks them up.
+	static void collectMeshes(gkBlendInternalFile* file, Blender::Scene* sc, utArray<gkConvertedMesh*>& meshes);
+
 private:
 	bool validObject(Blender::Object* ob);
 	void applyParents(utArray<Blender::Object*> &children);
@@ -0,0 +1,1109 @@
+/*
+-------------------------------------------------------------------------------
+    This file is part of OgreKit.
+    http://gamekit.googlecode.com/
+
+    Copyright (c) 2006-2013 Charlie C.
+
+    Contributor(s): none yet.
+-------------------------------------------------------------------------------
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#include "gkPackageSceneConverter.h"
+#include "gkBlendPackage.h"
+#include "gkBlendPackageDefs.h"
+#include "gkBlendFile.h"
+#include "Converters/gkLogicBrickCooker.h"
+#include "OgreKit.h"
+
+#include "fbtPackage.h"
+
+
+// Constraint codes of the cooked format, append only.
+enum gkCookedConstraintType
+{
+	CC_LIMIT_ROT,
+	CC_LIMIT_LOC,
+	CC_LIMIT_VELOCITY,
+};
+
+
+static void gkPackageSceneConverter_writeVariable(utMemoryStream& stream, gkVariable* var)
+{
+	gkCookedWrite(stream, var->getName());
+	gkCookedWrite(stream, var->getType());
+	gkCookedWrite(stream, var->isDebug());
+
+	switch (var->getType())
+	{
+	case gkVariable::VAR_BOOL: gkCookedWrite(stream, var->getValueBool());   break;
+	case gkVariable::VAR_INT:  gkCookedWrite(stream, var->getValueInt());    break;
+	case gkVariable::VAR_REAL: gkCookedWrite(stream, var->getValueReal());   break;
+	default:                   gkCookedWrite(stream, var->getValueString()); break;
+	}
+}
+
+
+static bool gkPackageSceneConverter_readVariable(gkCookedReader& reader, gkGameObject* gobj)
+{
+	gkString name;
+	int type = gkVariable::VAR_NULL;
+	bool debug = false;
+	reader.read(name);
+	reader.read(type);
+	reader.read(debug);
+	if (!reader.ok())
+		return false;
+
+	gkVariable* var = gobj->createVariable(name, debug);
+
+	switch (type)
+	{
+	case gkVariable::VAR_BOOL:
+		{
+			bool v = false;
+			reader.read(v);
+			var->setValue(v);
+		} break;
+	case gkVariable::VAR_INT:
+		{
+			int v = 0;
+			reader.read(v);
+			var->setValue(v);
+		} break;
+	case gkVariable::VAR_REAL:
+		{
+			gkScalar v = 0;
+			reader.read(v);
+			var->setValue(v);
+		} break;
+	case gkVariable::VAR_STRING:
+		{
+			gkString v;
+			reader.read(v);
+			var->setValue(v);
+		} break;
+	default:
+		{
+			gkString v;
+			reader.read(v);
+			var->setValue(type, v);
+		} break;
+	}
+
+	var->makeDefault();
+	return reader.ok();
+}
+
+
+
+gkPackageSceneConverter::gkPackageSceneConverter(gkBlendFile* fp, gkBlendPackage* package, const gkString& scene)
+	:	m_file(fp), m_package(package), m_gscene(0), m_sceneName(scene), m_groupName(fp->getResourceGroup())
+{
+	GK_ASSERT(m_file && m_package);
+}
+
+
+gkPackageSceneConverter::~gkPackageSceneConverter()
+{
+}
+
+
+
+bool gkPackageSceneConverter::readSceneProperties(gkCookedReader& reader)
+{
+	gkSceneProperties& sprops = m_gscene->getProperties();
+	gkSceneMaterial& props = sprops.m_material;
+
+	reader.read(sprops.m_manager);
+	reader.read(sprops.m_gravity);
+	reader.read(sprops.m_activityCulling);
+	reader.read(sprops.m_logicRadius);
+	reader.read(sprops.m_physicsRadius);
+
+	reader.read(props.m_type);
+	reader.read(props.m_name);
+	reader.read(props.m_horizon);
+	reader.read(props.m_zenith);
+	reader.read(props.m_ambient);
+	reader.read(props.m_distance);
+
+	reader.read(sprops.m_fog.m_mode);
+	reader.read(sprops.m_fog.m_start);
+	reader.read(sprops.m_fog.m_end);
+	reader.read(sprops.m_fog.m_intensity);
+	reader.read(sprops.m_fog.m_color);
+
+	gkSoundSceneProperties& sound = m_gscene->getSoundScene();
+	reader.read(sound.m_distModel);
+	reader.read(sound.m_dopplerFactor);
+	reader.read(sound.m_sndSpeed);
+	reader.read(sound.m_globalVolume);
+
+	UTuint32 layer = 0;
+	if (reader.read(layer))
+		m_gscene->setLayer(layer);
+
+	return reader.ok();
+}
+
+
+
+gkSkeletonResource* gkPackageSceneConverter::getSkeleton(const gkString& name)
+{
+	gkSkeletonManager& mgr = gkSkeletonManager::getSingleton();
+	const gkResourceName skelName(name, m_groupName);
+
+	if (mgr.exists(skelName))
+		return mgr.getByName<gkSkeletonResource>(skelName);
+
+	gkSkeletonResource* resource = mgr.create<gkSkeletonResource>(skelName);
+	if (!m_package->loadSkeleton(resource))
+	{
+		mgr.destroy(resource);
+		return 0;
+	}
+	return resource;
+}
+
+
+
+gkGameObject* gkPackageSceneConverter::readObject(gkCookedReader& reader, gkGameObject* gobj)
+{
+	int type = GK_OB_NULL;
+	gkString name;
+	reader.read(type);
+	if (!reader.read(name))
+		return 0;
+
+	if (gobj == 0)
+	{
+		gkHashedString hname(name);
+		switch (type)
+		{
+		case GK_OBJECT:     gobj = m_gscene->createObject(hname);    break;
+		case GK_LIGHT:      gobj = m_gscene->createLight(hname);     break;
+		case GK_CAMERA:     gobj = m_gscene->createCamera(hname);    break;
+		case GK_ENTITY:     gobj = m_gscene->createEntity(hname);    break;
+		case GK_SKELETON:   gobj = m_gscene->createSkeleton(hname);  break;
+		case GK_CURVE:      gobj = m_gscene->createCurve(hname);     break;
+		}
+
+		if (!gobj)
+			return 0;
+	}
+
+	m_created.insert(gobj->getName(), gobj);
+
+
+	gkGameObjectProperties& props = gobj->getProperties();
+	reader.read(props.m_transform);
+	reader.read(props.m_mode);
+	reader.read(props.m_state);
+	reader.read(props.m_findPathFlag);
+	reader.read(props.m_parent);
+	reader.read(props.m_boneParent);
+
+	bool activeLayer = false;
+	UTuint32 layer = 0;
+	reader.read(activeLayer);
+	reader.read(layer);
+	gobj->setActiveLayer(activeLayer);
+	gobj->setLayer(layer);
+
+
+	UTuint32 count = 0, i;
+	reader.readCount(count, sizeof(UTuint32));
+	for (i = 0; i < count && reader.ok(); ++i)
+		gkPackageSceneConverter_readVariable(reader, gobj);
+
+	reader.readCount(count, sizeof(UTuint32));
+	for (i = 0; i < count && reader.ok(); ++i)
+	{
+		gkString player;
+		gkScalar weight = 1;
+		reader.read(player);
+		reader.read(weight);
+
+		gkAnimation* act = gkAnimationManager::getSingleton().getAnimation(gkResourceName(player, m_groupName));
+		if (act)
+		{
+			gkAnimationPlayer* play = gobj->addAnimation(act, player);
+			if (play)
+				play->setWeight(weight);
+		}
+	}
+
+
+	// object data, the roots of group instances keep their type
+	if (type != gobj->getType())
+		return reader.ok() ? gobj : 0;
+
+	switch (type)
+	{
+	case GK_CAMERA:
+		{
+			gkCameraProperties& cprops = static_cast<gkCamera*>(gobj)->getCameraProperties();
+			reader.read(cprops.m_clipstart);
+			reader.read(cprops.m_clipend);
+			reader.read(cprops.m_fov);
+			reader.read(cprops.m_orthoscale);
+			reader.read(cprops.m_start);
+			reader.read(cprops.m_type);
+		} break;
+	case GK_LIGHT:
+		{
+			gkLightProperties& lprops = static_cast<gkLight*>(gobj)->getLightProperties();
+			reader.read(lprops.m_diffuse);
+			reader.read(lprops.m_specular);
+			reader.read(lprops.m_type);
+			reader.read(lprops.m_spot);
+			reader.read(lprops.m_direction);
+			reader.read(lprops.m_power);
+			reader.read(lprops.m_falloff);
+			reader.read(lprops.m_range);
+			reader.read(lprops.m_constant);
+			reader.read(lprops.m_linear);
+			reader.read(lprops.m_quadratic);
+			reader.read(lprops.m_casts);
+			reader.read(lprops.m_extra);
+			reader.read(lprops.m_param);
+		} break;
+	case GK_ENTITY:
+		{
+			gkEntity* ent = static_cast<gkEntity*>(gobj);
+			gkEntityProperties& eprops = ent->getEntityProperties();
+
+			gkString mesh;
+			SkeletonLink link;
+			link.m_entity = ent;
+			reader.read(mesh);
+			reader.read(eprops.m_casts);
+			reader.read(eprops.m_source);
+			reader.read(eprops.m_startPose);
+			reader.read(link.m_skeleton);
+			if (!reader.read(link.m_resource))
+				return 0;
+
+			// shared by name, like the converter does
+			if (!m_gscene->hasMesh(mesh))
+			{
+				eprops.m_mesh = m_gscene->createMesh(mesh);
+				if (!m_package->loadMesh(eprops.m_mesh))
+					return 0;
+			}
+			else
+				eprops.m_mesh = m_gscene->getMesh(mesh);
+
+			if (!link.m_skeleton.empty())
+				m_skeletonLinks.push_back(link);
+		} break;
+	case GK_SKELETON:
+		{
+			gkString resource;
+			if (!reader.read(resource))
+				return 0;
+
+			gkSkeletonResource* skel = getSkeleton(resource);
+			if (!skel)
+				return 0;
+
+			static_cast<gkSkeleton*>(gobj)->_setInternalSkeleton(skel);
+		} break;
+	case GK_CURVE:
+		{
+			gkCurveProperties& cprops = static_cast<gkCurve*>(gobj)->getCurveProperties();
+
+			int ctype = gkCurveProperties::CU_Points;
+			reader.read(ctype);
+			reader.read(cprops.m_isCyclic);
+			reader.read(cprops.m_points);
+			cprops.m_type = (gkCurveProperties::CurveType)ctype;
+
+			reader.readCount(count, sizeof(UTuint32));
+			for (i = 0; i < count && reader.ok(); ++i)
+			{
+				utArray<gkVector3> bezTriple;
+				reader.read(bezTriple);
+				cprops.m_BezTriples.push_back(bezTriple);
+			}
+		} break;
+	}
+
+	return reader.ok() ? gobj : 0;
+}
+
+
+
+bool gkPackageSceneConverter::readGroups(gkCookedReader& reader)
+{
+	gkGroupManager* mgr = gkGroupManager::getSingletonPtr();
+
+	UTuint32 count = 0;
+	reader.readCount(count, 3 * sizeof(UTuint32));
+
+	for (UTuint32 i = 0; i < count && reader.ok(); ++i)
+	{
+		gkString name;
+		reader.read(name);
+
+		const gkResourceName groupName(name, m_groupName);
+
+		// the first scene owning objects of a group creates it
+		gkGameObjectGroup* group = 0;
+		if (!mgr->exists(groupName))
+			group = (gkGameObjectGroup*)mgr->create(groupName);
+
+		UTuint32 items = 0, j;
+		reader.readCount(items, sizeof(UTuint32));
+		for (j = 0; j < items && reader.ok(); ++j)
+		{
+			gkString object;
+			reader.read(object);
+
+			gkGameObject* gobj = group ? m_gscene->getObject(object) : 0;
+			if (gobj)
+				group->addObject(gobj);
+		}
+
+		reader.readCount(items, 2 * sizeof(UTuint32));
+		for (j = 0; j < items && reader.ok(); ++j)
+		{
+			gkString instGroupName, root;
+			reader.read(instGroupName);
+			reader.read(root);
+
+			gkGameObject* gobj = group ? m_gscene->getObject(root) : 0;
+			if (gobj)
+				group->addGroup(instGroupName, gobj);
+		}
+
+		if (group)
+		{
+			if (group->isEmpty())
+				mgr->destroy(group);
+			else
+				mgr->attachGroupToScene(m_gscene, group);
+		}
+	}
+	return reader.ok();
+}
+
+
+
+bool gkPackageSceneConverter::readCollision(void)
+{
+	const void* data;
+	UTsize len;
+	if (!m_package->getSection(GK_PACKAGE_COLLISION, m_sceneName, data, len))
+		return false;
+
+	gkCookedReader reader(data, len);
+
+	UTuint32 count = 0;
+	if (!reader.readHeader() || !reader.readCount(count, 2 * sizeof(UTuint32)))
+		return false;
+
+	gkConstraintManager* mgr = m_gscene->getConstraintManager();
+
+	for (UTuint32 i = 0; i < count && reader.ok(); ++i)
+	{
+		gkString name;
+		gkCookedReader block(0, 0);
+		reader.read(name);
+		if (!reader.readBlock(block))
+			break;
+
+		// objects of the other pass
+		UTsize pos = m_created.find(name);
+		if (pos == UT_NPOS)
+			continue;
+
+		gkGameObject* gobj = m_created.at(pos);
+		gkPhysicsProperties& phy = gobj->getProperties().m_physics;
+
+		block.read(phy.m_type);
+		block.read(phy.m_mode);
+		block.read(phy.m_shape);
+		block.read(phy.m_margin);
+		block.read(phy.m_cpt);
+		block.read(phy.m_mass);
+		block.read(phy.m_radius);
+		block.read(phy.m_linearDamp);
+		block.read(phy.m_angularDamp);
+		block.read(phy.m_formFactor);
+		block.read(phy.m_minVel);
+		block.read(phy.m_maxVel);
+		block.read(phy.m_restitution);
+		block.read(phy.m_friction);
+		block.read(phy.m_colMask);
+		block.read(phy.m_colGroupMask);
+		block.read(phy.m_charStepHeight);
+		block.read(phy.m_charJumpSpeed);
+		block.read(phy.m_charFallSpeed);
+
+		UTuint32 items = 0, j;
+		block.readCount(items, sizeof(UTuint32));
+		for (j = 0; j < items && block.ok(); ++j)
+		{
+			gkPhysicsConstraintProperties p;
+			block.read(p.m_target);
+			block.read(p.m_type);
+			block.read(p.m_pivot);
+			block.read(p.m_axis);
+			block.read(p.m_minLimit);
+			block.read(p.m_maxLimit);
+			block.read(p.m_flag);
+			block.read(p.m_disableLinkedCollision);
+
+			if (block.ok())
+				phy.m_constraints.push_back(p);
+		}
+
+		block.readCount(items, 3 * sizeof(int));
+		for (j = 0; j < items && block.ok(); ++j)
+		{
+			int type = -1, space = TRANSFORM_LOCAL;
+			gkScalar influence = 1;
+			block.read(type);
+			block.read(space);
+			block.read(influence);
+
+			gkConstraint* co = 0;
+			switch (type)
+			{
+			case CC_LIMIT_ROT:
+				{
+					gkLimitRotConstraint* c = new gkLimitRotConstraint();
+					co = c;
+
+					bool has;
+					gkVector2 limit;
+					block.read(has); block.read(limit); if (has) c->setLimitX(limit);
+					block.read(has); block.read(limit); if (has) c->setLimitY(limit);
+					block.read(has); block.read(limit); if (has) c->setLimitZ(limit);
+				} break;
+			case CC_LIMIT_LOC:
+				{
+					gkLimitLocConstraint* c = new gkLimitLocConstraint();
+					co = c;
+
+					short minFlag = 0, maxFlag = 0;
+					gkScalar v[6] = {0, 0, 0, 0, 0, 0};
+					block.read(minFlag);
+					block.read(maxFlag);
+					block.read(v);
+
+					if (minFlag & 1) c->setMinX(v[0]);
+					if (maxFlag & 1) c->setMaxX(v[1]);
+					if (minFlag & 2) c->setMinY(v[2]);
+					if (maxFlag & 2) c->setMaxY(v[3]);
+					if (minFlag & 4) c->setMinZ(v[4]);
+					if (maxFlag & 4) c->setMaxZ(v[5]);
+				} break;
+			case CC_LIMIT_VELOCITY:
+				{
+					gkLimitVelocityConstraint* c = new gkLimitVelocityConstraint();
+					co = c;
+
+					gkVector2 limit;
+					block.read(limit);
+					c->setLimit(limit);
+				} break;
+			default:
+				return false;
+			}
+
+			co->setSpace((gkTransformSpace)space);
+			co->setInfluence(influence);
+			mgr->addConstraint(gobj, co);
+		}
+
+		if (!block.ok())
+			return false;
+	}
+	return reader.ok();
+}
+
+
+
+bool gkPackageSceneConverter::readLogic(void)
+{
+	const void* data;
+	UTsize len;
+	if (!m_package->getSection(GK_PACKAGE_LOGIC, m_sceneName, data, len))
+		return false;
+
+	gkCookedReader reader(data, len);
+
+	UTuint32 count = 0;
+	if (!reader.readHeader() || !reader.readCount(count, 2 * sizeof(UTuint32)))
+		return false;
+
+	gkLogicBrickCooker cooker(m_gscene);
+
+	bool result = true;
+	for (UTuint32 i = 0; i < count && result; ++i)
+	{
+		gkString name;
+		gkCookedReader block(0, 0);
+		reader.read(name);
+		if (!reader.readBlock(block))
+			break;
+
+		UTsize pos = m_created.find(name);
+		if (pos != UT_NPOS)
+			result = cooker.read(m_created.at(pos), block);
+	}
+
+	// links what was created, even of a damaged section
+	cooker.resolveLinks();
+	return result && reader.ok();
+}
+
+
+
+void gkPackageSceneConverter::linkSkeletons(void)
+{
+	for (UTsize i = 0; i < m_skeletonLinks.size(); ++i)
+	{
+		SkeletonLink& link = m_skeletonLinks[i];
+
+		gkGameObject* gobj = m_gscene->getObject(link.m_skeleton);
+		if (!gobj || gobj->getType() != GK_SKELETON)
+			continue;
+
+		link.m_entity->setSkeleton(static_cast<gkSkeleton*>(gobj));
+
+		// the bind pose was cooked with the root transform applied
+		if (!link.m_resource.empty())
+		{
+			gkSkeletonResource* skel = getSkeleton(link.m_resource);
+			if (skel)
+				link.m_entity->getEntityProperties().m_mesh->_setSkeleton(skel);
+		}
+	}
+	m_skeletonLinks.clear();
+}
+
+
+
+void gkPackageSceneConverter::convert(void)
+{
+	if (m_gscene)
+		return;
+
+	const void* data;
+	UTsize len;
+	if (!m_package->getSection(GK_PACKAGE_SCENE, m_sceneName, data, len))
+		return;
+
+	m_gscene = (gkScene*)gkSceneManager::getSingleton().create(gkResourceName(m_sceneName, m_groupName));
+	if (!m_gscene)
+	{
+		gkPrintf("SceneConverter: duplicate scene '%s'\n", m_sceneName.c_str());
+		return;
+	}
+
+	m_gscene->setLoadBlendFile(m_file);
+
+
+	gkCookedReader reader(data, len);
+	bool result = reader.readHeader() && readSceneProperties(reader);
+
+	UTuint32 count = 0;
+	if (result)
+		result = reader.readCount(count, 2 * sizeof(UTuint32));
+
+	for (UTuint32 i = 0; i < count && result; ++i)
+		result = readObject(reader) != 0;
+
+	if (result)
+		result = readGroups(reader);
+
+	linkSkeletons();
+
+	if (result)
+		result = readCollision() && readLogic();
+
+	if (!result)
+	{
+		gkLogMessage("PackageSceneConverter: Scene " << m_sceneName << " is damaged, it is loaded partially.");
+	}
+}
+
+
+
+void gkPackageSceneConverter::convertGroupInstances(void)
+{
+	m_gscene = static_cast<gkScene*>(gkSceneManager::getSingleton().getByName(gkResourceName(m_sceneName, m_groupName)));
+	if (!m_gscene)
+	{
+		gkLogMessage("PackageSceneConverter: Scene " << m_sceneName << " was not converted, no group instances created.");
+		return;
+	}
+
+	const void* data;
+	UTsize len;
+	if (!m_package->getSection(GK_PACKAGE_INSTANCES, m_sceneName, data, len))
+		return;
+
+	gkGroupManager* mgr = gkGroupManager::getSingletonPtr();
+
+	gkCookedReader reader(data, len);
+
+	UTuint32 count = 0;
+	bool result = reader.readHeader() && reader.readCount(count, 4 * sizeof(UTuint32));
+
+	for (UTuint32 i = 0; i < count && result; ++i)
+	{
+		gkString name, groupName;
+		UTuint32 layer = 0;
+		gkCookedReader block(0, 0);
+		reader.read(name);
+		reader.read(groupName);
+		reader.read(layer);
+		if (!(result = reader.readBlock(block)))
+			break;
+
+		const gkResourceName owner(groupName, m_groupName);
+		if (!mgr->exists(owner))
+			continue;
+
+		gkGameObjectGroup* ggobj = (gkGameObjectGroup*)mgr->getByName(owner);
+
+		gkGameObjectInstance* inst = ggobj->createGroupInstance(m_gscene, gkResourceName(name, m_groupName), 0, layer);
+		if (inst)
+		{
+			inst->getRoot()->_makeGroup(ggobj);
+			inst->getRoot()->_makeGroupInstance(inst);
+			result = readObject(block, inst->getRoot()) != 0;
+		}
+	}
+
+	if (result && !m_created.empty())
+		result = readCollision() && readLogic();
+
+	if (!result)
+	{
+		gkLogMessage("PackageSceneConverter: Group instances of " << m_sceneName << " are damaged.");
+	}
+}
+
+
+
+bool gkPackageSceneConverter::writeObject(gkGameObject* gobj, utMemoryStream& stream)
+{
+	gkGameObjectProperties& props = gobj->getProperties();
+
+	if (gobj->getType() == GK_PARTICLES || props.hasParticles())
+	{
+		gkLogMessage("PackageSceneConverter: Object " << gobj->getName() << " has particles.");
+		return false;
+	}
+
+	gkCookedWrite(stream, (int)gobj->getType());
+	gkCookedWrite(stream, gobj->getName());
+
+	gkCookedWrite(stream, props.m_transform);
+	gkCookedWrite(stream, props.m_mode);
+	gkCookedWrite(stream, props.m_state);
+	gkCookedWrite(stream, props.m_findPathFlag);
+	gkCookedWrite(stream, props.m_parent);
+	gkCookedWrite(stream, props.m_boneParent);
+
+	gkCookedWrite(stream, gobj->isInActiveLayer());
+	gkCookedWrite(stream, gobj->getLayer());
+
+
+	const gkGameObject::VariableMap& vars = gobj->getVariables();
+	gkCookedWrite(stream, (UTuint32)vars.size());
+	UTsize i;
+	for (i = 0; i < vars.size(); ++i)
+		gkPackageSceneConverter_writeVariable(stream, vars.at(i));
+
+	// players are named after their animation
+	const gkGameObject::Animations& anims = gobj->getAnimations();
+	gkCookedWrite(stream, (UTuint32)anims.size());
+	for (i = 0; i < anims.size(); ++i)
+	{
+		gkCookedWrite(stream, anims.keyAt(i).str());
+		gkCookedWrite(stream, anims.at(i)->getWeight());
+	}
+
+
+	switch (gobj->getType())
+	{
+	case GK_CAMERA:
+		{
+			gkCameraProperties& cprops = static_cast<gkCamera*>(gobj)->getCameraProperties();
+			gkCookedWrite(stream, cprops.m_clipstart);
+			gkCookedWrite(stream, cprops.m_clipend);
+			gkCookedWrite(stream, cprops.m_fov);
+			gkCookedWrite(stream, cprops.m_orthoscale);
+			gkCookedWrite(stream, cprops.m_start);
+			gkCookedWrite(stream, cprops.m_type);
+		} break;
+	case GK_LIGHT:
+		{
+			gkLightProperties& lprops = static_cast<gkLight*>(gobj)->getLightProperties();
+			gkCookedWrite(stream, lprops.m_diffuse);
+			gkCookedWrite(stream, lprops.m_specular);
+			gkCookedWrite(stream, lprops.m_type);
+			gkCookedWrite(stream, lprops.m_spot);
+			gkCookedWrite(stream, lprops.m_direction);
+			gkCookedWrite(stream, lprops.m_power);
+			gkCookedWrite(stream, lprops.m_falloff);
+			gkCookedWrite(stream, lprops.m_range);
+			gkCookedWrite(stream, lprops.m_constant);
+			gkCookedWrite(stream, lprops.m_linear);
+			gkCookedWrite(stream, lprops.m_quadratic);
+			gkCookedWrite(stream, lprops.m_casts);
+			gkCookedWrite(stream, lprops.m_extra);
+			gkCookedWrite(stream, lprops.m_param);
+		} break;
+	case GK_ENTITY:
+		{
+			gkEntity* ent = static_cast<gkEntity*>(gobj);
+			gkEntityProperties& eprops = ent->getEntityProperties();
+
+			// meshes load from their own sections
+			if (!eprops.m_mesh || eprops.m_mesh->getResourceName().getName().size() >= fbtPackage::NAME_LEN)
+			{
+				gkLogMessage("PackageSceneConverter: Entity " << gobj->getName() << " has no cooked mesh.");
+				return false;
+			}
+
+			gkSkeletonResource* skel = eprops.m_mesh->getSkeleton();
+			if (skel && skel->getResourceName().getName().size() >= fbtPackage::NAME_LEN)
+			{
+				gkLogMessage("PackageSceneConverter: Skeleton name " << skel->getResourceName().getName() << " is too long.");
+				return false;
+			}
+
+			gkCookedWrite(stream, eprops.m_mesh->getResourceName().getName());
+			gkCookedWrite(stream, eprops.m_casts);
+			gkCookedWrite(stream, eprops.m_source);
+			gkCookedWrite(stream, eprops.m_startPose);
+			gkCookedWrite(stream, ent->getSkeleton() ? ent->getSkeleton()->getName() : gkString());
+			gkCookedWrite(stream, skel ? skel->getResourceName().getName() : gkString());
+		} break;
+	case GK_SKELETON:
+		{
+			gkSkeletonResource* skel = static_cast<gkSkeleton*>(gobj)->getInternalSkeleton();
+			if (!skel || skel->getResourceName().getName().size() >= fbtPackage::NAME_LEN)
+			{
+				gkLogMessage("PackageSceneConverter: Skeleton " << gobj->getName() << " has no cooked bones.");
+				return false;
+			}
+
+			gkCookedWrite(stream, skel->getResourceName().getName());
+		} break;
+	case GK_CURVE:
+		{
+			gkCurveProperties& cprops = static_cast<gkCurve*>(gobj)->getCurveProperties();
+			gkCookedWrite(stream, (int)cprops.m_type);
+			gkCookedWrite(stream, cprops.m_isCyclic);
+			gkCookedWrite(stream, cprops.m_points);
+
+			gkCookedWrite(stream, (UTuint32)cprops.m_BezTriples.size());
+			for (i = 0; i < cprops.m_BezTriples.size(); ++i)
+				gkCookedWrite(stream, cprops.m_BezTriples[i]);
+		} break;
+	default:
+		break;
+	}
+	return true;
+}
+
+
+
+bool gkPackageSceneConverter::writeCollision(gkScene* scene, gkGameObject* gobj, utMemoryStream& stream)
+{
+	gkPhysicsProperties& phy = gobj->getProperties().m_physics;
+
+	gkCookedWrite(stream, phy.m_type);
+	gkCookedWrite(stream, phy.m_mode);
+	gkCookedWrite(stream, phy.m_shape);
+	gkCookedWrite(stream, phy.m_margin);
+	gkCookedWrite(stream, phy.m_cpt);
+	gkCookedWrite(stream, phy.m_mass);
+	gkCookedWrite(stream, phy.m_radius);
+	gkCookedWrite(stream, phy.m_linearDamp);
+	gkCookedWrite(stream, phy.m_angularDamp);
+	gkCookedWrite(stream, phy.m_formFactor);
+	gkCookedWrite(stream, phy.m_minVel);
+	gkCookedWrite(stream, phy.m_maxVel);
+	gkCookedWrite(stream, phy.m_restitution);
+	gkCookedWrite(stream, phy.m_friction);
+	gkCookedWrite(stream, phy.m_colMask);
+	gkCookedWrite(stream, phy.m_colGroupMask);
+	gkCookedWrite(stream, phy.m_charStepHeight);
+	gkCookedWrite(stream, phy.m_charJumpSpeed);
+	gkCookedWrite(stream, phy.m_charFallSpeed);
+
+	UTsize i;
+	gkCookedWrite(stream, (UTuint32)phy.m_constraints.size());
+	for (i = 0; i < phy.m_constraints.size(); ++i)
+	{
+		const gkPhysicsConstraintProperties& p = phy.m_constraints[i];
+		gkCookedWrite(stream, p.m_target);
+		gkCookedWrite(stream, p.m_type);
+		gkCookedWrite(stream, p.m_pivot);
+		gkCookedWrite(stream, p.m_axis);
+		gkCookedWrite(stream, p.m_minLimit);
+		gkCookedWrite(stream, p.m_maxLimit);
+		gkCookedWrite(stream, p.m_flag);
+		gkCookedWrite(stream, p.m_disableLinkedCollision);
+	}
+
+
+	gkConstraintManager* mgr = scene->getConstraintManager();
+	if (!mgr->hasConstraints(gobj))
+	{
+		gkCookedWrite(stream, (UTuint32)0);
+		return true;
+	}
+
+	gkConstraintManager::Constraints& cons = mgr->getConstraints(gobj);
+	gkCookedWrite(stream, (UTuint32)cons.size());
+	for (i = 0; i < cons.size(); ++i)
+	{
+		gkConstraint* co = cons[i];
+
+		int type;
+		if (dynamic_cast<gkLimitRotConstraint*>(co))
+			type = CC_LIMIT_ROT;
+		else if (dynamic_cast<gkLimitLocConstraint*>(co))
+			type = CC_LIMIT_LOC;
+		else if (dynamic_cast<gkLimitVelocityConstraint*>(co))
+			type = CC_LIMIT_VELOCITY;
+		else
+		{
+			gkLogMessage("PackageSceneConverter: Object " << gobj->getName() << " has an unknown constraint.");
+			return false;
+		}
+
+		gkCookedWrite(stream, type);
+		gkCookedWrite(stream, (int)co->getSpace());
+		gkCookedWrite(stream, co->getInfluence());
+
+		switch (type)
+		{
+		case CC_LIMIT_ROT:
+			{
+				gkLimitRotConstraint* c = static_cast<gkLimitRotConstraint*>(co);
+				gkCookedWrite(stream, c->hasLimitX());
+				gkCookedWrite(stream, c->getLimitX());
+				gkCookedWrite(stream, c->hasLimitY());
+				gkCookedWrite(stream, c->getLimitY());
+				gkCookedWrite(stream, c->hasLimitZ());
+				gkCookedWrite(stream, c->getLimitZ());
+			} break;
+		case CC_LIMIT_LOC:
+			{
+				gkLimitLocConstraint* c = static_cast<gkLimitLocConstraint*>(co);
+				gkScalar v[6] = {c->getMinX(), c->getMaxX(), c->getMinY(), c->getMaxY(), c->getMinZ(), c->getMaxZ()};
+				gkCookedWrite(stream, c->getMinFlag());
+				gkCookedWrite(stream, c->getMaxFlag());
+				gkCookedWrite(stream, v);
+			} break;
+		case CC_LIMIT_VELOCITY:
+			{
+				gkCookedWrite(stream, static_cast<gkLimitVelocityConstraint*>(co)->getLimit());
+			} break;
+		}
+	}
+	return true;
+}
+
+
+
+bool gkPackageSceneConverter::cook(gkScene* scene, fbtPackage& package)
+{
+	GK_ASSERT(scene);
+
+	const gkString& name = scene->getName();
+	if (name.size() >= fbtPackage::NAME_LEN)
+	{
+		gkLogMessage("PackageSceneConverter: Scene name " << name << " is too long.");
+		return false;
+	}
+
+	// group instances are created again in the second pass, their clones with them
+	utArray<gkGameObject*> objects, roots;
+
+	gkGameObjectHashMap& all = scene->getObjects();
+	UTsize i;
+	for (i = 0; i < all.size(); ++i)
+	{
+		gkGameObject* gobj = all.at(i);
+		if (gobj->isClone())
+			continue;
+
+		if (!gobj->isGroupInstance())
+			objects.push_back(gobj);
+		else if (gobj->getGroupInstance()->getRoot() == gobj)
+			roots.push_back(gobj);
+	}
+
+
+	utMemoryStream sstream(utStream::SM_WRITE);
+	gkCookedWriteHeader(sstream);
+
+	gkSceneProperties& sprops = scene->getProperties();
+	gkSceneMaterial& props = sprops.m_material;
+
+	gkCookedWrite(sstream, sprops.m_manager);
+	gkCookedWrite(sstream, sprops.m_gravity);
+	gkCookedWrite(sstream, sprops.m_activityCulling);
+	gkCookedWrite(sstream, sprops.m_logicRadius);
+	gkCookedWrite(sstream, sprops.m_physicsRadius);
+
+	gkCookedWrite(sstream, props.m_type);
+	gkCookedWrite(sstream, props.m_name);
+	gkCookedWrite(sstream, props.m_horizon);
+	gkCookedWrite(sstream, props.m_zenith);
+	gkCookedWrite(sstream, props.m_ambient);
+	gkCookedWrite(sstream, props.m_distance);
+
+	gkCookedWrite(sstream, sprops.m_fog.m_mode);
+	gkCookedWrite(sstream, sprops.m_fog.m_start);
+	gkCookedWrite(sstream, sprops.m_fog.m_end);
+	gkCookedWrite(sstream, sprops.m_fog.m_intensity);
+	gkCookedWrite(sstream, sprops.m_fog.m_color);
+
+	gkSoundSceneProperties& sound = scene->getSoundScene();
+	gkCookedWrite(sstream, sound.m_distModel);
+	gkCookedWrite(sstream, sound.m_dopplerFactor);
+	gkCookedWrite(sstream, sound.m_sndSpeed);
+	gkCookedWrite(sstream, sound.m_globalVolume);
+
+	gkCookedWrite(sstream, scene->getLayer());
+
+	gkCookedWrite(sstream, (UTuint32)objects.size());
+	for (i = 0; i < objects.size(); ++i)
+	{
+		if (!writeObject(objects[i], sstream))
+			return false;
+	}
+
+
+	utArray<gkGameObjectGroup*> groups;
+	gkGroupManager::Groups::Iterator git = gkGroupManager::getSingleton().getAttachedGroupIterator(scene);
+	while (git.hasMoreElements())
+		groups.push_back(git.getNext());
+
+	gkCookedWrite(sstream, (UTuint32)groups.size());
+	for (i = 0; i < groups.size(); ++i)
+	{
+		gkGameObjectGroup* group = groups[i];
+		gkCookedWrite(sstream, group->getResourceName().getName());
+
+		gkGameObjectGroup::Objects& gobjs = group->getObjects();
+		gkCookedWrite(sstream, (UTuint32)gobjs.size());
+		UTsize j;
+		for (j = 0; j < gobjs.size(); ++j)
+			gkCookedWrite(sstream, gobjs.at(j)->getName());
+
+		gkGameObjectGroup::GroupInstances& ginsts = group->getGroupInstances();
+		gkCookedWrite(sstream, (UTuint32)ginsts.size());
+		for (j = 0; j < ginsts.size(); ++j)
+		{
+			gkCookedWrite(sstream, ginsts[j]->m_groupName);
+			gkCookedWrite(sstream, ginsts[j]->m_root->getName());
+		}
+	}
+
+
+	utMemoryStream istream(utStream::SM_WRITE);
+	gkCookedWriteHeader(istream);
+
+	gkCookedWrite(istream, (UTuint32)roots.size());
+	for (i = 0; i < roots.size(); ++i)
+	{
+		gkGameObjectInstance* inst = roots[i]->getGroupInstance();
+		gkCookedWrite(istream, inst->getResourceName().getName());
+		gkCookedWrite(istream, inst->getGroup()->getResourceName().getName());
+		gkCookedWrite(istream, inst->getLayer());
+
+		utMemoryStream block(utStream::SM_WRITE);
+		if (!writeObject(roots[i], block))
+			return false;
+		gkCookedWriteBlock(istream, block);
+	}
+
+
+	utMemoryStream cstream(utStream::SM_WRITE), lstream(utStream::SM_WRITE);
+	gkCookedWriteHeader(cstream);
+	gkCookedWriteHeader(lstream);
+
+	objects.reserve(objects.size() + roots.size());
+	for (i = 0; i < roots.size(); ++i)
+		objects.push_back(roots[i]);
+
+	UTuint32 logics = 0;
+	for (i = 0; i < objects.size(); ++i)
+	{
+		if (objects[i]->getLogicBricks())
+		{
+			if (!gkLogicBrickCooker::canWrite(objects[i]))
+			{
+				gkLogMessage("PackageSceneConverter: Object " << objects[i]->getName() << " has an unknown logic brick.");
+				return false;
+			}
+			++logics;
+		}
+	}
+
+	gkCookedWrite(cstream, (UTuint32)objects.size());
+	gkCookedWrite(lstream, logics);
+
+	for (i = 0; i < objects.size(); ++i)
+	{
+		gkGameObject* gobj = objects[i];
+
+		utMemoryStream block(utStream::SM_WRITE);
+		if (!writeCollision(scene, gobj, block))
+			return false;
+
+		gkCookedWrite(cstream, gobj->getName());
+		gkCookedWriteBlock(cstream, block);
+
+		if (gobj->getLogicBricks())
+		{
+			utMemoryStream lblock(utStream::SM_WRITE);
+			gkLogicBrickCooker::write(gobj, lblock);
+
+			gkCookedWrite(lstream, gobj->getName());
+			gkCookedWriteBlock(lstream, lblock);
+		}
+	}
+
+
+	// a scene without all of its sections is converted at load
+	if (!package.addSection(GK_PACKAGE_SCENE, name.c_str(), sstream.ptr(), sstream.size())
+	        || !package.addSection(GK_PACKAGE_COLLISION, name.c_str(), cstream.ptr(), cstream.size())
+	        || !package.addSection(GK_PACKAGE_LOGIC, name.c_str(), lstream.ptr(), lstream.size())
+	        || (!roots.empty() && !package.addSection(GK_PACKAGE_INSTANCES, name.c_str(), istream.ptr(), istream.size())))
+	{
+		gkLogMessage("PackageSceneConverter: Out of memory adding scene " << name << ".");
+		return false;
+	}
+	return true;
+}
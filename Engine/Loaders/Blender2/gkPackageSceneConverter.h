@@ -0,0 +1,94 @@
+/*
+-------------------------------------------------------------------------------
+    This file is part of OgreKit.
+    http://gamekit.googlecode.com/
+
+    Copyright (c) 2006-2013 Charlie C.
+
+    Contributor(s): none yet.
+-------------------------------------------------------------------------------
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#ifndef _gkPackageSceneConverter_h_
+#define _gkPackageSceneConverter_h_
+
+
+#include "gkLoaderCommon.h"
+
+class fbtPackage;
+class utMemoryStream;
+class gkCookedReader;
+class gkBlendPackage;
+class gkLogicBrickCooker;
+
+
+///Creates a scene from the sections gkBlendPackage::cook wrote for it,
+///in place of gkBlenderSceneConverter.
+///
+///The objects, groups, group instances, collision and logic bricks of the
+///scene come from the package. Meshes, skeletons and animations are loaded
+///from their own sections, textures, sounds and texts are still built from
+///the embedded blend.
+class gkPackageSceneConverter
+{
+public:
+	gkPackageSceneConverter(gkBlendFile* fp, gkBlendPackage* package, const gkString& scene);
+	~gkPackageSceneConverter();
+
+	///Creates the scene with its objects and groups, see gkBlenderSceneConverter::convert(false).
+	void convert(void);
+
+	///Creates the group instances of the scene, once all scenes ran convert.
+	void convertGroupInstances(void);
+
+	///Writes the sections of scene to package, false if the scene has data
+	///the package cannot hold, it is converted from the blend at load then.
+	static bool cook(gkScene* scene, fbtPackage& package);
+
+private:
+	typedef utHashTable<gkHashedString, gkGameObject*> CreatedObjects;
+
+	gkSkeletonResource* getSkeleton(const gkString& name);
+
+	bool readSceneProperties(gkCookedReader& reader);
+	gkGameObject* readObject(gkCookedReader& reader, gkGameObject* gobj = 0);
+	bool readGroups(gkCookedReader& reader);
+	bool readCollision(void);
+	bool readLogic(void);
+	void linkSkeletons(void);
+
+	static bool writeObject(gkGameObject* gobj, utMemoryStream& stream);
+	static bool writeCollision(gkScene* scene, gkGameObject* gobj, utMemoryStream& stream);
+
+	struct SkeletonLink
+	{
+		gkEntity*   m_entity;
+		gkString    m_skeleton;
+		gkString    m_resource;
+	};
+
+	gkBlendFile*                m_file;
+	gkBlendPackage*             m_package;
+	gkScene*                    m_gscene;
+	const gkString              m_sceneName;
+	const gkResourceNameString  m_groupName;
+	CreatedObjects              m_created;
+	utArray<SkeletonLink>       m_skeletonLinks;
+};
+
+#endif//_gkPackageSceneConverter_h_
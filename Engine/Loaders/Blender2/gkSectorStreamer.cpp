@@ -0,0 +1,568 @@
+/*
+-------------------------------------------------------------------------------
+    This file is part of OgreKit.
+    http://gamekit.googlecode.com/
+
+    Copyright (c) 2006-2013 Charlie C.
+
+    Contributor(s): none yet.
+-------------------------------------------------------------------------------
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#include "gkSectorStreamer.h"
+#include "gkBlendLoader.h"
+#include "gkBlendFile.h"
+#include "gkScene.h"
+#include "gkGameObject.h"
+#include "gkCamera.h"
+#include "gkGameObjectGroup.h"
+#include "gkGameObjectInstance.h"
+#include "gkGroupManager.h"
+#include "gkLogger.h"
+#include "gkUtils.h"
+
+#include "OgreMeshManager.h"
+#include "OgreTextureManager.h"
+#include "OgreSkeletonManager.h"
+
+#include <stdio.h>
+
+
+
+class gkSectorPrefetchCall : public gkCall
+{
+public:
+
+	gkSectorPrefetchCall(const gkString& path, gkSectorStreamer::ASYNC_SIZE_RESULT result)
+		:	m_path(path), m_result(result) {}
+
+	~gkSectorPrefetchCall() {}
+
+	void run()
+	{
+		// Read the whole file, so the main thread's parse hits the OS cache.
+		UTsize size = 0;
+
+		FILE* fp = fopen(m_path.c_str(), "rb");
+		if (fp)
+		{
+			char buffer[65536];
+			size_t len;
+			while ((len = fread(buffer, 1, sizeof(buffer), fp)) > 0)
+				size += (UTsize)len;
+			fclose(fp);
+		}
+
+		m_result = size;
+	}
+
+private:
+
+	gkString m_path;
+
+	gkSectorStreamer::ASYNC_SIZE_RESULT m_result;
+};
+
+
+
+gkSectorStreamer::Sector::Sector(const gkString& name, const gkString& file, const gkVector3& center, gkScalar radius)
+	:	m_name(name),
+		m_file(file),
+		m_resourceGroup(gkUtils::getUniqueName("SECTOR")),
+		m_center(center),
+		m_radius(radius),
+		m_distance(GK_INFINITY),
+		m_state(SS_UNLOADED),
+		m_blend(0),
+		m_fileSize(0),
+		m_memory(0),
+		m_baseMemory(0),
+		m_cursor(0),
+		m_load(0)
+{
+}
+
+
+
+gkSectorStreamer::gkSectorStreamer(gkScene* scene)
+	:	m_scene(scene),
+		m_focus(0),
+		m_focusPosition(gkVector3::ZERO),
+		m_hasFocusPosition(false),
+		m_hysteresis(10.f),
+		m_frameBudget(4.f),
+		m_spendLimit(0),
+		m_memoryBudget(0),
+		m_memoryUsage(0),
+		m_prefetcher("SectorPrefetch")
+{
+	GK_ASSERT(m_scene);
+	gkEngine::getSingleton().addListener(this);
+}
+
+
+
+gkSectorStreamer::~gkSectorStreamer()
+{
+	if (gkEngine::getSingletonPtr())
+		gkEngine::getSingleton().removeListener(this);
+
+	m_prefetcher.join();
+
+	UTsize i;
+	for (i = 0; i < m_sectors.size(); ++i)
+	{
+		unloadNow(m_sectors[i]);
+		delete m_sectors[i];
+	}
+	m_sectors.clear();
+}
+
+
+
+gkSectorStreamer::Sector* gkSectorStreamer::addSector(const gkString& name, const gkString& file, const gkVector3& center, gkScalar radius)
+{
+	if (getSector(name))
+	{
+		gkLogMessage("SectorStreamer: Duplicate sector " << name << ".");
+		return 0;
+	}
+
+	Sector* sector = new Sector(name, gkUtils::getFile(file), center, radius);
+	m_sectors.push_back(sector);
+	return sector;
+}
+
+
+
+gkSectorStreamer::Sector* gkSectorStreamer::getSector(const gkString& name)
+{
+	UTsize i;
+	for (i = 0; i < m_sectors.size(); ++i)
+	{
+		if (m_sectors[i]->m_name == name)
+			return m_sectors[i];
+	}
+	return 0;
+}
+
+
+
+void gkSectorStreamer::removeSector(const gkString& name)
+{
+	Sector* sector = getSector(name);
+	if (!sector)
+		return;
+
+	unloadNow(sector);
+	m_sectors.erase(sector);
+	delete sector;
+}
+
+
+
+bool gkSectorStreamer::isIdle(void)
+{
+	UTsize i;
+	for (i = 0; i < m_sectors.size(); ++i)
+	{
+		Sector* sector = m_sectors[i];
+		switch (sector->m_state)
+		{
+		case SS_PREFETCHING:
+		case SS_LOADING:
+		case SS_INSTANCING:
+		case SS_UNLOADING:
+			return false;
+		case SS_PREFETCHED:
+			if (sector->m_distance <= sector->m_radius)
+				return false;
+			break;
+		default:
+			break;
+		}
+	}
+	return true;
+}
+
+
+
+void gkSectorStreamer::update(gkScalar rate)
+{
+	if (!m_scene->isInstanced())
+		return;
+
+	gkVector3 focus = m_focusPosition;
+	if (!m_hasFocusPosition)
+	{
+		gkGameObject* obj = m_focus;
+		if (!obj)
+			obj = m_scene->getMainCamera();
+
+		if (!obj || !obj->isInstanced())
+			return;
+
+		focus = obj->getWorldPosition();
+	}
+
+	// never spend more than the tick itself
+	gkScalar budget = m_frameBudget;
+	if (rate > 0 && budget > 0)
+		budget = gkMin<gkScalar>(budget, rate * 1000.f);
+	m_spendLimit = (unsigned long)(budget * 1000.f);
+
+	m_timer.reset();
+	updateDistances(focus);
+
+
+	UTsize i;
+	for (i = 0; i < m_sectors.size(); ++i)
+	{
+		Sector* sector = m_sectors[i];
+		const bool inside = sector->m_distance <= sector->m_radius;
+		const bool inBand = sector->m_distance <= sector->m_radius + m_hysteresis;
+
+		switch (sector->m_state)
+		{
+		case SS_UNLOADED:
+			if (inBand)
+				prefetch(sector);
+			break;
+		case SS_PREFETCHING:
+			if (sector->m_prefetch.hasResult())
+			{
+				sector->m_fileSize = sector->m_prefetch.getResult();
+				if (sector->m_fileSize == 0)
+				{
+					gkLogMessage("SectorStreamer: Failed to read " << sector->m_file << ".");
+					sector->m_state = SS_ERROR;
+				}
+				else
+					sector->m_state = inBand ? SS_PREFETCHED : SS_UNLOADED;
+			}
+			break;
+		case SS_PREFETCHED:
+			if (!inBand)
+				sector->m_state = SS_UNLOADED;
+			break;
+		case SS_LOADING:
+			// the loader ticks convert it, left the band or not
+			if (sector->m_load->isDone() && finishLoad(sector) && !inBand)
+				sector->m_state = SS_UNLOADING;
+			break;
+		case SS_INSTANCING:
+		case SS_ACTIVE:
+			if (!inBand)
+				sector->m_state = SS_UNLOADING;
+			break;
+		case SS_UNLOADING:
+			// came back before it was gone
+			if (inside)
+				sector->m_state = SS_INSTANCING;
+			break;
+		default:
+			break;
+		}
+	}
+
+
+	// Unloading goes first as it frees memory, then the nearest sectors.
+	while (!isSpent())
+	{
+		Sector* sector = findNearest(SS_UNLOADING, false);
+		if (sector)
+		{
+			unloadNext(sector);
+			continue;
+		}
+
+		sector = findNearest(SS_INSTANCING, false);
+		if (sector)
+		{
+			instanceNext(sector);
+			continue;
+		}
+
+		sector = findNearest(SS_PREFETCHED, true);
+		if (sector && makeRoom(sector->m_memory ? sector->m_memory : sector->m_fileSize))
+		{
+			load(sector);
+			continue;
+		}
+
+		break;
+	}
+}
+
+
+
+void gkSectorStreamer::updateDistances(const gkVector3& focus)
+{
+	UTsize i;
+	for (i = 0; i < m_sectors.size(); ++i)
+		m_sectors[i]->m_distance = focus.distance(m_sectors[i]->m_center);
+}
+
+
+
+gkSectorStreamer::Sector* gkSectorStreamer::findNearest(SectorState state, bool insideRadius)
+{
+	Sector* best = 0;
+
+	UTsize i;
+	for (i = 0; i < m_sectors.size(); ++i)
+	{
+		Sector* sector = m_sectors[i];
+		if (sector->m_state != state)
+			continue;
+
+		if (insideRadius && sector->m_distance > sector->m_radius)
+			continue;
+
+		if (!best || sector->m_distance < best->m_distance)
+			best = sector;
+	}
+
+	return best;
+}
+
+
+
+bool gkSectorStreamer::isSpent(void)
+{
+	if (m_spendLimit == 0)
+		return false;
+
+	return m_timer.getMicroseconds() >= m_spendLimit;
+}
+
+
+
+UTsize gkSectorStreamer::getResourceMemory(void)
+{
+	return  (UTsize)Ogre::MeshManager::getSingleton().getMemoryUsage() +
+	        (UTsize)Ogre::TextureManager::getSingleton().getMemoryUsage() +
+	        (UTsize)Ogre::SkeletonManager::getSingleton().getMemoryUsage();
+}
+
+
+
+bool gkSectorStreamer::makeRoom(UTsize bytes)
+{
+	if (m_memoryBudget == 0 || m_memoryUsage + bytes <= m_memoryBudget)
+		return true;
+
+
+	// Evict the farthest resident sector that is only kept by the hysteresis band,
+	// the load is retried once it is gone.
+	Sector* victim = 0;
+
+	UTsize i;
+	for (i = 0; i < m_sectors.size(); ++i)
+	{
+		Sector* sector = m_sectors[i];
+		if (!sector->isResident() || sector->m_state == SS_UNLOADING)
+			continue;
+
+		if (sector->m_distance <= sector->m_radius)
+			continue;
+
+		if (!victim || sector->m_distance > victim->m_distance)
+			victim = sector;
+	}
+
+	if (victim)
+		victim->m_state = SS_UNLOADING;
+
+	return false;
+}
+
+
+
+void gkSectorStreamer::prefetch(Sector* sector)
+{
+	sector->m_prefetch = ASYNC_SIZE_RESULT();
+	sector->m_state = SS_PREFETCHING;
+
+	gkPtrRef<gkCall> call(new gkSectorPrefetchCall(sector->m_file, sector->m_prefetch));
+	m_prefetcher.enqueue(call);
+}
+
+
+
+void gkSectorStreamer::load(Sector* sector)
+{
+	GK_ASSERT(sector->m_state == SS_PREFETCHED && !sector->m_blend && !sector->m_load);
+
+	sector->m_baseMemory = getResourceMemory();
+
+	// Parsed by the loader thread, converted within the loader's budget by its ticks.
+	sector->m_load = gkBlendLoader::getSingleton().loadFileAsync(sector->m_file,
+	                 gkBlendLoader::LO_ONLY_ACTIVE_SCENE | gkBlendLoader::LO_CREATE_PRIVATE_GROUP,
+	                 "", sector->m_resourceGroup);
+
+	sector->m_memory = sector->m_fileSize;
+	m_memoryUsage += sector->m_memory;
+
+	sector->m_state = SS_LOADING;
+}
+
+
+
+bool gkSectorStreamer::finishLoad(Sector* sector)
+{
+	GK_ASSERT(sector->m_state == SS_LOADING && sector->m_load);
+
+	gkBlendLoader& loader = gkBlendLoader::getSingleton();
+
+	sector->m_blend = loader.finishLoad(sector->m_load);
+	loader.releaseLoad(sector->m_load);
+	sector->m_load = 0;
+
+	if (!sector->m_blend)
+	{
+		gkLogMessage("SectorStreamer: Failed to load " << sector->m_file << ".");
+		loader.unloadGroup(sector->m_resourceGroup);
+
+		m_memoryUsage -= gkMin<UTsize>(sector->m_memory, m_memoryUsage);
+		sector->m_memory = 0;
+		sector->m_state = SS_ERROR;
+		return false;
+	}
+
+
+	// Collect the groups converted from this file.
+	sector->m_targets.clear();
+	sector->m_instances.clear();
+	sector->m_cursor = 0;
+
+	gkResourceManager::ResourceIterator it = gkGroupManager::getSingleton().getResourceIterator();
+	while (it.hasMoreElements())
+	{
+		gkGameObjectGroup* group = static_cast<gkGameObjectGroup*>(it.getNext().second);
+		if (group->getGroupName() != sector->m_resourceGroup)
+			continue;
+
+		if (!sector->m_groups.empty() && sector->m_groups.find(group->getName()) == UT_NPOS)
+			continue;
+
+		sector->m_targets.push_back(group);
+	}
+
+	if (sector->m_targets.empty())
+		gkLogMessage("SectorStreamer: No groups found in " << sector->m_file << ".");
+
+	sector->m_state = SS_INSTANCING;
+	return true;
+}
+
+
+
+bool gkSectorStreamer::instanceNext(Sector* sector)
+{
+	GK_ASSERT(sector->m_state == SS_INSTANCING);
+
+	if (sector->m_cursor < sector->m_targets.size())
+	{
+		gkGameObjectGroup* group = sector->m_targets[sector->m_cursor++];
+
+		gkResourceName name(gkUtils::getUniqueName(sector->m_name + "/" + group->getName()), sector->m_resourceGroup);
+		gkGameObjectInstance* inst = group->createGroupInstance(m_scene, name, 0, m_scene->getLayer());
+
+		if (inst && !inst->isInstanced())
+			inst->createInstance();
+
+		// kept in step with m_targets, even if it failed
+		sector->m_instances.push_back(inst);
+		return true;
+	}
+
+
+	// Now that meshes and textures are in use, replace the estimate.
+	UTsize memory = getResourceMemory();
+	memory = memory > sector->m_baseMemory ? memory - sector->m_baseMemory : 0;
+	memory = gkMax<UTsize>(memory, sector->m_fileSize);
+
+	m_memoryUsage = m_memoryUsage - sector->m_memory + memory;
+	sector->m_memory = memory;
+
+	sector->m_state = SS_ACTIVE;
+	return false;
+}
+
+
+
+bool gkSectorStreamer::unloadNext(Sector* sector)
+{
+	GK_ASSERT(sector->m_state == SS_UNLOADING);
+
+	if (!sector->m_instances.empty())
+	{
+		gkGameObjectInstance* inst = sector->m_instances.back();
+		sector->m_instances.pop_back();
+		--sector->m_cursor;
+
+		if (inst)
+		{
+			gkGameObjectGroup* group = inst->getGroup();
+			gkGameObject* root = inst->getRoot();
+
+			inst->destroyInstance();
+
+			// the root is deleted along with the instance
+			if (root && root->getOwner())
+				root->getOwner()->_eraseObject(root);
+
+			group->destroyGroupInstance(inst);
+		}
+		return true;
+	}
+
+
+	sector->m_targets.clear();
+	sector->m_cursor = 0;
+
+	if (sector->m_blend)
+	{
+		gkBlendLoader::getSingleton().unloadGroup(sector->m_resourceGroup);
+		sector->m_blend = 0;
+	}
+
+	m_memoryUsage -= gkMin<UTsize>(sector->m_memory, m_memoryUsage);
+	sector->m_state = SS_UNLOADED;
+	return false;
+}
+
+
+
+void gkSectorStreamer::unloadNow(Sector* sector)
+{
+	// waits for the loader, the file is unloaded below
+	if (sector->m_state == SS_LOADING && !finishLoad(sector))
+		return;
+
+	if (!sector->isResident())
+	{
+		if (sector->m_state != SS_ERROR)
+			sector->m_state = SS_UNLOADED;
+		return;
+	}
+
+	sector->m_state = SS_UNLOADING;
+	while (unloadNext(sector));
+}
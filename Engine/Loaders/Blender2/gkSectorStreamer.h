@@ -0,0 +1,188 @@
+/*
+-------------------------------------------------------------------------------
+    This file is part of OgreKit.
+    http://gamekit.googlecode.com/
+
+    Copyright (c) 2006-2013 Charlie C.
+
+    Contributor(s): none yet.
+-------------------------------------------------------------------------------
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#ifndef _gkSectorStreamer_h_
+#define _gkSectorStreamer_h_
+
+#include "gkLoaderCommon.h"
+#include "gkEngine.h"
+#include "gkBlendLoader.h"
+#include "gkMathUtils.h"
+#include "OgreTimer.h"
+#include "Thread/gkActiveObject.h"
+#include "Thread/gkAsyncResult.h"
+
+
+///Streams a large world in sectors around a focus position.
+///
+///Each sector is a .blend file whose groups are instanced into the target scene
+///once the focus comes within the sector's radius, and unloaded again after it
+///leaves the radius plus the hysteresis distance. Files are prefetched by a
+///background thread inside that band and loaded with gkBlendLoader::loadFileAsync
+///once inside the radius, so parsing stays off the main thread. Group instancing
+///happens on the main thread, limited by a per frame time budget and a memory budget.
+class gkSectorStreamer : public gkEngine::Listener
+{
+public:
+
+	enum SectorState
+	{
+		SS_UNLOADED,
+		SS_PREFETCHING,   // file is read by the background thread
+		SS_PREFETCHED,
+		SS_LOADING,       // blend is parsed by the loader thread and converted by its ticks
+		SS_INSTANCING,    // blend is loaded, groups are instanced one at a time
+		SS_ACTIVE,
+		SS_UNLOADING,     // group instances are destroyed one at a time
+		SS_ERROR          // file could not be read or parsed, never retried
+	};
+
+	typedef utArray<gkString>              GroupNames;
+	typedef utArray<gkGameObjectGroup*>    Groups;
+	typedef utArray<gkGameObjectInstance*> GroupInstances;
+	typedef gkAsyncResult<UTsize>          ASYNC_SIZE_RESULT;
+
+
+	class Sector
+	{
+	public:
+		Sector(const gkString& name, const gkString& file, const gkVector3& center, gkScalar radius);
+
+		GK_INLINE const gkString&  getName(void)   const {return m_name;}
+		GK_INLINE const gkString&  getFile(void)   const {return m_file;}
+		GK_INLINE const gkVector3& getCenter(void) const {return m_center;}
+		GK_INLINE gkScalar         getRadius(void) const {return m_radius;}
+		GK_INLINE SectorState      getState(void)  const {return m_state;}
+		GK_INLINE gkBlendFile*     getBlend(void)        {return m_blend;}
+
+		///Bytes accounted against the memory budget (measured once loaded).
+		GK_INLINE UTsize           getMemorySize(void) const {return m_memory;}
+
+		///Restrict instancing to the given groups, all groups of the file otherwise.
+		GK_INLINE void             addGroup(const gkString& name) {m_groups.push_back(name);}
+
+		GK_INLINE bool             isResident(void) const {return m_state >= SS_INSTANCING;}
+
+	private:
+		friend class gkSectorStreamer;
+
+		const gkString      m_name;
+		const gkString      m_file;
+		const gkString      m_resourceGroup;
+		gkVector3           m_center;
+		gkScalar            m_radius;
+		gkScalar            m_distance;
+		SectorState         m_state;
+		gkBlendFile*        m_blend;
+		UTsize              m_fileSize;
+		UTsize              m_memory;
+		UTsize              m_baseMemory;
+		GroupNames          m_groups;
+		Groups              m_targets;
+		GroupInstances      m_instances;
+		UTsize              m_cursor;
+		ASYNC_SIZE_RESULT   m_prefetch;
+		gkBlendLoader::AsyncLoad* m_load;
+	};
+
+	typedef utArray<Sector*> Sectors;
+
+
+public:
+	gkSectorStreamer(gkScene* scene);
+	virtual ~gkSectorStreamer();
+
+	Sector* addSector(const gkString& name, const gkString& file, const gkVector3& center, gkScalar radius);
+	Sector* getSector(const gkString& name);
+
+	///Unloads the sector right away and forgets about it.
+	void    removeSector(const gkString& name);
+
+
+	///The focus object (the scene's main camera when not set).
+	GK_INLINE void          setFocus(gkGameObject* obj)            {m_focus = obj; m_hasFocusPosition = false;}
+	GK_INLINE void          setFocusPosition(const gkVector3& pos) {m_focusPosition = pos; m_hasFocusPosition = true;}
+
+	///Extra distance past a sector's radius before it is unloaded, files are prefetched inside this band.
+	GK_INLINE void          setHysteresis(gkScalar v)              {m_hysteresis = gkMax<gkScalar>(v, 0);}
+	GK_INLINE gkScalar      getHysteresis(void)              const {return m_hysteresis;}
+
+	///Milliseconds per frame spent on instancing and unloading (0 = unlimited), conversion
+	///of loaded files is budgeted by gkBlendLoader through gkUserDefs::instancingBudget.
+	GK_INLINE void          setFrameBudget(gkScalar ms)            {m_frameBudget = gkMax<gkScalar>(ms, 0);}
+	GK_INLINE gkScalar      getFrameBudget(void)             const {return m_frameBudget;}
+
+	///Bytes of resident sector data (0 = unlimited).
+	GK_INLINE void          setMemoryBudget(UTsize bytes)          {m_memoryBudget = bytes;}
+	GK_INLINE UTsize        getMemoryBudget(void)            const {return m_memoryBudget;}
+	GK_INLINE UTsize        getMemoryUsage(void)             const {return m_memoryUsage;}
+
+	GK_INLINE gkScene*      getScene(void)                         {return m_scene;}
+	GK_INLINE Sectors&      getSectors(void)                       {return m_sectors;}
+
+	///Returns true when no sector is waiting to be loaded, instanced or unloaded.
+	bool isIdle(void);
+
+	///Called each engine tick, may also be called manually. The frame budget
+	///is capped to the tick length rate (seconds) when given.
+	void update(gkScalar rate = 0);
+
+	void tick(gkScalar rate) {update(rate);}
+
+
+private:
+
+	void     updateDistances(const gkVector3& focus);
+	void     prefetch(Sector* sector);
+	void     load(Sector* sector);
+	bool     finishLoad(Sector* sector);
+	bool     instanceNext(Sector* sector);
+	bool     unloadNext(Sector* sector);
+	void     unloadNow(Sector* sector);
+	bool     makeRoom(UTsize bytes);
+	bool     isSpent(void);
+	Sector*  findNearest(SectorState state, bool insideRadius);
+
+	UTsize   getResourceMemory(void);
+
+
+	gkScene*        m_scene;
+	Sectors         m_sectors;
+	gkGameObject*   m_focus;
+	gkVector3       m_focusPosition;
+	bool            m_hasFocusPosition;
+	gkScalar        m_hysteresis;
+	gkScalar        m_frameBudget;
+	unsigned long   m_spendLimit;       // microseconds for the current update
+	UTsize          m_memoryBudget;
+	UTsize          m_memoryUsage;
+	gkActiveObject  m_prefetcher;
+
+	Ogre::Timer     m_timer;
+};
+
+
+#endif//_gkSectorStreamer_h_
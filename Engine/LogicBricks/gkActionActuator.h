@@ -83,8 +83,8 @@ public:
 	void playAction(void);
 	void stopAction(void);
 
-	GK_INLINE void     setStart(int v)                 {m_startFrame = m_start; m_start = v / m_animFps;}
-	GK_INLINE void     setEnd(int v)                   {m_endFrame = m_end; m_end = v / m_animFps;}
+	GK_INLINE void     setStart(int v)                 {m_startFrame = v; m_start = v / m_animFps;}
+	GK_INLINE void     setEnd(int v)                   {m_endFrame = v; m_end = v / m_animFps;}
 	GK_INLINE void     setBlend(gkScalar v)                 {m_blend = v;}
 	GK_INLINE void     setMode(int v)                       {m_mode = v;}
 	GK_INLINE void     setPriority(int v)                   {m_prio = v;}
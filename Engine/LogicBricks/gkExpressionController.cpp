@@ -61,6 +61,7 @@ gkLogicBrick* gkExpressionController::clone(gkLogicLink* link, gkGameObject* des
 
 void gkExpressionController::setExpression(const gkString& str)
 {
+	m_expression = str;
 
 	gkString expr = "return " + str + "\n";
 	gkLuaScript* scrpt = gkLuaManager::getSingleton().createFromText(
@@ -36,6 +36,7 @@ class gkExpressionController : public gkLogicController
 protected:
 	class gkLuaScript* m_script;
 	bool m_error, m_isModule;
+	gkString m_expression;
 
 public:
 
@@ -51,6 +52,7 @@ public:
 	GK_INLINE bool isModule(void)               {return m_isModule;}
 	GK_INLINE void setScript(gkLuaScript* sc)   {m_script = sc;}
 	GK_INLINE gkLuaScript* getScript(void)      {return m_script;}
+	GK_INLINE const gkString& getExpression(void) const {return m_expression;}
 };
 
 #endif//OGREKIT_USE_LUA
@@ -83,6 +83,13 @@ public:
 	GK_INLINE void setAllElementEvents(bool v)         {m_allEvents = v;}
 	GK_INLINE void setEventType(int v)                 {m_eventType = v;}
 	GK_INLINE void setAxisDirection(int v)             {m_axisDirection = v;}
+
+	GK_INLINE unsigned int getJoystickIndex(void)      const {return m_joystickIndex;}
+	GK_INLINE unsigned int getElementIndex(void)       const {return m_elementIndex;}
+	GK_INLINE unsigned int getAxisThreshold(void)      const {return m_axisThreshold;}
+	GK_INLINE bool         getAllElementEvents(void)   const {return m_allEvents;}
+	GK_INLINE int          getEventType(void)          const {return m_eventType;}
+	GK_INLINE int          getAxisDirection(void)      const {return m_axisDirection;}
 };
 
 #endif // GKJOYSTICKSENSOR_H
@@ -42,7 +42,7 @@ void gkAbstractDispatcher::doDispatch(SensorList& senslist)
 			gkLogicSensor*   sens = it.getNext();
 			gkGameObject*    obj = sens->getObject();
 
-			if (obj && obj->isInstanced())
+			if (obj && obj->isInstanced() && !obj->isActivityCulled())
 				sens->execute();
 		}
 	}
@@ -125,6 +125,14 @@ public:
 	GK_INLINE const gkVector3& getAngularVelocity(void)     const {return m_angv.vec;}
 	GK_INLINE gkScalar         getDamping(void)             const {return m_damping;}
 	GK_INLINE bool             getIncrementalVelocity(void) const {return m_linvInc;}
+
+	GK_INLINE bool isTranslationLocal(void)     const {return m_loc.local;}
+	GK_INLINE bool isRotationLocal(void)        const {return m_rot.local;}
+	GK_INLINE bool isForceLocal(void)           const {return m_force.local;}
+	GK_INLINE bool isTorqueLocal(void)          const {return m_torque.local;}
+	GK_INLINE bool isLinearVelocityLocal(void)  const {return m_linv.local;}
+	GK_INLINE bool isAngularVelocityLocal(void) const {return m_angv.local;}
+	GK_INLINE int  getType(void)                const {return m_type;}
 };
 
 
@@ -27,10 +27,29 @@
 #include "gkMouseSensor.h"
 #include "gkLogicManager.h"
 #include "gkCamera.h"
+#include "gkEntity.h"
 #include "gkScene.h"
 
 #include "OgreCamera.h"
 #include "OgreSceneManager.h"
+#include "OgreInstancedEntity.h"
+
+
+
+// Ogre ray queries skip hardware instances, their bounds are tested instead.
+static bool gkMouseSensor_hitInstances(gkGameObject* obj, const Ogre::Ray& ray)
+{
+	if (obj->getType() != GK_ENTITY)
+		return false;
+
+	gkEntityInstancer::InstancedEntities& insts = obj->getEntity()->getInstancedEntities();
+	for (UTsize i = 0; i < insts.size(); ++i)
+	{
+		if (insts[i]->isInScene() && ray.intersects(insts[i]->getWorldBoundingBox(true)).first)
+			return true;
+	}
+	return false;
+}
 
 
 gkMouseDispatch::gkMouseDispatch()
@@ -171,5 +190,17 @@ bool gkMouseSensor::rayTest(void)
 			}
 		}
 	}
+
+	if (!result && m_object->getOwner()->getEntityInstancer())
+	{
+		if (m_type == MOUSE_MOUSE_OVER)
+			result = gkMouseSensor_hitInstances(m_object, dest);
+		else
+		{
+			gkGameObjectSet::Iterator it = m_object->getOwner()->getInstancedObjects().iterator();
+			while (!result && it.hasMoreElements())
+				result = gkMouseSensor_hitInstances(it.getNext(), dest);
+		}
+	}
 	return result;
 }
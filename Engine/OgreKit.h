@@ -35,6 +35,9 @@
 #include "gkDebugger.h"
 #include "gkEngine.h"
 #include "gkEntity.h"
+#include "gkEntityInstancer.h"
+#include "gkActivityCuller.h"
+#include "gkMeshSimplifier.h"
 #include "gkGameObject.h"
 #include "gkGameObjectManager.h"
 #include "gkGroupManager.h"
@@ -55,6 +58,7 @@
 #include "gkRenderFactory.h"
 #include "gkScene.h"
 #include "gkSceneManager.h"
+#include "gkSceneSnapshot.h"
 #include "gkSerialize.h"
 #include "gkSkeleton.h"
 #include "gkSkeletonResource.h"
@@ -103,6 +107,8 @@
 
 #include "Loaders/Blender2/gkBlendFile.h"
 #include "Loaders/Blender2/gkBlendLoader.h"
+#include "Loaders/Blender2/gkBlendPackage.h"
+#include "Loaders/Blender2/gkSectorStreamer.h"
 
 #include "Logic/gkButtonNode.h"
 #include "Logic/gkCameraNode.h"
@@ -181,6 +187,7 @@
 #include "LogicBricks/gkSoundActuator.h"
 
 #include "Physics/gkCharacter.h"
+#include "Physics/gkCollisionCache.h"
 #include "Physics/gkContactTest.h"
 #include "Physics/gkDynamicsWorld.h"
 #include "Physics/gkPhysicsDebug.h"
@@ -189,6 +196,7 @@
 #include "Physics/gkSoftBody.h"
 #include "Physics/gkVehicle.h"
 #include "Physics/gkRayTest.h"
+#include "Physics/gkSpatialQuery.h"
 #include "Physics/gkSweptTest.h"
 
 #include "Particles/gkParticleManager.h"
@@ -215,6 +223,7 @@
 
 #include "Thread/gkActiveObject.h"
 #include "Thread/gkCriticalSection.h"
+#include "Thread/gkJobPool.h"
 #include "Thread/gkNonCopyable.h"
 #include "Thread/gkNonCopyable.h"
 #include "Thread/gkPtrRef.h"
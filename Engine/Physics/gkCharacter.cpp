@@ -141,9 +141,7 @@ void gkCharacter::destroy(void)
 		m_owner->getBulletWorld()->removeAction(m_character);
 		m_owner->getBulletWorld()->removeCollisionObject(m_collisionObject);
 
-		delete m_shape;
-
-		m_shape = 0;
+		releaseShape();
 
 		delete m_character;
 
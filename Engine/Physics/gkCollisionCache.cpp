@@ -0,0 +1,448 @@
+/*
+-------------------------------------------------------------------------------
+    This file is part of OgreKit.
+    http://gamekit.googlecode.com/
+
+    Copyright (c) 2006-2013 Charlie C.
+
+    Contributor(s): none yet.
+-------------------------------------------------------------------------------
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#include "gkCollisionCache.h"
+#include "gkLogger.h"
+#include "btBulletDynamicsCommon.h"
+#include "BulletCollision/CollisionShapes/btOptimizedBvh.h"
+
+#if GK_PLATFORM == GK_PLATFORM_WIN32
+# include <windows.h>
+#else
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <fcntl.h>
+# include <unistd.h>
+#endif
+
+#include <stdio.h>
+
+
+#define GK_BVH_FILE_ID          "GKBV"
+#define GK_BVH_FILE_VERSION     ((1 << 16) | BT_BULLET_VERSION)
+#define GK_BVH_ENDIAN_TAG       0x01020304
+
+
+// 32 bytes, keeps the tree 16 byte aligned in the mapping
+struct gkBvhFileHeader
+{
+	char        m_id[4];
+	UTuint32    m_version;
+	UTuint32    m_endian;
+	UTuint32    m_scalarSize;
+	UTuint64    m_key;
+	UTuint32    m_size;
+	UTuint32    m_pad;
+};
+
+
+
+static void* gkMapFile(const gkString& name, UTsize& size)
+{
+	void* data = 0;
+	size = 0;
+
+	// copy on write, deserializing patches the tree in place
+#if GK_PLATFORM == GK_PLATFORM_WIN32
+
+	HANDLE file = CreateFileA(name.c_str(), GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+	if (file == INVALID_HANDLE_VALUE)
+		return 0;
+
+	DWORD high = 0;
+	DWORD low = GetFileSize(file, &high);
+
+	HANDLE mapping = high == 0 && low > 0 ? CreateFileMappingA(file, 0, PAGE_WRITECOPY, 0, 0, 0) : 0;
+	if (mapping)
+	{
+		data = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+		if (data)
+			size = (UTsize)low;
+		CloseHandle(mapping);
+	}
+	CloseHandle(file);
+
+#else
+
+	int fd = open(name.c_str(), O_RDONLY);
+	if (fd < 0)
+		return 0;
+
+	struct stat st;
+	if (fstat(fd, &st) == 0 && st.st_size > 0)
+	{
+		data = mmap(0, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+		if (data == MAP_FAILED)
+			data = 0;
+		else
+			size = (UTsize)st.st_size;
+	}
+	close(fd);
+
+#endif
+
+	return data;
+}
+
+
+
+static void gkUnmapFile(void* data, UTsize size)
+{
+#if GK_PLATFORM == GK_PLATFORM_WIN32
+	UnmapViewOfFile(data);
+#else
+	munmap(data, size);
+#endif
+}
+
+
+
+static GK_INLINE void gkHashBytes(UTuint64& hash, const void* data, UTsize len)
+{
+	const unsigned char* p = static_cast<const unsigned char*>(data);
+	for (UTsize i = 0; i < len; ++i)
+	{
+		hash ^= p[i];
+		hash *= 1099511628211ULL;
+	}
+}
+
+
+
+gkCollisionCache::ShapeKey::ShapeKey(gkMesh* mesh, int type, const gkVector3& size, const gkVector3& scale, gkScalar margin)
+	:   m_mesh(mesh),
+	    m_type(type),
+	    m_size(size),
+	    m_scale(scale),
+	    m_margin(margin)
+{
+	UTuint64 hash = 14695981039346656037ULL;
+	gkHashBytes(hash, &m_mesh, sizeof(gkMesh*));
+	gkHashBytes(hash, &m_type, sizeof(int));
+	gkHashBytes(hash, m_size.ptr(), 3 * sizeof(gkScalar));
+	gkHashBytes(hash, m_scale.ptr(), 3 * sizeof(gkScalar));
+	gkHashBytes(hash, &m_margin, sizeof(gkScalar));
+	m_hash = (UThash)(hash ^ (hash >> 32));
+}
+
+
+
+bool gkCollisionCache::ShapeKey::operator== (const ShapeKey& o) const
+{
+	return m_hash == o.m_hash && m_mesh == o.m_mesh && m_type == o.m_type &&
+	       m_size == o.m_size && m_scale == o.m_scale && m_margin == o.m_margin;
+}
+
+
+
+gkCollisionCache::gkCollisionCache(const gkString& path)
+	:   m_path(path)
+{
+}
+
+
+
+gkCollisionCache::~gkCollisionCache()
+{
+	// controllers are gone, anything left was leaked by its owner
+	for (UTsize i = 0; i < m_shapes.size(); ++i)
+		destroyShape(m_shapes.at(i).m_shape);
+	m_shapes.clear();
+	m_shapeKeys.clear();
+
+	for (UTsize i = 0; i < m_trees.size(); ++i)
+		freeTree(m_trees.at(i));
+	m_trees.clear();
+}
+
+
+
+UTuint64 gkCollisionCache::hashMesh(btTriangleMesh* mesh, const btVector3& scale)
+{
+	// FNV-1a over the positions and indices of every part
+	UTuint64 hash = 14695981039346656037ULL;
+
+	UTuint32 header[2] = { GK_BVH_FILE_VERSION, sizeof(btScalar) };
+	gkHashBytes(hash, header, sizeof(header));
+
+	for (int part = 0; part < mesh->getNumSubParts(); ++part)
+	{
+		const unsigned char* verts, *indices;
+		int numVerts, vertStride, indexStride, numFaces;
+		PHY_ScalarType vertType, indexType;
+
+		mesh->getLockedReadOnlyVertexIndexBase(&verts, numVerts, vertType, vertStride,
+		                                       &indices, indexStride, numFaces, indexType, part);
+
+		gkHashBytes(hash, &numVerts, sizeof(int));
+		gkHashBytes(hash, &numFaces, sizeof(int));
+
+		UTsize coordSize = vertType == PHY_DOUBLE ? 3 * sizeof(double) : 3 * sizeof(float);
+		for (int i = 0; i < numVerts; ++i)
+			gkHashBytes(hash, verts + i * vertStride, coordSize);
+
+		for (int i = 0; i < numFaces; ++i)
+		{
+			const unsigned char* face = indices + i * indexStride;
+
+			UTuint32 tri[3];
+			for (int k = 0; k < 3; ++k)
+				tri[k] = indexType == PHY_SHORT ? ((const unsigned short*)face)[k] : ((const unsigned int*)face)[k];
+			gkHashBytes(hash, tri, sizeof(tri));
+		}
+
+		mesh->unLockReadOnlyVertexBase(part);
+	}
+
+	float scl[3] = { (float)scale.x(), (float)scale.y(), (float)scale.z() };
+	gkHashBytes(hash, scl, sizeof(scl));
+	return hash;
+}
+
+
+
+gkString gkCollisionCache::getFileName(UTuint64 key) const
+{
+	char name[32];
+	sprintf(name, "%08x%08x.bvh", (unsigned int)(key >> 32), (unsigned int)(key & 0xFFFFFFFF));
+
+	if (m_path.empty())
+		return name;
+
+	char last = m_path[m_path.size() - 1];
+	return (last == '/' || last == '\\') ? m_path + name : m_path + "/" + name;
+}
+
+
+
+btBvhTriangleMeshShape* gkCollisionCache::createBvhShape(btTriangleMesh* mesh, const btVector3& scale)
+{
+	GK_ASSERT(mesh);
+
+	UTuint64 key = hashMesh(mesh, scale);
+
+	UTsize pos = m_trees.find(key);
+	if (pos == UT_NPOS)
+	{
+		Tree tree;
+		if (!loadTree(key, tree) && !buildTree(mesh, scale, key, tree))
+			return 0;
+
+		m_trees.insert(key, tree);
+		pos = m_trees.find(key);
+	}
+
+	// the tree was built for this scaling, setting it does not rebuild
+	btBvhTriangleMeshShape* shape = new btBvhTriangleMeshShape(mesh, true, false);
+	shape->setOptimizedBvh(m_trees.at(pos).m_bvh, scale);
+	return shape;
+}
+
+
+
+btCollisionShape* gkCollisionCache::acquireShape(const ShapeKey& key)
+{
+	SharedShape* shared = m_shapes.get(key);
+	if (!shared)
+		return 0;
+
+	++shared->m_refs;
+	return shared->m_shape;
+}
+
+
+
+void gkCollisionCache::addShape(const ShapeKey& key, btCollisionShape* shape)
+{
+	GK_ASSERT(shape && m_shapes.find(key) == UT_NPOS);
+
+	SharedShape shared;
+	shared.m_shape = shape;
+	shared.m_refs  = 1;
+
+	m_shapes.insert(key, shared);
+	m_shapeKeys.insert(shape, key);
+}
+
+
+
+bool gkCollisionCache::releaseShape(btCollisionShape* shape)
+{
+	UTsize pos = m_shapeKeys.find(shape);
+	if (pos == UT_NPOS)
+		return false;
+
+	ShapeKey key = m_shapeKeys.at(pos);
+	SharedShape* shared = m_shapes.get(key);
+	GK_ASSERT(shared && shared->m_shape == shape);
+
+	if (--shared->m_refs <= 0)
+	{
+		m_shapes.remove(key);
+		m_shapeKeys.remove(shape);
+		destroyShape(shape);
+	}
+	return true;
+}
+
+
+
+void gkCollisionCache::destroyShape(btCollisionShape* shape)
+{
+	if (!shape)
+		return;
+
+	if (shape->isCompound())
+	{
+		btCompoundShape* compShape = static_cast<btCompoundShape*>(shape);
+		for (int i = 0; i < compShape->getNumChildShapes(); i++)
+			destroyShape(compShape->getChildShape(i));
+	}
+	else if (shape->getShapeType() == SCALED_TRIANGLE_MESH_SHAPE_PROXYTYPE)
+		delete static_cast<btScaledBvhTriangleMeshShape*>(shape)->getChildShape();
+
+	delete shape;
+}
+
+
+
+bool gkCollisionCache::loadTree(UTuint64 key, Tree& tree)
+{
+	if (m_path.empty())
+		return false;
+
+	UTsize size;
+	void* data = gkMapFile(getFileName(key), size);
+	if (!data)
+		return false;
+
+	const gkBvhFileHeader* header = static_cast<const gkBvhFileHeader*>(data);
+
+	if (size < sizeof(gkBvhFileHeader)
+	        || memcmp(header->m_id, GK_BVH_FILE_ID, 4) != 0
+	        || header->m_version != GK_BVH_FILE_VERSION
+	        || header->m_endian != GK_BVH_ENDIAN_TAG
+	        || header->m_scalarSize != sizeof(btScalar)
+	        || header->m_key != key
+	        || header->m_size > size - sizeof(gkBvhFileHeader))
+	{
+		gkLogMessage("CollisionCache: Ignoring stale " << getFileName(key));
+		gkUnmapFile(data, size);
+		return false;
+	}
+
+	char* treeData = static_cast<char*>(data) + sizeof(gkBvhFileHeader);
+
+	tree.m_bvh    = static_cast<btOptimizedBvh*>(btOptimizedBvh::deSerializeInPlace(treeData, header->m_size, false));
+	tree.m_data   = data;
+	tree.m_size   = size;
+	tree.m_mapped = true;
+
+	if (!tree.m_bvh)
+	{
+		gkUnmapFile(data, size);
+		return false;
+	}
+	return true;
+}
+
+
+
+bool gkCollisionCache::buildTree(btTriangleMesh* mesh, const btVector3& scale, UTuint64 key, Tree& tree)
+{
+	btBvhTriangleMeshShape* builder = new btBvhTriangleMeshShape(mesh, true, false);
+	builder->btTriangleMeshShape::setLocalScaling(scale);
+	builder->buildOptimizedBvh();
+
+	btOptimizedBvh* bvh = builder->getOptimizedBvh();
+	UTuint32 treeSize = bvh->calculateSerializeBufferSize();
+
+	gkBvhFileHeader header;
+	memcpy(header.m_id, GK_BVH_FILE_ID, 4);
+	header.m_version    = GK_BVH_FILE_VERSION;
+	header.m_endian     = GK_BVH_ENDIAN_TAG;
+	header.m_scalarSize = sizeof(btScalar);
+	header.m_key        = key;
+	header.m_size       = treeSize;
+	header.m_pad        = 0;
+
+	UTsize size = sizeof(gkBvhFileHeader) + treeSize;
+	char* data = static_cast<char*>(btAlignedAlloc(size, 16));
+	memcpy(data, &header, sizeof(gkBvhFileHeader));
+
+	bool ok = bvh->serialize(data + sizeof(gkBvhFileHeader), treeSize, false);
+	delete builder;
+
+	if (!ok)
+	{
+		btAlignedFree(data);
+		return false;
+	}
+
+
+	// cook before deserializing, that patches the buffer
+	if (!m_path.empty())
+	{
+		gkString name = getFileName(key);
+		FILE* fp = fopen(name.c_str(), "wb");
+		if (fp)
+		{
+			fwrite(data, size, 1, fp);
+			fclose(fp);
+		}
+		else
+			gkLogMessage("CollisionCache: Cannot write " << name);
+	}
+
+	tree.m_bvh    = static_cast<btOptimizedBvh*>(btOptimizedBvh::deSerializeInPlace(data + sizeof(gkBvhFileHeader), treeSize, false));
+	tree.m_data   = data;
+	tree.m_size   = size;
+	tree.m_mapped = false;
+
+	if (!tree.m_bvh)
+	{
+		btAlignedFree(data);
+		return false;
+	}
+	return true;
+}
+
+
+
+void gkCollisionCache::freeTree(Tree& tree)
+{
+	// the tree lives inside the buffer, its arrays do not own memory
+	if (tree.m_bvh)
+		tree.m_bvh->~btOptimizedBvh();
+
+	if (tree.m_mapped)
+		gkUnmapFile(tree.m_data, tree.m_size);
+	else
+		btAlignedFree(tree.m_data);
+
+	tree.m_bvh = 0;
+	tree.m_data = 0;
+}
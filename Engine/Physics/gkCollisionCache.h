@@ -0,0 +1,145 @@
+/*
+-------------------------------------------------------------------------------
+    This file is part of OgreKit.
+    http://gamekit.googlecode.com/
+
+    Copyright (c) 2006-2013 Charlie C.
+
+    Contributor(s): none yet.
+-------------------------------------------------------------------------------
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#ifndef _gkCollisionCache_h_
+#define _gkCollisionCache_h_
+
+#include "gkCommon.h"
+#include "gkString.h"
+#include "gkMathUtils.h"
+#include "LinearMath/btScalar.h"
+
+class btCollisionShape;
+class btTriangleMesh;
+class btBvhTriangleMeshShape;
+class btOptimizedBvh;
+class btVector3;
+
+
+///Shares collision shapes between physics controllers, and the quantized BVH
+///of static triangle mesh shapes, which it also cooks to disk.
+///
+///Shapes are reference counted and keyed by mesh, shape type, size, scaling and
+///margin, so every instance or clone of a prop uses one btCollisionShape.
+///Trees are keyed by a hash of the collision triangles and the shape scaling.
+///Shapes with the same key use one tree, and when a cache directory is given
+///each tree is written to a sidecar file which later loads map instead of
+///building it again. Trees live as long as the cache, owned by gkEngine.
+class gkCollisionCache
+{
+public:
+
+	class ShapeKey
+	{
+	public:
+		ShapeKey() : m_mesh(0), m_type(0), m_margin(0), m_hash(0) {}
+		ShapeKey(gkMesh* mesh, int type, const gkVector3& size, const gkVector3& scale, gkScalar margin);
+
+		UThash hash(void) const {return m_hash;}
+
+		bool operator== (const ShapeKey& o) const;
+		bool operator!= (const ShapeKey& o) const {return !(*this == o);}
+
+		gkMesh*     m_mesh;     // mesh shapes only
+		int         m_type;
+		gkVector3   m_size, m_scale;
+		gkScalar    m_margin;
+		UThash      m_hash;
+	};
+
+public:
+
+	///path is the sidecar directory, empty keeps the trees in memory only.
+	gkCollisionCache(const gkString& path);
+	~gkCollisionCache();
+
+	///New shape over mesh at the given scaling, reusing or building its tree.
+	btBvhTriangleMeshShape* createBvhShape(btTriangleMesh* mesh, const btVector3& scale);
+
+	static UTuint64 hashMesh(btTriangleMesh* mesh, const btVector3& scale);
+
+
+	///Shared shape of key with one more reference, 0 if there is none yet.
+	btCollisionShape* acquireShape(const ShapeKey& key);
+
+	///Shares a newly built shape, the caller holds the first reference.
+	void addShape(const ShapeKey& key, btCollisionShape* shape);
+
+	///Drops a reference and deletes the shape with the last one.
+	///Returns false for shapes this cache does not know.
+	bool releaseShape(btCollisionShape* shape);
+
+	///Deletes a shape and what it owns: compound children, wrapped BVH shapes.
+	static void destroyShape(btCollisionShape* shape);
+
+private:
+
+	struct SharedShape
+	{
+		btCollisionShape*   m_shape;
+		int                 m_refs;
+	};
+
+	typedef utHashTable<ShapeKey, SharedShape>              Shapes;
+	typedef utHashTable<utPointerHashKey, ShapeKey>         ShapeKeys;
+
+	struct Tree
+	{
+		btOptimizedBvh*     m_bvh;
+		void*               m_data;     // serialized tree, mapped or aligned heap
+		UTsize              m_size;
+		bool                m_mapped;
+	};
+
+	class TreeKey
+	{
+	public:
+		TreeKey(UTuint64 key = 0) : m_key(key) {}
+
+		UThash hash(void) const {return (UThash)(m_key ^ (m_key >> 32));}
+
+		bool operator== (const TreeKey& o) const {return m_key == o.m_key;}
+		bool operator!= (const TreeKey& o) const {return m_key != o.m_key;}
+
+		UTuint64 m_key;
+	};
+
+	typedef utHashTable<TreeKey, Tree> Trees;
+
+	gkString getFileName(UTuint64 key) const;
+
+	bool loadTree(UTuint64 key, Tree& tree);
+	bool buildTree(btTriangleMesh* mesh, const btVector3& scale, UTuint64 key, Tree& tree);
+	void freeTree(Tree& tree);
+
+	gkString    m_path;
+	Trees       m_trees;
+	Shapes      m_shapes;
+	ShapeKeys   m_shapeKeys;
+};
+
+
+#endif//_gkCollisionCache_h_
@@ -31,6 +31,9 @@
 #include "gkRigidBody.h"
 #include "gkEngine.h"
 #include "gkUserDefs.h"
+#include "gkEntity.h"
+#include "gkMesh.h"
+#include "gkOcclusionBuffer.h"
 
 #include "OgreCamera.h"
 
@@ -39,14 +42,43 @@
 gkDbvt::gkDbvt()
 	:    m_tvs(0),
 	     m_tot(0),
-	     m_debug(gkString("btDbvt"), false)
+	     m_changes(0),
+	     m_debug(gkString("btDbvt"), false),
+	     m_current(0),
+	     m_valid(false),
+	     m_camera(0),
+	     m_camAspect(0),
+	     m_margin(0.5f),
+	     m_occlusion(0),
+	     m_occluded(0)
 {
+	setOcclusionCulling(gkEngine::getSingleton().getUserDefs().occlusionCulling);
 }
 
 
 
 gkDbvt::~gkDbvt()
 {
+	clearOccluders();
+	delete m_occlusion;
+}
+
+
+
+void gkDbvt::setOcclusionCulling(bool v)
+{
+	if (v == (m_occlusion != 0))
+		return;
+
+	if (v)
+		m_occlusion = new gkOcclusionBuffer();
+	else
+	{
+		delete m_occlusion;
+		m_occlusion = 0;
+		clearOccluders();
+	}
+	invalidate();
 }
 
 
@@ -54,16 +86,204 @@ gkDbvt::~gkDbvt()
 void gkDbvt::Process(const btDbvtNode* nd)
 {
 	btBroadphaseProxy* proxy = (btBroadphaseProxy*)nd->data;
-	if (gkPhysicsController::castController(proxy->m_clientObject)->_markDbvt(true))
-		m_tvs++;
+	gkPhysicsController* cont = gkPhysicsController::castController(proxy->m_clientObject);
+
+	if (m_occlusion)
+	{
+		// resolved once all occluders are drawn
+		Candidate cand = {cont, proxy->m_aabbMin, proxy->m_aabbMax};
+		m_candidates.push_back(cand);
+		return;
+	}
+
+	setVisible(cont);
+}
+
+
+
+void gkDbvt::setVisible(gkPhysicsController* cont)
+{
+	if (!m_sets[m_current].insert(cont))
+		return;
+
+	m_tvs++;
+
+	// only objects entering the frustum are touched
+	if (m_sets[!m_current].find(cont) == UT_NPOS || m_pending.find(cont) != UT_NPOS)
+	{
+		if (cont->_markDbvt(true))
+			m_changes++;
+	}
+}
+
+
+
+void gkDbvt::invalidate(void)
+{
+	m_valid = false;
+	m_camera = 0;
+}
+
+
+
+void gkDbvt::_notifyControllerCreated(gkPhysicsController* cont)
+{
+	m_pending.insert(cont);
 }
 
 
 
-void gkDbvt::mark(gkCamera* cam, btDbvtBroadphase* cullTree, gkPhysicsControllers& controllers)
+void gkDbvt::_notifyControllerDestroyed(gkPhysicsController* cont)
+{
+	m_sets[0].erase(cont);
+	m_sets[1].erase(cont);
+	m_pending.erase(cont);
+	m_suspended.erase(cont);
+
+	UTsize pos = m_occluders.find(cont);
+	if (pos != UT_NPOS)
+	{
+		delete m_occluders.at(pos);
+		m_occluders.remove(cont);
+	}
+}
+
+
+
+void gkDbvt::_notifyControllerResumed(gkPhysicsController* cont)
+{
+	if (m_suspended.find(cont) != UT_NPOS)
+	{
+		m_suspended.erase(cont);
+		m_pending.insert(cont);
+	}
+}
+
+
+
+void gkDbvt::clearOccluders(void)
+{
+	for (UTsize i = 0; i < m_occluders.size(); ++i)
+		delete m_occluders.at(i);
+	m_occluders.clear();
+}
+
+
+
+gkDbvt::Triangles* gkDbvt::getOccluderTriangles(gkPhysicsController* cont)
+{
+	UTsize pos = m_occluders.find(cont);
+	if (pos != UT_NPOS)
+		return m_occluders.at(pos);
+
+	// local space triangle soup, built on first use
+	Triangles* tris = new Triangles();
+
+	gkGameObject* obj = cont->getObject();
+	gkMesh* mesh = obj->getType() == GK_ENTITY ? static_cast<gkEntity*>(obj)->getMesh() : 0;
+
+	if (mesh)
+	{
+		gkMesh::SubMeshIterator iter = mesh->getSubMeshIterator();
+		while (iter.hasMoreElements())
+		{
+			gkSubMesh* sub = iter.getNext();
+
+			const gkSubMesh::Triangles& faces = sub->getIndexBuffer();
+			const gkSubMesh::Verticies& verts = sub->getVertexBuffer();
+
+			for (UTsize i = 0; i < faces.size(); ++i)
+			{
+				const gkTriangle& t = faces[i];
+				tris->push_back(verts[t.i0].co);
+				tris->push_back(verts[t.i1].co);
+				tris->push_back(verts[t.i2].co);
+			}
+		}
+	}
+
+	m_occluders.insert(cont, tris);
+	return tris;
+}
+
+
+
+void gkDbvt::drawOccluder(gkPhysicsController* cont)
+{
+	Triangles* tris = getOccluderTriangles(cont);
+	if (tris->empty())
+		return;
+
+	const gkMatrix4& world = cont->getObject()->getWorldTransform();
+
+	for (UTsize i = 0; i + 2 < tris->size(); i += 3)
+	{
+		m_occlusion->drawTriangle(world * tris->at(i),
+		                          world * tris->at(i + 1),
+		                          world * tris->at(i + 2));
+	}
+}
+
+
+
+bool gkDbvt::isCoherent(gkCamera* cam)
+{
+	if (m_camera != cam)
+		return false;
+
+	Ogre::Camera* ocam = cam->getCamera();
+	if (ocam->getFOVy() != m_camFov || ocam->getAspectRatio() != m_camAspect)
+		return false;
+
+	// the widened frustum still contains everything the camera can see
+	const gkVector3 pos = cam->getWorldPosition();
+	if (pos.squaredDistance(m_camPos) >= m_margin * m_margin)
+		return false;
+
+	const gkQuaternion rot = cam->getWorldOrientation();
+	if (rot == m_camRot)
+		return true;
+
+	// infinite far plane, rotations are never safe
+	gkScalar farDist = ocam->getFarClipDistance();
+	if (farDist <= 0)
+		return false;
+
+	// rotating moves the far corners of the frustum by about angle * distance
+	Ogre::Radian angle;
+	gkVector3 axis;
+	(rot * m_camRot.Inverse()).ToAngleAxis(angle, axis);
+
+	gkScalar moved = pos.distance(m_camPos) + gkAbs(angle.valueRadians()) * farDist;
+	return moved < m_margin;
+}
+
+
+
+void gkDbvt::mark(gkCamera* cam, btDbvtBroadphase* cullTree, gkPhysicsControllers& controllers, bool objectsMoved)
 {
 	GK_ASSERT(cam && cullTree);
 
+	if (!m_valid)
+	{
+		// state of every controller unknown, diff against an empty set
+		m_sets[0].clear(true);
+		m_sets[1].clear(true);
+		m_pending.clear(true);
+		m_suspended.clear(true);
+
+		gkPhysicsControllers::Iterator iter = controllers.iterator();
+		while (iter.hasMoreElements())
+			m_pending.insert(iter.getNext());
+	}
+	else if (!objectsMoved && m_pending.empty() && isCoherent(cam))
+	{
+		// the margin says nothing about what the occluders hide
+		if (!m_occlusion || (cam->getWorldPosition() == m_camPos && cam->getWorldOrientation() == m_camRot))
+			return;
+	}
+
+
 	const Ogre::Plane* planes = cam->getCamera()->getFrustumPlanes();
 
 	btVector3 normals[6];
@@ -72,30 +292,100 @@ void gkDbvt::mark(gkCamera* cam, btDbvtBroadphase* cullTree, gkPhysicsController
 	for (int i = 0; i < 6; ++i)
 	{
 		normals[i].setValue(planes[i].normal.x, planes[i].normal.y, planes[i].normal.z);
-		offsets[i] = planes[i].d;
+		offsets[i] = planes[i].d + m_margin;
 	}
 
 
 	m_tot = controllers.size();
 	m_tvs = 0;
+	m_changes = 0;
 
-	if (!controllers.empty())
+	m_current = !m_current;
+	m_sets[m_current].clear(true);
+
+	btDbvt::collideKDOP(cullTree->m_sets[1].m_root, normals, offsets, 6, *this);
+	btDbvt::collideKDOP(cullTree->m_sets[0].m_root, normals, offsets, 6, *this);
+
+	m_occluded = 0;
+	if (m_occlusion)
 	{
-		// Mark all invisible
+		if (m_occlusion->begin(cam))
+		{
+			for (UTsize i = 0; i < m_candidates.size(); ++i)
+			{
+				if (m_candidates[i].cont->getObject()->getProperties().isOccluder())
+					drawOccluder(m_candidates[i].cont);
+			}
 
-		gkPhysicsControllers::Iterator iter = controllers.iterator();
-		while (iter.hasMoreElements())
-			iter.getNext()->_markDbvt(false);
+			for (UTsize i = 0; i < m_candidates.size(); ++i)
+			{
+				const Candidate& cand = m_candidates[i];
+				if (cand.cont->getObject()->getProperties().isOccluder() ||
+				        m_occlusion->isVisible(gkVector3(cand.min.x(), cand.min.y(), cand.min.z()),
+				                               gkVector3(cand.max.x(), cand.max.y(), cand.max.z())))
+					setVisible(cand.cont);
+				else
+					m_occluded++;
+			}
+		}
+		else
+		{
+			for (UTsize i = 0; i < m_candidates.size(); ++i)
+				setVisible(m_candidates[i].cont);
+		}
+
+		m_candidates.clear(true);
 	}
 
-	btDbvt::collideKDOP(cullTree->m_sets[1].m_root, normals, offsets, 6, *this);
-	btDbvt::collideKDOP(cullTree->m_sets[0].m_root, normals, offsets, 6, *this);
+
+	ControllerSet& visible = m_sets[m_current];
+	ControllerSet& previous = m_sets[!m_current];
+
+	// hide the ones that left the frustum
+	ControllerSet::Iterator it = previous.iterator();
+	while (it.hasMoreElements())
+	{
+		gkPhysicsController* cont = it.getNext();
+		if (visible.find(cont) == UT_NPOS)
+		{
+			if (cont->isSuspended())
+				m_suspended.insert(cont);
+			else if (cont->_markDbvt(false))
+				m_changes++;
+		}
+	}
+
+
+	// resolve unknown states, suspended ones wait for _notifyControllerResumed
+	if (!m_pending.empty())
+	{
+		ControllerSet::Iterator pendIt = m_pending.iterator();
+		while (pendIt.hasMoreElements())
+		{
+			gkPhysicsController* cont = pendIt.getNext();
+
+			if (cont->isSuspended())
+				m_suspended.insert(cont);
+			else if (visible.find(cont) == UT_NPOS && cont->_markDbvt(false))
+				m_changes++;
+		}
+
+		m_pending.clear(true);
+	}
+
+
+	m_valid = true;
+	m_camera = cam;
+	m_camPos = cam->getWorldPosition();
+	m_camRot = cam->getWorldOrientation();
+	m_camFov = cam->getCamera()->getFOVy();
+	m_camAspect = cam->getCamera()->getAspectRatio();
 
 
 	if (gkEngine::getSingleton().getUserDefs().debugFps)
 	{
 		char buf[72];
-		sprintf(buf, "%i, %i\n", m_tvs, m_tot);
+		sprintf(buf, "%i, %i, %i, %i\n", m_tvs, m_tot, m_changes, m_occluded);
 		m_debug.setValue(gkString(buf));
 	}
 }
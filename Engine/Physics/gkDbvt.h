@@ -31,24 +31,89 @@
 #include "gkDynamicsWorld.h"
 #include "gkVariable.h"
 
+class gkOcclusionBuffer;
 
 
+///Frustum culling on the broadphase tree.
+///
+///Only the difference with the previous visible set is applied, so the cost follows
+///the visible set and the objects entering or leaving it, not the scene size.
+///The frustum is widened by a margin, small camera motions with no moving objects
+///reuse the last result.
+///With occlusion culling on, objects flagged as occluders are rasterized into a
+///gkOcclusionBuffer and the frustum candidates behind them are hidden as well.
 class gkDbvt : public btDbvt::ICollide
 {
+public:
+	typedef utHashSet<gkPhysicsController*> ControllerSet;
+
 public:
 	gkDbvt();
 	~gkDbvt();
 
 	gkVariable* getInfo(void) {return &m_debug;}
-	void mark(gkCamera* cam, struct btDbvtBroadphase* cullTree, gkPhysicsControllers& controllers);
+
+	/// objectsMoved false means only the camera changed since the last call.
+	void mark(gkCamera* cam, struct btDbvtBroadphase* cullTree, gkPhysicsControllers& controllers, bool objectsMoved = true);
 
 	void Process(const btDbvtNode* nd);
 
+	///Forces a full visibility pass on the next mark.
+	void invalidate(void);
+
+	void _notifyControllerCreated(gkPhysicsController* cont);
+	void _notifyControllerDestroyed(gkPhysicsController* cont);
+	void _notifyControllerResumed(gkPhysicsController* cont);
+
+	GK_INLINE void     setCoherenceMargin(gkScalar v) {m_margin = gkMax<gkScalar>(0, v); invalidate();}
+	GK_INLINE gkScalar getCoherenceMargin(void)       {return m_margin;}
+
+	void setOcclusionCulling(bool v);
+	GK_INLINE bool isOcclusionCulling(void) {return m_occlusion != 0;}
+
 private:
 	void updateDebug(void);
+	bool isCoherent(gkCamera* cam);
+	void setVisible(gkPhysicsController* cont);
+
+	struct Candidate
+	{
+		gkPhysicsController* cont;
+		btVector3 min, max;
+	};
+
+	typedef utArray<Candidate>                                   Candidates;
+	typedef utArray<gkVector3>                                   Triangles;
+	typedef utHashTable<utPointerHashKey, Triangles*>            OccluderTriangles;
+
+	void drawOccluder(gkPhysicsController* cont);
+	Triangles* getOccluderTriangles(gkPhysicsController* cont);
+	void clearOccluders(void);
+
+	int             m_tvs, m_tot, m_changes;
+	gkVariable      m_debug;
+
+	// visible sets of the previous and the current pass
+	ControllerSet   m_sets[2];
+	int             m_current;
+
+	// controllers with an unknown state, resolved on the next pass
+	ControllerSet   m_pending;
+	// suspended while hidden, back to m_pending once resumed
+	ControllerSet   m_suspended;
+	bool            m_valid;
+
+	gkCamera*       m_camera;
+	gkVector3       m_camPos;
+	gkQuaternion    m_camRot;
+	Ogre::Radian    m_camFov;
+	gkScalar        m_camAspect;
+	gkScalar        m_margin;
 
-	int         m_tvs, m_tot;
-	gkVariable  m_debug;
+	gkOcclusionBuffer*  m_occlusion;
+	Candidates          m_candidates;
+	OccluderTriangles   m_occluders;
+	int                 m_occluded;
 };
 
 
@@ -35,10 +35,16 @@
 #include "gkCamera.h"
 #include "gkVariable.h"
 #include "gkDbvt.h"
+#include "gkParallelDynamicsWorld.h"
+#include "gkJobPool.h"
+#include "gkLogger.h"
+#include "gkPhysicsSnapshot.h"
+#include "gkSpatialQuery.h"
 #include "btBulletDynamicsCommon.h"
 #include "BulletCollision/CollisionDispatch/btGhostObject.h"
 #include "BulletCollision/Gimpact/btGImpactCollisionAlgorithm.h"
 #include "BulletCollision/CollisionDispatch/btCollisionDispatcher.h"
+#include "BulletDynamics/Character/btKinematicCharacterController.h"
 
 
 
@@ -47,6 +53,7 @@
 gkDynamicsWorld::gkDynamicsWorld(const gkString& name, gkScene* scene)
 	:       m_scene(scene),
 	        m_dynamicsWorld(0),
+	        m_parallelWorld(0),
 	        m_collisionConfiguration(0),
 	        m_pairCache(0),
 	        m_ghostPairCallback(0),
@@ -54,7 +61,10 @@ gkDynamicsWorld::gkDynamicsWorld(const gkString& name, gkScene* scene)
 	        m_constraintSolver(0),
 	        m_debug(0),
 	        m_handleContacts(true),
-	        m_dbvt(0)
+	        m_dbvt(0),
+	        m_currentPairs(0),
+	        m_contactSubstep(0),
+	        m_contactFrame(0)
 {
 	createInstanceImpl();
 }
@@ -82,9 +92,29 @@ void gkDynamicsWorld::createInstanceImpl(void)
 	m_ghostPairCallback = new btGhostPairCallback();
 	m_pairCache->getOverlappingPairCache()->setInternalGhostPairCallback(m_ghostPairCallback);
 
-	m_dispatcher = new btCollisionDispatcher(m_collisionConfiguration);
 	m_constraintSolver = new btSequentialImpulseConstraintSolver();
-	m_dynamicsWorld = new btDiscreteDynamicsWorld(m_dispatcher, m_pairCache, m_constraintSolver, m_collisionConfiguration);
+
+	gkJobPool* pool = 0;
+	if (gkEngine::getSingleton().getUserDefs().multithreadedPhysics)
+	{
+#ifdef OGREKIT_BULLET_MULTITHREADED
+		pool = gkEngine::getSingleton().getJobPool();
+#else
+		gkLogMessage("DynamicsWorld: multithreaded physics needs OGREKIT_BULLET_MULTITHREADED, stepping on one thread.");
+#endif
+	}
+
+	if (pool && pool->getConcurrency() > 1)
+	{
+		m_dispatcher = new gkParallelCollisionDispatcher(m_collisionConfiguration, pool);
+		m_parallelWorld = new gkParallelDynamicsWorld(m_dispatcher, m_pairCache, m_constraintSolver, m_collisionConfiguration, pool);
+		m_dynamicsWorld = m_parallelWorld;
+	}
+	else
+	{
+		m_dispatcher = new btCollisionDispatcher(m_collisionConfiguration);
+		m_dynamicsWorld = new btDiscreteDynamicsWorld(m_dispatcher, m_pairCache, m_constraintSolver, m_collisionConfiguration);
+	}
 
 	gkVector3& grav = m_scene->getProperties().m_gravity;
 	m_dynamicsWorld->setGravity(btVector3(grav.x, grav.y, grav.z));
@@ -113,6 +143,7 @@ void gkDynamicsWorld::destroyInstanceImpl(void)
 
 	delete m_dynamicsWorld;
 	m_dynamicsWorld = 0;
+	m_parallelWorld = 0;
 
 	delete m_constraintSolver;
 	m_constraintSolver = 0;
@@ -287,6 +318,10 @@ gkRigidBody* gkDynamicsWorld::createRigidBody(gkGameObject* state)
 	gkRigidBody* rb = new gkRigidBody(state, this);
 	rb->create();
 	m_objects.push_back(rb);
+
+	if (m_dbvt)
+		m_dbvt->_notifyControllerCreated(rb);
+
 	return rb;
 }
 
@@ -295,6 +330,10 @@ gkGhost* gkDynamicsWorld::createGhost(gkGameObject* state){
 	gkGhost* ghost = new gkGhost(state,this);
 	ghost->create();
 	m_objects.push_back(ghost);
+
+	if (m_dbvt)
+		m_dbvt->_notifyControllerCreated(ghost);
+
 	return ghost;
 }
 
@@ -304,6 +343,10 @@ gkCharacter* gkDynamicsWorld::createCharacter(gkGameObject* state)
 	gkCharacter* character = new gkCharacter(state, this);
 	character->create();
 	m_objects.push_back(character);
+
+	if (m_dbvt)
+		m_dbvt->_notifyControllerCreated(character);
+
 	return character;
 }
 
@@ -316,6 +359,24 @@ void gkDynamicsWorld::destroyObject(gkPhysicsController* cont)
 	{
 		m_objects.erase(pos);
 
+		if (m_dbvt)
+			m_dbvt->_notifyControllerDestroyed(cont);
+
+		// no end events for a dead controller
+		for (int s = 0; s < 2; ++s)
+		{
+			utArray<ContactPair> dead;
+			for (UTsize i = 0; i < m_contactPairs[s].size(); ++i)
+			{
+				const ContactPair& pair = m_contactPairs[s].keyAt(i);
+				if (pair.m_a == cont || pair.m_b == cont)
+					dead.push_back(pair);
+			}
+
+			for (UTsize i = 0; i < dead.size(); ++i)
+				m_contactPairs[s].remove(dead[i]);
+		}
+
 		cont->destroy();
 		delete cont;
 	}
@@ -392,14 +453,9 @@ void gkDynamicsWorld::step(gkScalar tick)
 
 void gkDynamicsWorld::resetContacts()
 {
-	if (m_handleContacts && !m_objects.empty())
-	{
-		gkPhysicsControllers::Iterator iter = m_objects.iterator();
-		while (iter.hasMoreElements())
-		{
-			iter.getNext()->_resetContactInfo();
-		}
-	}
+	// controllers drop their contacts lazily when read or touched again
+	if (m_handleContacts)
+		++m_contactFrame;
 }
 
 
@@ -415,36 +471,96 @@ void gkDynamicsWorld::presubstep(gkScalar tick)
 void gkDynamicsWorld::substep(gkScalar tick)
 {
 	if (m_handleContacts)
-	{
-		int nr = m_dispatcher->getNumManifolds();
+		processContacts();
+	
+	// update callbacks
+	utArrayIterator<gkDynamicsWorld::Listeners> iter(m_listeners);
+	while(iter.hasMoreElements())
+		iter.getNext()->subtick(tick);
+}
 
-		for (int i = 0; i < nr; ++i)
-		{
-			btPersistentManifold* manifold = m_dispatcher->getManifoldByIndexInternal(i);
 
-			gkPhysicsController* colA = gkPhysicsController::castController(manifold->getBody0());
-			gkPhysicsController* colB = gkPhysicsController::castController(manifold->getBody1());
 
-			colA->_resetContactInfo();
-			colB->_resetContactInfo();
-		}
+void gkDynamicsWorld::processContacts(void)
+{
+	++m_contactSubstep;
 
-		for (int i = 0; i < nr; ++i)
-		{
-			btPersistentManifold* manifold = m_dispatcher->getManifoldByIndexInternal(i);
+	ContactPairs& previous = m_contactPairs[m_currentPairs];
+	m_currentPairs = !m_currentPairs;
+	ContactPairs& current = m_contactPairs[m_currentPairs];
+
+	current.clear(true);
+	m_contactEvents.clear(true);
+
+
+	int nr = m_dispatcher->getNumManifolds();
+
+	for (int i = 0; i < nr; ++i)
+	{
+		btPersistentManifold* manifold = m_dispatcher->getManifoldByIndexInternal(i);
+
+		gkPhysicsController* colA = gkPhysicsController::castController(manifold->getBody0());
+		gkPhysicsController* colB = gkPhysicsController::castController(manifold->getBody1());
 
-			gkPhysicsController* colA = gkPhysicsController::castController(manifold->getBody0());
-			gkPhysicsController* colB = gkPhysicsController::castController(manifold->getBody1());
+		// pairs nobody listens to cost nothing more
+		bool wantsA = colA->_wantsContacts();
+		bool wantsB = colB->_wantsContacts();
+		if (!wantsA && !wantsB)
+			continue;
 
+		if (wantsA)
+		{
+			colA->_touchContacts(m_contactSubstep, m_contactFrame);
 			colA->_handleManifold(manifold);
+		}
+		if (wantsB)
+		{
+			colB->_touchContacts(m_contactSubstep, m_contactFrame);
 			colB->_handleManifold(manifold);
 		}
+
+
+		bool touching = colA->getObject()->getProperties().isGhost() || colB->getObject()->getProperties().isGhost();
+
+		for (int j = 0; !touching && j < manifold->getNumContacts(); ++j)
+			touching = manifold->getContactPoint(j).getDistance() < 0.f;
+
+		if (!touching)
+			continue;
+
+		// compound shapes can give one pair several manifolds
+		ContactPair pair(colA, colB);
+		if (!current.insert(pair, true))
+			continue;
+
+		gkContactEvent ev;
+		ev.a    = pair.m_a;
+		ev.b    = pair.m_b;
+		ev.type = previous.find(pair) == UT_NPOS ? gkContactEvent::CE_BEGIN : gkContactEvent::CE_PERSIST;
+		m_contactEvents.push_back(ev);
+	}
+
+
+	for (UTsize i = 0; i < previous.size(); ++i)
+	{
+		const ContactPair& pair = previous.keyAt(i);
+		if (current.find(pair) == UT_NPOS)
+		{
+			gkContactEvent ev;
+			ev.a    = pair.m_a;
+			ev.b    = pair.m_b;
+			ev.type = gkContactEvent::CE_END;
+			m_contactEvents.push_back(ev);
+		}
+	}
+
+
+	if (!m_contactEvents.empty())
+	{
+		utArrayIterator<gkDynamicsWorld::Listeners> iter(m_listeners);
+		while (iter.hasMoreElements())
+			iter.getNext()->contacts(m_contactEvents);
 	}
-	
-	// update callbacks
-	utArrayIterator<gkDynamicsWorld::Listeners> iter(m_listeners);
-	while(iter.hasMoreElements())
-		iter.getNext()->subtick(tick);
 }
 
 
@@ -495,12 +611,20 @@ gkVariable* gkDynamicsWorld::getDBVTInfo(void)
 
 
 
-void gkDynamicsWorld::handleDbvt(gkCamera* cam)
+void gkDynamicsWorld::handleDbvt(gkCamera* cam, bool objectsMoved)
 {
 	if (!m_dbvt)
 		return;
 
-	m_dbvt->mark(cam, (btDbvtBroadphase*)m_pairCache, m_objects);
+	m_dbvt->mark(cam, (btDbvtBroadphase*)m_pairCache, m_objects, objectsMoved);
+}
+
+
+
+void gkDynamicsWorld::_notifyControllerResumed(gkPhysicsController* cont)
+{
+	if (m_dbvt)
+		m_dbvt->_notifyControllerResumed(cont);
 }
 
 
@@ -519,6 +643,303 @@ void gkDynamicsWorld::exportBullet(const gkString& fileName)
 	delete serializer;
 }
 
+// Bullet keeps these protected without accessors, member pointers
+// taken through a derived class reach them on any instance.
+class gkDiscreteWorldAccess : public btDiscreteDynamicsWorld
+{
+public:
+	static btScalar& localTime(btDynamicsWorld* world)
+	{
+		return static_cast<btDiscreteDynamicsWorld*>(world)->*(&gkDiscreteWorldAccess::m_localTime);
+	}
+};
+
+class gkCharacterControllerAccess : public btKinematicCharacterController
+{
+public:
+	static btScalar& verticalVelocity(btKinematicCharacterController* cont) {return cont->*(&gkCharacterControllerAccess::m_verticalVelocity);}
+	static btScalar& verticalOffset(btKinematicCharacterController* cont)   {return cont->*(&gkCharacterControllerAccess::m_verticalOffset);}
+};
+
+
+
+void gkDynamicsWorld::saveState(gkPhysicsSnapshot& snap)
+{
+	GK_ASSERT(m_dynamicsWorld);
+
+	snap.clear();
+
+
+	UTsize i;
+	for (i = 0; i < m_objects.size(); ++i)
+	{
+		gkPhysicsController* cont = m_objects[i];
+		btCollisionObject* obj = cont->getCollisionObject();
+		if (!obj)
+			continue;
+
+		gkPhysicsSnapshot::Body& body = snap.m_bodies.expand();
+		body.m_controller                   = cont;
+		body.m_object                       = obj;
+		body.m_transform                    = obj->getWorldTransform();
+		body.m_interpolationTransform       = obj->getInterpolationWorldTransform();
+		body.m_interpolationLinearVelocity  = obj->getInterpolationLinearVelocity();
+		body.m_interpolationAngularVelocity = obj->getInterpolationAngularVelocity();
+		body.m_activationState              = obj->getActivationState();
+		body.m_deactivationTime             = obj->getDeactivationTime();
+		body.m_verticalVelocity             = 0;
+		body.m_verticalOffset               = 0;
+
+		btRigidBody* rb = btRigidBody::upcast(obj);
+		if (rb)
+		{
+			body.m_linearVelocity  = rb->getLinearVelocity();
+			body.m_angularVelocity = rb->getAngularVelocity();
+		}
+		else
+		{
+			body.m_linearVelocity.setZero();
+			body.m_angularVelocity.setZero();
+		}
+
+		gkCharacter* character = cont->getObject()->getAttachedCharacter();
+		if (character == cont && character->getCharacterController())
+		{
+			btKinematicCharacterController* kcc = character->getCharacterController();
+			body.m_verticalVelocity = gkCharacterControllerAccess::verticalVelocity(kcc);
+			body.m_verticalOffset   = gkCharacterControllerAccess::verticalOffset(kcc);
+		}
+	}
+
+
+	// contact points carry the warm starting impulses
+	m_manifoldLookup.clear(true);
+
+	int nr = m_dispatcher->getNumManifolds();
+	for (int m = 0; m < nr; ++m)
+	{
+		btPersistentManifold* manifold = m_dispatcher->getManifoldByIndexInternal(m);
+		if (manifold->getNumContacts() == 0)
+			continue;
+
+		ContactPair pair(gkPhysicsController::castController(manifold->getBody0()),
+		                 gkPhysicsController::castController(manifold->getBody1()));
+
+		int index = snap.m_manifolds.size();
+
+		gkPhysicsSnapshot::Manifold& saved = snap.m_manifolds.expand();
+		saved.m_a     = pair.m_a;
+		saved.m_b     = pair.m_b;
+		saved.m_body0 = manifold->getBody0();
+		saved.m_first = snap.m_points.size();
+		saved.m_count = manifold->getNumContacts();
+		saved.m_next  = -1;
+
+		for (int p = 0; p < saved.m_count; ++p)
+			snap.m_points.push_back(manifold->getContactPoint(p));
+
+		// chain manifolds of the same pair, the lookup holds the last one
+		int* last = m_manifoldLookup.get(pair);
+		if (last)
+		{
+			snap.m_manifolds[*last].m_next = index;
+			*last = index;
+		}
+		else
+			m_manifoldLookup.insert(pair, index);
+	}
+
+
+	nr = m_dynamicsWorld->getNumConstraints();
+	for (int c = 0; c < nr; ++c)
+	{
+		btTypedConstraint* constraint = m_dynamicsWorld->getConstraint(c);
+
+		gkPhysicsSnapshot::Constraint& saved = snap.m_constraints.expand();
+		saved.m_constraint      = constraint;
+		saved.m_appliedImpulse  = constraint->getAppliedImpulse();
+		saved.m_enabled         = constraint->isEnabled();
+	}
+
+
+	const ContactPairs& pairs = m_contactPairs[m_currentPairs];
+	for (i = 0; i < pairs.size(); ++i)
+	{
+		snap.m_contactPairs.push_back(pairs.keyAt(i).m_a);
+		snap.m_contactPairs.push_back(pairs.keyAt(i).m_b);
+	}
+
+	snap.m_localTime  = gkDiscreteWorldAccess::localTime(m_dynamicsWorld);
+	snap.m_solverSeed = static_cast<btSequentialImpulseConstraintSolver*>(m_constraintSolver)->getRandSeed();
+	if (m_parallelWorld)
+		snap.m_batchSeeds = m_parallelWorld->getBatchSeeds();
+	else
+		snap.m_batchSeeds.resize(0);
+	snap.m_valid      = true;
+}
+
+
+
+bool gkDynamicsWorld::restoreState(const gkPhysicsSnapshot& snap)
+{
+	GK_ASSERT(m_dynamicsWorld);
+
+	if (!snap.isValid())
+		return false;
+
+	// motion states interpolate with the local time
+	gkDiscreteWorldAccess::localTime(m_dynamicsWorld) = snap.m_localTime;
+	m_restoredObjects.clear(true);
+
+
+	// bodies are saved in m_objects order, walk both and only search on a mismatch
+	UTsize cursor = 0;
+	int i;
+
+	for (i = 0; i < snap.m_bodies.size(); ++i)
+	{
+		const gkPhysicsSnapshot::Body& body = snap.m_bodies[i];
+
+		while (cursor < m_objects.size() && m_objects[cursor] != body.m_controller)
+			++cursor;
+
+		if (cursor == m_objects.size())
+		{
+			cursor = m_objects.find(body.m_controller);
+			if (cursor == UT_NPOS)
+			{
+				cursor = 0;
+				continue;
+			}
+		}
+
+		gkPhysicsController* cont = body.m_controller;
+		btCollisionObject* obj = cont->getCollisionObject();
+		if (obj != body.m_object)
+			continue;
+
+		m_restoredObjects.insert(cont, 0);
+
+		obj->setWorldTransform(body.m_transform);
+		obj->setInterpolationWorldTransform(body.m_interpolationTransform);
+		obj->setInterpolationLinearVelocity(body.m_interpolationLinearVelocity);
+		obj->setInterpolationAngularVelocity(body.m_interpolationAngularVelocity);
+		obj->forceActivationState(body.m_activationState);
+		obj->setDeactivationTime(body.m_deactivationTime);
+
+		btRigidBody* rb = btRigidBody::upcast(obj);
+		if (rb)
+		{
+			rb->setLinearVelocity(body.m_linearVelocity);
+			rb->setAngularVelocity(body.m_angularVelocity);
+			rb->clearForces();
+			rb->updateInertiaTensor();
+
+			if (!rb->isStaticOrKinematicObject())
+				static_cast<btDiscreteDynamicsWorld*>(m_dynamicsWorld)->synchronizeSingleMotionState(rb);
+		}
+
+		gkCharacter* character = cont->getObject()->getAttachedCharacter();
+		if (character == cont && character->getCharacterController())
+		{
+			btKinematicCharacterController* kcc = character->getCharacterController();
+			gkCharacterControllerAccess::verticalVelocity(kcc) = body.m_verticalVelocity;
+			gkCharacterControllerAccess::verticalOffset(kcc)   = body.m_verticalOffset;
+		}
+
+		// sleeping objects are skipped by the per step aabb update
+		if (obj->getBroadphaseHandle())
+			m_dynamicsWorld->updateSingleAabb(obj);
+	}
+
+
+	// put saved points back into the manifolds of the same pairs,
+	// pairs that were apart at save time start cold
+	m_manifoldLookup.clear(true);
+	for (i = 0; i < snap.m_manifolds.size(); ++i)
+	{
+		const gkPhysicsSnapshot::Manifold& saved = snap.m_manifolds[i];
+		m_manifoldLookup.insert(ContactPair(saved.m_a, saved.m_b), i);
+	}
+
+	int nr = m_dispatcher->getNumManifolds();
+	for (int m = 0; m < nr; ++m)
+	{
+		btPersistentManifold* manifold = m_dispatcher->getManifoldByIndexInternal(m);
+
+		ContactPair pair(gkPhysicsController::castController(manifold->getBody0()),
+		                 gkPhysicsController::castController(manifold->getBody1()));
+
+		int* index = m_manifoldLookup.get(pair);
+
+		manifold->clearManifold();
+
+		if (!index || *index == -1)
+			continue;
+
+		const gkPhysicsSnapshot::Manifold& saved = snap.m_manifolds[*index];
+		*index = saved.m_next;
+
+		if (saved.m_body0 != manifold->getBody0())
+			continue;
+
+		for (int p = 0; p < saved.m_count; ++p)
+			manifold->addManifoldPoint(snap.m_points[saved.m_first + p]);
+	}
+
+
+	nr = m_dynamicsWorld->getNumConstraints();
+	int c = 0;
+	for (i = 0; i < snap.m_constraints.size(); ++i)
+	{
+		const gkPhysicsSnapshot::Constraint& saved = snap.m_constraints[i];
+
+		// same order unless constraints were added or removed since
+		if (c >= nr || m_dynamicsWorld->getConstraint(c) != saved.m_constraint)
+		{
+			for (c = 0; c < nr && m_dynamicsWorld->getConstraint(c) != saved.m_constraint; ++c) ;
+
+			if (c == nr)
+			{
+				c = 0;
+				continue;
+			}
+		}
+
+		btTypedConstraint* constraint = m_dynamicsWorld->getConstraint(c++);
+		constraint->internalSetAppliedImpulse(saved.m_appliedImpulse);
+		constraint->setEnabled(saved.m_enabled);
+	}
+
+
+	// contact events continue from the saved pairs
+	ContactPairs& pairs = m_contactPairs[m_currentPairs];
+	pairs.clear(true);
+	for (i = 0; i + 1 < snap.m_contactPairs.size(); i += 2)
+	{
+		gkPhysicsController* a = snap.m_contactPairs[i];
+		gkPhysicsController* b = snap.m_contactPairs[i + 1];
+
+		if (m_restoredObjects.find(a) != UT_NPOS && m_restoredObjects.find(b) != UT_NPOS)
+			pairs.insert(ContactPair(a, b), true);
+	}
+	m_contactEvents.clear(true);
+
+	static_cast<btSequentialImpulseConstraintSolver*>(m_constraintSolver)->setRandSeed(snap.m_solverSeed);
+	if (m_parallelWorld)
+		m_parallelWorld->setBatchSeeds(snap.m_batchSeeds);
+	return true;
+}
+
+
+
+void gkDynamicsWorld::query(gkSpatialQuery& batch)
+{
+	batch.execute(this);
+}
+
+
+
 void gkDynamicsWorld::addListener(gkDynamicsWorld::Listener *listener)
 {
 	m_listeners.push_back(listener);
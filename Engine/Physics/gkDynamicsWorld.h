@@ -32,6 +32,7 @@
 #include "gkMathUtils.h"
 #include "LinearMath/btScalar.h"
 #include "gkGhost.h"
+#include "gkPhysicsController.h"
 
 class btDynamicsWorld;
 class btCollisionConfiguration;
@@ -48,6 +49,9 @@ class btGhostPairCallback;
 class gkPhysicsDebug;
 class gkDbvt;
 class gkPhysicsConstraintProperties;
+class gkPhysicsSnapshot;
+class gkSpatialQuery;
+class gkParallelDynamicsWorld;
 
 class gkDynamicsWorld
 {
@@ -59,6 +63,9 @@ public:
 		virtual ~Listener() {}
 		virtual void presubtick(gkScalar rate) = 0;
 		virtual void subtick(gkScalar rate) = 0;
+
+		///Pairs that started, kept or stopped touching this substep, before subtick.
+		virtual void contacts(const gkContactEvent::Array& events) {}
 	};
 
 	typedef utArray<Listener*> Listeners;
@@ -68,6 +75,7 @@ protected:
 
 	gkScene*                    m_scene;
 	btDynamicsWorld*            m_dynamicsWorld;
+	gkParallelDynamicsWorld*    m_parallelWorld;  // m_dynamicsWorld when stepping on a job pool
 	btCollisionConfiguration*   m_collisionConfiguration;;
 	btBroadphaseInterface*      m_pairCache;
 	btGhostPairCallback*        m_ghostPairCallback;
@@ -79,6 +87,37 @@ protected:
 	gkDbvt*                     m_dbvt;
 	Listeners                   m_listeners;
 
+	// touching pairs of the previous and the current substep
+	class ContactPair
+	{
+	public:
+		ContactPair() : m_a(0), m_b(0) {}
+		ContactPair(gkPhysicsController* a, gkPhysicsController* b) : m_a(a < b ? a : b), m_b(a < b ? b : a) {}
+
+		UThash hash(void) const
+		{
+			UThash ha = utPointerHashKey(m_a).hash(), hb = utPointerHashKey(m_b).hash();
+			return ha ^ (hb + 0x9e3779b9 + (ha << 6) + (ha >> 2));
+		}
+
+		bool operator== (const ContactPair& o) const {return m_a == o.m_a && m_b == o.m_b;}
+		bool operator!= (const ContactPair& o) const {return !(*this == o);}
+
+		gkPhysicsController* m_a;
+		gkPhysicsController* m_b;
+	};
+
+	typedef utHashTable<ContactPair, bool> ContactPairs;
+
+	ContactPairs                m_contactPairs[2];
+	utHashTable<ContactPair, int> m_manifoldLookup;   // snapshot scratch, pair to manifold index
+	utHashTable<utPointerHashKey, int> m_restoredObjects;
+	int                         m_currentPairs;
+	gkContactEvent::Array       m_contactEvents;
+	unsigned int                m_contactSubstep, m_contactFrame;
+
+	void processContacts(void);
+
 
 	// drawing all but static wireframes
 	void localDrawObject(gkPhysicsController* phyCon);
@@ -109,6 +148,8 @@ public:
 	gkGhost* createGhost(gkGameObject* state);
 	void destroyObject(gkPhysicsController* cont);
 
+	void _notifyControllerResumed(gkPhysicsController* cont);
+
 	GK_INLINE btDynamicsWorld* getBulletWorld(void) {GK_ASSERT(m_dynamicsWorld); return m_dynamicsWorld;}
 	GK_INLINE gkScene* getScene(void)               {GK_ASSERT(m_scene); return m_scene;}
 
@@ -116,7 +157,12 @@ public:
 
 	void resetContacts();
 
-	void handleDbvt(gkCamera* cam);
+	///Contact events of the last substep.
+	const gkContactEvent::Array& getContactEvents(void) const {return m_contactEvents;}
+
+	GK_INLINE unsigned int _getContactFrame(void) const {return m_contactFrame;}
+
+	void handleDbvt(gkCamera* cam, bool objectsMoved = true);
 
 	gkPhysicsDebug* getDebug() const { return m_debug; }
 
@@ -125,6 +171,19 @@ public:
 	gkVariable* getDBVTInfo(void);
 
 	void exportBullet(const gkString& fileName);
+
+	///Copies body states, velocities, activation, contact warm starting and
+	///constraint impulses into snap. Meant for per tick rollback and replay,
+	///taken between two steps.
+	void saveState(gkPhysicsSnapshot& snap);
+
+	///Puts the world back to a saved state. Controllers destroyed since then are
+	///skipped and ones created later keep their current state. Returns false
+	///for an empty snapshot.
+	bool restoreState(const gkPhysicsSnapshot& snap);
+
+	///Runs a batch of overlap, nearest and sweep queries on the broadphase.
+	void query(gkSpatialQuery& batch);
 	
 	void addListener(Listener *listener);
 	void removeListener(Listener *listener);
@@ -105,8 +105,7 @@ void gkGhost::destroy(void)
 		if (!m_suspend)
 			dyn->removeCollisionObject(m_collisionObject);
 
-		delete m_shape;
-		m_shape = 0;
+		releaseShape();
 
 		delete m_collisionObject;
 
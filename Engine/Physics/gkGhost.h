@@ -50,6 +50,9 @@ public:
 	void create(void);
 	void destroy(void);
 	void _handleManifold(btPersistentManifold* manifold);
+
+	// ghosts always record what overlaps them
+	bool _wantsContacts(void) {return true;}
 };
 
 #endif//_gkGhost_h_
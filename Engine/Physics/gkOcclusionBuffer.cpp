@@ -0,0 +1,246 @@
+/*
+-------------------------------------------------------------------------------
+    This file is part of OgreKit.
+    http://gamekit.googlecode.com/
+
+    Copyright (c) 2006-2013 Charlie C.
+
+    Contributor(s): none yet.
+-------------------------------------------------------------------------------
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#include "gkOcclusionBuffer.h"
+#include "gkCamera.h"
+
+#include "OgreCamera.h"
+#include "OgrePlatformInformation.h"
+
+#if __OGRE_HAVE_SSE
+#include <xmmintrin.h>
+#endif
+
+
+
+gkOcclusionBuffer::gkOcclusionBuffer(int width, int height)
+	:    m_width(gkMax<int>(4, (width + 3) & ~3)),
+	     m_height(gkMax<int>(1, height)),
+	     m_depth(0),
+	     m_viewProj(gkMatrix4::IDENTITY),
+	     m_near(0.1f)
+{
+	m_depth = new float[m_width * m_height];
+}
+
+
+
+gkOcclusionBuffer::~gkOcclusionBuffer()
+{
+	delete []m_depth;
+}
+
+
+
+bool gkOcclusionBuffer::begin(gkCamera* cam)
+{
+	Ogre::Camera* ocam = cam->getCamera();
+
+	// depth is the inverse of w, only meaningful for perspective
+	if (ocam->getProjectionType() != Ogre::PT_PERSPECTIVE)
+		return false;
+
+	m_viewProj = ocam->getProjectionMatrix() * ocam->getViewMatrix();
+	m_near = ocam->getNearClipDistance();
+
+	memset(m_depth, 0, sizeof(float) * m_width * m_height);
+	return true;
+}
+
+
+
+bool gkOcclusionBuffer::project(const gkVector3& p, ScreenVertex& out)
+{
+	Ogre::Vector4 clip = m_viewProj * Ogre::Vector4(p.x, p.y, p.z, 1.f);
+
+	if (clip.w < m_near)
+		return false;
+
+	const float iw = 1.f / clip.w;
+
+	out.x  = (clip.x * iw * 0.5f + 0.5f) * m_width;
+	out.y  = (0.5f - clip.y * iw * 0.5f) * m_height;
+	out.iz = iw;
+	return true;
+}
+
+
+
+void gkOcclusionBuffer::drawTriangle(const gkVector3& pa, const gkVector3& pb, const gkVector3& pc)
+{
+	ScreenVertex a, b, c;
+	if (!project(pa, a) || !project(pb, b) || !project(pc, c))
+		return;
+
+	float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+	if (gkAbs(area) < 1e-6f)
+		return;
+
+	// both windings, occluders are drawn two sided
+	if (area < 0)
+	{
+		ScreenVertex t = b;
+		b = c;
+		c = t;
+		area = -area;
+	}
+
+	int minx = (int)gkMax<float>(0.f, floorf(gkMin(a.x, gkMin(b.x, c.x))));
+	int maxx = (int)gkMin<float>((float)m_width - 1, ceilf(gkMax(a.x, gkMax(b.x, c.x))));
+	int miny = (int)gkMax<float>(0.f, floorf(gkMin(a.y, gkMin(b.y, c.y))));
+	int maxy = (int)gkMin<float>((float)m_height - 1, ceilf(gkMax(a.y, gkMax(b.y, c.y))));
+
+	if (minx > maxx || miny > maxy)
+		return;
+
+	// four pixel steps
+	minx &= ~3;
+
+
+	// edge functions, E(x, y) = A * x + B * y + C, positive inside
+	const float A0 = b.y - c.y, B0 = c.x - b.x, C0 = b.x * c.y - b.y * c.x; // opposite a
+	const float A1 = c.y - a.y, B1 = a.x - c.x, C1 = c.x * a.y - c.y * a.x; // opposite b
+	const float A2 = a.y - b.y, B2 = b.x - a.x, C2 = a.x * b.y - a.y * b.x; // opposite c
+
+	// inverse depth is linear in screen space
+	const float ia = a.iz / area, ib = b.iz / area, ic = c.iz / area;
+	const float AZ = A0 * ia + A1 * ib + A2 * ic;
+	const float BZ = B0 * ia + B1 * ib + B2 * ic;
+	const float CZ = C0 * ia + C1 * ib + C2 * ic;
+
+
+	for (int y = miny; y <= maxy; ++y)
+	{
+		const float py = y + 0.5f;
+		const float px = minx + 0.5f;
+
+		float e0 = A0 * px + B0 * py + C0;
+		float e1 = A1 * px + B1 * py + C1;
+		float e2 = A2 * px + B2 * py + C2;
+		float z  = AZ * px + BZ * py + CZ;
+
+		float* row = m_depth + y * m_width;
+
+#if __OGRE_HAVE_SSE
+		const __m128 offs = _mm_set_ps(3.f, 2.f, 1.f, 0.f);
+		const __m128 zero = _mm_setzero_ps();
+
+		__m128 ve0 = _mm_add_ps(_mm_set1_ps(e0), _mm_mul_ps(offs, _mm_set1_ps(A0)));
+		__m128 ve1 = _mm_add_ps(_mm_set1_ps(e1), _mm_mul_ps(offs, _mm_set1_ps(A1)));
+		__m128 ve2 = _mm_add_ps(_mm_set1_ps(e2), _mm_mul_ps(offs, _mm_set1_ps(A2)));
+		__m128 vz  = _mm_add_ps(_mm_set1_ps(z),  _mm_mul_ps(offs, _mm_set1_ps(AZ)));
+
+		const __m128 s0 = _mm_set1_ps(A0 * 4.f), s1 = _mm_set1_ps(A1 * 4.f);
+		const __m128 s2 = _mm_set1_ps(A2 * 4.f), sz = _mm_set1_ps(AZ * 4.f);
+
+		for (int x = minx; x <= maxx; x += 4)
+		{
+			__m128 inside = _mm_and_ps(_mm_cmpge_ps(ve0, zero), _mm_and_ps(_mm_cmpge_ps(ve1, zero), _mm_cmpge_ps(ve2, zero)));
+
+			if (_mm_movemask_ps(inside))
+			{
+				__m128 d = _mm_loadu_ps(row + x);
+				__m128 n = _mm_max_ps(d, vz);
+				_mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, n), _mm_andnot_ps(inside, d)));
+			}
+
+			ve0 = _mm_add_ps(ve0, s0);
+			ve1 = _mm_add_ps(ve1, s1);
+			ve2 = _mm_add_ps(ve2, s2);
+			vz  = _mm_add_ps(vz, sz);
+		}
+#else
+		for (int x = minx; x <= maxx; ++x)
+		{
+			if (e0 >= 0 && e1 >= 0 && e2 >= 0 && z > row[x])
+				row[x] = z;
+
+			e0 += A0;
+			e1 += A1;
+			e2 += A2;
+			z  += AZ;
+		}
+#endif
+	}
+}
+
+
+
+bool gkOcclusionBuffer::isVisible(const gkVector3& min, const gkVector3& max)
+{
+	float sminx = GK_INFINITY, sminy = GK_INFINITY, smaxx = -GK_INFINITY, smaxy = -GK_INFINITY;
+	float nearest = 0;
+
+	for (int i = 0; i < 8; ++i)
+	{
+		gkVector3 corner((i & 1) ? max.x : min.x, (i & 2) ? max.y : min.y, (i & 4) ? max.z : min.z);
+
+		ScreenVertex v;
+		if (!project(corner, v))
+			return true;
+
+		sminx = gkMin(sminx, v.x);
+		sminy = gkMin(sminy, v.y);
+		smaxx = gkMax(smaxx, v.x);
+		smaxy = gkMax(smaxy, v.y);
+		nearest = gkMax(nearest, v.iz);
+	}
+
+	int minx = (int)gkMax<float>(0.f, floorf(sminx));
+	int maxx = (int)gkMin<float>((float)m_width - 1, ceilf(smaxx));
+	int miny = (int)gkMax<float>(0.f, floorf(sminy));
+	int maxy = (int)gkMin<float>((float)m_height - 1, ceilf(smaxy));
+
+	// off screen, left to the frustum test
+	if (minx > maxx || miny > maxy)
+		return true;
+
+	minx &= ~3;
+
+
+	for (int y = miny; y <= maxy; ++y)
+	{
+		const float* row = m_depth + y * m_width;
+
+#if __OGRE_HAVE_SSE
+		const __m128 vn = _mm_set1_ps(nearest);
+		for (int x = minx; x <= maxx; x += 4)
+		{
+			// any pixel farther than the box
+			if (_mm_movemask_ps(_mm_cmplt_ps(_mm_loadu_ps(row + x), vn)))
+				return true;
+		}
+#else
+		for (int x = minx; x <= maxx; ++x)
+		{
+			if (row[x] < nearest)
+				return true;
+		}
+#endif
+	}
+
+	return false;
+}
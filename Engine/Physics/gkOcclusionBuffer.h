@@ -0,0 +1,73 @@
+/*
+-------------------------------------------------------------------------------
+    This file is part of OgreKit.
+    http://gamekit.googlecode.com/
+
+    Copyright (c) 2006-2013 Charlie C.
+
+    Contributor(s): none yet.
+-------------------------------------------------------------------------------
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#ifndef _gkOcclusionBuffer_h_
+#define _gkOcclusionBuffer_h_
+
+#include "gkCommon.h"
+#include "gkMathUtils.h"
+
+
+///Low resolution software depth buffer for occlusion culling.
+///
+///Occluder triangles are rasterized on the CPU, four pixels at a time when Ogre
+///is built with SSE, storing the inverse view distance per pixel. Boxes are then
+///tested conservatively against it: a box is hidden only if every pixel under its
+///screen rectangle holds an occluder nearer than the nearest box corner.
+class gkOcclusionBuffer
+{
+public:
+	gkOcclusionBuffer(int width = 256, int height = 128);
+	~gkOcclusionBuffer();
+
+	///Clears the buffer for a new view, returns false if the camera cannot be used.
+	bool begin(gkCamera* cam);
+
+	///Rasterizes a world space triangle, triangles crossing the near plane are skipped.
+	void drawTriangle(const gkVector3& a, const gkVector3& b, const gkVector3& c);
+
+	///Returns false only if the world space box is fully hidden.
+	bool isVisible(const gkVector3& min, const gkVector3& max);
+
+	GK_INLINE int getWidth(void)  const {return m_width;}
+	GK_INLINE int getHeight(void) const {return m_height;}
+
+private:
+	struct ScreenVertex
+	{
+		float x, y, iz;
+	};
+
+	bool project(const gkVector3& p, ScreenVertex& out);
+
+	int         m_width, m_height;
+	float*      m_depth;
+	gkMatrix4   m_viewProj;
+	gkScalar    m_near;
+};
+
+
+#endif//_gkOcclusionBuffer_h_
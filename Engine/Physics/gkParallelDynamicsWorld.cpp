@@ -0,0 +1,663 @@
+/*
+-------------------------------------------------------------------------------
+    This file is part of OgreKit.
+    http://gamekit.googlecode.com/
+
+    Copyright (c) 2006-2013 Charlie C.
+
+    Contributor(s): none yet.
+-------------------------------------------------------------------------------
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#include "gkParallelDynamicsWorld.h"
+#include "gkJobPool.h"
+#include "gkMathUtils.h"
+
+#include "BulletCollision/CollisionDispatch/btCollisionObjectWrapper.h"
+#include "BulletCollision/CollisionDispatch/btConvexConvexAlgorithm.h"
+#include "BulletCollision/CollisionDispatch/btSimulationIslandManager.h"
+#include "BulletCollision/NarrowPhaseCollision/btVoronoiSimplexSolver.h"
+
+
+// below this the jobs cost more than they save
+#define GK_PARALLEL_MIN_PAIRS   64
+#define GK_PARALLEL_MIN_BODIES  64
+// islands smaller than this are solved together
+#define GK_SOLVER_BATCH_BODIES  32
+
+
+
+// btConvexConvexAlgorithm with its own simplex solver, the configuration one is shared by all pairs
+class gkConvexConvexAlgorithm : public btConvexConvexAlgorithm
+{
+public:
+	gkConvexConvexAlgorithm(btPersistentManifold* mf, const btCollisionAlgorithmConstructionInfo& ci,
+	                        const btCollisionObjectWrapper* body0Wrap, const btCollisionObjectWrapper* body1Wrap,
+	                        btConvexPenetrationDepthSolver* pdSolver, int numPerturbationIterations, int minimumPointsPerturbationThreshold)
+		:    btConvexConvexAlgorithm(mf, ci, body0Wrap, body1Wrap, &m_simplex, pdSolver, numPerturbationIterations, minimumPointsPerturbationThreshold)
+	{
+	}
+
+private:
+	btVoronoiSimplexSolver m_simplex;
+};
+
+
+
+class gkConvexConvexCreateFunc : public btConvexConvexAlgorithm::CreateFunc
+{
+public:
+	gkConvexConvexCreateFunc(const btConvexConvexAlgorithm::CreateFunc& base)
+		:    btConvexConvexAlgorithm::CreateFunc(base.m_simplexSolver, base.m_pdSolver)
+	{
+		m_numPerturbationIterations = base.m_numPerturbationIterations;
+		m_minimumPointsPerturbationThreshold = base.m_minimumPointsPerturbationThreshold;
+		m_swapped = base.m_swapped;
+	}
+
+	virtual btCollisionAlgorithm* CreateCollisionAlgorithm(btCollisionAlgorithmConstructionInfo& ci,
+	        const btCollisionObjectWrapper* body0Wrap, const btCollisionObjectWrapper* body1Wrap)
+	{
+		// larger than the pool elements, freeCollisionAlgorithm hands it back to btAlignedFree
+		void* mem = btAlignedAlloc(sizeof(gkConvexConvexAlgorithm), 16);
+		return new(mem) gkConvexConvexAlgorithm(ci.m_manifold, ci, body0Wrap, body1Wrap, m_pdSolver,
+		                                        m_numPerturbationIterations, m_minimumPointsPerturbationThreshold);
+	}
+};
+
+
+
+class gkNarrowphaseJob : public gkJobPool::Job
+{
+public:
+	gkNarrowphaseJob(btBroadphasePair* pairs, btCollisionDispatcher* dispatcher, const btDispatcherInfo& info)
+		:    m_pairs(pairs), m_dispatcher(dispatcher), m_info(info), m_callback(dispatcher->getNearCallback())
+	{
+	}
+
+	void run(int begin, int end)
+	{
+		for (int i = begin; i < end; ++i)
+			m_callback(m_pairs[i], *m_dispatcher, m_info);
+	}
+
+private:
+	btBroadphasePair*       m_pairs;
+	btCollisionDispatcher*  m_dispatcher;
+	const btDispatcherInfo& m_info;
+	btNearCallback          m_callback;
+};
+
+
+
+gkParallelCollisionDispatcher::gkParallelCollisionDispatcher(btCollisionConfiguration* config, gkJobPool* pool)
+	:    btCollisionDispatcher(config),
+	     m_pool(pool),
+	     m_parallel(false)
+{
+	GK_ASSERT(m_pool);
+
+	btConvexConvexAlgorithm::CreateFunc* shared = 0;
+	btCollisionAlgorithmCreateFunc* own = 0;
+
+	for (int i = 0; i < MAX_BROADPHASE_COLLISION_TYPES; i++)
+	{
+		for (int j = 0; j < MAX_BROADPHASE_COLLISION_TYPES; j++)
+		{
+			btConvexConvexAlgorithm::CreateFunc* func = dynamic_cast<btConvexConvexAlgorithm::CreateFunc*>(config->getCollisionAlgorithmCreateFunc(i, j));
+			if (!func)
+				continue;
+
+			if (func != shared)
+			{
+				shared = func;
+				own = new gkConvexConvexCreateFunc(*func);
+				m_createFuncs.push_back(own);
+			}
+			registerCollisionCreateFunc(i, j, own);
+		}
+	}
+}
+
+
+
+gkParallelCollisionDispatcher::~gkParallelCollisionDispatcher()
+{
+	for (UTsize i = 0; i < m_createFuncs.size(); ++i)
+		delete m_createFuncs[i];
+}
+
+
+
+void gkParallelCollisionDispatcher::dispatchAllCollisionPairs(btOverlappingPairCache* pairCache, const btDispatcherInfo& info, btDispatcher* dispatcher)
+{
+	int numPairs = pairCache->getNumOverlappingPairs();
+
+	if (m_pool->getConcurrency() < 2 || numPairs < GK_PARALLEL_MIN_PAIRS)
+	{
+		btCollisionDispatcher::dispatchAllCollisionPairs(pairCache, info, dispatcher);
+		return;
+	}
+
+	btBroadphasePair* pairs = pairCache->getOverlappingPairArrayPtr();
+
+	// new algorithms come from the shared pools, create them here
+	for (int i = 0; i < numPairs; ++i)
+	{
+		btBroadphasePair& pair = pairs[i];
+		if (pair.m_algorithm)
+			continue;
+
+		btCollisionObject* colObj0 = (btCollisionObject*)pair.m_pProxy0->m_clientObject;
+		btCollisionObject* colObj1 = (btCollisionObject*)pair.m_pProxy1->m_clientObject;
+
+		if (!needsCollision(colObj0, colObj1))
+			continue;
+
+		btCollisionObjectWrapper obj0Wrap(0, colObj0->getCollisionShape(), colObj0, colObj0->getWorldTransform(), -1, -1);
+		btCollisionObjectWrapper obj1Wrap(0, colObj1->getCollisionShape(), colObj1, colObj1->getWorldTransform(), -1, -1);
+		pair.m_algorithm = btCollisionDispatcher::findAlgorithm(&obj0Wrap, &obj1Wrap);
+	}
+
+
+	gkNarrowphaseJob job(pairs, this, info);
+
+	m_parallel = true;
+	m_pool->parallelFor(numPairs, gkMax(16, numPairs / (m_pool->getConcurrency() * 8)), &job);
+	m_parallel = false;
+}
+
+
+
+btPersistentManifold* gkParallelCollisionDispatcher::getNewManifold(const btCollisionObject* b0, const btCollisionObject* b1)
+{
+	if (!m_parallel)
+		return btCollisionDispatcher::getNewManifold(b0, b1);
+
+	gkCriticalSection::Lock lock(m_cs);
+	return btCollisionDispatcher::getNewManifold(b0, b1);
+}
+
+
+
+void gkParallelCollisionDispatcher::releaseManifold(btPersistentManifold* manifold)
+{
+	if (!m_parallel)
+	{
+		btCollisionDispatcher::releaseManifold(manifold);
+		return;
+	}
+
+	gkCriticalSection::Lock lock(m_cs);
+	btCollisionDispatcher::releaseManifold(manifold);
+}
+
+
+
+btCollisionAlgorithm* gkParallelCollisionDispatcher::findAlgorithm(const btCollisionObjectWrapper* body0Wrap, const btCollisionObjectWrapper* body1Wrap, btPersistentManifold* sharedManifold)
+{
+	if (!m_parallel)
+		return btCollisionDispatcher::findAlgorithm(body0Wrap, body1Wrap, sharedManifold);
+
+	gkCriticalSection::Lock lock(m_cs);
+	return btCollisionDispatcher::findAlgorithm(body0Wrap, body1Wrap, sharedManifold);
+}
+
+
+
+void* gkParallelCollisionDispatcher::allocateCollisionAlgorithm(int size)
+{
+	if (!m_parallel)
+		return btCollisionDispatcher::allocateCollisionAlgorithm(size);
+
+	gkCriticalSection::Lock lock(m_cs);
+	return btCollisionDispatcher::allocateCollisionAlgorithm(size);
+}
+
+
+
+void gkParallelCollisionDispatcher::freeCollisionAlgorithm(void* ptr)
+{
+	if (!m_parallel)
+	{
+		btCollisionDispatcher::freeCollisionAlgorithm(ptr);
+		return;
+	}
+
+	gkCriticalSection::Lock lock(m_cs);
+	btCollisionDispatcher::freeCollisionAlgorithm(ptr);
+}
+
+
+
+class gkParallelDynamicsWorld::IslandCollector : public btSimulationIslandManager::IslandCallback
+{
+public:
+	IslandCollector(gkParallelDynamicsWorld* world) : m_world(world) {}
+
+	void processIsland(btCollisionObject** bodies, int numBodies, btPersistentManifold** manifolds, int numManifolds, int islandId)
+	{
+		// the body array is reused for the next island, manifolds stay until the next build
+		Island island;
+		island.m_firstBody      = m_world->m_islandBodies.size();
+		island.m_numBodies      = numBodies;
+		island.m_manifolds      = manifolds;
+		island.m_numManifolds   = numManifolds;
+		island.m_root           = (int)m_world->m_islands.size();
+
+		for (int i = 0; i < numBodies; ++i)
+			m_world->m_islandBodies.push_back(bodies[i]);
+
+		m_world->m_islandIndex.insert(islandId, island.m_root);
+		m_world->m_islands.push_back(island);
+	}
+
+private:
+	gkParallelDynamicsWorld* m_world;
+};
+
+
+
+class gkSolveBatchJob : public gkJobPool::Job
+{
+public:
+	typedef gkParallelDynamicsWorld::Batch Batch;
+
+	gkSolveBatchJob(gkParallelDynamicsWorld* world, Batch** batches, unsigned long* seeds, const btContactSolverInfo& info)
+		:    m_world(world), m_batches(batches), m_seeds(seeds), m_info(info)
+	{
+	}
+
+	void run(int begin, int end)
+	{
+		btSequentialImpulseConstraintSolver* solver = m_world->_acquireSolver();
+
+		for (int i = begin; i < end; ++i)
+		{
+			Batch* batch = m_batches[i];
+
+			// no debug drawing off the main thread
+			solver->setRandSeed(m_seeds[i]);
+			solver->solveGroup(&batch->m_bodies[0], batch->m_bodies.size(),
+			                   batch->m_manifolds.size() ? &batch->m_manifolds[0] : 0, batch->m_manifolds.size(),
+			                   batch->m_constraints.size() ? &batch->m_constraints[0] : 0, batch->m_constraints.size(),
+			                   m_info, 0, m_world->getDispatcher());
+			m_seeds[i] = solver->getRandSeed();
+		}
+
+		m_world->_releaseSolver(solver);
+	}
+
+private:
+	gkParallelDynamicsWorld*    m_world;
+	Batch**                     m_batches;
+	unsigned long*              m_seeds;
+	const btContactSolverInfo&  m_info;
+};
+
+
+
+class gkPredictMotionJob : public gkJobPool::Job
+{
+public:
+	gkPredictMotionJob(btRigidBody** bodies, btScalar timeStep) : m_bodies(bodies), m_timeStep(timeStep) {}
+
+	void run(int begin, int end)
+	{
+		for (int i = begin; i < end; ++i)
+		{
+			btRigidBody* body = m_bodies[i];
+			if (!body->isStaticOrKinematicObject())
+			{
+				body->applyDamping(m_timeStep);
+				body->predictIntegratedTransform(m_timeStep, body->getInterpolationWorldTransform());
+			}
+		}
+	}
+
+private:
+	btRigidBody**   m_bodies;
+	btScalar        m_timeStep;
+};
+
+
+
+class gkIntegrateJob : public gkJobPool::Job
+{
+public:
+	gkIntegrateJob(btRigidBody** bodies, btScalar timeStep) : m_bodies(bodies), m_timeStep(timeStep) {}
+
+	void run(int begin, int end)
+	{
+		btTransform predictedTrans;
+		for (int i = begin; i < end; ++i)
+		{
+			btRigidBody* body = m_bodies[i];
+			body->setHitFraction(1.f);
+
+			if (body->isActive() && !body->isStaticOrKinematicObject())
+			{
+				body->predictIntegratedTransform(m_timeStep, predictedTrans);
+				body->proceedToTransform(predictedTrans);
+			}
+		}
+	}
+
+private:
+	btRigidBody**   m_bodies;
+	btScalar        m_timeStep;
+};
+
+
+
+static int gkGetConstraintIslandId(btTypedConstraint* constraint)
+{
+	const btCollisionObject& rcolObj0 = constraint->getRigidBodyA();
+	const btCollisionObject& rcolObj1 = constraint->getRigidBodyB();
+	return rcolObj0.getIslandTag() >= 0 ? rcolObj0.getIslandTag() : rcolObj1.getIslandTag();
+}
+
+
+
+gkParallelDynamicsWorld::gkParallelDynamicsWorld(btDispatcher* dispatcher, btBroadphaseInterface* pairCache, btConstraintSolver* constraintSolver,
+        btCollisionConfiguration* collisionConfiguration, gkJobPool* pool)
+	:    btDiscreteDynamicsWorld(dispatcher, pairCache, constraintSolver, collisionConfiguration),
+	     m_pool(pool),
+	     m_usedBatches(0)
+{
+	GK_ASSERT(m_pool);
+
+	for (int i = 0; i < m_pool->getConcurrency(); ++i)
+	{
+		btSequentialImpulseConstraintSolver* solver = new btSequentialImpulseConstraintSolver();
+		m_solvers.push_back(solver);
+		m_freeSolvers.push_back(solver);
+	}
+}
+
+
+
+gkParallelDynamicsWorld::~gkParallelDynamicsWorld()
+{
+	UTsize i;
+	for (i = 0; i < m_solvers.size(); ++i)
+		delete m_solvers[i];
+
+	for (i = 0; i < m_batches.size(); ++i)
+		delete m_batches[i];
+}
+
+
+
+btSequentialImpulseConstraintSolver* gkParallelDynamicsWorld::_acquireSolver(void)
+{
+	gkCriticalSection::Lock lock(m_solverCs);
+
+	if (m_freeSolvers.empty())
+	{
+		btSequentialImpulseConstraintSolver* solver = new btSequentialImpulseConstraintSolver();
+		m_solvers.push_back(solver);
+		return solver;
+	}
+
+	btSequentialImpulseConstraintSolver* solver = m_freeSolvers.back();
+	m_freeSolvers.pop_back();
+	return solver;
+}
+
+
+
+void gkParallelDynamicsWorld::_releaseSolver(btSequentialImpulseConstraintSolver* solver)
+{
+	gkCriticalSection::Lock lock(m_solverCs);
+	m_freeSolvers.push_back(solver);
+}
+
+
+
+int gkParallelDynamicsWorld::findRoot(int island)
+{
+	while (m_islands[island].m_root != island)
+	{
+		Island& is = m_islands[island];
+		is.m_root = m_islands[is.m_root].m_root;
+		island = is.m_root;
+	}
+	return island;
+}
+
+
+
+gkParallelDynamicsWorld::Batch* gkParallelDynamicsWorld::newBatch(void)
+{
+	if (m_usedBatches == m_batches.size())
+		m_batches.push_back(new Batch());
+
+	Batch* batch = m_batches[m_usedBatches++];
+	batch->m_bodies.resize(0);
+	batch->m_manifolds.resize(0);
+	batch->m_constraints.resize(0);
+	return batch;
+}
+
+
+
+void gkParallelDynamicsWorld::solveConstraints(btContactSolverInfo& solverInfo)
+{
+	if (m_pool->getConcurrency() < 2 || !m_islandManager->getSplitIslands())
+	{
+		btDiscreteDynamicsWorld::solveConstraints(solverInfo);
+		return;
+	}
+
+
+	m_islands.clear(true);
+	m_islandBodies.resize(0);
+	m_islandIndex.clear(true);
+
+	IslandCollector collector(this);
+	m_islandManager->buildAndProcessIslands(getCollisionWorld()->getDispatcher(), getCollisionWorld(), &collector);
+
+	if (m_islands.empty())
+		return;
+
+
+	// kinematic bodies belong to no island, but the solver writes to them
+	utHashTable<utPointerHashKey, int> kinematics;
+
+	UTsize i;
+	int j;
+	for (i = 0; i < m_islands.size(); ++i)
+	{
+		const Island& island = m_islands[i];
+		for (j = 0; j < island.m_numManifolds; ++j)
+		{
+			const btCollisionObject* objs[2] = {island.m_manifolds[j]->getBody0(), island.m_manifolds[j]->getBody1()};
+
+			for (int k = 0; k < 2; ++k)
+			{
+				if (!objs[k]->isKinematicObject())
+					continue;
+
+				UTsize pos = kinematics.find((void*)objs[k]);
+				if (pos == UT_NPOS)
+					kinematics.insert((void*)objs[k], (int)i);
+				else
+					m_islands[findRoot((int)i)].m_root = findRoot(kinematics.at(pos));
+			}
+		}
+	}
+
+	for (j = 0; j < m_constraints.size(); ++j)
+	{
+		btTypedConstraint* constraint = m_constraints[j];
+		if (!constraint->isEnabled())
+			continue;
+
+		UTsize pos = m_islandIndex.find(gkGetConstraintIslandId(constraint));
+		if (pos == UT_NPOS)
+			continue;
+
+		int island = m_islandIndex.at(pos);
+		const btCollisionObject* objs[2] = {&constraint->getRigidBodyA(), &constraint->getRigidBodyB()};
+
+		for (int k = 0; k < 2; ++k)
+		{
+			if (!objs[k]->isKinematicObject())
+				continue;
+
+			UTsize kpos = kinematics.find((void*)objs[k]);
+			if (kpos == UT_NPOS)
+				kinematics.insert((void*)objs[k], island);
+			else
+				m_islands[findRoot(island)].m_root = findRoot(kinematics.at(kpos));
+		}
+	}
+
+
+	// one batch per large group, small ones share
+	utArray<int> rootBodies, rootBatch;
+	rootBodies.resize(m_islands.size(), 0);
+	rootBatch.resize(m_islands.size(), -1);
+
+	for (i = 0; i < m_islands.size(); ++i)
+		rootBodies[findRoot((int)i)] += m_islands[i].m_numBodies;
+
+	m_usedBatches = 0;
+	int smallBatch = -1, smallBodies = 0;
+
+	for (i = 0; i < m_islands.size(); ++i)
+	{
+		int root = findRoot((int)i);
+		if (rootBatch[root] >= 0)
+			continue;
+
+		if (rootBodies[root] >= GK_SOLVER_BATCH_BODIES)
+		{
+			newBatch();
+			rootBatch[root] = (int)m_usedBatches - 1;
+		}
+		else
+		{
+			if (smallBatch < 0 || smallBodies >= GK_SOLVER_BATCH_BODIES)
+			{
+				newBatch();
+				smallBatch = (int)m_usedBatches - 1;
+				smallBodies = 0;
+			}
+
+			rootBatch[root] = smallBatch;
+			smallBodies += rootBodies[root];
+		}
+	}
+
+	for (i = 0; i < m_islands.size(); ++i)
+	{
+		const Island& island = m_islands[i];
+		Batch* batch = m_batches[rootBatch[findRoot((int)i)]];
+
+		for (j = 0; j < island.m_numBodies; ++j)
+			batch->m_bodies.push_back(m_islandBodies[island.m_firstBody + j]);
+		for (j = 0; j < island.m_numManifolds; ++j)
+			batch->m_manifolds.push_back(island.m_manifolds[j]);
+	}
+
+	for (j = 0; j < m_constraints.size(); ++j)
+	{
+		btTypedConstraint* constraint = m_constraints[j];
+		if (!constraint->isEnabled())
+			continue;
+
+		UTsize pos = m_islandIndex.find(gkGetConstraintIslandId(constraint));
+		if (pos != UT_NPOS)
+			m_batches[rootBatch[findRoot(m_islandIndex.at(pos))]]->m_constraints.push_back(constraint);
+	}
+
+
+	// largest first, ragdolls and piles should not be picked up last
+	for (i = 1; i < m_usedBatches; ++i)
+	{
+		Batch* batch = m_batches[i];
+		int weight = batch->m_bodies.size() + batch->m_manifolds.size() + batch->m_constraints.size();
+
+		UTsize k = i;
+		while (k > 0)
+		{
+			Batch* prev = m_batches[k - 1];
+			if (prev->m_bodies.size() + prev->m_manifolds.size() + prev->m_constraints.size() >= weight)
+				break;
+
+			m_batches[k] = prev;
+			--k;
+		}
+		m_batches[k] = batch;
+	}
+
+
+	// new slots start like a fresh solver
+	while (m_batchSeeds.size() < (int)m_usedBatches)
+		m_batchSeeds.push_back(0);
+
+	gkSolveBatchJob job(this, m_batches.ptr(), &m_batchSeeds[0], solverInfo);
+	m_pool->parallelFor((int)m_usedBatches, 1, &job);
+}
+
+
+
+void gkParallelDynamicsWorld::predictUnconstraintMotion(btScalar timeStep)
+{
+	int count = m_nonStaticRigidBodies.size();
+
+	if (m_pool->getConcurrency() < 2 || count < GK_PARALLEL_MIN_BODIES)
+	{
+		btDiscreteDynamicsWorld::predictUnconstraintMotion(timeStep);
+		return;
+	}
+
+	gkPredictMotionJob job(&m_nonStaticRigidBodies[0], timeStep);
+	m_pool->parallelFor(count, gkMax(16, count / (m_pool->getConcurrency() * 4)), &job);
+}
+
+
+
+void gkParallelDynamicsWorld::integrateTransforms(btScalar timeStep)
+{
+	int count = m_nonStaticRigidBodies.size();
+
+	if (m_pool->getConcurrency() < 2 || count < GK_PARALLEL_MIN_BODIES)
+	{
+		btDiscreteDynamicsWorld::integrateTransforms(timeStep);
+		return;
+	}
+
+	// continuous collision sweeps against the world, keep those serial
+	if (getDispatchInfo().m_useContinuous)
+	{
+		for (int i = 0; i < count; ++i)
+		{
+			if (m_nonStaticRigidBodies[i]->getCcdSquareMotionThreshold() != btScalar(0.))
+			{
+				btDiscreteDynamicsWorld::integrateTransforms(timeStep);
+				return;
+			}
+		}
+	}
+
+	gkIntegrateJob job(&m_nonStaticRigidBodies[0], timeStep);
+	m_pool->parallelFor(count, gkMax(16, count / (m_pool->getConcurrency() * 4)), &job);
+}
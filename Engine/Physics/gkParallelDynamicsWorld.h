@@ -0,0 +1,137 @@
+/*
+-------------------------------------------------------------------------------
+    This file is part of OgreKit.
+    http://gamekit.googlecode.com/
+
+    Copyright (c) 2006-2013 Charlie C.
+
+    Contributor(s): none yet.
+-------------------------------------------------------------------------------
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#ifndef _gkParallelDynamicsWorld_h_
+#define _gkParallelDynamicsWorld_h_
+
+#include "btBulletDynamicsCommon.h"
+#include "gkCommon.h"
+#include "gkCriticalSection.h"
+
+class gkJobPool;
+class btSequentialImpulseConstraintSolver;
+
+
+///Collision dispatcher running the narrowphase of the overlapping pairs on a gkJobPool.
+///
+///Algorithms are created up front on the calling thread; anything the algorithms
+///allocate lazily goes through the locked overrides below. Convex pairs get their
+///own simplex solver instead of the one shared by the collision configuration.
+class gkParallelCollisionDispatcher : public btCollisionDispatcher
+{
+public:
+	gkParallelCollisionDispatcher(btCollisionConfiguration* config, gkJobPool* pool);
+	virtual ~gkParallelCollisionDispatcher();
+
+	virtual void dispatchAllCollisionPairs(btOverlappingPairCache* pairCache, const btDispatcherInfo& info, btDispatcher* dispatcher);
+
+	virtual btPersistentManifold* getNewManifold(const btCollisionObject* b0, const btCollisionObject* b1);
+	virtual void releaseManifold(btPersistentManifold* manifold);
+
+	virtual btCollisionAlgorithm* findAlgorithm(const btCollisionObjectWrapper* body0Wrap, const btCollisionObjectWrapper* body1Wrap, btPersistentManifold* sharedManifold = 0);
+	virtual void* allocateCollisionAlgorithm(int size);
+	virtual void freeCollisionAlgorithm(void* ptr);
+
+private:
+	typedef utArray<btCollisionAlgorithmCreateFunc*> CreateFuncs;
+
+	gkJobPool*          m_pool;
+	gkCriticalSection   m_cs;
+	bool                m_parallel;
+	CreateFuncs         m_createFuncs;
+};
+
+
+
+///Discrete dynamics world stepping independent simulation islands in parallel.
+///
+///Islands sharing a kinematic body are solved together, small islands are batched,
+///and each batch runs its own sequential impulse solver. Velocity prediction and
+///transform integration are split over the bodies unless continuous collision
+///detection needs the serial sweep.
+class gkParallelDynamicsWorld : public btDiscreteDynamicsWorld
+{
+public:
+	gkParallelDynamicsWorld(btDispatcher* dispatcher, btBroadphaseInterface* pairCache, btConstraintSolver* constraintSolver,
+	                        btCollisionConfiguration* collisionConfiguration, gkJobPool* pool);
+	virtual ~gkParallelDynamicsWorld();
+
+	struct Batch
+	{
+		btAlignedObjectArray<btCollisionObject*>    m_bodies;
+		btAlignedObjectArray<btPersistentManifold*> m_manifolds;
+		btAlignedObjectArray<btTypedConstraint*>    m_constraints;
+	};
+
+	typedef btAlignedObjectArray<unsigned long> Seeds;
+
+	btSequentialImpulseConstraintSolver* _acquireSolver(void);
+	void _releaseSolver(btSequentialImpulseConstraintSolver* solver);
+
+	///Solver seeds by batch, largest batch first. Pooled solvers are picked up in any
+	///order, so each batch is solved from its own seed instead of the solver's.
+	GK_INLINE const Seeds& getBatchSeeds(void) const {return m_batchSeeds;}
+	GK_INLINE void setBatchSeeds(const Seeds& seeds) {m_batchSeeds = seeds;}
+
+protected:
+	virtual void solveConstraints(btContactSolverInfo& solverInfo);
+	virtual void predictUnconstraintMotion(btScalar timeStep);
+	virtual void integrateTransforms(btScalar timeStep);
+
+private:
+	struct Island
+	{
+		int                     m_firstBody, m_numBodies;
+		btPersistentManifold**  m_manifolds;
+		int                     m_numManifolds;
+		int                     m_root;
+	};
+
+	class IslandCollector;
+	friend class IslandCollector;
+
+	typedef utArray<Island>                                 Islands;
+	typedef utArray<Batch*>                                 Batches;
+	typedef utArray<btSequentialImpulseConstraintSolver*>   Solvers;
+
+	int findRoot(int island);
+	Batch* newBatch(void);
+
+	gkJobPool*                                  m_pool;
+	Islands                                     m_islands;
+	btAlignedObjectArray<btCollisionObject*>    m_islandBodies;
+	utHashTable<utIntHashKey, int>              m_islandIndex;
+
+	Batches                                     m_batches;
+	UTsize                                      m_usedBatches;
+	Seeds                                       m_batchSeeds;
+
+	gkCriticalSection                           m_solverCs;
+	Solvers                                     m_solvers, m_freeSolvers;
+};
+
+
+#endif//_gkParallelDynamicsWorld_h_
@@ -30,9 +30,12 @@
 #include "gkEntity.h"
 #include "gkMesh.h"
 #include "gkCharacter.h"
+#include "gkCollisionCache.h"
+#include "gkEngine.h"
 
 #include "OgreSceneNode.h"
 #include "OgreMovableObject.h"
+#include "OgreInstancedEntity.h"
 
 #include "btBulletDynamicsCommon.h"
 #include "BulletCollision/CollisionDispatch/btGhostObject.h"
@@ -45,6 +48,9 @@ gkPhysicsController::gkPhysicsController(gkGameObject* object, gkDynamicsWorld*
 	     m_object(object),
 	     m_collisionObject(0),
 	     m_shape(0),
+	     m_sharedShape(false),
+	     m_contactSubstep(0),
+	     m_contactFrame(0),
 	     m_suspend(false),
 	     m_dbvtMark(true)
 {
@@ -56,39 +62,31 @@ gkPhysicsController::gkPhysicsController(gkGameObject* object, gkDynamicsWorld*
 
 gkPhysicsController::~gkPhysicsController()
 {
-	if (m_shape)
-	{
-		destroyShape(m_shape);
-		m_shape = 0;
-	}
+	releaseShape();
 }
 
 void gkPhysicsController::destroyShape(btCollisionShape* shape)
 {
-	if (!shape) return;
+	gkCollisionCache::destroyShape(shape);
+}
 
-	if (shape->isCompound())
-	{
-		btCompoundShape* compShape = static_cast<btCompoundShape*>(shape);
-		int i;
-		for (i = 0; i < compShape->getNumChildShapes(); i++)
-		{
-			btCollisionShape* childShape = compShape->getChildShape(i);
-			if (childShape->isCompound())
-				destroyShape(childShape);
-			else
-				delete childShape;
-		}
-	}
+void gkPhysicsController::releaseShape(void)
+{
+	if (!m_shape)
+		return;
+
+	if (!m_sharedShape || !gkEngine::getSingleton().getCollisionCache()->releaseShape(m_shape))
+		destroyShape(m_shape);
 
-	delete shape;
+	m_shape = 0;
+	m_sharedShape = false;
 }
 
 void gkPhysicsController::setShape(btCollisionShape* shape)
 {
 	if (m_collisionObject)
 	{
-		destroyShape(m_shape);
+		releaseShape();
 
 		m_shape = shape;
 		m_collisionObject->setCollisionShape(m_shape);
@@ -109,14 +107,24 @@ gkPhysicsProperties& gkPhysicsController::getProperties(void)
 }
 
 
+void gkPhysicsController::syncContacts(void)
+{
+	if (m_contactFrame != m_owner->_getContactFrame() && !m_localContacts.empty())
+		m_localContacts.clear(true);
+}
+
+
+
 gkContactInfo::Array& gkPhysicsController::getContacts(void)
 {
+	syncContacts();
 	return m_localContacts;
 }
 
 
 gkContactInfo::Iterator gkPhysicsController::getContactIterator(void)
 {
+	syncContacts();
 	return gkContactInfo::Iterator(m_localContacts);
 }
 
@@ -124,6 +132,8 @@ gkContactInfo::Iterator gkPhysicsController::getContactIterator(void)
 
 bool gkPhysicsController::collidesWith(gkGameObject* ob, gkContactInfo* cpy)
 {
+	syncContacts();
+
 	if (!m_localContacts.empty())
 	{
 		UTsize i, s;
@@ -152,6 +162,8 @@ bool gkPhysicsController::collidesWith(gkGameObject* ob, gkContactInfo* cpy)
 
 bool gkPhysicsController::collidesWith(const gkString& name, gkContactInfo* cpy, bool emptyFilter)
 {
+	syncContacts();
+
 
 	if (!m_localContacts.empty())
 	{
@@ -198,6 +210,7 @@ bool gkPhysicsController::sensorCollides(const gkString& prop, const gkString& m
 	if (onlyActor && !m_object->getProperties().isActor())
 		return false;
 
+	syncContacts();
 
 	if (!m_localContacts.empty())
 	{
@@ -325,7 +338,16 @@ bool gkPhysicsController::_markDbvt(bool v)
 			if (mov)
 			{
 				result = mov->isVisible() != m_dbvtMark;
-				mov->setVisible(m_dbvtMark);
+
+				// hardware instances have one movable per sub mesh
+				gkEntityInstancer::InstancedEntities& insts = m_object->getEntity()->getInstancedEntities();
+				if (insts.empty())
+					mov->setVisible(m_dbvtMark);
+				else
+				{
+					for (UTsize i = 0; i < insts.size(); ++i)
+						insts[i]->setVisible(m_dbvtMark);
+				}
 			}
 		}
 	}
@@ -518,6 +540,9 @@ void gkPhysicsController::suspend(bool v)
 			}
 			else
 				dyn->addCollisionObject(m_collisionObject);
+
+			// culling skips suspended controllers, their visibility is stale
+			m_owner->_notifyControllerResumed(this);
 		}
 	}
 }
@@ -572,26 +597,54 @@ gkBoundingBox gkPhysicsController::getAabb(void) const
 	return gkBoundingBox();
 }
 
-void gkPhysicsController::createShape(void)
-{
-	GK_ASSERT(!m_shape && m_object);
-
-	m_shape = _createShape();
-}
-
-btCollisionShape* gkPhysicsController::_createShape(void)
+gkMesh* gkPhysicsController::getShapeSource(gkVector3& size)
 {
 	gkMesh* me = 0;
 	gkEntity* ent = m_object->getEntity();
 	if (ent != 0)
 		me = ent->getEntityProperties().m_mesh;
 
-	gkVector3 size(1.f, 1.f, 1.f);
+	size = gkVector3(1.f, 1.f, 1.f);
 	if (me != 0)
 		size = me->getBoundingBox().getHalfSize();
 	else
 		size *= m_props.m_radius;
 
+	return me;
+}
+
+void gkPhysicsController::createShape(void)
+{
+	GK_ASSERT(!m_shape && m_object);
+
+	// compound parents get their children added per object
+	if (m_props.isCompound())
+	{
+		m_shape = _createShape();
+		return;
+	}
+
+	gkVector3 size;
+	gkMesh* me = getShapeSource(size);
+
+	gkCollisionCache* cache = gkEngine::getSingleton().getCollisionCache();
+	gkCollisionCache::ShapeKey key(m_props.isMeshShape() ? me : 0, m_props.m_shape, size, m_object->getScale(), m_props.m_margin);
+
+	m_shape = cache->acquireShape(key);
+	if (!m_shape)
+	{
+		m_shape = _createShape();
+		if (m_shape)
+			cache->addShape(key, m_shape);
+	}
+	m_sharedShape = m_shape != 0;
+}
+
+btCollisionShape* gkPhysicsController::_createShape(void)
+{
+	gkVector3 size;
+	gkMesh* me = getShapeSource(size);
+
 	btCollisionShape* shape = 0;	
 
 	switch (m_props.m_shape)
@@ -629,9 +682,24 @@ btCollisionShape* gkPhysicsController::_createShape(void)
 						break;
 					}					
 					case SH_BVH_MESH:
-						shape = new btBvhTriangleMeshShape(triMesh, true);
+					{
+						// one unscaled tree per mesh, cooked to disk with gkUserDefs::collisionCachePath,
+						// other scalings wrap it instead of building another
+						btBvhTriangleMeshShape* bvhShape = gkEngine::getSingleton().getCollisionCache()->createBvhShape(triMesh, btVector3(1.f, 1.f, 1.f));
+						if (!bvhShape)
+							bvhShape = new btBvhTriangleMeshShape(triMesh, true);
+
+						const gkVector3& scale = m_object->getScale();
+						if (scale.positionEquals(gkVector3::UNIT_SCALE))
+							shape = bvhShape;
+						else
+						{
+							bvhShape->setMargin(m_props.m_margin);
+							shape = new btScaledBvhTriangleMeshShape(bvhShape, gkMathUtils::get(scale));
+						}
 						break;
 					}
+					}
  					break;
 				}
 				else
@@ -743,6 +811,13 @@ void gkPhysicsController::_handleManifold(btPersistentManifold* manifold)
 
 
 
+bool gkPhysicsController::_wantsContacts(void)
+{
+	return !m_suspend && m_props.isContactListener() && m_object->isInstanced();
+}
+
+
+
 void gkPhysicsController::_resetContactInfo(void)
 {
 	if (m_props.isContactListener())
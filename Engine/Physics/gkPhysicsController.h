@@ -50,6 +50,24 @@ struct gkContactInfo
 };
 
 
+///Change in the touching state of a controller pair, reported once per substep.
+struct gkContactEvent
+{
+	enum Type
+	{
+		CE_BEGIN,
+		CE_PERSIST,
+		CE_END,
+	};
+
+	gkPhysicsController* a;
+	gkPhysicsController* b;
+	int                  type;
+
+	typedef utArray<gkContactEvent> Array;
+};
+
+
 ///Base class for a physics object that gets updated along side a gkGameObject.
 class gkPhysicsController
 {
@@ -69,6 +87,9 @@ public:
 	void suspend(bool v);
 	bool isSuspended(void) {return m_suspend;}
 
+	///Last frustum state set by gkDbvt
+	bool _isDbvtMarked(void) {return m_dbvtMark;}
+
 
 	gkPhysicsProperties& getProperties(void);
 
@@ -117,6 +138,20 @@ public:
 
 	virtual void _handleManifold(btPersistentManifold* manifold);
 	void _resetContactInfo(void);
+
+	///Only these get gkContactInfo copies of their manifolds.
+	virtual bool _wantsContacts(void);
+
+	///Drops the contacts of an older substep before new ones are added.
+	GK_INLINE void _touchContacts(unsigned int substep, unsigned int frame)
+	{
+		if (m_contactSubstep != substep)
+		{
+			m_localContacts.clear(true);
+			m_contactSubstep = substep;
+			m_contactFrame = frame;
+		}
+	}
 	bool _markDbvt(bool v);
 	
 	btCollisionShape* _createShape(void);
@@ -129,7 +164,17 @@ protected:
 	void createShape(void);
 	void destroyShape(btCollisionShape* shape);
 
+	// gives the shape back to gkCollisionCache, or deletes an own one
+	void releaseShape(void);
+
+	// mesh the shape is built from and its half size
+	gkMesh* getShapeSource(gkVector3& size);
+
+	// contacts from before the last gkDynamicsWorld::resetContacts read as empty
+	void syncContacts(void);
+
 	gkContactInfo::Array m_localContacts;
+	unsigned int m_contactSubstep, m_contactFrame;
 
 	gkDynamicsWorld* m_owner;
 	gkGameObject* m_object;
@@ -137,6 +182,7 @@ protected:
 	btCollisionObject* m_collisionObject;
 
 	btCollisionShape* m_shape;
+	bool m_sharedShape;
 	bool m_suspend;
 	bool m_dbvtMark;
 
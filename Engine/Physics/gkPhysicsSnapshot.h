@@ -0,0 +1,127 @@
+/*
+-------------------------------------------------------------------------------
+    This file is part of OgreKit.
+    http://gamekit.googlecode.com/
+
+    Copyright (c) 2006-2013 Charlie C.
+
+    Contributor(s): none yet.
+-------------------------------------------------------------------------------
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#ifndef _gkPhysicsSnapshot_h_
+#define _gkPhysicsSnapshot_h_
+
+#include "btBulletDynamicsCommon.h"
+#include "gkCommon.h"
+
+class gkPhysicsController;
+
+
+///In memory copy of the simulation state of a gkDynamicsWorld.
+///
+///Filled by gkDynamicsWorld::saveState and applied by gkDynamicsWorld::restoreState.
+///The arrays keep their storage between saves, so a snapshot reused every tick
+///does not allocate once it has grown to the size of the world.
+class gkPhysicsSnapshot
+{
+public:
+
+	ATTRIBUTE_ALIGNED16(struct) Body
+	{
+		BT_DECLARE_ALIGNED_ALLOCATOR();
+
+		btTransform             m_transform;
+		btTransform             m_interpolationTransform;
+		btVector3               m_linearVelocity;
+		btVector3               m_angularVelocity;
+		btVector3               m_interpolationLinearVelocity;
+		btVector3               m_interpolationAngularVelocity;
+		gkPhysicsController*    m_controller;
+		btCollisionObject*      m_object;
+		btScalar                m_deactivationTime;
+		btScalar                m_verticalVelocity;     // character controllers only
+		btScalar                m_verticalOffset;
+		int                     m_activationState;
+	};
+
+	struct Manifold
+	{
+		gkPhysicsController*        m_a;      // ordered like gkDynamicsWorld contact pairs
+		gkPhysicsController*        m_b;
+		const btCollisionObject*    m_body0;
+		int                         m_first, m_count;
+		int                         m_next;   // next manifold of the same pair (compound shapes), -1 if none
+	};
+
+	struct Constraint
+	{
+		btTypedConstraint*      m_constraint;
+		btScalar                m_appliedImpulse;
+		bool                    m_enabled;
+	};
+
+	typedef btAlignedObjectArray<Body>              Bodies;
+	typedef btAlignedObjectArray<Manifold>          Manifolds;
+	typedef btAlignedObjectArray<btManifoldPoint>   Points;
+	typedef btAlignedObjectArray<Constraint>        Constraints;
+	typedef btAlignedObjectArray<gkPhysicsController*> ContactPairs;
+	typedef btAlignedObjectArray<unsigned long>     Seeds;
+
+public:
+
+	gkPhysicsSnapshot() : m_localTime(0), m_solverSeed(0), m_valid(false) {}
+
+	GK_INLINE bool isValid(void) const {return m_valid;}
+
+	void clear(void)
+	{
+		m_bodies.resize(0);
+		m_manifolds.resize(0);
+		m_points.resize(0);
+		m_constraints.resize(0);
+		m_contactPairs.resize(0);
+		m_batchSeeds.resize(0);
+		m_valid = false;
+	}
+
+	///Bytes held by the snapshot, including unused capacity.
+	UTsize getMemoryUsage(void) const
+	{
+		return sizeof(gkPhysicsSnapshot)
+		       + m_bodies.capacity() * sizeof(Body)
+		       + m_manifolds.capacity() * sizeof(Manifold)
+		       + m_points.capacity() * sizeof(btManifoldPoint)
+		       + m_constraints.capacity() * sizeof(Constraint)
+		       + m_contactPairs.capacity() * sizeof(gkPhysicsController*)
+		       + m_batchSeeds.capacity() * sizeof(unsigned long);
+	}
+
+	Bodies          m_bodies;
+	Manifolds       m_manifolds;      // touching manifolds, points in m_points
+	Points          m_points;
+	Constraints     m_constraints;
+	ContactPairs    m_contactPairs;   // gkDynamicsWorld touching pairs, two entries each
+	btScalar        m_localTime;
+	unsigned long   m_solverSeed;
+	Seeds           m_batchSeeds;     // gkParallelDynamicsWorld, one per batch
+	bool            m_valid;
+};
+
+
+#endif//_gkPhysicsSnapshot_h_
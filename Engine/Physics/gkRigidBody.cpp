@@ -173,8 +173,7 @@ void gkRigidBody::destroy(void)
 		if (!m_suspend)
 			dyn->removeRigidBody(m_body);
 
-		delete m_shape;
-		m_shape = 0;
+		releaseShape();
 
 		delete m_body;
 		m_body = 0;
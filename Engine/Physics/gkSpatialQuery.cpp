@@ -0,0 +1,315 @@
+/*
+-------------------------------------------------------------------------------
+    This file is part of OgreKit.
+    http://gamekit.googlecode.com/
+
+    Copyright (c) 2006-2013 Charlie C.
+
+    Contributor(s): none yet.
+-------------------------------------------------------------------------------
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#include "gkSpatialQuery.h"
+#include "gkDynamicsWorld.h"
+#include "gkPhysicsController.h"
+#include "gkEngine.h"
+#include "gkJobPool.h"
+#include "btBulletDynamicsCommon.h"
+
+
+
+// squared distance from p to the box, zero inside
+static btScalar gkAabbDistance2(const btVector3& p, const btVector3& min, const btVector3& max)
+{
+	btScalar d2 = 0;
+	for (int i = 0; i < 3; ++i)
+	{
+		if (p[i] < min[i])
+			d2 += (min[i] - p[i]) * (min[i] - p[i]);
+		else if (p[i] > max[i])
+			d2 += (p[i] - max[i]) * (p[i] - max[i]);
+	}
+	return d2;
+}
+
+
+
+class gkSpatialQueryCallback : public btBroadphaseAabbCallback
+{
+public:
+	gkSpatialQueryCallback(const gkSpatialQuery::Query& query, gkSpatialQuery::Results& results)
+		:    m_query(query), m_results(results),
+		     m_a(query.m_a.x, query.m_a.y, query.m_a.z),
+		     m_b(query.m_b.x, query.m_b.y, query.m_b.z),
+		     m_radius2(query.m_radius * query.m_radius),
+		     m_sweep(m_a, m_b),
+		     m_sweepShape(0)
+	{
+	}
+
+	bool process(const btBroadphaseProxy* proxy)
+	{
+		if (!(proxy->m_collisionFilterGroup & m_query.m_mask))
+			return true;
+
+		btCollisionObject* colObj = static_cast<btCollisionObject*>(proxy->m_clientObject);
+		gkPhysicsController* cont = static_cast<gkPhysicsController*>(colObj->getUserPointer());
+		if (!cont)
+			return true;
+
+		switch (m_query.m_type)
+		{
+		case gkSpatialQuery::SQ_SPHERE:
+			{
+				btScalar d2 = gkAabbDistance2(m_a, proxy->m_aabbMin, proxy->m_aabbMax);
+				if (d2 <= m_radius2)
+					add(cont, btSqrt(d2));
+			}
+			break;
+		case gkSpatialQuery::SQ_AABB:
+			if (TestAabbAgainstAabb2(m_a, m_b, proxy->m_aabbMin, proxy->m_aabbMax))
+				add(cont, btSqrt(gkAabbDistance2((m_a + m_b) * btScalar(0.5), proxy->m_aabbMin, proxy->m_aabbMax)));
+			break;
+		case gkSpatialQuery::SQ_NEAREST:
+			{
+				btScalar d2 = gkAabbDistance2(m_a, proxy->m_aabbMin, proxy->m_aabbMax);
+				if (d2 <= m_radius2)
+					insertNearest(cont, btSqrt(d2));
+			}
+			break;
+		case gkSpatialQuery::SQ_SWEEP:
+			if (colObj->hasContactResponse())
+			{
+				btTransform from, to;
+				from.setIdentity();
+				to.setIdentity();
+				from.setOrigin(m_a);
+				to.setOrigin(m_b);
+
+				btCollisionWorld::objectQuerySingle(m_sweepShape, from, to, colObj, colObj->getCollisionShape(),
+				                                    colObj->getWorldTransform(), m_sweep, btScalar(0));
+			}
+			break;
+		}
+		return true;
+	}
+
+	void add(gkPhysicsController* cont, btScalar distance)
+	{
+		gkSpatialQuery::Result res;
+		res.m_object = cont;
+		res.m_distance = distance;
+		res.m_point = gkVector3::ZERO;
+		res.m_normal = gkVector3::ZERO;
+		m_results.push_back(res);
+	}
+
+	// keeps the closest m_count results sorted
+	void insertNearest(gkPhysicsController* cont, btScalar distance)
+	{
+		int size = (int)m_results.size();
+		if (size == m_query.m_count)
+		{
+			if (distance >= m_results[size - 1].m_distance)
+				return;
+			m_results.pop_back();
+			--size;
+		}
+
+		add(cont, distance);
+
+		for (int i = size; i > 0 && m_results[i - 1].m_distance > distance; --i)
+		{
+			gkSpatialQuery::Result tmp = m_results[i];
+			m_results[i] = m_results[i - 1];
+			m_results[i - 1] = tmp;
+		}
+	}
+
+	const gkSpatialQuery::Query&    m_query;
+	gkSpatialQuery::Results&        m_results;
+	btVector3                       m_a, m_b;
+	btScalar                        m_radius2;
+
+	btCollisionWorld::ClosestConvexResultCallback m_sweep;
+	btSphereShape*                  m_sweepShape;
+};
+
+
+
+class gkSpatialQueryJob : public gkJobPool::Job
+{
+public:
+	gkSpatialQueryJob(gkSpatialQuery* batch, gkDynamicsWorld* world)
+		:    m_batch(batch), m_world(world)
+	{
+	}
+
+	void run(int begin, int end)
+	{
+		for (int i = begin; i < end; ++i)
+			m_batch->_run(m_world, i);
+	}
+
+private:
+	gkSpatialQuery*     m_batch;
+	gkDynamicsWorld*    m_world;
+};
+
+
+
+gkSpatialQuery::gkSpatialQuery()
+{
+}
+
+
+
+gkSpatialQuery::~gkSpatialQuery()
+{
+}
+
+
+
+int gkSpatialQuery::addQuery(int type, const gkVector3& a, const gkVector3& b, gkScalar radius, int count, short mask)
+{
+	Query query;
+	query.m_type = type;
+	query.m_a = a;
+	query.m_b = b;
+	query.m_radius = gkMax<gkScalar>(radius, 0);
+	query.m_count = count;
+	query.m_mask = mask;
+	m_queries.push_back(query);
+	return (int)m_queries.size() - 1;
+}
+
+
+
+int gkSpatialQuery::addSphere(const gkVector3& center, gkScalar radius, short mask)
+{
+	return addQuery(SQ_SPHERE, center, center, radius, 0, mask);
+}
+
+
+
+int gkSpatialQuery::addAabb(const gkVector3& min, const gkVector3& max, short mask)
+{
+	gkVector3 lo(min), hi(max);
+	lo.makeFloor(max);
+	hi.makeCeil(min);
+	return addQuery(SQ_AABB, lo, hi, 0, 0, mask);
+}
+
+
+
+int gkSpatialQuery::addNearest(const gkVector3& center, int count, gkScalar maxDistance, short mask)
+{
+	return addQuery(SQ_NEAREST, center, center, maxDistance, gkMax(count, 0), mask);
+}
+
+
+
+int gkSpatialQuery::addSweep(const gkVector3& from, const gkVector3& to, gkScalar radius, short mask)
+{
+	return addQuery(SQ_SWEEP, from, to, radius, 0, mask);
+}
+
+
+
+void gkSpatialQuery::clear(void)
+{
+	m_queries.resize(0);
+	m_results.resize(0);
+	m_ranges.resize(0);
+}
+
+
+
+void gkSpatialQuery::_run(gkDynamicsWorld* world, int q)
+{
+	const Query& query = m_queries[q];
+	Results& results = m_scratch[q];
+	results.resize(0);
+
+	if (query.m_type == SQ_NEAREST && query.m_count == 0)
+		return;
+
+	btVector3 a(query.m_a.x, query.m_a.y, query.m_a.z);
+	btVector3 b(query.m_b.x, query.m_b.y, query.m_b.z);
+	btVector3 ext(query.m_radius, query.m_radius, query.m_radius);
+
+	btVector3 min = a, max = b;
+	if (query.m_type == SQ_SWEEP)
+	{
+		min.setMin(b);
+		max.setMax(a);
+	}
+	if (query.m_type != SQ_AABB)
+	{
+		min -= ext;
+		max += ext;
+	}
+
+	gkSpatialQueryCallback callback(query, results);
+
+	btSphereShape sphere(query.m_radius);
+	callback.m_sweepShape = &sphere;
+
+	world->getBulletWorld()->getBroadphase()->aabbTest(min, max, callback);
+
+	if (query.m_type == SQ_SWEEP && callback.m_sweep.hasHit())
+	{
+		Result res;
+		res.m_object = static_cast<gkPhysicsController*>(callback.m_sweep.m_hitCollisionObject->getUserPointer());
+		res.m_distance = callback.m_sweep.m_closestHitFraction * (b - a).length();
+		res.m_point = gkVector3(callback.m_sweep.m_hitPointWorld);
+		res.m_normal = gkVector3(callback.m_sweep.m_hitNormalWorld);
+		results.push_back(res);
+	}
+}
+
+
+
+void gkSpatialQuery::execute(gkDynamicsWorld* world)
+{
+	GK_ASSERT(world);
+
+	int count = (int)m_queries.size();
+	if (m_scratch.size() < m_queries.size())
+		m_scratch.resize(m_queries.size());
+
+	// broadphase reads only, the world must not step meanwhile
+	gkJobPool* pool = gkEngine::getSingleton().getJobPool();
+	gkSpatialQueryJob job(this, world);
+	if (count > 1)
+		pool->parallelFor(count, gkMax(1, count / (pool->getConcurrency() * 4)), &job);
+	else
+		job.run(0, count);
+
+	m_results.resize(0);
+	m_ranges.resize(count * 2);
+	for (int i = 0; i < count; ++i)
+	{
+		const Results& results = m_scratch[i];
+		m_ranges[i * 2] = (int)m_results.size();
+		m_ranges[i * 2 + 1] = (int)results.size();
+
+		for (UTsize j = 0; j < results.size(); ++j)
+			m_results.push_back(results[j]);
+	}
+}
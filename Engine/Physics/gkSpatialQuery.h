@@ -0,0 +1,119 @@
+/*
+-------------------------------------------------------------------------------
+    This file is part of OgreKit.
+    http://gamekit.googlecode.com/
+
+    Copyright (c) 2006-2013 Charlie C.
+
+    Contributor(s): none yet.
+-------------------------------------------------------------------------------
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#ifndef _gkSpatialQuery_h_
+#define _gkSpatialQuery_h_
+
+#include "gkCommon.h"
+#include "gkMathUtils.h"
+
+class gkDynamicsWorld;
+class gkPhysicsController;
+
+
+///Batch of scene queries answered from the broadphase tree.
+///
+///Queries are added once per frame, executed together on the engine job pool,
+///then read back per query. Overlap and nearest queries test the broadphase
+///bounding boxes only, distances are from the query point to the closest point
+///of the box. Sweeps move a sphere and keep the closest hit. The mask is
+///matched against the collision group of each object.
+class gkSpatialQuery
+{
+public:
+
+	enum Type
+	{
+		SQ_SPHERE,
+		SQ_AABB,
+		SQ_NEAREST,
+		SQ_SWEEP,
+	};
+
+	class Query
+	{
+	public:
+		int         m_type;
+		gkVector3   m_a;        // center, min or sweep start
+		gkVector3   m_b;        // max or sweep end
+		gkScalar    m_radius;
+		int         m_count;    // nearest only
+		short       m_mask;
+	};
+
+	class Result
+	{
+	public:
+		gkPhysicsController*    m_object;
+		gkScalar                m_distance;
+		gkVector3               m_point;    // sweeps only
+		gkVector3               m_normal;   // sweeps only
+	};
+
+	typedef utArray<Query>  Queries;
+	typedef utArray<Result> Results;
+
+public:
+	gkSpatialQuery();
+	~gkSpatialQuery();
+
+	///Each add returns the query index used to read its results.
+	int addSphere(const gkVector3& center, gkScalar radius, short mask = -1);
+	int addAabb(const gkVector3& min, const gkVector3& max, short mask = -1);
+
+	///Up to count objects within maxDistance, closest first.
+	int addNearest(const gkVector3& center, int count, gkScalar maxDistance, short mask = -1);
+	int addSweep(const gkVector3& from, const gkVector3& to, gkScalar radius, short mask = -1);
+
+	///Drops queries and results, keeps the memory for the next frame.
+	void clear(void);
+
+	void execute(gkDynamicsWorld* world);
+
+	GK_INLINE int getQueryCount(void) const          {return (int)m_queries.size();}
+	GK_INLINE const Query& getQuery(int q) const     {return m_queries[q];}
+
+	///False until the batch holding query q was executed.
+	GK_INLINE bool hasResults(int q) const           {return q >= 0 && q * 2 < (int)m_ranges.size();}
+
+	GK_INLINE int getResultCount(int q) const        {return m_ranges[q * 2 + 1];}
+	GK_INLINE const Result& getResult(int q, int i) const {return m_results[m_ranges[q * 2] + i];}
+
+	///Results of every query, grouped by query in order.
+	GK_INLINE const Results& getResults(void) const  {return m_results;}
+
+	void _run(gkDynamicsWorld* world, int q);
+
+private:
+	int addQuery(int type, const gkVector3& a, const gkVector3& b, gkScalar radius, int count, short mask);
+
+	Queries             m_queries;
+	Results             m_results;
+	utArray<int>        m_ranges;   // first result and count per query
+	utArray<Results>    m_scratch;  // per query, filled by the jobs
+};
+
+#endif//_gkSpatialQuery_h_
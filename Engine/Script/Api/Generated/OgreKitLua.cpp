@@ -1568,83 +1568,85 @@ SWIG_Lua_dostring(lua_State *L, const char* str) {
 #define SWIGTYPE_p_gsArrayT_gsLogicObject_gkLogicLink_t swig_types[50]
 #define SWIGTYPE_p_gsArrayT_gsProcess_gkProcess_t swig_types[51]
 #define SWIGTYPE_p_gsArrayT_gsSensor_gkLogicSensor_t swig_types[52]
-#define SWIGTYPE_p_gsBrick swig_types[53]
-#define SWIGTYPE_p_gsCamera swig_types[54]
-#define SWIGTYPE_p_gsCharacter swig_types[55]
-#define SWIGTYPE_p_gsCollisionSensor swig_types[56]
-#define SWIGTYPE_p_gsController swig_types[57]
-#define SWIGTYPE_p_gsCurve swig_types[58]
-#define SWIGTYPE_p_gsDebugger swig_types[59]
-#define SWIGTYPE_p_gsDelaySensor swig_types[60]
-#define SWIGTYPE_p_gsDynamicsWorld swig_types[61]
-#define SWIGTYPE_p_gsEditObjectActuator swig_types[62]
-#define SWIGTYPE_p_gsEngine swig_types[63]
-#define SWIGTYPE_p_gsEntity swig_types[64]
-#define SWIGTYPE_p_gsExpressionController swig_types[65]
-#define SWIGTYPE_p_gsFSM swig_types[66]
-#define SWIGTYPE_p_gsGameActuator swig_types[67]
-#define SWIGTYPE_p_gsGameObject swig_types[68]
-#define SWIGTYPE_p_gsGameObjectInstance swig_types[69]
-#define SWIGTYPE_p_gsHUD swig_types[70]
-#define SWIGTYPE_p_gsHUDElement swig_types[71]
-#define SWIGTYPE_p_gsJoystick swig_types[72]
-#define SWIGTYPE_p_gsKeyboard swig_types[73]
-#define SWIGTYPE_p_gsKeyboardSensor swig_types[74]
-#define SWIGTYPE_p_gsLight swig_types[75]
-#define SWIGTYPE_p_gsLogicManager swig_types[76]
-#define SWIGTYPE_p_gsLogicObject swig_types[77]
-#define SWIGTYPE_p_gsLogicOpController swig_types[78]
-#define SWIGTYPE_p_gsLuaManager swig_types[79]
-#define SWIGTYPE_p_gsLuaScript swig_types[80]
-#define SWIGTYPE_p_gsMesh swig_types[81]
-#define SWIGTYPE_p_gsMessageActuator swig_types[82]
-#define SWIGTYPE_p_gsMessageSensor swig_types[83]
-#define SWIGTYPE_p_gsMotionActuator swig_types[84]
-#define SWIGTYPE_p_gsMouse swig_types[85]
-#define SWIGTYPE_p_gsMouseSensor swig_types[86]
-#define SWIGTYPE_p_gsNearSensor swig_types[87]
-#define SWIGTYPE_p_gsObject swig_types[88]
-#define SWIGTYPE_p_gsParentActuator swig_types[89]
-#define SWIGTYPE_p_gsParticles swig_types[90]
-#define SWIGTYPE_p_gsProcess swig_types[91]
-#define SWIGTYPE_p_gsProcessManager swig_types[92]
-#define SWIGTYPE_p_gsProperty swig_types[93]
-#define SWIGTYPE_p_gsPropertyActuator swig_types[94]
-#define SWIGTYPE_p_gsPropertySensor swig_types[95]
-#define SWIGTYPE_p_gsQuaternion swig_types[96]
-#define SWIGTYPE_p_gsRadarSensor swig_types[97]
-#define SWIGTYPE_p_gsRandomActuator swig_types[98]
-#define SWIGTYPE_p_gsRandomSensor swig_types[99]
-#define SWIGTYPE_p_gsRay swig_types[100]
-#define SWIGTYPE_p_gsRaySensor swig_types[101]
-#define SWIGTYPE_p_gsRayTest swig_types[102]
-#define SWIGTYPE_p_gsScene swig_types[103]
-#define SWIGTYPE_p_gsSceneActuator swig_types[104]
-#define SWIGTYPE_p_gsScriptController swig_types[105]
-#define SWIGTYPE_p_gsSensor swig_types[106]
-#define SWIGTYPE_p_gsSkeleton swig_types[107]
-#define SWIGTYPE_p_gsSoundActuator swig_types[108]
-#define SWIGTYPE_p_gsStateActuator swig_types[109]
-#define SWIGTYPE_p_gsSubMesh swig_types[110]
-#define SWIGTYPE_p_gsSweptTest swig_types[111]
-#define SWIGTYPE_p_gsTouchSensor swig_types[112]
-#define SWIGTYPE_p_gsUserDefs swig_types[113]
-#define SWIGTYPE_p_gsVector3 swig_types[114]
-#define SWIGTYPE_p_gsVector4 swig_types[115]
-#define SWIGTYPE_p_gsVisibilityActuator swig_types[116]
-#define SWIGTYPE_p_gsWhenEvent swig_types[117]
-#define SWIGTYPE_p_utArrayT_gkGameObject_p_t swig_types[118]
-#define SWIGTYPE_p_utArrayT_gkLogicActuator_p_t swig_types[119]
-#define SWIGTYPE_p_utArrayT_gkLogicController_p_t swig_types[120]
-#define SWIGTYPE_p_utArrayT_gkLogicLink_p_t swig_types[121]
-#define SWIGTYPE_p_utArrayT_gkLogicSensor_p_t swig_types[122]
-#define SWIGTYPE_p_utArrayT_gkPhysicsConstraintProperties_t swig_types[123]
-#define SWIGTYPE_p_utArrayT_gkProcess_p_t swig_types[124]
-#define SWIGTYPE_p_utArrayT_gkString_t swig_types[125]
-#define SWIGTYPE_p_utArrayT_gkVector3_t swig_types[126]
-#define SWIGTYPE_p_utArrayT_utArrayT_gkVector3_t_t swig_types[127]
-static swig_type_info *swig_types[129];
-static swig_module_info swig_module = {swig_types, 128, 0, 0, 0, 0};
+#define SWIGTYPE_p_gsBlendLoad swig_types[53]
+#define SWIGTYPE_p_gsBrick swig_types[54]
+#define SWIGTYPE_p_gsCamera swig_types[55]
+#define SWIGTYPE_p_gsCharacter swig_types[56]
+#define SWIGTYPE_p_gsCollisionSensor swig_types[57]
+#define SWIGTYPE_p_gsController swig_types[58]
+#define SWIGTYPE_p_gsCurve swig_types[59]
+#define SWIGTYPE_p_gsDebugger swig_types[60]
+#define SWIGTYPE_p_gsDelaySensor swig_types[61]
+#define SWIGTYPE_p_gsDynamicsWorld swig_types[62]
+#define SWIGTYPE_p_gsEditObjectActuator swig_types[63]
+#define SWIGTYPE_p_gsEngine swig_types[64]
+#define SWIGTYPE_p_gsEntity swig_types[65]
+#define SWIGTYPE_p_gsExpressionController swig_types[66]
+#define SWIGTYPE_p_gsFSM swig_types[67]
+#define SWIGTYPE_p_gsGameActuator swig_types[68]
+#define SWIGTYPE_p_gsGameObject swig_types[69]
+#define SWIGTYPE_p_gsGameObjectInstance swig_types[70]
+#define SWIGTYPE_p_gsHUD swig_types[71]
+#define SWIGTYPE_p_gsHUDElement swig_types[72]
+#define SWIGTYPE_p_gsJoystick swig_types[73]
+#define SWIGTYPE_p_gsKeyboard swig_types[74]
+#define SWIGTYPE_p_gsKeyboardSensor swig_types[75]
+#define SWIGTYPE_p_gsLight swig_types[76]
+#define SWIGTYPE_p_gsLogicManager swig_types[77]
+#define SWIGTYPE_p_gsLogicObject swig_types[78]
+#define SWIGTYPE_p_gsLogicOpController swig_types[79]
+#define SWIGTYPE_p_gsLuaManager swig_types[80]
+#define SWIGTYPE_p_gsLuaScript swig_types[81]
+#define SWIGTYPE_p_gsMesh swig_types[82]
+#define SWIGTYPE_p_gsMessageActuator swig_types[83]
+#define SWIGTYPE_p_gsMessageSensor swig_types[84]
+#define SWIGTYPE_p_gsMotionActuator swig_types[85]
+#define SWIGTYPE_p_gsMouse swig_types[86]
+#define SWIGTYPE_p_gsMouseSensor swig_types[87]
+#define SWIGTYPE_p_gsNearSensor swig_types[88]
+#define SWIGTYPE_p_gsObject swig_types[89]
+#define SWIGTYPE_p_gsParentActuator swig_types[90]
+#define SWIGTYPE_p_gsParticles swig_types[91]
+#define SWIGTYPE_p_gsProcess swig_types[92]
+#define SWIGTYPE_p_gsProcessManager swig_types[93]
+#define SWIGTYPE_p_gsProperty swig_types[94]
+#define SWIGTYPE_p_gsPropertyActuator swig_types[95]
+#define SWIGTYPE_p_gsPropertySensor swig_types[96]
+#define SWIGTYPE_p_gsQuaternion swig_types[97]
+#define SWIGTYPE_p_gsRadarSensor swig_types[98]
+#define SWIGTYPE_p_gsRandomActuator swig_types[99]
+#define SWIGTYPE_p_gsRandomSensor swig_types[100]
+#define SWIGTYPE_p_gsRay swig_types[101]
+#define SWIGTYPE_p_gsRaySensor swig_types[102]
+#define SWIGTYPE_p_gsRayTest swig_types[103]
+#define SWIGTYPE_p_gsScene swig_types[104]
+#define SWIGTYPE_p_gsSceneActuator swig_types[105]
+#define SWIGTYPE_p_gsScriptController swig_types[106]
+#define SWIGTYPE_p_gsSensor swig_types[107]
+#define SWIGTYPE_p_gsSkeleton swig_types[108]
+#define SWIGTYPE_p_gsSoundActuator swig_types[109]
+#define SWIGTYPE_p_gsSpatialQuery swig_types[110]
+#define SWIGTYPE_p_gsStateActuator swig_types[111]
+#define SWIGTYPE_p_gsSubMesh swig_types[112]
+#define SWIGTYPE_p_gsSweptTest swig_types[113]
+#define SWIGTYPE_p_gsTouchSensor swig_types[114]
+#define SWIGTYPE_p_gsUserDefs swig_types[115]
+#define SWIGTYPE_p_gsVector3 swig_types[116]
+#define SWIGTYPE_p_gsVector4 swig_types[117]
+#define SWIGTYPE_p_gsVisibilityActuator swig_types[118]
+#define SWIGTYPE_p_gsWhenEvent swig_types[119]
+#define SWIGTYPE_p_utArrayT_gkGameObject_p_t swig_types[120]
+#define SWIGTYPE_p_utArrayT_gkLogicActuator_p_t swig_types[121]
+#define SWIGTYPE_p_utArrayT_gkLogicController_p_t swig_types[122]
+#define SWIGTYPE_p_utArrayT_gkLogicLink_p_t swig_types[123]
+#define SWIGTYPE_p_utArrayT_gkLogicSensor_p_t swig_types[124]
+#define SWIGTYPE_p_utArrayT_gkPhysicsConstraintProperties_t swig_types[125]
+#define SWIGTYPE_p_utArrayT_gkProcess_p_t swig_types[126]
+#define SWIGTYPE_p_utArrayT_gkString_t swig_types[127]
+#define SWIGTYPE_p_utArrayT_gkVector3_t swig_types[128]
+#define SWIGTYPE_p_utArrayT_utArrayT_gkVector3_t_t swig_types[129]
+static swig_type_info *swig_types[131];
+static swig_module_info swig_module = {swig_types, 130, 0, 0, 0, 0};
 #define SWIG_TypeQuery(name) SWIG_TypeQueryModule(&swig_module, &swig_module, name)
 #define SWIG_MangledTypeQuery(name) SWIG_MangledTypeQueryModule(&swig_module, &swig_module, name)
 
@@ -17355,6 +17357,99 @@ static swig_lua_class *swig_gsKeyboard_bases[] = {0};
 static const char *swig_gsKeyboard_base_names[] = {0};
 static swig_lua_class _wrap_class_gsKeyboard = { "Keyboard", &SWIGTYPE_p_gsKeyboard,_wrap_new_Keyboard, swig_delete_Keyboard, swig_gsKeyboard_methods, swig_gsKeyboard_attributes, swig_gsKeyboard_bases, swig_gsKeyboard_base_names };
 
+static int _wrap_BlendLoad_isDone(lua_State* L) {
+  int SWIG_arg = 0;
+  gsBlendLoad *arg1 = (gsBlendLoad *) 0 ;
+  bool result;
+  
+  SWIG_check_num_args("gsBlendLoad::isDone",1,1)
+  if(!SWIG_isptrtype(L,1)) SWIG_fail_arg("gsBlendLoad::isDone",1,"gsBlendLoad *");
+  
+  if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&arg1,SWIGTYPE_p_gsBlendLoad,0))){
+    SWIG_fail_ptr("BlendLoad_isDone",1,SWIGTYPE_p_gsBlendLoad);
+  }
+  
+  result = (bool)(arg1)->isDone();
+  lua_pushboolean(L,(int)(result!=0)); SWIG_arg++;
+  return SWIG_arg;
+  
+  if(0) SWIG_fail;
+  
+fail:
+  lua_error(L);
+  return SWIG_arg;
+}
+
+
+static int _wrap_BlendLoad_getScene(lua_State* L) {
+  int SWIG_arg = 0;
+  gsBlendLoad *arg1 = (gsBlendLoad *) 0 ;
+  gkScene *result = 0 ;
+  
+  SWIG_check_num_args("gsBlendLoad::getScene",1,1)
+  if(!SWIG_isptrtype(L,1)) SWIG_fail_arg("gsBlendLoad::getScene",1,"gsBlendLoad *");
+  
+  if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&arg1,SWIGTYPE_p_gsBlendLoad,0))){
+    SWIG_fail_ptr("BlendLoad_getScene",1,SWIGTYPE_p_gsBlendLoad);
+  }
+  
+  result = (gkScene *)(arg1)->getScene();
+  if (result) {
+    SWIG_arg += GS_LUA_OBJECT_STORE(result, Scene); 
+  } 
+  return SWIG_arg;
+  
+  if(0) SWIG_fail;
+  
+fail:
+  lua_error(L);
+  return SWIG_arg;
+}
+
+
+static int _wrap_BlendLoad_finish(lua_State* L) {
+  int SWIG_arg = 0;
+  gsBlendLoad *arg1 = (gsBlendLoad *) 0 ;
+  gkScene *result = 0 ;
+  
+  SWIG_check_num_args("gsBlendLoad::finish",1,1)
+  if(!SWIG_isptrtype(L,1)) SWIG_fail_arg("gsBlendLoad::finish",1,"gsBlendLoad *");
+  
+  if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&arg1,SWIGTYPE_p_gsBlendLoad,0))){
+    SWIG_fail_ptr("BlendLoad_finish",1,SWIGTYPE_p_gsBlendLoad);
+  }
+  
+  result = (gkScene *)(arg1)->finish();
+  if (result) {
+    SWIG_arg += GS_LUA_OBJECT_STORE(result, Scene); 
+  } 
+  return SWIG_arg;
+  
+  if(0) SWIG_fail;
+  
+fail:
+  lua_error(L);
+  return SWIG_arg;
+}
+
+
+static void swig_delete_BlendLoad(void *obj) {
+gsBlendLoad *arg1 = (gsBlendLoad *) obj;
+delete arg1;
+}
+static swig_lua_method swig_gsBlendLoad_methods[] = {
+    {"isDone", _wrap_BlendLoad_isDone}, 
+    {"getScene", _wrap_BlendLoad_getScene}, 
+    {"finish", _wrap_BlendLoad_finish}, 
+    {0,0}
+};
+static swig_lua_attribute swig_gsBlendLoad_attributes[] = {
+    {0,0,0}
+};
+static swig_lua_class *swig_gsBlendLoad_bases[] = {0};
+static const char *swig_gsBlendLoad_base_names[] = {0};
+static swig_lua_class _wrap_class_gsBlendLoad = { "BlendLoad", &SWIGTYPE_p_gsBlendLoad,0, swig_delete_BlendLoad, swig_gsBlendLoad_methods, swig_gsBlendLoad_attributes, swig_gsBlendLoad_bases, swig_gsBlendLoad_base_names };
+
 static int _wrap_new_Engine(lua_State* L) {
   int SWIG_arg = 0;
   gsEngine *result = 0 ;
@@ -17635,6 +17730,37 @@ fail:
 }
 
 
+static int _wrap_Engine_loadBlendFileAsync(lua_State* L) {
+  int SWIG_arg = 0;
+  gsEngine *arg1 = (gsEngine *) 0 ;
+  gkString *arg2 = 0 ;
+  gkString temp2 ;
+  gsBlendLoad *result = 0 ;
+  
+  SWIG_check_num_args("gsEngine::loadBlendFileAsync",2,2)
+  if(!SWIG_isptrtype(L,1)) SWIG_fail_arg("gsEngine::loadBlendFileAsync",1,"gsEngine *");
+  if(!lua_isstring(L,2)) SWIG_fail_arg("gsEngine::loadBlendFileAsync",2,"gkString const &");
+  
+  if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&arg1,SWIGTYPE_p_gsEngine,0))){
+    SWIG_fail_ptr("Engine_loadBlendFileAsync",1,SWIGTYPE_p_gsEngine);
+  }
+  
+  
+  temp2 = gkString((const char*)lua_tostring(L, 2));
+  arg2 = &temp2;
+  
+  result = (gsBlendLoad *)(arg1)->loadBlendFileAsync((gkString const &)*arg2);
+  SWIG_NewPointerObj(L,result,SWIGTYPE_p_gsBlendLoad,1); SWIG_arg++; 
+  return SWIG_arg;
+  
+  if(0) SWIG_fail;
+  
+fail:
+  lua_error(L);
+  return SWIG_arg;
+}
+
+
 static int _wrap_Engine_getActiveScene(lua_State* L) {
   int SWIG_arg = 0;
   gsEngine *arg1 = (gsEngine *) 0 ;
@@ -18151,6 +18277,7 @@ static swig_lua_method swig_gsEngine_methods[] = {
     {"saveTimestampedScreenShot", _wrap_Engine_saveTimestampedScreenShot}, 
     {"connect", _wrap_Engine_connect}, 
     {"loadBlendFile", _wrap_Engine_loadBlendFile}, 
+    {"loadBlendFileAsync", _wrap_Engine_loadBlendFileAsync}, 
     {"getActiveScene", _wrap_Engine_getActiveScene}, 
     {"getScene", _wrap_Engine_getScene}, 
     {"addOverlayScene", _wrap_Engine_addOverlayScene}, 
@@ -41645,12 +41772,43 @@ fail:
 }
 
 
+static int _wrap_DynamicsWorld_query(lua_State* L) {
+  int SWIG_arg = 0;
+  gsDynamicsWorld *arg1 = (gsDynamicsWorld *) 0 ;
+  gsSpatialQuery *arg2 = 0 ;
+  
+  SWIG_check_num_args("gsDynamicsWorld::query",2,2)
+  if(!SWIG_isptrtype(L,1)) SWIG_fail_arg("gsDynamicsWorld::query",1,"gsDynamicsWorld *");
+  if(!lua_isuserdata(L,2)) SWIG_fail_arg("gsDynamicsWorld::query",2,"gsSpatialQuery &");
+  
+  if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&arg1,SWIGTYPE_p_gsDynamicsWorld,0))){
+    SWIG_fail_ptr("DynamicsWorld_query",1,SWIGTYPE_p_gsDynamicsWorld);
+  }
+  
+  
+  if (!SWIG_IsOK(SWIG_ConvertPtr(L,2,(void**)&arg2,SWIGTYPE_p_gsSpatialQuery,0))){
+    SWIG_fail_ptr("DynamicsWorld_query",2,SWIGTYPE_p_gsSpatialQuery);
+  }
+  
+  (arg1)->query(*arg2);
+  
+  return SWIG_arg;
+  
+  if(0) SWIG_fail;
+  
+fail:
+  lua_error(L);
+  return SWIG_arg;
+}
+
+
 static void swig_delete_DynamicsWorld(void *obj) {
 gsDynamicsWorld *arg1 = (gsDynamicsWorld *) obj;
 delete arg1;
 }
 static swig_lua_method swig_gsDynamicsWorld_methods[] = {
     {"exportBullet", _wrap_DynamicsWorld_exportBullet}, 
+    {"query", _wrap_DynamicsWorld_query}, 
     {0,0}
 };
 static swig_lua_attribute swig_gsDynamicsWorld_attributes[] = {
@@ -41660,6 +41818,893 @@ static swig_lua_class *swig_gsDynamicsWorld_bases[] = {0};
 static const char *swig_gsDynamicsWorld_base_names[] = {0};
 static swig_lua_class _wrap_class_gsDynamicsWorld = { "DynamicsWorld", &SWIGTYPE_p_gsDynamicsWorld,_wrap_new_DynamicsWorld, swig_delete_DynamicsWorld, swig_gsDynamicsWorld_methods, swig_gsDynamicsWorld_attributes, swig_gsDynamicsWorld_bases, swig_gsDynamicsWorld_base_names };
 
+static int _wrap_new_SpatialQuery(lua_State* L) {
+  int SWIG_arg = 0;
+  gsSpatialQuery *result = 0 ;
+  
+  SWIG_check_num_args("gsSpatialQuery::gsSpatialQuery",0,0)
+  result = (gsSpatialQuery *)new gsSpatialQuery();
+  SWIG_NewPointerObj(L,result,SWIGTYPE_p_gsSpatialQuery,1); SWIG_arg++; 
+  return SWIG_arg;
+  
+  if(0) SWIG_fail;
+  
+fail:
+  lua_error(L);
+  return SWIG_arg;
+}
+
+
+static int _wrap_SpatialQuery_addSphere__SWIG_0(lua_State* L) {
+  int SWIG_arg = 0;
+  gsSpatialQuery *arg1 = (gsSpatialQuery *) 0 ;
+  gsVector3 *arg2 = 0 ;
+  float arg3 ;
+  int arg4 ;
+  int result;
+  
+  SWIG_check_num_args("gsSpatialQuery::addSphere",4,4)
+  if(!SWIG_isptrtype(L,1)) SWIG_fail_arg("gsSpatialQuery::addSphere",1,"gsSpatialQuery *");
+  if(!lua_isuserdata(L,2)) SWIG_fail_arg("gsSpatialQuery::addSphere",2,"gsVector3 const &");
+  if(!lua_isnumber(L,3)) SWIG_fail_arg("gsSpatialQuery::addSphere",3,"float");
+  if(!lua_isnumber(L,4)) SWIG_fail_arg("gsSpatialQuery::addSphere",4,"int");
+  
+  if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&arg1,SWIGTYPE_p_gsSpatialQuery,0))){
+    SWIG_fail_ptr("SpatialQuery_addSphere",1,SWIGTYPE_p_gsSpatialQuery);
+  }
+  
+  
+  if (!SWIG_IsOK(SWIG_ConvertPtr(L,2,(void**)&arg2,SWIGTYPE_p_gsVector3,0))){
+    SWIG_fail_ptr("SpatialQuery_addSphere",2,SWIGTYPE_p_gsVector3);
+  }
+  
+  arg3 = (float)lua_tonumber(L, 3);
+  arg4 = (int)lua_tonumber(L, 4);
+  result = (int)(arg1)->addSphere((gsVector3 const &)*arg2,arg3,arg4);
+  lua_pushnumber(L, (lua_Number) result); SWIG_arg++;
+  return SWIG_arg;
+  
+  if(0) SWIG_fail;
+  
+fail:
+  lua_error(L);
+  return SWIG_arg;
+}
+
+
+static int _wrap_SpatialQuery_addSphere__SWIG_1(lua_State* L) {
+  int SWIG_arg = 0;
+  gsSpatialQuery *arg1 = (gsSpatialQuery *) 0 ;
+  gsVector3 *arg2 = 0 ;
+  float arg3 ;
+  int result;
+  
+  SWIG_check_num_args("gsSpatialQuery::addSphere",3,3)
+  if(!SWIG_isptrtype(L,1)) SWIG_fail_arg("gsSpatialQuery::addSphere",1,"gsSpatialQuery *");
+  if(!lua_isuserdata(L,2)) SWIG_fail_arg("gsSpatialQuery::addSphere",2,"gsVector3 const &");
+  if(!lua_isnumber(L,3)) SWIG_fail_arg("gsSpatialQuery::addSphere",3,"float");
+  
+  if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&arg1,SWIGTYPE_p_gsSpatialQuery,0))){
+    SWIG_fail_ptr("SpatialQuery_addSphere",1,SWIGTYPE_p_gsSpatialQuery);
+  }
+  
+  
+  if (!SWIG_IsOK(SWIG_ConvertPtr(L,2,(void**)&arg2,SWIGTYPE_p_gsVector3,0))){
+    SWIG_fail_ptr("SpatialQuery_addSphere",2,SWIGTYPE_p_gsVector3);
+  }
+  
+  arg3 = (float)lua_tonumber(L, 3);
+  result = (int)(arg1)->addSphere((gsVector3 const &)*arg2,arg3);
+  lua_pushnumber(L, (lua_Number) result); SWIG_arg++;
+  return SWIG_arg;
+  
+  if(0) SWIG_fail;
+  
+fail:
+  lua_error(L);
+  return SWIG_arg;
+}
+
+
+static int _wrap_SpatialQuery_addSphere(lua_State* L) {
+  int argc;
+  int argv[5]={
+    1,2,3,4,5
+  };
+  
+  argc = lua_gettop(L);
+  if (argc == 3) {
+    int _v;
+    {
+      void *ptr;
+      if (SWIG_isptrtype(L,argv[0])==0 || SWIG_ConvertPtr(L,argv[0], (void **) &ptr, SWIGTYPE_p_gsSpatialQuery, 0)) {
+        _v = 0;
+      } else {
+        _v = 1;
+      }
+    }
+    if (_v) {
+      {
+        void *ptr;
+        if (lua_isuserdata(L,argv[1])==0 || SWIG_ConvertPtr(L,argv[1], (void **) &ptr, SWIGTYPE_p_gsVector3, 0)) {
+          _v = 0;
+        } else {
+          _v = 1;
+        }
+      }
+      if (_v) {
+        {
+          _v = lua_isnumber(L,argv[2]);
+        }
+        if (_v) {
+          return _wrap_SpatialQuery_addSphere__SWIG_1(L);
+        }
+      }
+    }
+  }
+  if (argc == 4) {
+    int _v;
+    {
+      void *ptr;
+      if (SWIG_isptrtype(L,argv[0])==0 || SWIG_ConvertPtr(L,argv[0], (void **) &ptr, SWIGTYPE_p_gsSpatialQuery, 0)) {
+        _v = 0;
+      } else {
+        _v = 1;
+      }
+    }
+    if (_v) {
+      {
+        void *ptr;
+        if (lua_isuserdata(L,argv[1])==0 || SWIG_ConvertPtr(L,argv[1], (void **) &ptr, SWIGTYPE_p_gsVector3, 0)) {
+          _v = 0;
+        } else {
+          _v = 1;
+        }
+      }
+      if (_v) {
+        {
+          _v = lua_isnumber(L,argv[2]);
+        }
+        if (_v) {
+          {
+            _v = lua_isnumber(L,argv[3]);
+          }
+          if (_v) {
+            return _wrap_SpatialQuery_addSphere__SWIG_0(L);
+          }
+        }
+      }
+    }
+  }
+  
+  lua_pushstring(L,"Wrong arguments for overloaded function 'SpatialQuery_addSphere'\n"
+    "  Possible C/C++ prototypes are:\n"
+    "    gsSpatialQuery::addSphere(gsVector3 const &,float,int)\n"
+    "    gsSpatialQuery::addSphere(gsVector3 const &,float)\n");
+  lua_error(L);return 0;
+}
+
+
+static int _wrap_SpatialQuery_addBox__SWIG_0(lua_State* L) {
+  int SWIG_arg = 0;
+  gsSpatialQuery *arg1 = (gsSpatialQuery *) 0 ;
+  gsVector3 *arg2 = 0 ;
+  gsVector3 *arg3 = 0 ;
+  int arg4 ;
+  int result;
+  
+  SWIG_check_num_args("gsSpatialQuery::addBox",4,4)
+  if(!SWIG_isptrtype(L,1)) SWIG_fail_arg("gsSpatialQuery::addBox",1,"gsSpatialQuery *");
+  if(!lua_isuserdata(L,2)) SWIG_fail_arg("gsSpatialQuery::addBox",2,"gsVector3 const &");
+  if(!lua_isuserdata(L,3)) SWIG_fail_arg("gsSpatialQuery::addBox",3,"gsVector3 const &");
+  if(!lua_isnumber(L,4)) SWIG_fail_arg("gsSpatialQuery::addBox",4,"int");
+  
+  if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&arg1,SWIGTYPE_p_gsSpatialQuery,0))){
+    SWIG_fail_ptr("SpatialQuery_addBox",1,SWIGTYPE_p_gsSpatialQuery);
+  }
+  
+  
+  if (!SWIG_IsOK(SWIG_ConvertPtr(L,2,(void**)&arg2,SWIGTYPE_p_gsVector3,0))){
+    SWIG_fail_ptr("SpatialQuery_addBox",2,SWIGTYPE_p_gsVector3);
+  }
+  
+  
+  if (!SWIG_IsOK(SWIG_ConvertPtr(L,3,(void**)&arg3,SWIGTYPE_p_gsVector3,0))){
+    SWIG_fail_ptr("SpatialQuery_addBox",3,SWIGTYPE_p_gsVector3);
+  }
+  
+  arg4 = (int)lua_tonumber(L, 4);
+  result = (int)(arg1)->addBox((gsVector3 const &)*arg2,(gsVector3 const &)*arg3,arg4);
+  lua_pushnumber(L, (lua_Number) result); SWIG_arg++;
+  return SWIG_arg;
+  
+  if(0) SWIG_fail;
+  
+fail:
+  lua_error(L);
+  return SWIG_arg;
+}
+
+
+static int _wrap_SpatialQuery_addBox__SWIG_1(lua_State* L) {
+  int SWIG_arg = 0;
+  gsSpatialQuery *arg1 = (gsSpatialQuery *) 0 ;
+  gsVector3 *arg2 = 0 ;
+  gsVector3 *arg3 = 0 ;
+  int result;
+  
+  SWIG_check_num_args("gsSpatialQuery::addBox",3,3)
+  if(!SWIG_isptrtype(L,1)) SWIG_fail_arg("gsSpatialQuery::addBox",1,"gsSpatialQuery *");
+  if(!lua_isuserdata(L,2)) SWIG_fail_arg("gsSpatialQuery::addBox",2,"gsVector3 const &");
+  if(!lua_isuserdata(L,3)) SWIG_fail_arg("gsSpatialQuery::addBox",3,"gsVector3 const &");
+  
+  if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&arg1,SWIGTYPE_p_gsSpatialQuery,0))){
+    SWIG_fail_ptr("SpatialQuery_addBox",1,SWIGTYPE_p_gsSpatialQuery);
+  }
+  
+  
+  if (!SWIG_IsOK(SWIG_ConvertPtr(L,2,(void**)&arg2,SWIGTYPE_p_gsVector3,0))){
+    SWIG_fail_ptr("SpatialQuery_addBox",2,SWIGTYPE_p_gsVector3);
+  }
+  
+  
+  if (!SWIG_IsOK(SWIG_ConvertPtr(L,3,(void**)&arg3,SWIGTYPE_p_gsVector3,0))){
+    SWIG_fail_ptr("SpatialQuery_addBox",3,SWIGTYPE_p_gsVector3);
+  }
+  
+  result = (int)(arg1)->addBox((gsVector3 const &)*arg2,(gsVector3 const &)*arg3);
+  lua_pushnumber(L, (lua_Number) result); SWIG_arg++;
+  return SWIG_arg;
+  
+  if(0) SWIG_fail;
+  
+fail:
+  lua_error(L);
+  return SWIG_arg;
+}
+
+
+static int _wrap_SpatialQuery_addBox(lua_State* L) {
+  int argc;
+  int argv[5]={
+    1,2,3,4,5
+  };
+  
+  argc = lua_gettop(L);
+  if (argc == 3) {
+    int _v;
+    {
+      void *ptr;
+      if (SWIG_isptrtype(L,argv[0])==0 || SWIG_ConvertPtr(L,argv[0], (void **) &ptr, SWIGTYPE_p_gsSpatialQuery, 0)) {
+        _v = 0;
+      } else {
+        _v = 1;
+      }
+    }
+    if (_v) {
+      {
+        void *ptr;
+        if (lua_isuserdata(L,argv[1])==0 || SWIG_ConvertPtr(L,argv[1], (void **) &ptr, SWIGTYPE_p_gsVector3, 0)) {
+          _v = 0;
+        } else {
+          _v = 1;
+        }
+      }
+      if (_v) {
+        {
+          void *ptr;
+          if (lua_isuserdata(L,argv[2])==0 || SWIG_ConvertPtr(L,argv[2], (void **) &ptr, SWIGTYPE_p_gsVector3, 0)) {
+            _v = 0;
+          } else {
+            _v = 1;
+          }
+        }
+        if (_v) {
+          return _wrap_SpatialQuery_addBox__SWIG_1(L);
+        }
+      }
+    }
+  }
+  if (argc == 4) {
+    int _v;
+    {
+      void *ptr;
+      if (SWIG_isptrtype(L,argv[0])==0 || SWIG_ConvertPtr(L,argv[0], (void **) &ptr, SWIGTYPE_p_gsSpatialQuery, 0)) {
+        _v = 0;
+      } else {
+        _v = 1;
+      }
+    }
+    if (_v) {
+      {
+        void *ptr;
+        if (lua_isuserdata(L,argv[1])==0 || SWIG_ConvertPtr(L,argv[1], (void **) &ptr, SWIGTYPE_p_gsVector3, 0)) {
+          _v = 0;
+        } else {
+          _v = 1;
+        }
+      }
+      if (_v) {
+        {
+          void *ptr;
+          if (lua_isuserdata(L,argv[2])==0 || SWIG_ConvertPtr(L,argv[2], (void **) &ptr, SWIGTYPE_p_gsVector3, 0)) {
+            _v = 0;
+          } else {
+            _v = 1;
+          }
+        }
+        if (_v) {
+          {
+            _v = lua_isnumber(L,argv[3]);
+          }
+          if (_v) {
+            return _wrap_SpatialQuery_addBox__SWIG_0(L);
+          }
+        }
+      }
+    }
+  }
+  
+  lua_pushstring(L,"Wrong arguments for overloaded function 'SpatialQuery_addBox'\n"
+    "  Possible C/C++ prototypes are:\n"
+    "    gsSpatialQuery::addBox(gsVector3 const &,gsVector3 const &,int)\n"
+    "    gsSpatialQuery::addBox(gsVector3 const &,gsVector3 const &)\n");
+  lua_error(L);return 0;
+}
+
+
+static int _wrap_SpatialQuery_addNearest__SWIG_0(lua_State* L) {
+  int SWIG_arg = 0;
+  gsSpatialQuery *arg1 = (gsSpatialQuery *) 0 ;
+  gsVector3 *arg2 = 0 ;
+  int arg3 ;
+  float arg4 ;
+  int arg5 ;
+  int result;
+  
+  SWIG_check_num_args("gsSpatialQuery::addNearest",5,5)
+  if(!SWIG_isptrtype(L,1)) SWIG_fail_arg("gsSpatialQuery::addNearest",1,"gsSpatialQuery *");
+  if(!lua_isuserdata(L,2)) SWIG_fail_arg("gsSpatialQuery::addNearest",2,"gsVector3 const &");
+  if(!lua_isnumber(L,3)) SWIG_fail_arg("gsSpatialQuery::addNearest",3,"int");
+  if(!lua_isnumber(L,4)) SWIG_fail_arg("gsSpatialQuery::addNearest",4,"float");
+  if(!lua_isnumber(L,5)) SWIG_fail_arg("gsSpatialQuery::addNearest",5,"int");
+  
+  if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&arg1,SWIGTYPE_p_gsSpatialQuery,0))){
+    SWIG_fail_ptr("SpatialQuery_addNearest",1,SWIGTYPE_p_gsSpatialQuery);
+  }
+  
+  
+  if (!SWIG_IsOK(SWIG_ConvertPtr(L,2,(void**)&arg2,SWIGTYPE_p_gsVector3,0))){
+    SWIG_fail_ptr("SpatialQuery_addNearest",2,SWIGTYPE_p_gsVector3);
+  }
+  
+  arg3 = (int)lua_tonumber(L, 3);
+  arg4 = (float)lua_tonumber(L, 4);
+  arg5 = (int)lua_tonumber(L, 5);
+  result = (int)(arg1)->addNearest((gsVector3 const &)*arg2,arg3,arg4,arg5);
+  lua_pushnumber(L, (lua_Number) result); SWIG_arg++;
+  return SWIG_arg;
+  
+  if(0) SWIG_fail;
+  
+fail:
+  lua_error(L);
+  return SWIG_arg;
+}
+
+
+static int _wrap_SpatialQuery_addNearest__SWIG_1(lua_State* L) {
+  int SWIG_arg = 0;
+  gsSpatialQuery *arg1 = (gsSpatialQuery *) 0 ;
+  gsVector3 *arg2 = 0 ;
+  int arg3 ;
+  float arg4 ;
+  int result;
+  
+  SWIG_check_num_args("gsSpatialQuery::addNearest",4,4)
+  if(!SWIG_isptrtype(L,1)) SWIG_fail_arg("gsSpatialQuery::addNearest",1,"gsSpatialQuery *");
+  if(!lua_isuserdata(L,2)) SWIG_fail_arg("gsSpatialQuery::addNearest",2,"gsVector3 const &");
+  if(!lua_isnumber(L,3)) SWIG_fail_arg("gsSpatialQuery::addNearest",3,"int");
+  if(!lua_isnumber(L,4)) SWIG_fail_arg("gsSpatialQuery::addNearest",4,"float");
+  
+  if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&arg1,SWIGTYPE_p_gsSpatialQuery,0))){
+    SWIG_fail_ptr("SpatialQuery_addNearest",1,SWIGTYPE_p_gsSpatialQuery);
+  }
+  
+  
+  if (!SWIG_IsOK(SWIG_ConvertPtr(L,2,(void**)&arg2,SWIGTYPE_p_gsVector3,0))){
+    SWIG_fail_ptr("SpatialQuery_addNearest",2,SWIGTYPE_p_gsVector3);
+  }
+  
+  arg3 = (int)lua_tonumber(L, 3);
+  arg4 = (float)lua_tonumber(L, 4);
+  result = (int)(arg1)->addNearest((gsVector3 const &)*arg2,arg3,arg4);
+  lua_pushnumber(L, (lua_Number) result); SWIG_arg++;
+  return SWIG_arg;
+  
+  if(0) SWIG_fail;
+  
+fail:
+  lua_error(L);
+  return SWIG_arg;
+}
+
+
+static int _wrap_SpatialQuery_addNearest(lua_State* L) {
+  int argc;
+  int argv[6]={
+    1,2,3,4,5,6
+  };
+  
+  argc = lua_gettop(L);
+  if (argc == 4) {
+    int _v;
+    {
+      void *ptr;
+      if (SWIG_isptrtype(L,argv[0])==0 || SWIG_ConvertPtr(L,argv[0], (void **) &ptr, SWIGTYPE_p_gsSpatialQuery, 0)) {
+        _v = 0;
+      } else {
+        _v = 1;
+      }
+    }
+    if (_v) {
+      {
+        void *ptr;
+        if (lua_isuserdata(L,argv[1])==0 || SWIG_ConvertPtr(L,argv[1], (void **) &ptr, SWIGTYPE_p_gsVector3, 0)) {
+          _v = 0;
+        } else {
+          _v = 1;
+        }
+      }
+      if (_v) {
+        {
+          _v = lua_isnumber(L,argv[2]);
+        }
+        if (_v) {
+          {
+            _v = lua_isnumber(L,argv[3]);
+          }
+          if (_v) {
+            return _wrap_SpatialQuery_addNearest__SWIG_1(L);
+          }
+        }
+      }
+    }
+  }
+  if (argc == 5) {
+    int _v;
+    {
+      void *ptr;
+      if (SWIG_isptrtype(L,argv[0])==0 || SWIG_ConvertPtr(L,argv[0], (void **) &ptr, SWIGTYPE_p_gsSpatialQuery, 0)) {
+        _v = 0;
+      } else {
+        _v = 1;
+      }
+    }
+    if (_v) {
+      {
+        void *ptr;
+        if (lua_isuserdata(L,argv[1])==0 || SWIG_ConvertPtr(L,argv[1], (void **) &ptr, SWIGTYPE_p_gsVector3, 0)) {
+          _v = 0;
+        } else {
+          _v = 1;
+        }
+      }
+      if (_v) {
+        {
+          _v = lua_isnumber(L,argv[2]);
+        }
+        if (_v) {
+          {
+            _v = lua_isnumber(L,argv[3]);
+          }
+          if (_v) {
+            {
+              _v = lua_isnumber(L,argv[4]);
+            }
+            if (_v) {
+              return _wrap_SpatialQuery_addNearest__SWIG_0(L);
+            }
+          }
+        }
+      }
+    }
+  }
+  
+  lua_pushstring(L,"Wrong arguments for overloaded function 'SpatialQuery_addNearest'\n"
+    "  Possible C/C++ prototypes are:\n"
+    "    gsSpatialQuery::addNearest(gsVector3 const &,int,float,int)\n"
+    "    gsSpatialQuery::addNearest(gsVector3 const &,int,float)\n");
+  lua_error(L);return 0;
+}
+
+
+static int _wrap_SpatialQuery_addSweep__SWIG_0(lua_State* L) {
+  int SWIG_arg = 0;
+  gsSpatialQuery *arg1 = (gsSpatialQuery *) 0 ;
+  gsVector3 *arg2 = 0 ;
+  gsVector3 *arg3 = 0 ;
+  float arg4 ;
+  int arg5 ;
+  int result;
+  
+  SWIG_check_num_args("gsSpatialQuery::addSweep",5,5)
+  if(!SWIG_isptrtype(L,1)) SWIG_fail_arg("gsSpatialQuery::addSweep",1,"gsSpatialQuery *");
+  if(!lua_isuserdata(L,2)) SWIG_fail_arg("gsSpatialQuery::addSweep",2,"gsVector3 const &");
+  if(!lua_isuserdata(L,3)) SWIG_fail_arg("gsSpatialQuery::addSweep",3,"gsVector3 const &");
+  if(!lua_isnumber(L,4)) SWIG_fail_arg("gsSpatialQuery::addSweep",4,"float");
+  if(!lua_isnumber(L,5)) SWIG_fail_arg("gsSpatialQuery::addSweep",5,"int");
+  
+  if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&arg1,SWIGTYPE_p_gsSpatialQuery,0))){
+    SWIG_fail_ptr("SpatialQuery_addSweep",1,SWIGTYPE_p_gsSpatialQuery);
+  }
+  
+  
+  if (!SWIG_IsOK(SWIG_ConvertPtr(L,2,(void**)&arg2,SWIGTYPE_p_gsVector3,0))){
+    SWIG_fail_ptr("SpatialQuery_addSweep",2,SWIGTYPE_p_gsVector3);
+  }
+  
+  
+  if (!SWIG_IsOK(SWIG_ConvertPtr(L,3,(void**)&arg3,SWIGTYPE_p_gsVector3,0))){
+    SWIG_fail_ptr("SpatialQuery_addSweep",3,SWIGTYPE_p_gsVector3);
+  }
+  
+  arg4 = (float)lua_tonumber(L, 4);
+  arg5 = (int)lua_tonumber(L, 5);
+  result = (int)(arg1)->addSweep((gsVector3 const &)*arg2,(gsVector3 const &)*arg3,arg4,arg5);
+  lua_pushnumber(L, (lua_Number) result); SWIG_arg++;
+  return SWIG_arg;
+  
+  if(0) SWIG_fail;
+  
+fail:
+  lua_error(L);
+  return SWIG_arg;
+}
+
+
+static int _wrap_SpatialQuery_addSweep__SWIG_1(lua_State* L) {
+  int SWIG_arg = 0;
+  gsSpatialQuery *arg1 = (gsSpatialQuery *) 0 ;
+  gsVector3 *arg2 = 0 ;
+  gsVector3 *arg3 = 0 ;
+  float arg4 ;
+  int result;
+  
+  SWIG_check_num_args("gsSpatialQuery::addSweep",4,4)
+  if(!SWIG_isptrtype(L,1)) SWIG_fail_arg("gsSpatialQuery::addSweep",1,"gsSpatialQuery *");
+  if(!lua_isuserdata(L,2)) SWIG_fail_arg("gsSpatialQuery::addSweep",2,"gsVector3 const &");
+  if(!lua_isuserdata(L,3)) SWIG_fail_arg("gsSpatialQuery::addSweep",3,"gsVector3 const &");
+  if(!lua_isnumber(L,4)) SWIG_fail_arg("gsSpatialQuery::addSweep",4,"float");
+  
+  if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&arg1,SWIGTYPE_p_gsSpatialQuery,0))){
+    SWIG_fail_ptr("SpatialQuery_addSweep",1,SWIGTYPE_p_gsSpatialQuery);
+  }
+  
+  
+  if (!SWIG_IsOK(SWIG_ConvertPtr(L,2,(void**)&arg2,SWIGTYPE_p_gsVector3,0))){
+    SWIG_fail_ptr("SpatialQuery_addSweep",2,SWIGTYPE_p_gsVector3);
+  }
+  
+  
+  if (!SWIG_IsOK(SWIG_ConvertPtr(L,3,(void**)&arg3,SWIGTYPE_p_gsVector3,0))){
+    SWIG_fail_ptr("SpatialQuery_addSweep",3,SWIGTYPE_p_gsVector3);
+  }
+  
+  arg4 = (float)lua_tonumber(L, 4);
+  result = (int)(arg1)->addSweep((gsVector3 const &)*arg2,(gsVector3 const &)*arg3,arg4);
+  lua_pushnumber(L, (lua_Number) result); SWIG_arg++;
+  return SWIG_arg;
+  
+  if(0) SWIG_fail;
+  
+fail:
+  lua_error(L);
+  return SWIG_arg;
+}
+
+
+static int _wrap_SpatialQuery_addSweep(lua_State* L) {
+  int argc;
+  int argv[6]={
+    1,2,3,4,5,6
+  };
+  
+  argc = lua_gettop(L);
+  if (argc == 4) {
+    int _v;
+    {
+      void *ptr;
+      if (SWIG_isptrtype(L,argv[0])==0 || SWIG_ConvertPtr(L,argv[0], (void **) &ptr, SWIGTYPE_p_gsSpatialQuery, 0)) {
+        _v = 0;
+      } else {
+        _v = 1;
+      }
+    }
+    if (_v) {
+      {
+        void *ptr;
+        if (lua_isuserdata(L,argv[1])==0 || SWIG_ConvertPtr(L,argv[1], (void **) &ptr, SWIGTYPE_p_gsVector3, 0)) {
+          _v = 0;
+        } else {
+          _v = 1;
+        }
+      }
+      if (_v) {
+        {
+          void *ptr;
+          if (lua_isuserdata(L,argv[2])==0 || SWIG_ConvertPtr(L,argv[2], (void **) &ptr, SWIGTYPE_p_gsVector3, 0)) {
+            _v = 0;
+          } else {
+            _v = 1;
+          }
+        }
+        if (_v) {
+          {
+            _v = lua_isnumber(L,argv[3]);
+          }
+          if (_v) {
+            return _wrap_SpatialQuery_addSweep__SWIG_1(L);
+          }
+        }
+      }
+    }
+  }
+  if (argc == 5) {
+    int _v;
+    {
+      void *ptr;
+      if (SWIG_isptrtype(L,argv[0])==0 || SWIG_ConvertPtr(L,argv[0], (void **) &ptr, SWIGTYPE_p_gsSpatialQuery, 0)) {
+        _v = 0;
+      } else {
+        _v = 1;
+      }
+    }
+    if (_v) {
+      {
+        void *ptr;
+        if (lua_isuserdata(L,argv[1])==0 || SWIG_ConvertPtr(L,argv[1], (void **) &ptr, SWIGTYPE_p_gsVector3, 0)) {
+          _v = 0;
+        } else {
+          _v = 1;
+        }
+      }
+      if (_v) {
+        {
+          void *ptr;
+          if (lua_isuserdata(L,argv[2])==0 || SWIG_ConvertPtr(L,argv[2], (void **) &ptr, SWIGTYPE_p_gsVector3, 0)) {
+            _v = 0;
+          } else {
+            _v = 1;
+          }
+        }
+        if (_v) {
+          {
+            _v = lua_isnumber(L,argv[3]);
+          }
+          if (_v) {
+            {
+              _v = lua_isnumber(L,argv[4]);
+            }
+            if (_v) {
+              return _wrap_SpatialQuery_addSweep__SWIG_0(L);
+            }
+          }
+        }
+      }
+    }
+  }
+  
+  lua_pushstring(L,"Wrong arguments for overloaded function 'SpatialQuery_addSweep'\n"
+    "  Possible C/C++ prototypes are:\n"
+    "    gsSpatialQuery::addSweep(gsVector3 const &,gsVector3 const &,float,int)\n"
+    "    gsSpatialQuery::addSweep(gsVector3 const &,gsVector3 const &,float)\n");
+  lua_error(L);return 0;
+}
+
+
+static int _wrap_SpatialQuery_clear(lua_State* L) {
+  int SWIG_arg = 0;
+  gsSpatialQuery *arg1 = (gsSpatialQuery *) 0 ;
+  
+  SWIG_check_num_args("gsSpatialQuery::clear",1,1)
+  if(!SWIG_isptrtype(L,1)) SWIG_fail_arg("gsSpatialQuery::clear",1,"gsSpatialQuery *");
+  
+  if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&arg1,SWIGTYPE_p_gsSpatialQuery,0))){
+    SWIG_fail_ptr("SpatialQuery_clear",1,SWIGTYPE_p_gsSpatialQuery);
+  }
+  
+  (arg1)->clear();
+  
+  return SWIG_arg;
+  
+  if(0) SWIG_fail;
+  
+fail:
+  lua_error(L);
+  return SWIG_arg;
+}
+
+
+static int _wrap_SpatialQuery_getResultCount(lua_State* L) {
+  int SWIG_arg = 0;
+  gsSpatialQuery *arg1 = (gsSpatialQuery *) 0 ;
+  int arg2 ;
+  int result;
+  
+  SWIG_check_num_args("gsSpatialQuery::getResultCount",2,2)
+  if(!SWIG_isptrtype(L,1)) SWIG_fail_arg("gsSpatialQuery::getResultCount",1,"gsSpatialQuery *");
+  if(!lua_isnumber(L,2)) SWIG_fail_arg("gsSpatialQuery::getResultCount",2,"int");
+  
+  if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&arg1,SWIGTYPE_p_gsSpatialQuery,0))){
+    SWIG_fail_ptr("SpatialQuery_getResultCount",1,SWIGTYPE_p_gsSpatialQuery);
+  }
+  
+  arg2 = (int)lua_tonumber(L, 2);
+  result = (int)(arg1)->getResultCount(arg2);
+  lua_pushnumber(L, (lua_Number) result); SWIG_arg++;
+  return SWIG_arg;
+  
+  if(0) SWIG_fail;
+  
+fail:
+  lua_error(L);
+  return SWIG_arg;
+}
+
+
+static int _wrap_SpatialQuery_getObject(lua_State* L) {
+  int SWIG_arg = 0;
+  gsSpatialQuery *arg1 = (gsSpatialQuery *) 0 ;
+  int arg2 ;
+  int arg3 ;
+  gkGameObject *result = 0 ;
+  
+  SWIG_check_num_args("gsSpatialQuery::getObject",3,3)
+  if(!SWIG_isptrtype(L,1)) SWIG_fail_arg("gsSpatialQuery::getObject",1,"gsSpatialQuery *");
+  if(!lua_isnumber(L,2)) SWIG_fail_arg("gsSpatialQuery::getObject",2,"int");
+  if(!lua_isnumber(L,3)) SWIG_fail_arg("gsSpatialQuery::getObject",3,"int");
+  
+  if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&arg1,SWIGTYPE_p_gsSpatialQuery,0))){
+    SWIG_fail_ptr("SpatialQuery_getObject",1,SWIGTYPE_p_gsSpatialQuery);
+  }
+  
+  arg2 = (int)lua_tonumber(L, 2);
+  arg3 = (int)lua_tonumber(L, 3);
+  result = (gkGameObject *)(arg1)->getObject(arg2,arg3);
+  if (result) {
+    SWIG_arg += gsWrapGameObject(L, result); 
+  } 
+  return SWIG_arg;
+  
+  if(0) SWIG_fail;
+  
+fail:
+  lua_error(L);
+  return SWIG_arg;
+}
+
+
+static int _wrap_SpatialQuery_getDistance(lua_State* L) {
+  int SWIG_arg = 0;
+  gsSpatialQuery *arg1 = (gsSpatialQuery *) 0 ;
+  int arg2 ;
+  int arg3 ;
+  float result;
+  
+  SWIG_check_num_args("gsSpatialQuery::getDistance",3,3)
+  if(!SWIG_isptrtype(L,1)) SWIG_fail_arg("gsSpatialQuery::getDistance",1,"gsSpatialQuery *");
+  if(!lua_isnumber(L,2)) SWIG_fail_arg("gsSpatialQuery::getDistance",2,"int");
+  if(!lua_isnumber(L,3)) SWIG_fail_arg("gsSpatialQuery::getDistance",3,"int");
+  
+  if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&arg1,SWIGTYPE_p_gsSpatialQuery,0))){
+    SWIG_fail_ptr("SpatialQuery_getDistance",1,SWIGTYPE_p_gsSpatialQuery);
+  }
+  
+  arg2 = (int)lua_tonumber(L, 2);
+  arg3 = (int)lua_tonumber(L, 3);
+  result = (float)(arg1)->getDistance(arg2,arg3);
+  lua_pushnumber(L, (lua_Number) result); SWIG_arg++;
+  return SWIG_arg;
+  
+  if(0) SWIG_fail;
+  
+fail:
+  lua_error(L);
+  return SWIG_arg;
+}
+
+
+static int _wrap_SpatialQuery_getHitPoint(lua_State* L) {
+  int SWIG_arg = 0;
+  gsSpatialQuery *arg1 = (gsSpatialQuery *) 0 ;
+  int arg2 ;
+  int arg3 ;
+  gsVector3 result;
+  
+  SWIG_check_num_args("gsSpatialQuery::getHitPoint",3,3)
+  if(!SWIG_isptrtype(L,1)) SWIG_fail_arg("gsSpatialQuery::getHitPoint",1,"gsSpatialQuery *");
+  if(!lua_isnumber(L,2)) SWIG_fail_arg("gsSpatialQuery::getHitPoint",2,"int");
+  if(!lua_isnumber(L,3)) SWIG_fail_arg("gsSpatialQuery::getHitPoint",3,"int");
+  
+  if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&arg1,SWIGTYPE_p_gsSpatialQuery,0))){
+    SWIG_fail_ptr("SpatialQuery_getHitPoint",1,SWIGTYPE_p_gsSpatialQuery);
+  }
+  
+  arg2 = (int)lua_tonumber(L, 2);
+  arg3 = (int)lua_tonumber(L, 3);
+  result = (arg1)->getHitPoint(arg2,arg3);
+  {
+    gsVector3 * resultptr = new gsVector3((const gsVector3 &) result);
+    SWIG_NewPointerObj(L,(void *) resultptr,SWIGTYPE_p_gsVector3,1); SWIG_arg++;
+  }
+  return SWIG_arg;
+  
+  if(0) SWIG_fail;
+  
+fail:
+  lua_error(L);
+  return SWIG_arg;
+}
+
+
+static int _wrap_SpatialQuery_getHitNormal(lua_State* L) {
+  int SWIG_arg = 0;
+  gsSpatialQuery *arg1 = (gsSpatialQuery *) 0 ;
+  int arg2 ;
+  int arg3 ;
+  gsVector3 result;
+  
+  SWIG_check_num_args("gsSpatialQuery::getHitNormal",3,3)
+  if(!SWIG_isptrtype(L,1)) SWIG_fail_arg("gsSpatialQuery::getHitNormal",1,"gsSpatialQuery *");
+  if(!lua_isnumber(L,2)) SWIG_fail_arg("gsSpatialQuery::getHitNormal",2,"int");
+  if(!lua_isnumber(L,3)) SWIG_fail_arg("gsSpatialQuery::getHitNormal",3,"int");
+  
+  if (!SWIG_IsOK(SWIG_ConvertPtr(L,1,(void**)&arg1,SWIGTYPE_p_gsSpatialQuery,0))){
+    SWIG_fail_ptr("SpatialQuery_getHitNormal",1,SWIGTYPE_p_gsSpatialQuery);
+  }
+  
+  arg2 = (int)lua_tonumber(L, 2);
+  arg3 = (int)lua_tonumber(L, 3);
+  result = (arg1)->getHitNormal(arg2,arg3);
+  {
+    gsVector3 * resultptr = new gsVector3((const gsVector3 &) result);
+    SWIG_NewPointerObj(L,(void *) resultptr,SWIGTYPE_p_gsVector3,1); SWIG_arg++;
+  }
+  return SWIG_arg;
+  
+  if(0) SWIG_fail;
+  
+fail:
+  lua_error(L);
+  return SWIG_arg;
+}
+
+
+static void swig_delete_SpatialQuery(void *obj) {
+gsSpatialQuery *arg1 = (gsSpatialQuery *) obj;
+delete arg1;
+}
+static swig_lua_method swig_gsSpatialQuery_methods[] = {
+    {"addSphere", _wrap_SpatialQuery_addSphere}, 
+    {"addBox", _wrap_SpatialQuery_addBox}, 
+    {"addNearest", _wrap_SpatialQuery_addNearest}, 
+    {"addSweep", _wrap_SpatialQuery_addSweep}, 
+    {"clear", _wrap_SpatialQuery_clear}, 
+    {"getResultCount", _wrap_SpatialQuery_getResultCount}, 
+    {"getObject", _wrap_SpatialQuery_getObject}, 
+    {"getDistance", _wrap_SpatialQuery_getDistance}, 
+    {"getHitPoint", _wrap_SpatialQuery_getHitPoint}, 
+    {"getHitNormal", _wrap_SpatialQuery_getHitNormal}, 
+    {0,0}
+};
+static swig_lua_attribute swig_gsSpatialQuery_attributes[] = {
+    {0,0,0}
+};
+static swig_lua_class *swig_gsSpatialQuery_bases[] = {0};
+static const char *swig_gsSpatialQuery_base_names[] = {0};
+static swig_lua_class _wrap_class_gsSpatialQuery = { "SpatialQuery", &SWIGTYPE_p_gsSpatialQuery,_wrap_new_SpatialQuery, swig_delete_SpatialQuery, swig_gsSpatialQuery_methods, swig_gsSpatialQuery_attributes, swig_gsSpatialQuery_bases, swig_gsSpatialQuery_base_names };
+
 static int _wrap_new_RayTest__SWIG_0(lua_State* L) {
   int SWIG_arg = 0;
   gsScene *arg1 = (gsScene *) 0 ;
@@ -45075,6 +46120,7 @@ static swig_type_info _swigt__p_gsArrayT_gsGameObject_gkGameObject_t = {"_p_gsAr
 static swig_type_info _swigt__p_gsArrayT_gsLogicObject_gkLogicLink_t = {"_p_gsArrayT_gsLogicObject_gkLogicLink_t", "gsArray< gsLogicObject,gkLogicLink > *", 0, 0, (void*)&_wrap_class_gsArray_Sl_gsLogicObject_Sc_gkLogicLink_Sg_, 0};
 static swig_type_info _swigt__p_gsArrayT_gsProcess_gkProcess_t = {"_p_gsArrayT_gsProcess_gkProcess_t", "gsArray< gsProcess,gkProcess > *", 0, 0, (void*)&_wrap_class_gsArray_Sl_gsProcess_Sc_gkProcess_Sg_, 0};
 static swig_type_info _swigt__p_gsArrayT_gsSensor_gkLogicSensor_t = {"_p_gsArrayT_gsSensor_gkLogicSensor_t", "gsArray< gsSensor,gkLogicSensor > *", 0, 0, (void*)&_wrap_class_gsArray_Sl_gsSensor_Sc_gkLogicSensor_Sg_, 0};
+static swig_type_info _swigt__p_gsBlendLoad = {"_p_gsBlendLoad", "gsBlendLoad *", 0, 0, (void*)&_wrap_class_gsBlendLoad, 0};
 static swig_type_info _swigt__p_gsBrick = {"_p_gsBrick", "gsBrick *", 0, 0, (void*)&_wrap_class_gsBrick, 0};
 static swig_type_info _swigt__p_gsCamera = {"_p_gsCamera", "gsCamera *", 0, 0, (void*)&_wrap_class_gsCamera, 0};
 static swig_type_info _swigt__p_gsCharacter = {"_p_gsCharacter", "gsCharacter *", 0, 0, (void*)&_wrap_class_gsCharacter, 0};
@@ -45131,6 +46177,7 @@ static swig_type_info _swigt__p_gsScriptController = {"_p_gsScriptController", "
 static swig_type_info _swigt__p_gsSensor = {"_p_gsSensor", "gsSensor *", 0, 0, (void*)&_wrap_class_gsSensor, 0};
 static swig_type_info _swigt__p_gsSkeleton = {"_p_gsSkeleton", "gsSkeleton *", 0, 0, (void*)&_wrap_class_gsSkeleton, 0};
 static swig_type_info _swigt__p_gsSoundActuator = {"_p_gsSoundActuator", "gsSoundActuator *", 0, 0, (void*)&_wrap_class_gsSoundActuator, 0};
+static swig_type_info _swigt__p_gsSpatialQuery = {"_p_gsSpatialQuery", "gsSpatialQuery *", 0, 0, (void*)&_wrap_class_gsSpatialQuery, 0};
 static swig_type_info _swigt__p_gsStateActuator = {"_p_gsStateActuator", "gsStateActuator *", 0, 0, (void*)&_wrap_class_gsStateActuator, 0};
 static swig_type_info _swigt__p_gsSubMesh = {"_p_gsSubMesh", "gsSubMesh *", 0, 0, (void*)&_wrap_class_gsSubMesh, 0};
 static swig_type_info _swigt__p_gsSweptTest = {"_p_gsSweptTest", "gsSweptTest *", 0, 0, (void*)&_wrap_class_gsSweptTest, 0};
@@ -45205,6 +46252,7 @@ static swig_type_info *swig_type_initial[] = {
   &_swigt__p_gsArrayT_gsLogicObject_gkLogicLink_t,
   &_swigt__p_gsArrayT_gsProcess_gkProcess_t,
   &_swigt__p_gsArrayT_gsSensor_gkLogicSensor_t,
+  &_swigt__p_gsBlendLoad,
   &_swigt__p_gsBrick,
   &_swigt__p_gsCamera,
   &_swigt__p_gsCharacter,
@@ -45261,6 +46309,7 @@ static swig_type_info *swig_type_initial[] = {
   &_swigt__p_gsSensor,
   &_swigt__p_gsSkeleton,
   &_swigt__p_gsSoundActuator,
+  &_swigt__p_gsSpatialQuery,
   &_swigt__p_gsStateActuator,
   &_swigt__p_gsSubMesh,
   &_swigt__p_gsSweptTest,
@@ -45335,6 +46384,7 @@ static swig_cast_info _swigc__p_gsArrayT_gsGameObject_gkGameObject_t[] = {  {&_s
 static swig_cast_info _swigc__p_gsArrayT_gsLogicObject_gkLogicLink_t[] = {  {&_swigt__p_gsArrayT_gsLogicObject_gkLogicLink_t, 0, 0, 0},{0, 0, 0, 0}};
 static swig_cast_info _swigc__p_gsArrayT_gsProcess_gkProcess_t[] = {  {&_swigt__p_gsArrayT_gsProcess_gkProcess_t, 0, 0, 0},{0, 0, 0, 0}};
 static swig_cast_info _swigc__p_gsArrayT_gsSensor_gkLogicSensor_t[] = {  {&_swigt__p_gsArrayT_gsSensor_gkLogicSensor_t, 0, 0, 0},{0, 0, 0, 0}};
+static swig_cast_info _swigc__p_gsBlendLoad[] = {  {&_swigt__p_gsBlendLoad, 0, 0, 0},{0, 0, 0, 0}};
 static swig_cast_info _swigc__p_gsBrick[] = {  {&_swigt__p_gsAlwaysSensor, _p_gsAlwaysSensorTo_p_gsBrick, 0, 0},  {&_swigt__p_gsDelaySensor, _p_gsDelaySensorTo_p_gsBrick, 0, 0},  {&_swigt__p_gsMessageSensor, _p_gsMessageSensorTo_p_gsBrick, 0, 0},  {&_swigt__p_gsMouseSensor, _p_gsMouseSensorTo_p_gsBrick, 0, 0},  {&_swigt__p_gsPropertySensor, _p_gsPropertySensorTo_p_gsBrick, 0, 0},  {&_swigt__p_gsRaySensor, _p_gsRaySensorTo_p_gsBrick, 0, 0},  {&_swigt__p_gsRandomSensor, _p_gsRandomSensorTo_p_gsBrick, 0, 0},  {&_swigt__p_gsSensor, _p_gsSensorTo_p_gsBrick, 0, 0},  {&_swigt__p_gsBrick, 0, 0, 0},  {&_swigt__p_gsCollisionSensor, _p_gsCollisionSensorTo_p_gsBrick, 0, 0},  {&_swigt__p_gsTouchSensor, _p_gsTouchSensorTo_p_gsBrick, 0, 0},  {&_swigt__p_gsKeyboardSensor, _p_gsKeyboardSensorTo_p_gsBrick, 0, 0},  {&_swigt__p_gsNearSensor, _p_gsNearSensorTo_p_gsBrick, 0, 0},  {&_swigt__p_gsRadarSensor, _p_gsRadarSensorTo_p_gsBrick, 0, 0},  {&_swigt__p_gsActuatorSensor, _p_gsActuatorSensorTo_p_gsBrick, 0, 0},  {&_swigt__p_gsController, _p_gsControllerTo_p_gsBrick, 0, 0},  {&_swigt__p_gsLogicOpController, _p_gsLogicOpControllerTo_p_gsBrick, 0, 0},  {&_swigt__p_gsExpressionController, _p_gsExpressionControllerTo_p_gsBrick, 0, 0},  {&_swigt__p_gsScriptController, _p_gsScriptControllerTo_p_gsBrick, 0, 0},  {&_swigt__p_gsActuator, _p_gsActuatorTo_p_gsBrick, 0, 0},  {&_swigt__p_gsActionActuator, _p_gsActionActuatorTo_p_gsBrick, 0, 0},  {&_swigt__p_gsEditObjectActuator, _p_gsEditObjectActuatorTo_p_gsBrick, 0, 0},  {&_swigt__p_gsGameActuator, _p_gsGameActuatorTo_p_gsBrick, 0, 0},  {&_swigt__p_gsMessageActuator, _p_gsMessageActuatorTo_p_gsBrick, 0, 0},  {&_swigt__p_gsMotionActuator, _p_gsMotionActuatorTo_p_gsBrick, 0, 0},  {&_swigt__p_gsParentActuator, _p_gsParentActuatorTo_p_gsBrick, 0, 0},  {&_swigt__p_gsPropertyActuator, _p_gsPropertyActuatorTo_p_gsBrick, 0, 0},  {&_swigt__p_gsRandomActuator, _p_gsRandomActuatorTo_p_gsBrick, 0, 0},  {&_swigt__p_gsSceneActuator, _p_gsSceneActuatorTo_p_gsBrick, 0, 0},  {&_swigt__p_gsSoundActuator, _p_gsSoundActuatorTo_p_gsBrick, 0, 0},  {&_swigt__p_gsStateActuator, _p_gsStateActuatorTo_p_gsBrick, 0, 0},  {&_swigt__p_gsVisibilityActuator, _p_gsVisibilityActuatorTo_p_gsBrick, 0, 0},{0, 0, 0, 0}};
 static swig_cast_info _swigc__p_gsCamera[] = {  {&_swigt__p_gsCamera, 0, 0, 0},{0, 0, 0, 0}};
 static swig_cast_info _swigc__p_gsCharacter[] = {  {&_swigt__p_gsCharacter, 0, 0, 0},{0, 0, 0, 0}};
@@ -45391,6 +46441,7 @@ static swig_cast_info _swigc__p_gsScriptController[] = {  {&_swigt__p_gsScriptCo
 static swig_cast_info _swigc__p_gsSensor[] = {  {&_swigt__p_gsAlwaysSensor, _p_gsAlwaysSensorTo_p_gsSensor, 0, 0},  {&_swigt__p_gsDelaySensor, _p_gsDelaySensorTo_p_gsSensor, 0, 0},  {&_swigt__p_gsMessageSensor, _p_gsMessageSensorTo_p_gsSensor, 0, 0},  {&_swigt__p_gsMouseSensor, _p_gsMouseSensorTo_p_gsSensor, 0, 0},  {&_swigt__p_gsPropertySensor, _p_gsPropertySensorTo_p_gsSensor, 0, 0},  {&_swigt__p_gsRaySensor, _p_gsRaySensorTo_p_gsSensor, 0, 0},  {&_swigt__p_gsRandomSensor, _p_gsRandomSensorTo_p_gsSensor, 0, 0},  {&_swigt__p_gsSensor, 0, 0, 0},  {&_swigt__p_gsActuatorSensor, _p_gsActuatorSensorTo_p_gsSensor, 0, 0},  {&_swigt__p_gsCollisionSensor, _p_gsCollisionSensorTo_p_gsSensor, 0, 0},  {&_swigt__p_gsTouchSensor, _p_gsTouchSensorTo_p_gsSensor, 0, 0},  {&_swigt__p_gsKeyboardSensor, _p_gsKeyboardSensorTo_p_gsSensor, 0, 0},  {&_swigt__p_gsNearSensor, _p_gsNearSensorTo_p_gsSensor, 0, 0},  {&_swigt__p_gsRadarSensor, _p_gsRadarSensorTo_p_gsSensor, 0, 0},{0, 0, 0, 0}};
 static swig_cast_info _swigc__p_gsSkeleton[] = {  {&_swigt__p_gsSkeleton, 0, 0, 0},{0, 0, 0, 0}};
 static swig_cast_info _swigc__p_gsSoundActuator[] = {  {&_swigt__p_gsSoundActuator, 0, 0, 0},{0, 0, 0, 0}};
+static swig_cast_info _swigc__p_gsSpatialQuery[] = {  {&_swigt__p_gsSpatialQuery, 0, 0, 0},{0, 0, 0, 0}};
 static swig_cast_info _swigc__p_gsStateActuator[] = {  {&_swigt__p_gsStateActuator, 0, 0, 0},{0, 0, 0, 0}};
 static swig_cast_info _swigc__p_gsSubMesh[] = {  {&_swigt__p_gsSubMesh, 0, 0, 0},{0, 0, 0, 0}};
 static swig_cast_info _swigc__p_gsSweptTest[] = {  {&_swigt__p_gsSweptTest, 0, 0, 0},{0, 0, 0, 0}};
@@ -45465,6 +46516,7 @@ static swig_cast_info *swig_cast_initial[] = {
   _swigc__p_gsArrayT_gsLogicObject_gkLogicLink_t,
   _swigc__p_gsArrayT_gsProcess_gkProcess_t,
   _swigc__p_gsArrayT_gsSensor_gkLogicSensor_t,
+  _swigc__p_gsBlendLoad,
   _swigc__p_gsBrick,
   _swigc__p_gsCamera,
   _swigc__p_gsCharacter,
@@ -45521,6 +46573,7 @@ static swig_cast_info *swig_cast_initial[] = {
   _swigc__p_gsSensor,
   _swigc__p_gsSkeleton,
   _swigc__p_gsSoundActuator,
+  _swigc__p_gsSpatialQuery,
   _swigc__p_gsStateActuator,
   _swigc__p_gsSubMesh,
   _swigc__p_gsSweptTest,
@@ -260,6 +260,7 @@ gsUserDefs::gsUserDefs(gkUserDefs* defs)
 	PROP_INSERT_B("debugPhysics",       debugPhysics);
 	PROP_INSERT_B("debugPhysicsAABB",   debugPhysicsAabb);
 	PROP_INSERT_B("usebulletDBVT",      useBulletDbvt);
+	PROP_INSERT_N("instancingBudget",   instancingBudget);
 	PROP_INSERT_B("showDebugProps",     showDebugProps);
 	PROP_INSERT_B("debugSounds",        debugSounds);
 	PROP_INSERT_B("enableShadows",      enableshadows);
@@ -301,6 +302,7 @@ void gsUserDefs::setValueEvent(gkVariable& v)
 		PROP_SET_B("debugPhysics",       debugPhysics);
 		PROP_SET_B("debugPhysicsAABB",   debugPhysicsAabb);
 		PROP_SET_B("usebulletDBVT",      useBulletDbvt);
+		PROP_SET_N("instancingBudget",   instancingBudget);
 		PROP_SET_B("showDebugProps",     showDebugProps);
 		PROP_SET_B("debugSounds",        debugSounds);
 		PROP_SET_B("enableShadows",      enableshadows);
@@ -666,6 +668,27 @@ gsUserDefs& gsEngine::getUserDefs(void)
 	return *m_defs;
 }
 
+// merges the main scene of gkb into the active one
+static gkScene* gsMergeBlendFile(gkEngine* engine, gkBlendFile* gkb)
+{
+	gkScene* scene = gkb->getMainScene();
+	gkScene* activeScene = engine->getActiveScene();
+
+	if (scene)
+	{
+		if (activeScene)
+			gkSceneManager::getSingleton().copyObjects(scene, activeScene);
+		else
+			activeScene = scene;
+
+		return activeScene;
+	}
+	else
+		gkLogMessage("gsEngine: no usable scenes found in blend.");
+
+	return 0;
+}
+
 gkScene* gsEngine::loadBlendFile(const gkString& name)
 {
 	if (m_engine) // && m_ctxOwner) // && !m_running
@@ -684,25 +707,76 @@ gkScene* gsEngine::loadBlendFile(const gkString& name)
 			return 0;
 		}
 		
-		gkScene* scene = gkb->getMainScene();
-		gkScene* activeScene = m_engine->getActiveScene();
+		return gsMergeBlendFile(m_engine, gkb);
+	}
 
-		if (scene)
+	return 0;
+}
+
+gsBlendLoad* gsEngine::loadBlendFileAsync(const gkString& name)
+{
+	if (m_engine)
+	{
+		if (!m_engine->isInitialized())
 		{
-			if (activeScene)
-				gkSceneManager::getSingleton().copyObjects(scene, activeScene);
-			else
-				activeScene = scene;
-		
-			return activeScene;
+			gkLogMessage("gsEngine: loadBlendFileAsync on uninitialized engine.");
+			return 0;
 		}
-		else
-			gkLogMessage("gsEngine: no usable scenes found in blend.");
+
+		int options = gkBlendLoader::LO_ONLY_ACTIVE_SCENE | gkBlendLoader::LO_CREATE_UNIQUE_GROUP;
+		return new gsBlendLoad(gkBlendLoader::getSingleton().loadFileAsync(gkUtils::getFile(name), options));
 	}
 
 	return 0;
 }
 
+gsBlendLoad::gsBlendLoad(gkBlendLoader::AsyncLoad* load)
+	:	m_load(load),
+		m_scene(0),
+		m_merged(false)
+{
+}
+
+gsBlendLoad::~gsBlendLoad()
+{
+	if (m_load && gkBlendLoader::getSingletonPtr())
+		gkBlendLoader::getSingleton().releaseLoad(m_load);
+}
+
+bool gsBlendLoad::isDone(void)
+{
+	return !m_load || m_load->isDone();
+}
+
+gkScene* gsBlendLoad::getScene(void)
+{
+	if (!m_load || !m_load->isDone())
+		return 0;
+
+	if (!m_merged)
+	{
+		m_merged = true;
+
+		gkBlendFile* gkb = m_load->getFile();
+		if (!gkb)
+		{
+			gkLogMessage("gsBlendLoad: File Loading failed!\n");
+		}
+		else if (gkEngine::getSingletonPtr())
+			m_scene = gsMergeBlendFile(gkEngine::getSingletonPtr(), gkb);
+	}
+
+	return m_scene;
+}
+
+gkScene* gsBlendLoad::finish(void)
+{
+	if (m_load && gkBlendLoader::getSingletonPtr())
+		gkBlendLoader::getSingleton().finishLoad(m_load);
+
+	return getScene();
+}
+
 void gsEngine::unloadBlendFile(const gkString& name)
 {
 	if (m_engine) // && m_ctxOwner)
@@ -2399,7 +2473,11 @@ gkGameObjectInstance* createGroupInstance(gkScene* scene,gkString groupName,gsVe
 			inst->getRoot()->getProperties().m_transform =  gkTransformState(pos, quat, scl);
 			bool b = inst->isInstanced();
 			if (!b){
-				inst->createInstance(false);
+				// large groups are spread over frames within the instancing budget
+				if (scene->getInstancingBudget() > 0)
+					inst->queueInstance(gkGameObjectManager::getSingletonPtr());
+				else
+					inst->createInstance(false);
 			}
 
 			return inst;
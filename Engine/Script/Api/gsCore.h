@@ -724,6 +724,62 @@ public:
 
 
 
+class gsBlendLoad
+{
+private:
+	gkBlendLoader::AsyncLoad* m_load;
+	gkScene* m_scene;
+	bool m_merged;
+
+public:
+
+#ifndef SWIG
+	gsBlendLoad(gkBlendLoader::AsyncLoad* load);
+#endif
+	~gsBlendLoad();
+
+	/**
+		\LuaMethod{BlendLoad,isDone}
+
+		Returns true once the file is loaded or has failed to load.
+
+		\code
+		function BlendLoad:isDone()
+		\endcode
+
+		\returns bool
+	*/
+	bool isDone(void);
+
+	/**
+		\LuaMethod{BlendLoad,getScene}
+
+		Returns the active scene like \LuaMethodRef{Engine,loadBlendFile} does, nil while loading.
+
+		\code
+		function BlendLoad:getScene()
+		\endcode
+
+		\returns \LuaClassRef{Scene}
+	*/
+	gkScene* getScene(void);
+
+	/**
+		\LuaMethod{BlendLoad,finish}
+
+		Waits for the file and returns its scene right away.
+
+		\code
+		function BlendLoad:finish()
+		\endcode
+
+		\returns \LuaClassRef{Scene}
+	*/
+	gkScene* finish(void);
+};
+
+
+
 class gsEngine
 #ifndef SWIG
 	: public gkEngine::Listener
@@ -843,6 +899,20 @@ public:
 		\note The returned scene is \b not loaded.
 	*/
 	gkScene* loadBlendFile(const gkString& name);
+	/**
+		\LuaMethod{Engine,loadBlendFileAsync}
+
+		Loads the .blend in the background, poll the returned load
+		or wait for it with finish.
+
+		\code
+		function Engine:loadBlendFileAsync(name)
+		\endcode
+
+		\param name Path to the blend file.
+		\returns \LuaClassRef{BlendLoad}
+	*/
+	gsBlendLoad* loadBlendFileAsync(const gkString& name);
 	/**
 		\LuaMethod{Engine,getActiveScene}
 
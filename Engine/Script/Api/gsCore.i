@@ -74,6 +74,9 @@ struct gkTriangle
 %newobject getHUD;
 %newobject gsHUD::getChild;
 %newobject gsEngine::loadBlendFile;
+%newobject gsEngine::loadBlendFileAsync;
+%newobject gsBlendLoad::getScene;
+%newobject gsBlendLoad::finish;
 %newobject gsGameObject::getEntity;
 %newobject gsGameObject::getLight;
 %newobject gsGameObject::getCamera;
@@ -95,6 +98,7 @@ struct gkTriangle
 
 
 // Classes
+GS_SCRIPT_NAME(BlendLoad)
 GS_SCRIPT_NAME(Camera)
 GS_SCRIPT_NAME(Debugger)
 GS_SCRIPT_NAME(Engine)
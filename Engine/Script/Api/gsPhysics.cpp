@@ -41,6 +41,94 @@ void gsDynamicsWorld::exportBullet(const gkString& fileName)
 	m_world->exportBullet(fileName);
 }
 
+void gsDynamicsWorld::query(gsSpatialQuery& batch)
+{
+	m_world->query(batch.getBatch());
+}
+
+
+
+gsSpatialQuery::gsSpatialQuery()
+{
+}
+
+
+gsSpatialQuery::~gsSpatialQuery()
+{
+}
+
+
+int gsSpatialQuery::addSphere(const gsVector3& center, float radius, int mask)
+{
+	return m_batch.addSphere(center, radius, (short)mask);
+}
+
+
+int gsSpatialQuery::addBox(const gsVector3& min, const gsVector3& max, int mask)
+{
+	return m_batch.addAabb(min, max, (short)mask);
+}
+
+
+int gsSpatialQuery::addNearest(const gsVector3& center, int count, float maxDistance, int mask)
+{
+	return m_batch.addNearest(center, count, maxDistance, (short)mask);
+}
+
+
+int gsSpatialQuery::addSweep(const gsVector3& from, const gsVector3& to, float radius, int mask)
+{
+	return m_batch.addSweep(from, to, radius, (short)mask);
+}
+
+
+void gsSpatialQuery::clear(void)
+{
+	m_batch.clear();
+}
+
+
+int gsSpatialQuery::getResultCount(int query)
+{
+	return m_batch.hasResults(query) ? m_batch.getResultCount(query) : 0;
+}
+
+
+const gkSpatialQuery::Result* gsSpatialQuery::getResult(int query, int index)
+{
+	if (index < 0 || index >= getResultCount(query))
+		return 0;
+	return &m_batch.getResult(query, index);
+}
+
+
+gkGameObject* gsSpatialQuery::getObject(int query, int index)
+{
+	const gkSpatialQuery::Result* res = getResult(query, index);
+	return res ? res->m_object->getObject() : 0;
+}
+
+
+float gsSpatialQuery::getDistance(int query, int index)
+{
+	const gkSpatialQuery::Result* res = getResult(query, index);
+	return res ? res->m_distance : 0.f;
+}
+
+
+gsVector3 gsSpatialQuery::getHitPoint(int query, int index)
+{
+	const gkSpatialQuery::Result* res = getResult(query, index);
+	return res ? res->m_point : gkVector3::ZERO;
+}
+
+
+gsVector3 gsSpatialQuery::getHitNormal(int query, int index)
+{
+	const gkSpatialQuery::Result* res = getResult(query, index);
+	return res ? res->m_normal : gkVector3::ZERO;
+}
+
 gsRayTest::gsRayTest(gsScene* scene)
 {
 	if (scene)
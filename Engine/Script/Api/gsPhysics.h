@@ -37,6 +37,8 @@
 	@{
 */
 
+class gsSpatialQuery;
+
 class gsDynamicsWorld
 {
 private:
@@ -50,6 +52,193 @@ public:
 	/**
 	*/
 	void exportBullet(const gkString& fileName);
+
+	/**
+		\LuaMethod{DynamicsWorld,query}
+
+		Runs every query of the batch, results are read back from the batch.
+
+		\code
+		function DynamicsWorld:query(batch)
+		\endcode
+
+		\param batch \LuaClassRef{SpatialQuery}
+	*/
+	void query(gsSpatialQuery& batch);
+};
+
+
+class gsSpatialQuery
+{
+private:
+	gkSpatialQuery m_batch;
+
+	const gkSpatialQuery::Result* getResult(int query, int index);
+
+public:
+	/**
+		\LuaMethod{SpatialQuery,constructor}
+
+		Construct an empty batch. Keep it across frames and clear it
+		before adding the queries of the next frame.
+
+		\code
+		function SpatialQuery:constructor()
+		\endcode
+	*/
+	gsSpatialQuery();
+	~gsSpatialQuery();
+
+	/**
+		\LuaMethod{SpatialQuery,addSphere}
+
+		Objects whose bounding box is within radius of center.
+
+		\code
+		function SpatialQuery:addSphere(center, radius, mask)
+		\endcode
+
+		\param center \LuaClassRef{Vector3}
+		\param radius Sphere radius.
+		\param mask Collision groups to report (optional, all by default).
+		\returns number Index of the query.
+	*/
+	int addSphere(const gsVector3& center, float radius, int mask = -1);
+
+	/**
+		\LuaMethod{SpatialQuery,addBox}
+
+		Objects whose bounding box overlaps the box.
+
+		\code
+		function SpatialQuery:addBox(min, max, mask)
+		\endcode
+
+		\param min \LuaClassRef{Vector3} lower corner.
+		\param max \LuaClassRef{Vector3} upper corner.
+		\param mask Collision groups to report (optional, all by default).
+		\returns number Index of the query.
+	*/
+	int addBox(const gsVector3& min, const gsVector3& max, int mask = -1);
+
+	/**
+		\LuaMethod{SpatialQuery,addNearest}
+
+		Up to count objects closest to center, nearest first.
+
+		\code
+		function SpatialQuery:addNearest(center, count, maxDistance, mask)
+		\endcode
+
+		\param center \LuaClassRef{Vector3}
+		\param count Maximum number of objects.
+		\param maxDistance Search radius.
+		\param mask Collision groups to report (optional, all by default).
+		\returns number Index of the query.
+	*/
+	int addNearest(const gsVector3& center, int count, float maxDistance, int mask = -1);
+
+	/**
+		\LuaMethod{SpatialQuery,addSweep}
+
+		First object hit by a sphere moved from one point to another.
+
+		\code
+		function SpatialQuery:addSweep(from, to, radius, mask)
+		\endcode
+
+		\param from \LuaClassRef{Vector3} start position.
+		\param to \LuaClassRef{Vector3} end position.
+		\param radius Radius of the sphere.
+		\param mask Collision groups to report (optional, all by default).
+		\returns number Index of the query.
+	*/
+	int addSweep(const gsVector3& from, const gsVector3& to, float radius, int mask = -1);
+
+	/**
+		\LuaMethod{SpatialQuery,clear}
+
+		Removes all queries and results.
+
+		\code
+		function SpatialQuery:clear()
+		\endcode
+	*/
+	void clear(void);
+
+	/**
+		\LuaMethod{SpatialQuery,getResultCount}
+
+		Returns the number of results of a query.
+
+		\code
+		function SpatialQuery:getResultCount(query)
+		\endcode
+
+		\param query Index returned by the add method.
+		\returns number
+	*/
+	int getResultCount(int query);
+
+	/**
+		\LuaMethod{SpatialQuery,getObject}
+
+		Returns a found object.
+
+		\code
+		function SpatialQuery:getObject(query, index)
+		\endcode
+
+		\param query Index returned by the add method.
+		\param index Result index, from 0 to getResultCount(query) - 1.
+		\returns \LuaClassRef{GameObject}
+	*/
+	gkGameObject* getObject(int query, int index);
+
+	/**
+		\LuaMethod{SpatialQuery,getDistance}
+
+		Returns the distance to a found object, along the path for sweeps.
+
+		\code
+		function SpatialQuery:getDistance(query, index)
+		\endcode
+
+		\param query Index returned by the add method.
+		\param index Result index.
+		\returns number
+	*/
+	float getDistance(int query, int index);
+
+	/**
+		\LuaMethod{SpatialQuery,getHitPoint}
+
+		Returns the hit point of a sweep.
+
+		\code
+		function SpatialQuery:getHitPoint(query, index)
+		\endcode
+
+		\returns \LuaClassRef{Vector3}
+	*/
+	gsVector3 getHitPoint(int query, int index);
+
+	/**
+		\LuaMethod{SpatialQuery,getHitNormal}
+
+		Returns the hit normal of a sweep.
+
+		\code
+		function SpatialQuery:getHitNormal(query, index)
+		\endcode
+
+		\returns \LuaClassRef{Vector3}
+	*/
+	gsVector3 getHitNormal(int query, int index);
+
+#ifndef SWIG
+	GK_INLINE gkSpatialQuery& getBatch(void) {return m_batch;}
+#endif
 };
 
 
@@ -32,10 +32,12 @@
 %newobject gsRayTest::getObject;
 %newobject gsSweptTest::getObject;
 %newobject gsCharacter::getObject;
+%newobject gsSpatialQuery::getObject;
 
 GS_SCRIPT_NAME(RayTest)
 GS_SCRIPT_NAME(SweptTest)
 GS_SCRIPT_NAME(DynamicsWorld)
+GS_SCRIPT_NAME(SpatialQuery)
 GS_SCRIPT_NAME(Character)    
 
 %include "gsPhysics.h"
@@ -0,0 +1,154 @@
+/*
+-------------------------------------------------------------------------------
+    This file is part of OgreKit.
+    http://gamekit.googlecode.com/
+
+    Copyright (c) 2006-2013 Charlie C.
+
+    Contributor(s): none yet.
+-------------------------------------------------------------------------------
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#include "gkJobPool.h"
+#include "gkMathUtils.h"
+
+
+
+gkJobPool::gkJobPool(int workers)
+	:    m_job(0),
+	     m_next(0),
+	     m_count(0),
+	     m_grain(1),
+	     m_busy(0),
+	     m_quit(false)
+{
+	for (int i = 0; i < workers; ++i)
+	{
+		Worker* worker = new Worker(this);
+		worker->m_thread = new gkThread(worker);
+		m_workers.push_back(worker);
+	}
+}
+
+
+
+gkJobPool::~gkJobPool()
+{
+	{
+		gkCriticalSection::Lock lock(m_cs);
+		m_quit = true;
+	}
+
+	UTsize i;
+	for (i = 0; i < m_workers.size(); ++i)
+		m_workers[i]->m_wake.signal();
+
+	for (i = 0; i < m_workers.size(); ++i)
+	{
+		Worker* worker = m_workers[i];
+		worker->m_thread->join();
+
+		delete worker->m_thread;
+		worker->release();
+	}
+}
+
+
+
+bool gkJobPool::fetch(int& begin, int& end)
+{
+	gkCriticalSection::Lock lock(m_cs);
+
+	if (m_next >= m_count)
+		return false;
+
+	begin = m_next;
+	end = gkMin(m_count, begin + m_grain);
+	m_next = end;
+	return true;
+}
+
+
+
+void gkJobPool::runChunks(void)
+{
+	int begin, end;
+	while (fetch(begin, end))
+		m_job->run(begin, end);
+}
+
+
+
+void gkJobPool::Worker::run()
+{
+	for (;;)
+	{
+		m_wake.wait();
+
+		if (m_pool->m_quit)
+			break;
+
+		m_pool->runChunks();
+
+		bool last;
+		{
+			gkCriticalSection::Lock lock(m_pool->m_cs);
+			last = --m_pool->m_busy == 0;
+		}
+
+		if (last)
+			m_pool->m_done.signal();
+	}
+}
+
+
+
+void gkJobPool::parallelFor(int count, int grain, Job* job)
+{
+	GK_ASSERT(job);
+
+	if (count <= 0)
+		return;
+
+	grain = gkMax(1, grain);
+
+	// not worth waking anyone
+	if (m_workers.empty() || count <= grain)
+	{
+		job->run(0, count);
+		return;
+	}
+
+	// only as many workers as there are chunks left for them
+	int chunks = (count + grain - 1) / grain;
+	int wake = gkMin<int>((int)m_workers.size(), chunks - 1);
+
+	m_job   = job;
+	m_next  = 0;
+	m_count = count;
+	m_grain = grain;
+	m_busy  = wake;
+
+	for (int i = 0; i < wake; ++i)
+		m_workers[i]->m_wake.signal();
+
+	runChunks();
+
+	m_done.wait();
+	m_job = 0;
+}
@@ -0,0 +1,90 @@
+/*
+-------------------------------------------------------------------------------
+    This file is part of OgreKit.
+    http://gamekit.googlecode.com/
+
+    Copyright (c) 2006-2013 Charlie C.
+
+    Contributor(s): none yet.
+-------------------------------------------------------------------------------
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#ifndef _gkJobPool_h_
+#define _gkJobPool_h_
+
+#include "gkCommon.h"
+#include "gkThread.h"
+#include "gkCriticalSection.h"
+#include "gkSyncObj.h"
+
+
+///Fixed set of worker threads running fork / join loops.
+///
+///parallelFor splits [0, count) into chunks of grain items; the workers and the
+///calling thread pull chunks until none are left, and the call returns once every
+///chunk has run. Loops are not reentrant, a job must not call parallelFor itself.
+class gkJobPool : gkNonCopyable
+{
+public:
+	class Job
+	{
+	public:
+		virtual ~Job() {}
+
+		///Processes items [begin, end), called from any thread.
+		virtual void run(int begin, int end) = 0;
+	};
+
+public:
+	gkJobPool(int workers);
+	~gkJobPool();
+
+	void parallelFor(int count, int grain, Job* job);
+
+	///Worker threads plus the calling thread.
+	GK_INLINE int getConcurrency(void) const {return (int)m_workers.size() + 1;}
+
+private:
+	class Worker : public gkCall
+	{
+	public:
+		Worker(gkJobPool* pool) : m_pool(pool), m_thread(0) {}
+
+		void run();
+
+		gkJobPool*  m_pool;
+		gkThread*   m_thread;
+		gkSyncObj   m_wake;
+	};
+
+	typedef utArray<Worker*> Workers;
+
+	bool fetch(int& begin, int& end);
+	void runChunks(void);
+
+	Workers             m_workers;
+	gkCriticalSection   m_cs;
+	gkSyncObj           m_done;
+
+	Job*                m_job;
+	int                 m_next, m_count, m_grain;
+	int                 m_busy;
+	bool                m_quit;
+};
+
+#endif//_gkJobPool_h_
@@ -49,6 +49,8 @@ void* gkThread::task(void* p)
 	gkThread* pThread = static_cast<gkThread*>(p);
 
 	pThread->run();
+
+	return 0;
 }
 #endif
 
@@ -0,0 +1,222 @@
+/*
+-------------------------------------------------------------------------------
+    This file is part of OgreKit.
+    http://gamekit.googlecode.com/
+
+    Copyright (c) 2006-2013 Charlie C.
+
+    Contributor(s): none yet.
+-------------------------------------------------------------------------------
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#include "gkActivityCuller.h"
+#include "gkScene.h"
+#include "gkGameObject.h"
+#include "gkCamera.h"
+#include "gkEngine.h"
+#include "gkUserDefs.h"
+#include "gkPhysicsController.h"
+#include "gkLogger.h"
+
+
+// widens a radius when leaving a level, avoids flipping at the border
+#define GK_ACTIVITY_HYSTERESIS 1.1f
+
+
+
+gkActivityCuller::gkActivityCuller(gkScene* scene)
+	:    m_scene(scene),
+	     m_logicRadius(scene->getProperties().m_logicRadius),
+	     m_physicsRadius(scene->getProperties().m_physicsRadius),
+	     m_useDbvt(gkEngine::getSingleton().getUserDefs().useBulletDbvt),
+	     m_cursor(0),
+	     m_scanBudget(256),
+	     m_due(0)
+{
+	for (int i = 0; i < BUCKETS; ++i)
+		m_bucketTick[i] = 0;
+
+	// the world has a single radius, the physics one can be set apart
+	gkScalar physics = gkEngine::getSingleton().getUserDefs().physicsActivityRadius;
+	if (physics >= 0)
+		m_physicsRadius = physics;
+}
+
+
+
+void gkActivityCuller::setLogicRadius(gkScalar v)
+{
+	m_logicRadius = gkMax<gkScalar>(v, 0);
+	if (m_logicRadius > 0)
+		return;
+
+	gkGameObjectSet::Iterator it = m_scene->getInstancedObjects().iterator();
+	while (it.hasMoreElements())
+		setLevel(it.getNext(), gkGameObject::AL_ACTIVE);
+}
+
+
+
+void gkActivityCuller::setPhysicsRadius(gkScalar v)
+{
+	m_physicsRadius = gkMax<gkScalar>(v, 0);
+	if (m_physicsRadius > 0)
+		return;
+
+	ControllerSet::Iterator it = m_suspended.iterator();
+	while (it.hasMoreElements())
+		it.getNext()->suspend(false);
+	m_suspended.clear();
+}
+
+
+
+gkActivityCuller::~gkActivityCuller()
+{
+}
+
+
+
+void gkActivityCuller::setLevel(gkGameObject* obj, int level)
+{
+	int old = obj->getActivityLevel();
+	if (old == level)
+		return;
+
+	if (old == gkGameObject::AL_REDUCED)
+	{
+		for (int i = 0; i < BUCKETS; ++i)
+			m_buckets[i].erase(obj);
+	}
+
+	obj->_setActivityLevel(level);
+
+	// join the bucket just updated, its first step is a full period
+	if (level == gkGameObject::AL_REDUCED)
+		m_buckets[m_due].insert(obj);
+}
+
+
+
+void gkActivityCuller::classify(gkGameObject* obj, const gkVector3& center)
+{
+	if (!obj->isInstanced() || !obj->getProperties().isActivityCullable() || obj->getType() == GK_CAMERA)
+	{
+		setLevel(obj, gkGameObject::AL_ACTIVE);
+		return;
+	}
+
+	const gkScalar dist = obj->getWorldPosition().distance(center);
+	const int level = obj->getActivityLevel();
+
+	gkPhysicsController* cont = obj->getPhysicsController();
+
+
+	// logic and animations
+	if (m_logicRadius > 0)
+	{
+		bool visible = m_useDbvt && cont && !cont->isSuspended() && cont->_isDbvtMarked();
+
+		gkScalar active  = m_logicRadius * (level == gkGameObject::AL_ACTIVE ? GK_ACTIVITY_HYSTERESIS : 1.f);
+		gkScalar reduced = m_logicRadius * REDUCED_FACTOR * (level != gkGameObject::AL_SUSPENDED ? GK_ACTIVITY_HYSTERESIS : 1.f);
+
+		if (dist < active || (visible && dist < reduced))
+			setLevel(obj, gkGameObject::AL_ACTIVE);
+		else if (dist < reduced || visible)
+			setLevel(obj, gkGameObject::AL_REDUCED);
+		else
+			setLevel(obj, gkGameObject::AL_SUSPENDED);
+	}
+
+
+	// dynamics
+	if (m_physicsRadius > 0 && cont && cont->getProperties().isRigidOrDynamic() &&
+	        !obj->hasParent() && !obj->getProperties().m_physics.isLinkedToOther())
+	{
+		if (m_suspended.find(cont) != UT_NPOS)
+		{
+			if (dist < m_physicsRadius)
+			{
+				m_suspended.erase(cont);
+				cont->suspend(false);
+			}
+		}
+		else if (!cont->isSuspended() && dist > m_physicsRadius * GK_ACTIVITY_HYSTERESIS)
+		{
+			m_suspended.insert(cont);
+			cont->suspend(true);
+		}
+	}
+}
+
+
+
+void gkActivityCuller::update(gkScalar tick)
+{
+	// last frame's bucket goes back to idle
+	gkGameObjectSet::Iterator idle = m_buckets[m_due].iterator();
+	while (idle.hasMoreElements())
+		idle.getNext()->_setActivityTick(0);
+
+	for (int i = 0; i < BUCKETS; ++i)
+		m_bucketTick[i] += tick;
+
+	m_due = (m_due + 1) % BUCKETS;
+
+	// catch up with the ticks accumulated since its last update
+	gkGameObjectSet::Iterator due = m_buckets[m_due].iterator();
+	while (due.hasMoreElements())
+		due.getNext()->_setActivityTick(m_bucketTick[m_due]);
+
+	m_bucketTick[m_due] = 0;
+
+
+	gkCamera* cam = m_scene->getMainCamera();
+	if (!cam)
+		return;
+
+	const gkVector3 center = cam->getWorldPosition();
+
+	gkGameObjectSet& objects = m_scene->getInstancedObjects();
+	const UTsize size = objects.size();
+	if (size == 0)
+		return;
+
+	UTsize count = gkMin<UTsize>(m_scanBudget, size);
+	while (count-- > 0)
+	{
+		if (m_cursor >= size)
+			m_cursor = 0;
+
+		classify(objects.at(m_cursor++), center);
+	}
+}
+
+
+
+void gkActivityCuller::_notifyObjectDestroyed(gkGameObject* obj)
+{
+	setLevel(obj, gkGameObject::AL_ACTIVE);
+
+	gkPhysicsController* cont = obj->getPhysicsController();
+	if (cont && m_suspended.find(cont) != UT_NPOS)
+	{
+		m_suspended.erase(cont);
+		cont->suspend(false);
+	}
+}
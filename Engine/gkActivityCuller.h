@@ -0,0 +1,98 @@
+/*
+-------------------------------------------------------------------------------
+    This file is part of OgreKit.
+    http://gamekit.googlecode.com/
+
+    Copyright (c) 2006-2013 Charlie C.
+
+    Contributor(s): none yet.
+-------------------------------------------------------------------------------
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#ifndef _gkActivityCuller_h_
+#define _gkActivityCuller_h_
+
+#include "gkCommon.h"
+#include "gkMathUtils.h"
+
+
+///Blender style activity culling, throttles objects far from the main camera.
+///
+///Inside gkSceneProperties::m_logicRadius logic bricks, animations and steering run
+///every frame. Up to REDUCED_FACTOR times the radius they run every BUCKETS frames
+///with the tick accumulated in between, further away they are suspended.
+///Objects gkDbvt marked visible are never suspended. Rigid and dynamic bodies
+///beyond gkSceneProperties::m_physicsRadius are removed from the dynamics world,
+///gkUserDefs::physicsActivityRadius replaces that radius when it is not negative.
+///
+///Levels are re-evaluated for a limited number of objects per frame, so the
+///per frame cost follows the active area rather than the scene size.
+class gkActivityCuller
+{
+public:
+	enum
+	{
+		BUCKETS = 8,
+		REDUCED_FACTOR = 2,
+	};
+
+public:
+	gkActivityCuller(gkScene* scene);
+	~gkActivityCuller();
+
+	///Called once per scene update, before physics and logic.
+	void update(gkScalar tick);
+
+	void _notifyObjectDestroyed(gkGameObject* obj);
+
+	GK_INLINE void   setScanBudget(UTsize v)  {m_scanBudget = gkMax<UTsize>(1, v);}
+	GK_INLINE UTsize getScanBudget(void)      {return m_scanBudget;}
+
+	///0 disables the radius, objects it throttled are restored.
+	void setLogicRadius(gkScalar v);
+	void setPhysicsRadius(gkScalar v);
+
+	GK_INLINE gkScalar getLogicRadius(void)   {return m_logicRadius;}
+	GK_INLINE gkScalar getPhysicsRadius(void) {return m_physicsRadius;}
+
+private:
+	typedef utHashSet<gkPhysicsController*> ControllerSet;
+
+	void classify(gkGameObject* obj, const gkVector3& center);
+	void setLevel(gkGameObject* obj, int level);
+
+	gkScene*        m_scene;
+	gkScalar        m_logicRadius;
+	gkScalar        m_physicsRadius;
+	bool            m_useDbvt;
+
+	// round robin over the scene objects
+	UTsize          m_cursor;
+	UTsize          m_scanBudget;
+
+	// reduced objects, one bucket is updated per frame
+	gkGameObjectSet m_buckets[BUCKETS];
+	gkScalar        m_bucketTick[BUCKETS];
+	int             m_due;
+
+	// bodies suspended by us, others are left alone
+	ControllerSet   m_suspended;
+};
+
+
+#endif//_gkActivityCuller_h_
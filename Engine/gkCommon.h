@@ -111,6 +111,8 @@ class gkDynamicsWorld;
 class gkDebugger;
 class gkScene;
 class gkActiveObject;
+class gkJobPool;
+class gkCollisionCache;
 
 class gkGameObjectGroup;
 class gkGameObjectInstance;
@@ -53,6 +53,8 @@
 #include "gkAnimationManager.h"
 #include "gkParticleManager.h"
 #include "gkHUDManager.h"
+#include "gkJobPool.h"
+#include "gkCollisionCache.h"
 
 #ifdef OGREKIT_COMPILE_ENET
 #include "Network/gkNetworkManager.h"
@@ -182,7 +184,9 @@ gkEngine::gkEngine(gkUserDefs* oth)
 	:	m_window(0),
 		m_initialized(false),
 		m_ownsDefs(oth != 0),
-		m_running(false)
+		m_running(false),
+		m_jobPool(0),
+		m_collisionCache(0)
 {
 	m_private = new gkOgreEnginePrivate(this);
 	if (oth != 0)
@@ -272,6 +276,9 @@ void gkEngine::initialize()
 	new gkGroupManager();
 	new gkGameObjectManager();
 
+	// streamed object creation (group instances, incremental scenes) keeps to the frame budget
+	gkGameObjectManager::getSingleton().setQueueBudget(m_defs->instancingBudget);
+
 	new gkAnimationManager();
 
 #ifdef OGREKIT_USE_LUA
@@ -435,6 +442,15 @@ void gkEngine::finalize()
 
 
 	delete gkStats::getSingletonPtr();
+
+	// scenes are gone, nothing is running jobs anymore
+	delete m_jobPool;
+	m_jobPool = 0;
+
+	// and so are the shapes using the cached trees
+	delete m_collisionCache;
+	m_collisionCache = 0;
+
 	delete m_private->debugFps;
 	delete m_private->debugPage;
 	delete m_private->debug;
@@ -458,6 +474,24 @@ gkUserDefs& gkEngine::getUserDefs(void)
 
 
 
+gkJobPool* gkEngine::getJobPool(void)
+{
+	if (!m_jobPool)
+		m_jobPool = new gkJobPool(getUserDefs().jobThreads);
+	return m_jobPool;
+}
+
+
+
+gkCollisionCache* gkEngine::getCollisionCache(void)
+{
+	if (!m_collisionCache)
+		m_collisionCache = new gkCollisionCache(getUserDefs().collisionCachePath);
+	return m_collisionCache;
+}
+
+
+
 void gkEngine::requestExit(void)
 {
 	gkWindowSystem::getSingleton().exit(true);
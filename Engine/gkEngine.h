@@ -85,6 +85,12 @@ public:
 	void addListener(Listener* listener);
 	void removeListener(Listener* listener);
 
+	///Shared worker threads, created on first use with gkUserDefs::jobThreads workers.
+	gkJobPool* getJobPool(void);
+
+	///Shared static mesh BVHs, created on first use with gkUserDefs::collisionCachePath.
+	gkCollisionCache* getCollisionCache(void);
+
 private:
 
 	class Private;
@@ -97,6 +103,8 @@ private:
 	bool                    m_running;
 	gkUserDefs*             m_defs;
 	Listeners               m_listeners;
+	gkJobPool*              m_jobPool;
+	gkCollisionCache*       m_collisionCache;
 
 	static gkScalar         m_tickRate;
 
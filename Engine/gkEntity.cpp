@@ -32,6 +32,10 @@
 #include "gkUserDefs.h"
 #include "gkSkeleton.h"
 #include "gkMesh.h"
+#include "gkGameObjectGroup.h"
+#include "gkVariable.h"
+#include "gkUtils.h"
+#include "OgreStaticGeometry.h"
 
 
 
@@ -39,7 +43,8 @@ gkEntity::gkEntity(gkInstancedManager* creator, const gkResourceName& name, cons
 	:    gkGameObject(creator, name, handle, GK_ENTITY),
 	     m_entityProps(new gkEntityProperties()),
 	     m_entity(0),
-	     m_skeleton(0)
+	     m_skeleton(0),
+	     m_staticBatch(0)
 {
 }
 
@@ -66,13 +71,19 @@ void gkEntity::createInstanceImpl(void)
 	if (m_skeleton)
 		m_skeleton->createInstance();
 
-	Ogre::SceneManager* manager = m_scene->getManager();
-	m_entity = manager->createEntity(m_name.getName(), m_entityProps->m_mesh->getResourceName().getName(), 
-		m_name.getGroup().empty() ? Ogre::ResourceGroupManager::AUTODETECT_RESOURCE_GROUP_NAME : m_name.getGroup());
+	// Meshes already promoted by gkScene::createInstancedBatches skip the entity.
+	gkEntityInstancer* instancer = m_scene->getEntityInstancer();
+	if (instancer && !m_skeleton && m_entityProps->m_startPose.empty() &&
+	        instancer->hasMesh(m_entityProps->m_mesh) &&
+	        instancer->createInstances(m_entityProps->m_mesh, m_node, m_entityProps->m_casts, m_instancedEntities))
+	{
+		if (m_baseProps.isInvisible())
+			m_node->setVisible(false, false);
+		return;
+	}
 
 
-	m_entity->setCastShadows(m_entityProps->m_casts);
-	m_node->attachObject(m_entity);
+	createEntity();
 
 	if (m_skeleton)
 		m_skeleton->updateFromController();
@@ -88,8 +99,46 @@ void gkEntity::createInstanceImpl(void)
 
 
 
+void gkEntity::createEntity(void)
+{
+	// per object LOD thresholds, the first object loading the mesh sets them
+	gkMesh* mesh = m_entityProps->m_mesh;
+	if (mesh->getLodValues().empty() && hasVariable("lod_values"))
+	{
+		gkMesh::LodValues values;
+		gkMesh::parseLodValues(getVariable("lod_values")->getValueString(), values);
+		mesh->setLodValues(values);
+	}
+
+
+	Ogre::SceneManager* manager = m_scene->getManager();
+	m_entity = manager->createEntity(m_name.getName(), mesh->getResourceName().getName(), 
+		m_name.getGroup().empty() ? Ogre::ResourceGroupManager::AUTODETECT_RESOURCE_GROUP_NAME : m_name.getGroup());
+
+
+	m_entity->setCastShadows(m_entityProps->m_casts);
+	m_node->attachObject(m_entity);
+
+	// > 1 keeps higher detail for longer
+	if (hasVariable("lod_bias"))
+		m_entity->setMeshLodBias(getVariable("lod_bias")->getValueReal());
+}
+
+
+
+
 void gkEntity::destroyInstanceImpl(void)
 {
+	if (m_staticBatch)
+	{
+		gkGameObjectGroup* group = m_staticBatch;
+		m_staticBatch = 0;
+		group->_notifyStaticEntityDestroyed(this);
+	}
+
+	if (!m_instancedEntities.empty())
+		m_scene->getEntityInstancer()->destroyInstances(m_instancedEntities);
+
 	if (m_entity)
 	{
 
@@ -150,6 +199,69 @@ void gkEntity::_destroyAsStaticGeometry(void)
 }
 
 
+void gkEntity::_addToStaticGeometry(Ogre::StaticGeometry* geometry)
+{
+	GK_ASSERT(geometry && m_entityProps->m_mesh);
+
+	Ogre::Entity* ent = m_entity;
+
+	// Already batched before, a temporary entity feeds the mesh.
+	if (!ent)
+	{
+		Ogre::SceneManager* manager = m_scene->getManager();
+		ent = manager->createEntity(gkUtils::getUniqueName(m_name.getName()), m_entityProps->m_mesh->getResourceName().getName(), 
+			m_name.getGroup().empty() ? Ogre::ResourceGroupManager::AUTODETECT_RESOURCE_GROUP_NAME : m_name.getGroup());
+
+		if (!m_materialNameCache.empty())
+			ent->setMaterialName(m_materialNameCache);
+	}
+
+	geometry->addEntity(ent, getWorldPosition(), getWorldOrientation(), getWorldScale());
+
+	if (ent == m_entity)
+		_destroyAsStaticGeometry();
+	else
+		m_scene->getManager()->destroyEntity(ent);
+}
+
+
+
+void gkEntity::_createFromStaticGeometry(void)
+{
+	if (m_entity || !m_node || !m_entityProps->m_mesh)
+		return;
+
+	createEntity();
+
+	if (!m_materialNameCache.empty())
+		m_entity->setMaterialName(m_materialNameCache);
+}
+
+
+
+bool gkEntity::_createAsInstanced(void)
+{
+	gkEntityInstancer* instancer = m_scene ? m_scene->getEntityInstancer() : 0;
+
+	if (!m_entity || !instancer || m_skeleton || !m_materialNameCache.empty())
+		return false;
+
+	gkMesh* mesh = m_entityProps->m_mesh;
+	if (!instancer->addMesh(mesh, m_name.getGroup()))
+		return false;
+
+	if (!instancer->createInstances(mesh, m_node, m_entityProps->m_casts, m_instancedEntities))
+		return false;
+
+	Ogre::SceneManager* manager = m_scene->getManager();
+	m_node->detachObject(m_entity);
+	manager->destroyEntity(m_entity);
+	m_entity = 0;
+	return true;
+}
+
+
+
 gkGameObject* gkEntity::clone(const gkString& name)
 {
 	gkEntity* cl = new gkEntity(getInstanceCreator(), name, -1);
@@ -191,7 +303,7 @@ gkBoundingBox gkEntity::getAabb() const
 }
 
 void gkEntity::setMaterialName(const gkString& matName) {
-	if (m_materialNameCache!=matName) {
+	if (m_entity && m_materialNameCache!=matName) {
 		m_entity->setMaterialName(matName);
 		m_materialNameCache = matName;
 	}
@@ -29,6 +29,7 @@
 
 #include "gkGameObject.h"
 #include "gkSerialize.h"
+#include "gkEntityInstancer.h"
 
 
 class gkEntity : public gkGameObject
@@ -52,6 +53,24 @@ public:
 	// Remove only the entity but keep the rest.
 	void _destroyAsStaticGeometry(void);
 
+	// Add the mesh to a static batch (the entity, if still there, is removed).
+	void _addToStaticGeometry(Ogre::StaticGeometry* geometry);
+
+	// Bring the entity back after its static batch was destroyed.
+	void _createFromStaticGeometry(void);
+
+	// Group batching this entity, notified when it is destroyed.
+	GK_INLINE void               _setStaticBatch(gkGameObjectGroup* group) {m_staticBatch = group;}
+	GK_INLINE gkGameObjectGroup* _getStaticBatch(void)                     {return m_staticBatch;}
+
+	// Replace the entity by hardware instances of the scene's gkEntityInstancer.
+	bool _createAsInstanced(void);
+
+	GK_INLINE bool isHardwareInstanced(void) const {return !m_instancedEntities.empty();}
+
+	// One per sub mesh, the first stands in for the entity in getMovable.
+	GK_INLINE gkEntityInstancer::InstancedEntities& getInstancedEntities(void) {return m_instancedEntities;}
+
 	void setMaterialName(const gkString& matName);
 
 protected:
@@ -65,6 +84,11 @@ protected:
 	Ogre::Entity*           m_entity;
 	gkSkeleton*             m_skeleton;
 
+	gkEntityInstancer::InstancedEntities m_instancedEntities;
+	gkGameObjectGroup*      m_staticBatch;
+
+	void createEntity(void);
+
 	virtual void createInstanceImpl();
 	virtual void destroyInstanceImpl();
 
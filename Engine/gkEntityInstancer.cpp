@@ -0,0 +1,231 @@
+/*
+-------------------------------------------------------------------------------
+    This file is part of OgreKit.
+    http://gamekit.googlecode.com/
+
+    Copyright (c) 2006-2013 Charlie C.
+
+    Contributor(s): none yet.
+-------------------------------------------------------------------------------
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#include "gkEntityInstancer.h"
+#include "gkScene.h"
+#include "gkMesh.h"
+#include "gkLogger.h"
+#include "gkUtils.h"
+
+#include "OgreSceneManager.h"
+#include "OgreSceneNode.h"
+#include "OgreMeshManager.h"
+#include "OgreMaterialManager.h"
+#include "OgreSubMesh.h"
+#include "OgreInstanceManager.h"
+#include "OgreInstancedEntity.h"
+
+
+const gkString gkEntityInstancer::MATERIAL_SUFFIX = "/Instanced";
+
+
+
+gkEntityInstancer::gkEntityInstancer(gkScene* scene, int technique)
+	:	m_scene(scene),
+		m_technique(technique)
+{
+	GK_ASSERT(m_scene);
+}
+
+
+
+gkEntityInstancer::~gkEntityInstancer()
+{
+	// The managers (and their entities) are owned by the Ogre scene manager,
+	// destroying them here is only needed when the scene outlives this object.
+	if (!m_scene->isBeingDestroyed() && m_scene->isInstanced())
+	{
+		Ogre::SceneManager* manager = m_scene->getManager();
+
+		MeshManagers::Iterator it = m_managers.iterator();
+		while (it.hasMoreElements())
+		{
+			Managers& mgrs = it.getNext().second;
+
+			UTsize i;
+			for (i = 0; i < mgrs.size(); ++i)
+				manager->destroyInstanceManager(mgrs[i].manager);
+		}
+	}
+
+	m_managers.clear();
+}
+
+
+
+bool gkEntityInstancer::hasMesh(gkMesh* mesh)
+{
+	UTsize pos = m_managers.find(mesh);
+	return pos != UT_NPOS && !m_managers.at(pos).empty();
+}
+
+
+
+bool gkEntityInstancer::addMesh(gkMesh* mesh, const gkString& group)
+{
+	if (!mesh || m_technique == IT_NONE)
+		return false;
+
+	UTsize pos = m_managers.find(mesh);
+	if (pos != UT_NPOS)
+		return !m_managers.at(pos).empty();
+
+
+	Ogre::SceneManager* manager = m_scene->getManager();
+	const gkString& meshName = mesh->getResourceName().getName();
+	const gkString groupName = group.empty() ? Ogre::ResourceGroupManager::AUTODETECT_RESOURCE_GROUP_NAME : group;
+
+	Ogre::InstanceManager::InstancingTechnique technique = (Ogre::InstanceManager::InstancingTechnique)m_technique;
+	Ogre::uint16 flags = (m_technique == IT_VTF || m_technique == IT_HW_VTF) ? Ogre::IM_USEALL : 0;
+
+	Managers mgrs;
+
+	try
+	{
+		Ogre::MeshPtr omesh = Ogre::MeshManager::getSingleton().load(meshName, groupName);
+
+		// Meshes with skeletons are left to the entity path.
+		if (omesh.isNull() || omesh->hasSkeleton())
+		{
+			m_managers.insert(mesh, mgrs);
+			return false;
+		}
+
+
+		unsigned short i;
+		for (i = 0; i < omesh->getNumSubMeshes(); ++i)
+		{
+			const gkString material = omesh->getSubMesh(i)->getMaterialName() + MATERIAL_SUFFIX;
+
+			if (!Ogre::MaterialManager::getSingleton().resourceExists(material))
+			{
+				gkLogMessage("EntityInstancer: No instancing material '" << material << "', mesh " << meshName << " is not instanced.");
+				break;
+			}
+
+			size_t perBatch = manager->getNumInstancesPerBatch(meshName, groupName, material, technique, 80, flags, i);
+			if (perBatch == 0)
+			{
+				gkLogMessage("EntityInstancer: Technique not supported for mesh " << meshName << ".");
+				break;
+			}
+
+			Batch batch;
+			batch.material = material;
+			batch.manager  = manager->createInstanceManager(gkUtils::getUniqueName("Instancer/" + meshName),
+			                 meshName, groupName, technique, perBatch, flags, i);
+			mgrs.push_back(batch);
+		}
+
+		if (mgrs.size() != omesh->getNumSubMeshes())
+		{
+			for (i = 0; i < mgrs.size(); ++i)
+				manager->destroyInstanceManager(mgrs[i].manager);
+			mgrs.clear();
+		}
+	}
+	catch (Ogre::Exception& e)
+	{
+		gkLogMessage("EntityInstancer: " << e.getDescription());
+
+		UTsize i;
+		for (i = 0; i < mgrs.size(); ++i)
+			manager->destroyInstanceManager(mgrs[i].manager);
+		mgrs.clear();
+	}
+
+	m_managers.insert(mesh, mgrs);
+	return !mgrs.empty();
+}
+
+
+
+bool gkEntityInstancer::createInstances(gkMesh* mesh, Ogre::SceneNode* node, bool castShadows, InstancedEntities& ents)
+{
+	GK_ASSERT(node && ents.empty());
+
+	UTsize pos = m_managers.find(mesh);
+	if (pos == UT_NPOS || m_managers.at(pos).empty())
+		return false;
+
+
+	Ogre::SceneManager* manager = m_scene->getManager();
+	Managers& mgrs = m_managers.at(pos);
+
+	UTsize i;
+	for (i = 0; i < mgrs.size(); ++i)
+	{
+		Ogre::InstancedEntity* ent = manager->createInstancedEntity(mgrs[i].material, mgrs[i].manager->getName());
+		if (!ent)
+		{
+			destroyInstances(ents);
+			return false;
+		}
+
+		ent->setCastShadows(castShadows);
+		node->attachObject(ent);
+		ents.push_back(ent);
+	}
+
+	return true;
+}
+
+
+
+void gkEntityInstancer::destroyInstances(InstancedEntities& ents)
+{
+	if (!m_scene->isBeingDestroyed())
+	{
+		Ogre::SceneManager* manager = m_scene->getManager();
+
+		UTsize i;
+		for (i = 0; i < ents.size(); ++i)
+		{
+			Ogre::InstancedEntity* ent = ents[i];
+			if (ent->isAttached())
+				ent->detachFromParent();
+
+			manager->destroyInstancedEntity(ent);
+		}
+	}
+
+	ents.clear();
+}
+
+
+
+void gkEntityInstancer::defragment(void)
+{
+	MeshManagers::Iterator it = m_managers.iterator();
+	while (it.hasMoreElements())
+	{
+		Managers& mgrs = it.getNext().second;
+
+		UTsize i;
+		for (i = 0; i < mgrs.size(); ++i)
+			mgrs[i].manager->defragmentBatches(true);
+	}
+}
@@ -0,0 +1,94 @@
+/*
+-------------------------------------------------------------------------------
+    This file is part of OgreKit.
+    http://gamekit.googlecode.com/
+
+    Copyright (c) 2006-2013 Charlie C.
+
+    Contributor(s): none yet.
+-------------------------------------------------------------------------------
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#ifndef _gkEntityInstancer_h_
+#define _gkEntityInstancer_h_
+
+#include "gkCommon.h"
+#include "gkString.h"
+#include "utCommon.h"
+
+
+///Renders entities sharing a gkMesh through Ogre's InstanceManager.
+///
+///One Ogre::InstanceManager is created per sub mesh, each entity then gets an
+///Ogre::InstancedEntity per sub mesh attached to its scene node, so instance
+///transforms follow the game object. The technique needs a vertex program aware of
+///it, it is looked up as the sub mesh material name followed by MATERIAL_SUFFIX.
+///Meshes without such materials, or on hardware lacking the technique, are rejected
+///and keep using plain Ogre entities.
+class gkEntityInstancer
+{
+public:
+	typedef utArray<Ogre::InstancedEntity*> InstancedEntities;
+
+	static const gkString MATERIAL_SUFFIX;
+
+	enum Technique
+	{
+		IT_NONE = -1,
+		IT_SHADER,      // Ogre::InstanceManager::ShaderBased
+		IT_VTF,         // Ogre::InstanceManager::TextureVTF
+		IT_HW_BASIC,    // Ogre::InstanceManager::HWInstancingBasic
+		IT_HW_VTF       // Ogre::InstanceManager::HWInstancingVTF
+	};
+
+public:
+	gkEntityInstancer(gkScene* scene, int technique);
+	~gkEntityInstancer();
+
+	///Creates the instance managers for the mesh, returns false if it cannot be instanced.
+	bool addMesh(gkMesh* mesh, const gkString& group);
+
+	///Returns true once addMesh succeeded for this mesh.
+	bool hasMesh(gkMesh* mesh);
+
+	///Creates and attaches one instanced entity per sub mesh to node.
+	bool createInstances(gkMesh* mesh, Ogre::SceneNode* node, bool castShadows, InstancedEntities& ents);
+	void destroyInstances(InstancedEntities& ents);
+
+	///Batches of moving entities grow their bounds over time, regroup them by location.
+	void defragment(void);
+
+	GK_INLINE int getTechnique(void) const {return m_technique;}
+
+private:
+	struct Batch
+	{
+		Ogre::InstanceManager* manager;
+		gkString               material;
+	};
+
+	typedef utArray<Batch>                                 Managers;
+	typedef utHashTable<utPointerHashKey, Managers>        MeshManagers;
+
+	gkScene*        m_scene;
+	int             m_technique;
+	MeshManagers    m_managers; // empty for rejected meshes
+};
+
+
+#endif//_gkEntityInstancer_h_
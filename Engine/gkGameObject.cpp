@@ -29,6 +29,7 @@
 #include "OgreSceneNode.h"
 #include "OgreException.h"
 #include "OgreEntity.h"
+#include "OgreInstancedEntity.h"
 #include "OgreStringConverter.h"
 
 #include "gkSceneManager.h"
@@ -69,6 +70,10 @@ gkGameObject::gkGameObject(gkInstancedManager* creator, const gkResourceName& na
 	     m_layer(0xFFFFFFFF),
 	     m_isClone(false),
 	     m_flags(0),
+	     m_activityLevel(AL_ACTIVE),
+	     m_activityTick(0),
+	     m_cloneSlot(UT_NPOS),
+	     m_lifeSlot(UT_NPOS),
 	     m_actionBlender(0),
 	     m_cloneToScene(0),
 	     m_boneTransform(0)
@@ -346,7 +351,12 @@ Ogre::MovableObject* gkGameObject::getMovable(void)
 	case GK_CAMERA:
 		return getCamera()->getCamera();
 	case GK_ENTITY:
-		return getEntity()->getEntity();
+		{
+			gkEntity* ent = getEntity();
+			if (ent->isHardwareInstanced())
+				return ent->getInstancedEntities().at(0);
+			return ent->getEntity();
+		}
 	case GK_LIGHT:
 		return getLight()->getLight();
 	}
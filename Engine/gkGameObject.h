@@ -76,6 +76,14 @@ public:
 
 	typedef utHashTable<gkHashedString, gkAnimationPlayer*>  Animations;
 
+	// See gkActivityCuller
+	enum ActivityLevel
+	{
+		AL_ACTIVE,      // Updated every frame
+		AL_REDUCED,     // Updated every few frames with the accumulated tick
+		AL_SUSPENDED,   // Not updated
+	};
+
 public:
 
 	gkGameObject(gkInstancedManager* creator, const gkResourceName& name, const gkResourceHandle& handle, gkGameObjectTypes type = GK_OBJECT);
@@ -123,6 +131,12 @@ public:
 	GK_INLINE LifeSpan& getLifeSpan(void)               {return m_life;}
 	GK_INLINE void      setLifeSpan(const LifeSpan& v)  {m_life = v;}
 
+	// Slots in the owning scene's clone array and life span heap (UT_NPOS when unused)
+	GK_INLINE UTsize    _getCloneSlot(void)             {return m_cloneSlot;}
+	GK_INLINE void      _setCloneSlot(UTsize v)         {m_cloneSlot = v;}
+	GK_INLINE UTsize    _getLifeSlot(void)              {return m_lifeSlot;}
+	GK_INLINE void      _setLifeSlot(UTsize v)          {m_lifeSlot = v;}
+
 
 	// layers
 	GK_INLINE void setActiveLayer(bool v)   {m_activeLayer = v; }
@@ -257,6 +271,18 @@ public:
 
 	GK_INLINE bool   isStaticGeometry(void)   {return (m_flags & GK_STATIC_GEOM) != 0;}
 	GK_INLINE bool   isImmovable(void)        {return (m_flags & GK_IMMOVABLE) != 0;}
+
+
+	// Activity culling
+
+	GK_INLINE int      getActivityLevel(void)          {return m_activityLevel;}
+
+	///Tick to update logic, animations or steering with, 0 when throttled this frame.
+	GK_INLINE gkScalar getActivityTick(gkScalar tick)  {return m_activityLevel == AL_ACTIVE ? tick : m_activityTick;}
+	GK_INLINE bool     isActivityCulled(void)          {return m_activityLevel != AL_ACTIVE && m_activityTick <= 0;}
+
+	GK_INLINE void     _setActivityLevel(int v)        {m_activityLevel = v; m_activityTick = 0;}
+	GK_INLINE void     _setActivityTick(gkScalar v)    {m_activityTick = v;}
 	
 	GK_INLINE void setVisible(bool v)          {getNode()->setVisible(v, false);}
 	GK_INLINE void setVisibleRecursive(bool v) {getNode()->setVisible(v, true);}
@@ -353,7 +379,11 @@ protected:
 	int                         m_layer;
 	bool                        m_isClone;
 	int                         m_flags;
+	int                         m_activityLevel;
+	gkScalar                    m_activityTick;
 	LifeSpan                    m_life;
+	UTsize                      m_cloneSlot;
+	UTsize                      m_lifeSlot;
 
 
 	gkAnimationBlender*         m_actionBlender;
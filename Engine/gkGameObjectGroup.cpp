@@ -32,6 +32,9 @@
 
 #include "gkEntity.h"
 #include "gkScene.h"
+#include "gkEngine.h"
+#include "gkUserDefs.h"
+#include "gkUtils.h"
 
 #include "OgreSceneManager.h"
 #include "OgreEntity.h"
@@ -54,7 +57,8 @@ gkResource* gkGameObjectGroup::InstanceManager::createImpl(const gkResourceName&
 
 gkGameObjectGroup::gkGameObjectGroup(gkResourceManager* creator, const gkResourceName& name, const gkResourceHandle& handle)
 	:   gkResource(creator, name, handle),
-	    m_geometry(0)
+	    m_batchScene(0),
+	    m_regionSize(0)
 {
 	m_instanceManager = new InstanceManager(this);
 }
@@ -65,6 +69,9 @@ gkGameObjectGroup::gkGameObjectGroup(gkResourceManager* creator, const gkResourc
 gkGameObjectGroup::~gkGameObjectGroup()
 {
 	destroyAllInstances();
+
+	if (m_batchScene)
+		destroyStaticBatches(m_batchScene);
 	delete m_instanceManager;
 	m_instanceManager = 0;
 
@@ -204,7 +211,7 @@ void gkGameObjectGroup::destroyGroupInstance(gkGameObjectInstance* inst)
 
 
 
-void gkGameObjectGroup::createGameObjectInstances(gkScene* scene)
+void gkGameObjectGroup::createGameObjectInstances(gkScene* scene, gkInstancedManager* queue)
 {
 	gkResourceManager::ResourceIterator it = m_instanceManager->getResourceIterator();
 	while (it.hasMoreElements())
@@ -219,7 +226,10 @@ void gkGameObjectGroup::createGameObjectInstances(gkScene* scene)
 			if (obj && obj->getOwner() != scene)
 				obj->setOwner(scene);
 
-			inst->createInstance();
+			if (queue)
+				inst->queueInstance(queue);
+			else
+				inst->createInstance();
 		}
 
 	}
@@ -297,16 +307,17 @@ void gkGameObjectGroup::cloneObjects(gkScene* scene,
 
 void gkGameObjectGroup::createStaticBatches(gkScene* scene)
 {
-	Ogre::SceneManager* mgr = scene->getManager();
-	if (m_geometry)
-		mgr->destroyStaticGeometry(m_geometry);
+	if (m_batchScene && m_batchScene != scene)
+	{
+		gkLogMessage("GameObjectGroup: " << m_name.getName() << " is already batched in another scene.");
+		return;
+	}
 
-	m_geometry = 0;
+	if (!m_batchScene)
+		m_regionSize = gkEngine::getSingleton().getUserDefs().staticBatchRegion;
 
 
 	// Span all instances.
-
-
 	gkResourceManager::ResourceIterator it = m_instanceManager->getResourceIterator();
 	while (it.hasMoreElements())
 	{
@@ -315,62 +326,216 @@ void gkGameObjectGroup::createStaticBatches(gkScene* scene)
 		if (!inst->isInstanced() || !(inst->getLayer() & scene->getLayer()) || inst->getRoot()->getOwner()!=scene)
 			continue;
 
-		gkGameObjectInstance::Objects::Iterator instIt = inst->getObjects().iterator();
-		while (instIt.hasMoreElements())
+		m_batchScene = scene;
+		addStaticEntities(inst);
+	}
+
+
+	// Initial build, all at once.
+	while (updateStaticBatches(scene));
+}
+
+
+
+void gkGameObjectGroup::addStaticEntities(gkGameObjectInstance* inst)
+{
+	gkGameObjectInstance::Objects::Iterator instIt = inst->getObjects().iterator();
+	while (instIt.hasMoreElements())
+	{
+		gkGameObject* obj = instIt.getNext().second;
+		obj->createInstance();
+
+
+		if (obj->getType() == GK_ENTITY)
 		{
-			gkGameObject* obj = instIt.getNext().second;
-			obj->createInstance();
+			const gkGameObjectProperties& props = obj->getProperties();
+
+			gkEntity* ent = obj->getEntity();
 
+			// skip the hardware instanced and already batched ones
+			if (!props.isPhysicsObject() && ent->getEntity() && !ent->_getStaticBatch())
+				addStaticEntity(ent);
+		}
+	}
+}
 
-			if (obj->getType() == GK_ENTITY)
-			{
-				const gkGameObjectProperties& props = obj->getProperties();
 
-				if (!props.isPhysicsObject())
-				{
-					gkEntity* ent = obj->getEntity();
 
-					if (!m_geometry)
-						m_geometry = mgr->createStaticGeometry(m_name.getName());
+UTint32 gkGameObjectGroup::getRegionKey(const gkVector3& pos)
+{
+	if (m_regionSize <= 0)
+		return 0;
 
+	// 10 bits per axis, far away cells may share a region
+	UTint32 x = Ogre::Math::IFloor(pos.x / m_regionSize) & 0x3FF;
+	UTint32 y = Ogre::Math::IFloor(pos.y / m_regionSize) & 0x3FF;
+	UTint32 z = Ogre::Math::IFloor(pos.z / m_regionSize) & 0x3FF;
+	return (x << 20) | (y << 10) | z;
+}
 
-					m_geometry->addEntity(ent->getEntity(),
-					                      obj->getWorldPosition(),
-					                      obj->getWorldOrientation(),
-					                      obj->getWorldScale());
 
-					// no longer needed
-					ent->_destroyAsStaticGeometry();
-				}
-			}
+
+void gkGameObjectGroup::addStaticEntity(gkEntity* ent)
+{
+	const gkVector3 pos = ent->getWorldPosition();
+	const UTint32 key = getRegionKey(pos);
+
+	StaticRegion* region = 0;
+
+	UTsize slot = m_regions.find(key);
+	if (slot == UT_NPOS)
+	{
+		region = new StaticRegion();
+		region->m_geometry = 0;
+		region->m_dirty = false;
+
+		if (m_regionSize > 0)
+		{
+			region->m_origin = gkVector3(Ogre::Math::Floor(pos.x / m_regionSize),
+			                             Ogre::Math::Floor(pos.y / m_regionSize),
+			                             Ogre::Math::Floor(pos.z / m_regionSize)) * m_regionSize;
 		}
+		else
+			region->m_origin = gkVector3::ZERO;
+
+		m_regions.insert(key, region);
 	}
+	else
+		region = m_regions.at(slot);
+
+
+	region->m_entities.push_back(ent);
+	region->m_dirty = true;
+
+	m_staticMembers.insert(ent, key);
+	ent->_setStaticBatch(this);
+}
+
+
+
+void gkGameObjectGroup::_notifyInstanceCreated(gkGameObjectInstance* inst)
+{
+	// Join the existing batches, the entities stay until their region is rebuilt.
+	if (!m_batchScene || inst->getRoot()->getOwner() != m_batchScene)
+		return;
+
+	if (!(inst->getLayer() & m_batchScene->getLayer()))
+		return;
+
+	addStaticEntities(inst);
+}
+
 
-	if (m_geometry)
+
+void gkGameObjectGroup::_notifyStaticEntityDestroyed(gkEntity* ent)
+{
+	UTsize pos = m_staticMembers.find(ent);
+	if (pos == UT_NPOS)
+		return;
+
+	UTint32 key = m_staticMembers.at(pos);
+	m_staticMembers.remove(ent);
+
+	pos = m_regions.find(key);
+	if (pos != UT_NPOS)
 	{
-		m_geometry->build();
-		m_geometry->setCastShadows(false);
+		StaticRegion* region = m_regions.at(pos);
+		region->m_entities.erase(ent);
+		region->m_dirty = true;
 	}
+}
 
+
+
+bool gkGameObjectGroup::updateStaticBatches(gkScene* scene)
+{
+	if (m_batchScene != scene)
+		return false;
+
+	StaticRegions::Iterator it = m_regions.iterator();
+	while (it.hasMoreElements())
+	{
+		StaticRegion* region = it.getNext().second;
+		if (region->m_dirty)
+		{
+			rebuildStaticRegion(region);
+			return true;
+		}
+	}
+
+	return false;
 }
 
 
 
-void gkGameObjectGroup::destroyStaticBatches(gkScene* scene)
+void gkGameObjectGroup::rebuildStaticRegion(StaticRegion* region)
 {
-	bool isSceneUnloading = scene->isBeingDestroyed();
+	GK_ASSERT(m_batchScene);
 
-	if (!isSceneUnloading)
+	Ogre::SceneManager* mgr = m_batchScene->getManager();
+
+
+	// Build the replacement first, the old one is visible until the swap.
+	Ogre::StaticGeometry* geometry = 0;
+
+	if (!region->m_entities.empty())
 	{
-		if (m_geometry)
+		geometry = mgr->createStaticGeometry(gkUtils::getUniqueName(m_name.getName()));
+
+		if (m_regionSize > 0)
 		{
-			Ogre::SceneManager* mgr = scene->getManager();
-			mgr->destroyStaticGeometry(m_geometry);
+			geometry->setRegionDimensions(gkVector3(m_regionSize, m_regionSize, m_regionSize));
+			geometry->setOrigin(region->m_origin);
 		}
+
+		UTsize i;
+		for (i = 0; i < region->m_entities.size(); ++i)
+			region->m_entities[i]->_addToStaticGeometry(geometry);
+
+		geometry->build();
+		geometry->setCastShadows(false);
 	}
-	else
+
+	if (region->m_geometry)
+		mgr->destroyStaticGeometry(region->m_geometry);
+
+	region->m_geometry = geometry;
+	region->m_dirty = false;
+}
+
+
+
+void gkGameObjectGroup::destroyStaticBatches(gkScene* scene)
+{
+	if (m_batchScene != scene)
+		return;
+
+	bool isSceneUnloading = scene->isBeingDestroyed();
+
+
+	StaticRegions::Iterator it = m_regions.iterator();
+	while (it.hasMoreElements())
 	{
-		// TODO: reinstance entities.
-		m_geometry = 0;
+		StaticRegion* region = it.getNext().second;
+
+		if (!isSceneUnloading && region->m_geometry)
+			scene->getManager()->destroyStaticGeometry(region->m_geometry);
+
+		UTsize i;
+		for (i = 0; i < region->m_entities.size(); ++i)
+		{
+			gkEntity* ent = region->m_entities[i];
+			ent->_setStaticBatch(0);
+
+			// reinstance entities
+			if (!isSceneUnloading && ent->isInstanced())
+				ent->_createFromStaticGeometry();
+		}
+
+		delete region;
 	}
+
+	m_regions.clear();
+	m_staticMembers.clear();
+	m_batchScene = 0;
 }
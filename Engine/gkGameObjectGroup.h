@@ -54,6 +54,19 @@ public:
 	typedef utArray<GroupInstance*> GroupInstances;
 
 
+	///A cell of static batched geometry, rebuilt on its own when its entities change.
+	struct StaticRegion
+	{
+		Ogre::StaticGeometry*   m_geometry;
+		utArray<gkEntity*>      m_entities;
+		gkVector3               m_origin;
+		bool                    m_dirty;
+	};
+
+	typedef utHashTable<utIntHashKey, StaticRegion*>    StaticRegions;
+	typedef utHashTable<utPointerHashKey, UTint32>      StaticMembers;
+
+
 	class InstanceManager : public gkInstancedManager
 	{
 	public:
@@ -73,7 +86,10 @@ public:
 
 protected:
 
-	Ogre::StaticGeometry*   m_geometry;
+	StaticRegions           m_regions;
+	StaticMembers           m_staticMembers;
+	gkScene*                m_batchScene;
+	gkScalar                m_regionSize;
 	UTsize                  m_handle;
 	Objects                 m_objects;
 	GroupInstances			m_groupInstances;
@@ -109,12 +125,24 @@ public:
 	///Things like grass, tree leaves, or basically
 	///any gkEntity that does not respond to collisions (GK_NO_COLLISION).
 	///\todo This needs a better static object check.
+	///
+	///Entities are batched per region (gkUserDefs::staticBatchRegion), adding or removing
+	///one only marks its region dirty, updateStaticBatches then rebuilds it and swaps it in.
 	void createStaticBatches(gkScene* scene);
 	void destroyStaticBatches(gkScene* scene);
 
+	///Rebuilds the first dirty region, returns false if there was none.
+	bool updateStaticBatches(gkScene* scene);
 
-	///Places all gkGameObjectInstance objects in the Ogre scene
-	void createGameObjectInstances(gkScene* scene);
+	GK_INLINE bool hasStaticBatches(gkScene* scene) {return m_batchScene == scene && !m_regions.empty();}
+
+	void _notifyInstanceCreated(gkGameObjectInstance* inst);
+	void _notifyStaticEntityDestroyed(gkEntity* ent);
+
+
+	///Places all gkGameObjectInstance objects in the Ogre scene,
+	///or adds them to the create queue of \a queue when one is given.
+	void createGameObjectInstances(gkScene* scene, gkInstancedManager* queue = 0);
 
 	///Removes all gkGameObjectInstance objects from the Ogre scene
 	void destroyGameObjectInstances(gkScene* scene=0);
@@ -131,9 +159,17 @@ public:
 
 	GK_INLINE InstanceManager&           getInstances(void)      {GK_ASSERT(m_instanceManager); return *m_instanceManager;}
 	GK_INLINE Objects&                   getObjects(void)        {return m_objects;}
+	GK_INLINE GroupInstances&            getGroupInstances(void) {return m_groupInstances;}
 	GK_INLINE bool                       isEmpty(void)           {return m_objects.empty() && m_groupInstances.empty();}
 
 
+private:
+
+	void addStaticEntities(gkGameObjectInstance* inst);
+	void addStaticEntity(gkEntity* ent);
+	void rebuildStaticRegion(StaticRegion* region);
+	UTint32 getRegionKey(const gkVector3& pos);
+
 
 };
 
@@ -51,6 +51,14 @@ gkGameObjectInstance::gkGameObjectInstance(gkInstancedManager* creator, const gk
 
 gkGameObjectInstance::~gkGameObjectInstance()
 {
+	// still waiting in a create queue, see queueInstance
+	if (!isInstanced() && gkGameObjectManager::getSingletonPtr())
+	{
+		gkInstancedManager::Instances queued;
+		_getQueued(queued);
+		gkGameObjectManager::getSingleton().removeQueued(queued);
+	}
+
 	if (m_owner != 0)
 		gkGameObjectManager::getSingleton().destroy(m_owner->getResourceHandle());
 
@@ -357,22 +365,8 @@ void gkGameObjectInstance::cloneObjects(gkScene* scene, const gkTransformState&
 }
 
 
-void gkGameObjectInstance::createInstanceImpl(void)
+void gkGameObjectInstance::linkSkeletons(void)
 {
-	if (!m_owner || !m_owner->getOwner())
-	{
-		m_instanceState = ST_ERROR;
-		m_instanceError = "Root object is not in any scene!";
-		return;
-	}
-
-
-	gkScene* scene = m_owner->getOwner();
-
-	m_owner->createInstance();
-	gkGameObjectSet parentingPhysicsObjs;
-
-
 	// first check for entities that are parented to a skeleton
 	{
 		Objects::Iterator iter = m_objects.iterator();
@@ -415,6 +409,76 @@ void gkGameObjectInstance::createInstanceImpl(void)
 		}
 
 	}
+}
+
+
+void gkGameObjectInstance::queueInstance(gkInstancedManager* queue)
+{
+	GK_ASSERT(queue);
+
+	if (isInstanced() || !m_owner || !m_owner->getOwner())
+		return;
+
+	gkScene* scene = m_owner->getOwner();
+
+	// entities need their skeleton before they are created
+	linkSkeletons();
+
+	queue->addStreamInstanceQueue(m_owner);
+
+	Objects::Iterator iter = m_objects.iterator();
+	while (iter.hasMoreElements())
+	{
+		gkGameObject* gobj = iter.getNext().second;
+		gobj->setOwner(scene);
+		queue->addStreamInstanceQueue(gobj);
+	}
+
+	GroupInstances::Iterator giter = m_groupInstances.iterator();
+	while (giter.hasMoreElements())
+		giter.getNext().second->queueInstance(queue);
+
+	// parents and physics once all objects exist
+	queue->addStreamInstanceQueue(this);
+}
+
+
+void gkGameObjectInstance::_getQueued(gkInstancedManager::Instances& queued)
+{
+	if (isInstanced())
+		return;
+
+	queued.insert(this);
+	if (m_owner)
+		queued.insert(m_owner);
+
+	Objects::Iterator iter = m_objects.iterator();
+	while (iter.hasMoreElements())
+		queued.insert(iter.getNext().second);
+
+	GroupInstances::Iterator giter = m_groupInstances.iterator();
+	while (giter.hasMoreElements())
+		giter.getNext().second->_getQueued(queued);
+}
+
+
+void gkGameObjectInstance::createInstanceImpl(void)
+{
+	if (!m_owner || !m_owner->getOwner())
+	{
+		m_instanceState = ST_ERROR;
+		m_instanceError = "Root object is not in any scene!";
+		return;
+	}
+
+
+	gkScene* scene = m_owner->getOwner();
+
+	m_owner->createInstance();
+	gkGameObjectSet parentingPhysicsObjs;
+
+	linkSkeletons();
+
 	// now instantiate the group-instance-objects
 	{
 		Objects::Iterator iter = m_objects.iterator();
@@ -451,6 +515,10 @@ void gkGameObjectInstance::postCreateInstanceImpl(void)
 
 
 	applyTransform(m_owner->getTransformState());
+
+	// join the static batches of an already batched group
+	if (m_parent)
+		m_parent->_notifyInstanceCreated(this);
 }
 
 
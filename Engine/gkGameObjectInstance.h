@@ -56,6 +56,8 @@ protected:
 
 	void notifyGameObjectEvent(gkGameObject* gobj, const gkGameObject::Notifier::Event& id);
 
+	void linkSkeletons(void);
+
 	void createInstanceImpl(void);
 	void postCreateInstanceImpl(void);
 	void destroyInstanceImpl(void);
@@ -94,6 +96,13 @@ public:
 	                  const gkVector3& angularVelocity = gkVector3::ZERO,
 	                  bool tsAngLocal = true);
 
+	///Creates the instance through queue, one object per request, so the queue's
+	///budget spreads a large group over several frames. Nested instances are queued too.
+	void queueInstance(gkInstancedManager* queue);
+
+	///Adds the objects queueInstance may have queued to queued.
+	void _getQueued(gkInstancedManager::Instances& queued);
+
 	void _updateFromGroup(gkGameObjectGroup* group);
 	void _setExternalRoot(gkGameObjectGroup* group, gkGameObject* root);
 
@@ -64,7 +64,11 @@ void gkGroupManager::attachGroupToScene(gkScene* scene, gkGameObjectGroup* group
 		void notifyResourceDestroyed(gkResource* res)
 		{
 			if (gkGroupManager::getSingletonPtr())
+			{
+				// batches must not outlive their scene
+				m_this->destroyStaticBatches((gkScene*)res);
 				m_this->m_attachements.erase((gkScene*)res);
+			}
 		}
 	};
 
@@ -97,14 +101,14 @@ gkGroupManager::Groups::Iterator gkGroupManager::getAttachedGroupIterator(gkScen
 
 // instantiate group-instances that should be create in the specified scene
 // for that check all groups from all scenes which will only instantiate valid ones
-void gkGroupManager::createGameObjectInstances(gkScene* scene)
+void gkGroupManager::createGameObjectInstances(gkScene* scene, gkInstancedManager* queue)
 {
 	GroupAttachements::Iterator it = m_attachements.iterator();
 	while (it.hasMoreElements())
 	{
 		Groups::Iterator sceneGroups = it.getNext().second;
 		while (sceneGroups.hasMoreElements())
-			sceneGroups.getNext()->createGameObjectInstances(scene);
+			sceneGroups.getNext()->createGameObjectInstances(scene, queue);
 	}
 }
 
@@ -134,16 +138,32 @@ void gkGroupManager::createStaticBatches(gkScene* scene)
 }
 
 
-void gkGroupManager::destroyStaticBatches(gkScene* scene)
+bool gkGroupManager::updateStaticBatches(gkScene* scene)
 {
-	UTsize pos;
-	if ((pos = m_attachements.find(scene)) != UT_NPOS)
+	GroupAttachements::Iterator it = m_attachements.iterator();
+	while (it.hasMoreElements())
 	{
-		Groups::Iterator it = m_attachements.at(pos).iterator();
-		while (it.hasMoreElements())
-			it.getNext()->destroyStaticBatches(scene);
+		Groups::Iterator sceneGroups = it.getNext().second;
+		while (sceneGroups.hasMoreElements())
+		{
+			// one region per call
+			if (sceneGroups.getNext()->updateStaticBatches(scene))
+				return true;
+		}
 	}
+	return false;
+}
+
 
+void gkGroupManager::destroyStaticBatches(gkScene* scene)
+{
+	// any group may be batched in this scene, attached to it or not
+	gkResourceManager::ResourceIterator it = getResourceIterator();
+	while (it.hasMoreElements())
+	{
+		gkGameObjectGroup* grp = static_cast<gkGameObjectGroup*>(it.getNext().second);
+		grp->destroyStaticBatches(scene);
+	}
 }
 
 void gkGroupManager::notifyDestroyAllImpl(void)
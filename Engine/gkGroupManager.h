@@ -48,7 +48,8 @@ public:
 
 
 	///Place all of gkGameObjectGroup's instances in the Ogre scene
-	void createGameObjectInstances(gkScene* scene);
+	///(or in the create queue of \a queue)
+	void createGameObjectInstances(gkScene* scene, gkInstancedManager* queue = 0);
 
 	///Remove all of gkGameObjectGroup's instances in the Ogre scene
 	void destroyGameObjectInstances(gkScene* scene);
@@ -57,6 +58,9 @@ public:
 	void createStaticBatches(gkScene* scene);
 	void destroyStaticBatches(gkScene* scene);
 
+	///Rebuild at most one dirty static batch region, returns true if one was rebuilt
+	bool updateStaticBatches(gkScene* scene);
+
 
 	void attachGroupToScene(gkScene* sc, gkGameObjectGroup* group);
 	Groups::Iterator getAttachedGroupIterator(gkScene* sc);
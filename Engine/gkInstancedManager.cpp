@@ -26,10 +26,12 @@
 */
 #include "gkInstancedManager.h"
 #include "gkInstancedObject.h"
+#include "OgreTimer.h"
 
 
 gkInstancedManager::gkInstancedManager(const gkString& type, const gkString& rtype)
-	:    gkResourceManager(type, rtype)
+	:    gkResourceManager(type, rtype),
+	     m_queueBudget(0)
 {
 }
 
@@ -66,11 +68,12 @@ void gkInstancedManager::destroyAllInstances(void)
 
 void gkInstancedManager::addCreateInstanceQueue(gkInstancedObject* iobj)
 {
+	// No duplicate check, creating an instanced object twice is a no-op.
+	// (Scenes queue thousands of objects here when instancing incrementally.)
 	if (iobj && !iobj->isInstanced())
 	{
 		InstanceParam p = {iobj, InstanceParam::CREATE};
-		if (m_instanceQueue.find(p))
-			m_instanceQueue.push_back(p);
+		m_instanceQueue.push_back(p);
 	}
 
 
@@ -78,13 +81,23 @@ void gkInstancedManager::addCreateInstanceQueue(gkInstancedObject* iobj)
 
 
 
+void gkInstancedManager::addStreamInstanceQueue(gkInstancedObject* iobj)
+{
+	if (iobj && !iobj->isInstanced())
+	{
+		InstanceParam p = {iobj, InstanceParam::STREAM};
+		m_instanceQueue.push_back(p);
+	}
+}
+
+
+
 void gkInstancedManager::addDestroyInstanceQueue(gkInstancedObject* iobj)
 {
 	if (iobj && iobj->isInstanced())
 	{
 		InstanceParam p = {iobj, InstanceParam::DESTROY};
-		if (m_instanceQueue.find(p))
-			m_instanceQueue.push_back(p);
+		m_instanceQueue.push_back(p);
 	}
 }
 
@@ -93,18 +106,64 @@ void gkInstancedManager::addReInstanceQueue(gkInstancedObject* iobj)
 	if (iobj && iobj->isInstanced())
 	{
 		InstanceParam p = {iobj, InstanceParam::REINSTANCE};
-		if (m_instanceQueue.find(p))
+		if (m_instanceQueue.find(p) == UT_NPOS)
 			m_instanceQueue.push_back(p);
 	}
 }
 
+
+void gkInstancedManager::removeQueued(Instances& objs)
+{
+	if (objs.empty() || m_instanceQueue.empty())
+		return;
+
+	// cleared rather than erased, this may run from within postProcessQueue
+	UTsize i;
+	for (i = 0; i < m_instanceQueue.size(); ++i)
+	{
+		if (m_instanceQueue[i].first && objs.find(m_instanceQueue[i].first) != UT_NPOS)
+			m_instanceQueue[i].first = 0;
+	}
+}
+
+
+void gkInstancedManager::_notifyDeleted(gkInstancedObject* iobj)
+{
+	UTsize i;
+	for (i = 0; i < m_instanceQueue.size(); ++i)
+	{
+		if (m_instanceQueue[i].first == iobj)
+			m_instanceQueue[i].first = 0;
+	}
+}
+
+
 void gkInstancedManager::postProcessQueue(void)
 {
-	InstanceParams::Iterator it = m_instanceQueue.iterator();
+	if (m_instanceQueue.empty())
+		return;
 
-	while (it.hasMoreElements())
+	Ogre::Timer timer;
+	const unsigned long budget = (unsigned long)(m_queueBudget * 1000.f);
+
+	// Requests may queue others, so index the array rather than iterating it.
+	// Streamed creates left once out of time move to the front, in order.
+	bool outOfTime = false;
+	UTsize i, n = 0;
+	for (i = 0; i < m_instanceQueue.size(); ++i)
 	{
-		InstanceParam& iq = it.getNext();
+		if (!m_instanceQueue[i].first)
+			continue;
+
+		if (outOfTime && m_instanceQueue[i].second == InstanceParam::STREAM)
+		{
+			m_instanceQueue[n++] = m_instanceQueue[i];
+			continue;
+		}
+
+		// cleared so removeQueued and _notifyDeleted skip it
+		InstanceParam iq = m_instanceQueue[i];
+		m_instanceQueue[i].first = 0;
 
 		switch (iq.second)
 		{
@@ -117,10 +176,26 @@ void gkInstancedManager::postProcessQueue(void)
 		case InstanceParam::REINSTANCE:
 			iq.first->reinstance();
 			break;
+		case InstanceParam::STREAM:
+			iq.first->createInstance();
+			if (budget > 0 && timer.getMicroseconds() >= budget)
+				outOfTime = true;
+			break;
 		}
 	}
 
-	m_instanceQueue.clear(true);
+	// kept entries may have been cleared since they were moved
+	UTsize k = 0;
+	for (i = 0; i < n; ++i)
+	{
+		if (m_instanceQueue[i].first)
+			m_instanceQueue[k++] = m_instanceQueue[i];
+	}
+
+	if (k > 0)
+		m_instanceQueue.resize(k);
+	else
+		m_instanceQueue.clear(true);
 }
 
 
@@ -28,6 +28,7 @@
 #define _gkInstancedManager_h_
 
 #include "gkResourceManager.h"
+#include "gkMathUtils.h"
 
 class gkInstancedManager : public gkResourceManager
 {
@@ -56,7 +57,8 @@ public:
 		{
 			REINSTANCE,
 			CREATE,
-			DESTROY
+			DESTROY,
+			STREAM      // create within the queue budget
 		};
 
 		gkInstancedObject* first;
@@ -74,10 +76,22 @@ public:
 	~gkInstancedManager();
 
 	void addCreateInstanceQueue(gkInstancedObject* iobj);
+	void addStreamInstanceQueue(gkInstancedObject* iobj);
 	void addDestroyInstanceQueue(gkInstancedObject* iobj);
 	void addReInstanceQueue(gkInstancedObject* iobj);
+	void removeQueued(Instances& objs);
 	void postProcessQueue(void);
 
+	///Drops the requests of an object being deleted.
+	void _notifyDeleted(gkInstancedObject* iobj);
+
+	///Milliseconds postProcessQueue may spend per call on streamed creates, zero
+	///processes them all. Streamed creates left over are kept in order for the next
+	///call, every other request is always processed in full.
+	GK_INLINE void     setQueueBudget(gkScalar ms)  {m_queueBudget = ms;}
+	GK_INLINE gkScalar getQueueBudget(void)         {return m_queueBudget;}
+	GK_INLINE UTsize   getQueueSize(void)           {return m_instanceQueue.size();}
+
 	void destroyGroupInstances(const gkString& group);
 	void destroyAllInstances(void);
 
@@ -97,6 +111,7 @@ public:
 protected:
 
 	InstanceParams m_instanceQueue;
+	gkScalar m_queueBudget;
 
 	Instances m_instances;
 	InstanceListeners m_instanceListeners;
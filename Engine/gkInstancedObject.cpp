@@ -40,6 +40,9 @@ gkInstancedObject::gkInstancedObject(gkInstancedManager* creator, const gkResour
 
 gkInstancedObject::~gkInstancedObject()
 {
+	// queued requests must not outlive the object
+	if (m_creator)
+		getInstanceCreator()->_notifyDeleted(this);
 }
 
 
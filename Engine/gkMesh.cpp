@@ -27,6 +27,7 @@
 #include "gkCommon.h"
 #include "gkMesh.h"
 #include "gkResourceManager.h"
+#include "OgreStringConverter.h"
 #include "BulletCollision/CollisionShapes/btTriangleMesh.h"
 
 
@@ -69,13 +70,17 @@ gkVertex& gkVertex::operator = (const gkVertex& o)
 
 
 
+// Welds vertices with the same source index and exactly the same attributes,
+// all variants of a source vertex along uv / normal seams are found again.
 class gkSubMeshIndexer
 {
 
 public:
 
-	typedef utHashTable<utIntHashKey, unsigned int> IndexMap;
-	IndexMap m_indexMap;
+	// vertices chained per attribute hash
+	typedef utHashTable<utIntHashKey, int> IndexMap;
+	IndexMap            m_heads;
+	utArray<int>        m_chain;
 
 	gkSubMeshIndexer() {}
 
@@ -83,32 +88,91 @@ public:
 
 	unsigned int getVertexIndex(gkSubMesh* sub, unsigned int index, const gkVertex& ref)
 	{
-		UTsize i = m_indexMap.find((int)index), fnd = UT_NPOS, size = sub->m_verts.size();
+		// vertices added past the indexer, ie; to a clone
+		if (m_chain.size() != sub->m_verts.size())
+			rebuild(sub);
 
-		if (i != UT_NPOS)
+		const int key = (int)vertHash(sub, index, ref);
+
+		UTsize pos = m_heads.find(key);
+		int cur = pos != UT_NPOS ? m_heads.at(pos) : -1;
+
+		while (cur != -1 && (sub->m_source.at(cur) != index || !vertEq(sub, sub->m_verts.at(cur), ref)))
+			cur = m_chain.at(cur);
+
+		if (cur != -1)
+			return (unsigned int)cur;
+
+		const UTsize size = sub->m_verts.size();
+		sub->m_bounds.merge(ref.co);
+		sub->m_verts.push_back(ref);
+		sub->m_source.push_back(index);
+		link(pos, key);
+		return (unsigned int)size;
+	}
+
+
+	void link(UTsize pos, int key)
+	{
+		const int vert = (int)m_chain.size();
+
+		if (pos != UT_NPOS)
 		{
-			UTsize sp = m_indexMap.at(i);
-			if (sp < size && vertEq(sub, sub->m_verts.at(sp), ref))
-				fnd = sp;
+			m_chain.push_back(m_heads.at(pos));
+			m_heads.at(pos) = vert;
 		}
+		else
+		{
+			m_chain.push_back(-1);
+			m_heads.insert(key, vert);
+		}
+	}
 
-		if (fnd == UT_NPOS)
+
+	void rebuild(gkSubMesh* sub)
+	{
+		m_heads.clear();
+		m_chain.clear();
+
+		// vertices pushed straight into the buffer have no source, never weld them
+		sub->m_source.resize(sub->m_verts.size(), (unsigned int)UT_NPOS);
+
+		for (UTsize i = 0; i < sub->m_verts.size(); ++i)
 		{
-			sub->m_bounds.merge(ref.co);
-			sub->m_verts.push_back(ref);
-			m_indexMap.insert((int)index, size);
-			return (unsigned int)size;
+			const int key = (int)vertHash(sub, sub->m_source.at(i), sub->m_verts.at(i));
+			link(m_heads.find(key), key);
 		}
+	}
+
 
-		return (unsigned int)fnd;
+	static UTuint32 mix(UTuint32 h, float f)
+	{
+		// + 0 folds -0 into 0
+		f += 0.f;
+		UTuint32 b;
+		memcpy(&b, &f, sizeof(b));
+		return (h ^ b) * 16777619u;
+	}
+
+
+	UTuint32 vertHash(gkSubMesh* sub, unsigned int index, const gkVertex& v)
+	{
+		UTuint32 h = index * 2654435761u;
+		h = mix(mix(mix(h, v.co.x), v.co.y), v.co.z);
+		h = mix(mix(mix(h, v.no.x), v.no.y), v.no.z);
+
+		if (sub->hasVertexColors())
+			h = (h ^ v.vcol) * 16777619u;
+
+		for (int i = 0; i < sub->getUvLayerCount(); i++)
+			h = mix(mix(h, v.uv[i].x), v.uv[i].y);
+		return h;
 	}
 
 
 	bool vertEq(gkSubMesh* sub, const gkVertex& a, const gkVertex& b)
 	{
-		if (!gkFuzzyT((a.co - b.co).squaredLength(), 1e-10))
-			return false;
-		if (!gkFuzzyT((a.no - b.no).squaredLength(), 1e-10))
+		if (a.co != b.co || a.no != b.no)
 			return false;
 
 		if (sub->hasVertexColors())
@@ -117,15 +181,12 @@ public:
 				return false;
 		}
 
-		bool result = true;
 		for (int i = 0; i < sub->getUvLayerCount(); i++)
 		{
-			result = gkFuzzyT((a.uv[i] - b.uv[i]).squaredLength(), 1e-10);
-			if (!result)
-				break;
+			if (a.uv[i] != b.uv[i])
+				return false;
 		}
-		return result;
-
+		return true;
 	}
 };
 
@@ -153,6 +214,7 @@ gkSubMesh* gkSubMesh::clone(void)
 	gkSubMesh* nme = new gkSubMesh();
 	nme->m_tris             = m_tris;
 	nme->m_verts            = m_verts;
+	nme->m_source           = m_source;
 	nme->m_uvlayers         = m_uvlayers;
 	nme->m_hasVertexColors  = m_hasVertexColors;
 	nme->m_boundsInit       = false;
@@ -463,3 +525,16 @@ void gkMesh::reload()
 }
 
 
+
+void gkMesh::parseLodValues(const gkString& str, LodValues& values)
+{
+	values.clear();
+
+	Ogre::StringVector items = Ogre::StringUtil::split(str, " ,\t");
+	for (UTsize i = 0; i < items.size(); ++i)
+	{
+		gkScalar v = Ogre::StringConverter::parseReal(items[i]);
+		if (v > 0)
+			values.push_back(v);
+	}
+}
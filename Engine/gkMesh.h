@@ -106,6 +106,7 @@ private:
 
 	Triangles           m_tris;
 	Verticies           m_verts;
+	utArray<unsigned int> m_source;     // source index per vertex, welds added triangles
 	int                 m_uvlayers;
 	gkBoundingBox       m_bounds;
 	bool                m_boundsInit;
@@ -177,6 +178,7 @@ public:
 	typedef utArray<gkSubMesh*>             SubMeshArray;
 	typedef utArrayIterator<SubMeshArray>   SubMeshIterator;
 	typedef utArray<gkVertexGroup*>         VertexGroups;
+	typedef utArray<gkScalar>               LodValues;
 	SubMeshArray         m_submeshes;
 
 private:
@@ -191,6 +193,8 @@ private:
 	UTsize               m_vertexCount;
 	UTsize               m_triFaceCount;
 
+	LodValues            m_lodValues;
+
 public:
 
 	gkMesh(gkResourceManager* creator, const gkResourceName& name, const gkResourceHandle& handle);
@@ -218,6 +222,16 @@ public:
 
 	gkMeshLoader* getLoader(void) {return m_meshLoader;}
 
+
+	///LOD strategy values (distances or pixel counts) of the generated detail levels,
+	///one level per value. Applied the next time the Ogre mesh loads, an empty list
+	///falls back to gkUserDefs::meshLodValues.
+	void setLodValues(const LodValues& v)   {m_lodValues = v;}
+	LodValues& getLodValues(void)           {return m_lodValues;}
+
+	///Space separated list, "25 50 100"
+	static void parseLodValues(const gkString& str, LodValues& values);
+
 	UTsize getMeshVertexCount(void);
 	const gkVertex& getMeshVertex(UTsize n);
 
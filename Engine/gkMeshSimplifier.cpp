@@ -0,0 +1,527 @@
+/*
+-------------------------------------------------------------------------------
+    This file is part of OgreKit.
+    http://gamekit.googlecode.com/
+
+    Copyright (c) 2006-2013 Charlie C.
+
+    Contributor(s): none yet.
+-------------------------------------------------------------------------------
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#include "gkMeshSimplifier.h"
+#include <math.h>
+#include <string.h>
+
+
+// iterations before giving up on the target count
+#define GK_SIMPLIFY_MAX_ITERATIONS  100
+
+// edges cheaper than 1e-9 * (iteration + 3) ^ GK_SIMPLIFY_AGGRESSIVENESS are collapsed
+#define GK_SIMPLIFY_AGGRESSIVENESS  7.0
+
+
+
+static void gkQuadricPlane(double* m, double a, double b, double c, double d)
+{
+	m[0] = a * a; m[1] = a * b; m[2] = a * c; m[3] = a * d;
+	m[4] = b * b; m[5] = b * c; m[6] = b * d;
+	m[7] = c * c; m[8] = c * d;
+	m[9] = d * d;
+}
+
+
+
+static double gkQuadricError(const double* q, const gkVector3& p)
+{
+	const double x = p.x, y = p.y, z = p.z;
+	return  q[0] * x * x + 2 * q[1] * x * y + 2 * q[2] * x * z + 2 * q[3] * x +
+	        q[4] * y * y + 2 * q[5] * y * z + 2 * q[6] * y +
+	        q[7] * z * z + 2 * q[8] * z +
+	        q[9];
+}
+
+
+
+static UTuint32 gkPositionHash(const gkVector3& co)
+{
+	// + 0 folds -0 into 0
+	float f[3] = { co.x + 0.f, co.y + 0.f, co.z + 0.f };
+	UTuint32 b[3];
+	memcpy(b, f, sizeof(b));
+	return (b[0] * 73856093u) ^ (b[1] * 19349663u) ^ (b[2] * 83492791u);
+}
+
+
+
+gkMeshSimplifier::gkMeshSimplifier(gkSubMesh* sub)
+	:    m_sub(sub),
+	     m_live(0),
+	     m_initialized(false)
+{
+}
+
+
+
+gkMeshSimplifier::~gkMeshSimplifier()
+{
+}
+
+
+
+void gkMeshSimplifier::initialize(void)
+{
+	m_initialized = true;
+
+	gkSubMesh::Verticies& verts = m_sub->getVertexBuffer();
+	gkSubMesh::Triangles& tris = m_sub->getIndexBuffer();
+
+	const UTsize nverts = verts.size();
+
+
+	// weld vertices by exact position, chained per hash
+	utHashTable<utIntHashKey, int> heads;
+	utArray<int> chain, groupOf;
+	chain.resize(nverts, -1);
+	groupOf.resize(nverts, -1);
+
+	UTsize i;
+	for (i = 0; i < nverts; ++i)
+	{
+		const gkVector3& co = verts[i].co;
+		const int key = (int)gkPositionHash(co);
+
+		UTsize pos = heads.find(key);
+		int cur = pos != UT_NPOS ? heads.at(pos) : -1;
+
+		while (cur != -1 && verts[cur].co != co)
+			cur = chain[cur];
+
+		if (cur != -1)
+		{
+			groupOf[i] = groupOf[cur];
+			continue;
+		}
+
+		groupOf[i] = (int)m_verts.size();
+
+		Vert v;
+		v.p = co;
+		memset(v.q.m, 0, sizeof(v.q.m));
+		v.tstart = v.tcount = 0;
+		v.border = false;
+		m_verts.push_back(v);
+
+		if (pos != UT_NPOS)
+		{
+			chain[i] = heads.at(pos);
+			heads.at(pos) = (int)i;
+		}
+		else
+			heads.insert(key, (int)i);
+	}
+
+
+	// members per welded vertex
+	m_memberStart.resize(m_verts.size() + 1, 0);
+	for (i = 0; i < nverts; ++i)
+		m_memberStart[groupOf[i] + 1]++;
+	for (i = 1; i <= m_verts.size(); ++i)
+		m_memberStart[i] += m_memberStart[i - 1];
+
+	utArray<int> fill;
+	fill.resize(m_verts.size(), 0);
+	m_members.resize(nverts);
+	for (i = 0; i < nverts; ++i)
+	{
+		int g = groupOf[i];
+		m_members[m_memberStart[g] + fill[g]++] = (unsigned int)i;
+	}
+
+
+	for (i = 0; i < tris.size(); ++i)
+	{
+		const gkTriangle& src = tris[i];
+
+		Tri t;
+		t.corner[0] = src.i0;
+		t.corner[1] = src.i1;
+		t.corner[2] = src.i2;
+		t.v[0] = groupOf[src.i0];
+		t.v[1] = groupOf[src.i1];
+		t.v[2] = groupOf[src.i2];
+		t.flag = src.flag;
+		t.deleted = t.dirty = false;
+
+		// degenerate after welding
+		if (t.v[0] == t.v[1] || t.v[1] == t.v[2] || t.v[2] == t.v[0])
+			continue;
+
+		m_tris.push_back(t);
+	}
+
+	m_live = m_tris.size();
+
+
+	updateMesh(false);
+
+
+	// quadrics from the planes of the adjacent triangles
+	for (i = 0; i < m_tris.size(); ++i)
+	{
+		Tri& t = m_tris[i];
+		const gkVector3& p0 = m_verts[t.v[0]].p;
+
+		t.n = (m_verts[t.v[1]].p - p0).crossProduct(m_verts[t.v[2]].p - p0);
+		t.n.normalise();
+
+		double plane[10];
+		gkQuadricPlane(plane, t.n.x, t.n.y, t.n.z, -t.n.dotProduct(p0));
+
+		for (int j = 0; j < 3; ++j)
+		{
+			double* q = m_verts[t.v[j]].q.m;
+			for (int k = 0; k < 10; ++k)
+				q[k] += plane[k];
+		}
+	}
+
+
+	// an edge used by a single triangle is a border
+	utArray<int> vcount, vids;
+	for (i = 0; i < m_verts.size(); ++i)
+	{
+		Vert& v = m_verts[i];
+		vcount.clear(true);
+		vids.clear(true);
+
+		for (int j = 0; j < v.tcount; ++j)
+		{
+			const Tri& t = m_tris[m_refs[v.tstart + j].tid];
+			for (int k = 0; k < 3; ++k)
+			{
+				UTsize ofs = vids.find(t.v[k]);
+				if (ofs == UT_NPOS)
+				{
+					vids.push_back(t.v[k]);
+					vcount.push_back(1);
+				}
+				else
+					vcount[ofs]++;
+			}
+		}
+
+		for (UTsize j = 0; j < vcount.size(); ++j)
+		{
+			if (vcount[j] == 1)
+				m_verts[vids[j]].border = true;
+		}
+	}
+
+
+	for (i = 0; i < m_tris.size(); ++i)
+	{
+		Tri& t = m_tris[i];
+		bool keep;
+		for (int j = 0; j < 3; ++j)
+			t.err[j] = calculateError(t.v[j], t.v[(j + 1) % 3], keep);
+		t.err[3] = gkMin(t.err[0], gkMin(t.err[1], t.err[2]));
+	}
+}
+
+
+
+void gkMeshSimplifier::updateMesh(bool compact)
+{
+	UTsize i;
+
+	if (compact)
+	{
+		UTsize dst = 0;
+		for (i = 0; i < m_tris.size(); ++i)
+		{
+			if (!m_tris[i].deleted)
+				m_tris[dst++] = m_tris[i];
+		}
+		m_tris.resize(dst);
+	}
+
+
+	// triangle references per vertex
+	for (i = 0; i < m_verts.size(); ++i)
+	{
+		m_verts[i].tstart = 0;
+		m_verts[i].tcount = 0;
+	}
+
+	for (i = 0; i < m_tris.size(); ++i)
+	{
+		const Tri& t = m_tris[i];
+		for (int j = 0; j < 3; ++j)
+			m_verts[t.v[j]].tcount++;
+	}
+
+	int tstart = 0;
+	for (i = 0; i < m_verts.size(); ++i)
+	{
+		Vert& v = m_verts[i];
+		v.tstart = tstart;
+		tstart += v.tcount;
+		v.tcount = 0;
+	}
+
+	m_refs.resize(m_tris.size() * 3);
+	for (i = 0; i < m_tris.size(); ++i)
+	{
+		const Tri& t = m_tris[i];
+		for (int j = 0; j < 3; ++j)
+		{
+			Vert& v = m_verts[t.v[j]];
+			Ref& r = m_refs[v.tstart + v.tcount++];
+			r.tid = (int)i;
+			r.tvertex = j;
+		}
+	}
+}
+
+
+
+double gkMeshSimplifier::calculateError(int i0, int i1, bool& keepFirst)
+{
+	Quadric q;
+	for (int k = 0; k < 10; ++k)
+		q.m[k] = m_verts[i0].q.m[k] + m_verts[i1].q.m[k];
+
+	double e0 = gkQuadricError(q.m, m_verts[i0].p);
+	double e1 = gkQuadricError(q.m, m_verts[i1].p);
+
+	keepFirst = e0 <= e1;
+	return keepFirst ? e0 : e1;
+}
+
+
+
+bool gkMeshSimplifier::flipped(const gkVector3& p, int i0, Vert& v1, utArray<char>& deleted)
+{
+	for (int k = 0; k < v1.tcount; ++k)
+	{
+		const Ref& r = m_refs[v1.tstart + k];
+		const Tri& t = m_tris[r.tid];
+		if (t.deleted)
+			continue;
+
+		int id1 = t.v[(r.tvertex + 1) % 3];
+		int id2 = t.v[(r.tvertex + 2) % 3];
+
+		// shares the collapsed edge, removed
+		if (id1 == i0 || id2 == i0)
+		{
+			deleted[k] = 1;
+			continue;
+		}
+
+		gkVector3 d1 = m_verts[id1].p - p;
+		gkVector3 d2 = m_verts[id2].p - p;
+		d1.normalise();
+		d2.normalise();
+
+		if (gkAbs(d1.dotProduct(d2)) > 0.999f)
+			return true;
+
+		gkVector3 n = d1.crossProduct(d2);
+		n.normalise();
+
+		deleted[k] = 0;
+		if (n.dotProduct(t.n) < 0.2f)
+			return true;
+	}
+	return false;
+}
+
+
+
+unsigned int gkMeshSimplifier::findCorner(int group, unsigned int oldCorner)
+{
+	// the vertex at the new position with the closest attributes
+	gkSubMesh::Verticies& verts = m_sub->getVertexBuffer();
+	const gkVertex& ref = verts[oldCorner];
+	const int layers = m_sub->getUvLayerCount();
+
+	unsigned int best = m_members[m_memberStart[group]];
+	gkScalar bestDist = GK_INFINITY;
+
+	for (int i = m_memberStart[group]; i < m_memberStart[group + 1]; ++i)
+	{
+		const gkVertex& cand = verts[m_members[i]];
+
+		gkScalar dist = 1.f - cand.no.dotProduct(ref.no);
+		if (layers > 0)
+			dist += (cand.uv[0] - ref.uv[0]).squaredLength();
+
+		if (dist < bestDist)
+		{
+			bestDist = dist;
+			best = m_members[i];
+		}
+	}
+	return best;
+}
+
+
+
+void gkMeshSimplifier::updateTriangles(int i0, Vert& v, utArray<char>& deleted)
+{
+	bool keep;
+	for (int k = 0; k < v.tcount; ++k)
+	{
+		// copied, m_refs may grow
+		Ref r = m_refs[v.tstart + k];
+		Tri& t = m_tris[r.tid];
+		if (t.deleted)
+			continue;
+
+		if (deleted[k])
+		{
+			t.deleted = true;
+			m_live--;
+			continue;
+		}
+
+		if (t.v[r.tvertex] != i0)
+		{
+			t.v[r.tvertex] = i0;
+			t.corner[r.tvertex] = findCorner(i0, t.corner[r.tvertex]);
+
+			const gkVector3& p0 = m_verts[t.v[0]].p;
+			t.n = (m_verts[t.v[1]].p - p0).crossProduct(m_verts[t.v[2]].p - p0);
+			t.n.normalise();
+		}
+
+		t.dirty = true;
+		for (int j = 0; j < 3; ++j)
+			t.err[j] = calculateError(t.v[j], t.v[(j + 1) % 3], keep);
+		t.err[3] = gkMin(t.err[0], gkMin(t.err[1], t.err[2]));
+
+		m_refs.push_back(r);
+	}
+}
+
+
+
+void gkMeshSimplifier::simplify(UTsize targetTris, gkSubMesh::Triangles& out)
+{
+	if (!m_initialized)
+		initialize();
+
+	utArray<char> deleted0, deleted1;
+
+	for (int iteration = 0; iteration < GK_SIMPLIFY_MAX_ITERATIONS && m_live > targetTris; ++iteration)
+	{
+		if (iteration % 5 == 0)
+			updateMesh(true);
+
+		UTsize i;
+		for (i = 0; i < m_tris.size(); ++i)
+			m_tris[i].dirty = false;
+
+		const double threshold = 0.000000001 * pow(double(iteration + 3), GK_SIMPLIFY_AGGRESSIVENESS);
+
+		for (i = 0; i < m_tris.size() && m_live > targetTris; ++i)
+		{
+			Tri& t = m_tris[i];
+			if (t.err[3] > threshold || t.deleted || t.dirty)
+				continue;
+
+			for (int j = 0; j < 3; ++j)
+			{
+				if (t.err[j] >= threshold)
+					continue;
+
+				int i0 = t.v[j];
+				int i1 = t.v[(j + 1) % 3];
+
+				if (m_verts[i0].border != m_verts[i1].border)
+					continue;
+
+				// i0 survives at its own position
+				bool keepFirst;
+				calculateError(i0, i1, keepFirst);
+				if (!keepFirst)
+				{
+					int tmp = i0;
+					i0 = i1;
+					i1 = tmp;
+				}
+
+				Vert& v0 = m_verts[i0];
+				Vert& v1 = m_verts[i1];
+
+				deleted0.resize(v0.tcount, 0);
+				deleted1.resize(v1.tcount, 0);
+
+				if (flipped(v0.p, i0, v1, deleted1))
+					continue;
+
+				// triangles around i0 only go if they share the edge
+				for (int k = 0; k < v0.tcount; ++k)
+				{
+					const Tri& t0 = m_tris[m_refs[v0.tstart + k].tid];
+					deleted0[k] = (t0.v[0] == i1 || t0.v[1] == i1 || t0.v[2] == i1) ? 1 : 0;
+				}
+
+				for (int k = 0; k < 10; ++k)
+					v0.q.m[k] += v1.q.m[k];
+
+				int tstart = (int)m_refs.size();
+				updateTriangles(i0, v0, deleted0);
+				updateTriangles(i0, v1, deleted1);
+				int tcount = (int)m_refs.size() - tstart;
+
+				if (tcount <= v0.tcount)
+				{
+					// reuse the old slot
+					for (int k = 0; k < tcount; ++k)
+						m_refs[v0.tstart + k] = m_refs[tstart + k];
+					m_refs.resize(tstart);
+				}
+				else
+					v0.tstart = tstart;
+
+				v0.tcount = tcount;
+				v1.tcount = 0;
+				break;
+			}
+		}
+	}
+
+
+	out.clear(true);
+	for (UTsize i = 0; i < m_tris.size(); ++i)
+	{
+		const Tri& t = m_tris[i];
+		if (t.deleted)
+			continue;
+
+		gkTriangle tri;
+		tri.i0 = t.corner[0];
+		tri.i1 = t.corner[1];
+		tri.i2 = t.corner[2];
+		tri.flag = t.flag;
+		out.push_back(tri);
+	}
+}
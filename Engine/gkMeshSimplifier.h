@@ -0,0 +1,106 @@
+/*
+-------------------------------------------------------------------------------
+    This file is part of OgreKit.
+    http://gamekit.googlecode.com/
+
+    Copyright (c) 2006-2013 Charlie C.
+
+    Contributor(s): none yet.
+-------------------------------------------------------------------------------
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#ifndef _gkMeshSimplifier_h_
+#define _gkMeshSimplifier_h_
+
+#include "gkMesh.h"
+
+
+///Quadric error edge collapse on the triangles of a gkSubMesh.
+///
+///Vertices sharing a position are welded first, so uv and normal seams do not
+///stop collapses. Every collapse keeps one of its end points (half edge collapse),
+///hence the reduced triangles index the unchanged sub mesh vertex buffer and
+///only new index buffers are needed per detail level.
+///simplify can be called repeatedly with decreasing targets, each call continues
+///from the previous result.
+class gkMeshSimplifier
+{
+public:
+	gkMeshSimplifier(gkSubMesh* sub);
+	~gkMeshSimplifier();
+
+	///Collapses edges until at most \a targetTris triangles remain or no edge is
+	///cheap enough, then writes the remaining triangles to \a out.
+	void simplify(UTsize targetTris, gkSubMesh::Triangles& out);
+
+	GK_INLINE UTsize getTriangleCount(void) const {return m_live;}
+
+private:
+	struct Quadric
+	{
+		double m[10];
+	};
+
+	struct Tri
+	{
+		int             v[3];       // welded vertices
+		unsigned int    corner[3];  // sub mesh vertices
+		double          err[4];
+		gkVector3       n;
+		int             flag;
+		bool            deleted;
+		bool            dirty;
+	};
+
+	struct Vert
+	{
+		gkVector3   p;
+		Quadric     q;
+		int         tstart;
+		int         tcount;
+		bool        border;
+	};
+
+	struct Ref
+	{
+		int tid;
+		int tvertex;
+	};
+
+	void initialize(void);
+	void updateMesh(bool compact);
+	double calculateError(int i0, int i1, bool& keepFirst);
+	bool flipped(const gkVector3& p, int i0, Vert& v1, utArray<char>& deleted);
+	void updateTriangles(int i0, Vert& v, utArray<char>& deleted);
+	unsigned int findCorner(int group, unsigned int oldCorner);
+
+	gkSubMesh*      m_sub;
+	utArray<Tri>    m_tris;
+	utArray<Vert>   m_verts;
+	utArray<Ref>    m_refs;
+
+	// sub mesh vertices per welded vertex
+	utArray<int>            m_memberStart;
+	utArray<unsigned int>   m_members;
+
+	UTsize          m_live;
+	bool            m_initialized;
+};
+
+
+#endif//_gkMeshSimplifier_h_
@@ -31,6 +31,7 @@
 #include "OgreRenderWindow.h"
 #include "OgreViewport.h"
 #include "OgreStringConverter.h"
+#include "OgreTimer.h"
 
 #include "gkWindowSystem.h"
 #include "gkWindow.h"
@@ -58,6 +59,9 @@
 #include "gkConstraintManager.h"
 #include "gkGroupManager.h"
 #include "gkGameObjectManager.h"
+#include "gkGameObjectInstance.h"
+#include "gkEntityInstancer.h"
+#include "gkActivityCuller.h"
 
 #ifdef OGREKIT_USE_NNODE
 #include "gkNodeManager.h"
@@ -86,6 +90,8 @@
 #include "gkBone.h"
 #include "OgreTagPoint.h"
 #include "gkCurve.h"
+#include "gkSceneSnapshot.h"
+#include "gkVariable.h"
 
 using Ogre::TagPoint;
 
@@ -107,15 +113,25 @@ gkScene::gkScene(gkInstancedManager* creator, const gkResourceName& name, const
 	     m_debugger(0),
 	     m_hasLights(false),
 	     m_markDBVT(false),
+	     m_dbvtObjectsMoved(true),
 	     m_cloneCount(0),
+	     m_cloneTick(0),
 	     m_layers(0xFFFFFFFF),
 	     m_skybox(0),
+	     m_entityInstancer(0),
+	     m_activityCuller(0),
 		 m_window(0),
 		 m_updateFlags(UF_ALL),
 		 m_blendFile(0),
 	     m_renderToViewport(true),
 	     m_zorder(0),
-	     m_logicBrickManager(0)
+	     m_logicBrickManager(0),
+	     m_instancingPhase(IP_NONE),
+	     m_instancingBudget(-1),
+	     m_instancingListener(0),
+	     m_pendingCursor(0),
+	     m_pendingTotal(0),
+	     m_prevQueueBudget(0)
 #ifdef OGREKIT_USE_PROCESSMANAGER
 		,m_processManager(0)
 #endif
@@ -605,6 +621,231 @@ gkDynamicsWorld* gkScene::getDynamicsWorld(void)
 }
 
 
+void gkScene::saveSnapshot(gkSceneSnapshot& snap)
+{
+	snap.clear();
+
+	if (!isInstanced())
+		return;
+
+
+	UTsize i;
+	for (i = 0; i < m_instanceObjects.size(); ++i)
+	{
+		gkGameObject* obj = m_instanceObjects.at(i);
+
+		gkSceneSnapshot::Object state;
+		state.m_object          = obj;
+		state.m_transform       = obj->getTransformState();
+		state.m_firstVariable   = snap.m_variables.size();
+		state.m_variableCount   = 0;
+
+		const gkGameObject::VariableMap& vars = obj->getVariables();
+		for (UTsize v = 0; v < vars.size(); ++v)
+		{
+			gkVariable* var = vars.at(v);
+
+			gkSceneSnapshot::Variable value;
+			value.m_variable = var;
+			value.m_type     = var->getType();
+			value.m_int      = 0;
+			value.m_offset   = snap.m_reals.size();
+
+			switch (value.m_type)
+			{
+			case gkVariable::VAR_BOOL:
+				value.m_int = var->getValueBool() ? 1 : 0;
+				break;
+			case gkVariable::VAR_INT:
+				value.m_int = var->getValueInt();
+				break;
+			case gkVariable::VAR_REAL:
+				snap.m_reals.push_back(var->getValueReal());
+				break;
+			case gkVariable::VAR_VEC2:
+				{
+					gkVector2 vec = var->getValueVector2();
+					snap.m_reals.push_back(vec.x);
+					snap.m_reals.push_back(vec.y);
+				}
+				break;
+			case gkVariable::VAR_VEC3:
+				{
+					gkVector3 vec = var->getValueVector3();
+					snap.m_reals.push_back(vec.x);
+					snap.m_reals.push_back(vec.y);
+					snap.m_reals.push_back(vec.z);
+				}
+				break;
+			case gkVariable::VAR_VEC4:
+				{
+					gkVector4 vec = var->getValueVector4();
+					for (int c = 0; c < 4; ++c)
+						snap.m_reals.push_back(vec[c]);
+				}
+				break;
+			case gkVariable::VAR_QUAT:
+				{
+					gkQuaternion q = var->getValueQuaternion();
+					for (int c = 0; c < 4; ++c)
+						snap.m_reals.push_back(q[c]);
+				}
+				break;
+			case gkVariable::VAR_MAT3:
+				{
+					gkMatrix3 m = var->getValueMatrix3();
+					for (int c = 0; c < 9; ++c)
+						snap.m_reals.push_back(m[c / 3][c % 3]);
+				}
+				break;
+			case gkVariable::VAR_MAT4:
+				{
+					gkMatrix4 m = var->getValueMatrix4();
+					for (int c = 0; c < 16; ++c)
+						snap.m_reals.push_back(m[c / 4][c % 4]);
+				}
+				break;
+			case gkVariable::VAR_STRING:
+				value.m_offset = snap.m_stringCount++;
+				if (value.m_offset == snap.m_strings.size())
+					snap.m_strings.push_back(var->getValueString());
+				else
+					snap.m_strings[value.m_offset] = var->getValueString();
+				break;
+			default:
+				continue;
+			}
+
+			snap.m_variables.push_back(value);
+			++state.m_variableCount;
+		}
+
+		snap.m_objects.push_back(state);
+	}
+
+	if (m_physicsWorld)
+		m_physicsWorld->saveState(snap.m_physics);
+
+	snap.m_valid = true;
+}
+
+
+
+bool gkScene::restoreSnapshot(const gkSceneSnapshot& snap)
+{
+	if (!snap.isValid() || !isInstanced())
+		return false;
+
+
+	UTsize i;
+	for (i = 0; i < snap.m_objects.size(); ++i)
+	{
+		const gkSceneSnapshot::Object& state = snap.m_objects[i];
+		gkGameObject* obj = state.m_object;
+
+		if (m_instanceObjects.find(obj) == UT_NPOS)
+			continue;
+
+		// untouched objects are not marked as moved
+		if (obj->getTransformState() != state.m_transform)
+			obj->applyTransformState(state.m_transform);
+
+
+		const gkGameObject::VariableMap& vars = obj->getVariables();
+
+		for (UTsize v = 0; v < state.m_variableCount; ++v)
+		{
+			const gkSceneSnapshot::Variable& value = snap.m_variables[state.m_firstVariable + v];
+			gkVariable* var = value.m_variable;
+
+			// removed since the save
+			bool found = false;
+			for (UTsize k = 0; k < vars.size() && !found; ++k)
+				found = vars.at(k) == var;
+			if (!found)
+				continue;
+
+			// setValue allocates, so only changed values are written back
+			const gkScalar* reals = value.m_offset < snap.m_reals.size() ? &snap.m_reals[value.m_offset] : 0;
+
+			switch (value.m_type)
+			{
+			case gkVariable::VAR_BOOL:
+				if (var->getType() != value.m_type || var->getValueBool() != (value.m_int != 0))
+					var->setValue(value.m_int != 0);
+				break;
+			case gkVariable::VAR_INT:
+				if (var->getType() != value.m_type || var->getValueInt() != value.m_int)
+					var->setValue(value.m_int);
+				break;
+			case gkVariable::VAR_REAL:
+				if (var->getType() != value.m_type || var->getValueReal() != reals[0])
+					var->setValue(reals[0]);
+				break;
+			case gkVariable::VAR_VEC2:
+				{
+					gkVector2 vec(reals[0], reals[1]);
+					if (var->getType() != value.m_type || var->getValueVector2() != vec)
+						var->setValue(vec);
+				}
+				break;
+			case gkVariable::VAR_VEC3:
+				{
+					gkVector3 vec(reals[0], reals[1], reals[2]);
+					if (var->getType() != value.m_type || var->getValueVector3() != vec)
+						var->setValue(vec);
+				}
+				break;
+			case gkVariable::VAR_VEC4:
+				{
+					gkVector4 vec(reals[0], reals[1], reals[2], reals[3]);
+					if (var->getType() != value.m_type || var->getValueVector4() != vec)
+						var->setValue(vec);
+				}
+				break;
+			case gkVariable::VAR_QUAT:
+				{
+					gkQuaternion q(reals[0], reals[1], reals[2], reals[3]);
+					if (var->getType() != value.m_type || var->getValueQuaternion() != q)
+						var->setValue(q);
+				}
+				break;
+			case gkVariable::VAR_MAT3:
+				{
+					gkMatrix3 m(reals[0], reals[1], reals[2],
+					            reals[3], reals[4], reals[5],
+					            reals[6], reals[7], reals[8]);
+					if (var->getType() != value.m_type || var->getValueMatrix3() != m)
+						var->setValue(m);
+				}
+				break;
+			case gkVariable::VAR_MAT4:
+				{
+					gkMatrix4 m(reals[0],  reals[1],  reals[2],  reals[3],
+					            reals[4],  reals[5],  reals[6],  reals[7],
+					            reals[8],  reals[9],  reals[10], reals[11],
+					            reals[12], reals[13], reals[14], reals[15]);
+					if (var->getType() != value.m_type || var->getValueMatrix4() != m)
+						var->setValue(m);
+				}
+				break;
+			case gkVariable::VAR_STRING:
+				if (var->getType() != value.m_type || var->getValueString() != snap.m_strings[value.m_offset])
+					var->setValue(snap.m_strings[value.m_offset]);
+				break;
+			}
+		}
+	}
+
+	// physics last, it owns the exact body transforms
+	if (m_physicsWorld)
+		m_physicsWorld->restoreState(snap.m_physics);
+
+	return true;
+}
+
+
+
 void gkScene::addConstraint(gkGameObject* gobj, gkConstraint* co)
 {
 	if (gobj && co)
@@ -1024,52 +1265,68 @@ void gkScene::createInstanceImpl(void)
 
 	m_skybox  = gkMaterialLoader::loadSceneSkyMaterial(this, m_baseProps.m_material);
 
+	if (gkEngine::getSingleton().getUserDefs().hardwareInstancing != gkEntityInstancer::IT_NONE)
+		m_entityInstancer = new gkEntityInstancer(this, gkEngine::getSingleton().getUserDefs().hardwareInstancing);
+
+	if (m_baseProps.m_activityCulling)
+		m_activityCuller = new gkActivityCuller(this);
 
 
 	// create the world
 	(void)getDynamicsWorld();
 
 
-	gkGameObjectHashMap::Iterator it = m_objects.iterator();
-	while (it.hasMoreElements())
+	gkScalar budget = getInstancingBudget();
+	if (budget > 0)
 	{
-		gkGameObject* gobj = it.getNext().second;
-
-		if (!gobj->isInstanced())
+		// objects, physics and logic are finished over the next frames
+		queueInstances(budget);
+	}
+	else
+	{
+		gkGameObjectHashMap::Iterator it = m_objects.iterator();
+		while (it.hasMoreElements())
 		{
-			// Skip creation of inactive layers
-			if (m_layers & gobj->getLayer())
+			gkGameObject* gobj = it.getNext().second;
+
+			if (!gobj->isInstanced())
 			{
-				// call builder
-				gobj->createInstance();
+				// Skip creation of inactive layers
+				if (m_layers & gobj->getLayer())
+				{
+					// call builder
+					gobj->createInstance();
+				}
 			}
 		}
-	}
 
-	// Build groups.
-	gkGroupManager::getSingleton().createGameObjectInstances(this);
+		// Build groups.
+		gkGroupManager::getSingleton().createGameObjectInstances(this);
 
-	if (gkEngine::getSingleton().getUserDefs().buildStaticGeometry)
-		gkGroupManager::getSingleton().createStaticBatches(this);
+		if (gkEngine::getSingleton().getUserDefs().buildStaticGeometry)
+			gkGroupManager::getSingleton().createStaticBatches(this);
 
+		createInstancedBatches();
 
-	gkGameObjectSet objs;
 
-	// hack!? need to be easier
-	gkGameObjectSet::Iterator iter(m_instanceObjects);
+		gkGameObjectSet objs;
 
-	while (iter.hasMoreElements()){
-		gkGameObject* obj = iter.getNext();
-		if (!obj->isGroupInstance())
-		{
-			objs.insert(obj);
+		// hack!? need to be easier
+		gkGameObjectSet::Iterator iter(m_instanceObjects);
+
+		while (iter.hasMoreElements()){
+			gkGameObject* obj = iter.getNext();
+			if (!obj->isGroupInstance())
+			{
+				objs.insert(obj);
+			}
 		}
-	}
-	// Build parent / child hierarchy.
-	_applyBuiltinParents(objs);
+		// Build parent / child hierarchy.
+		_applyBuiltinParents(objs);
 
-	// Build physics.
-	_applyBuiltinPhysics(objs);
+		// Build physics.
+		_applyBuiltinPhysics(objs);
+	}
 
 	if (!m_viewport)
 	{
@@ -1163,6 +1420,15 @@ void gkScene::createInstanceImpl(void)
 
 
 void gkScene::postCreateInstanceImpl(void)
+{
+	// incremental instancing runs it once the scene is complete
+	if (m_instancingPhase == IP_NONE)
+		executeStartupScript();
+}
+
+
+
+void gkScene::executeStartupScript(void)
 {
 #ifdef OGREKIT_USE_LUA
 	gkLuaScript* script = gkLuaManager::getSingleton().getByName<gkLuaScript>(gkResourceName(DEFAULT_STARTUP_LUA_FILE, getGroupName()));
@@ -1174,6 +1440,262 @@ void gkScene::postCreateInstanceImpl(void)
 
 
 
+gkScalar gkScene::getInstancingBudget(void)
+{
+	if (m_instancingBudget >= 0)
+		return m_instancingBudget;
+	return gkEngine::getSingleton().getUserDefs().instancingBudget;
+}
+
+
+
+void gkScene::queueInstances(gkScalar budget)
+{
+	gkGameObjectManager& mgr = gkGameObjectManager::getSingleton();
+	m_prevQueueBudget = mgr.getQueueBudget();
+	mgr.setQueueBudget(budget);
+
+
+	// Bucket objects by their parent depth so parents are created before their
+	// children, and other objects (skeletons, empties) before the entities of the same depth.
+	utArray<gkGameObjectArray> buckets;
+
+	gkGameObjectHashMap::Iterator it = m_objects.iterator();
+	while (it.hasMoreElements())
+	{
+		gkGameObject* gobj = it.getNext().second;
+
+		if (gobj->isInstanced() || !(m_layers & gobj->getLayer()))
+			continue;
+
+		if (gobj->getType() == GK_CAMERA)
+		{
+			// the viewport needs it right away
+			gobj->createInstance();
+			continue;
+		}
+
+		UTsize depth = 0;
+		gkGameObject* pobj = gobj;
+		while (depth < 64 && !pobj->getProperties().m_parent.empty())
+		{
+			UTsize pos = m_objects.find(gkHashedString(pobj->getProperties().m_parent));
+			if (pos == UT_NPOS)
+				break;
+
+			pobj = m_objects.at(pos);
+			++depth;
+		}
+
+		UTsize slot = depth * 2 + (gobj->getType() == GK_ENTITY ? 1 : 0);
+		if (buckets.size() <= slot)
+			buckets.resize(slot + 1);
+
+		buckets[slot].push_back(gobj);
+	}
+
+	UTsize i, j;
+	for (i = 0; i < buckets.size(); ++i)
+	{
+		gkGameObjectArray& bucket = buckets[i];
+		for (j = 0; j < bucket.size(); ++j)
+			mgr.addStreamInstanceQueue(bucket[j]);
+	}
+
+	// Groups go after the objects they may be parented to.
+	gkGroupManager::getSingleton().createGameObjectInstances(this, &mgr);
+
+
+	m_pendingObjects.clear();
+	m_pendingLinks.clear();
+	m_pendingCursor = 0;
+	m_pendingTotal = mgr.getQueueSize();
+	m_instancingPhase = IP_OBJECTS;
+}
+
+
+
+void gkScene::stepInstancing(void)
+{
+	Ogre::Timer timer;
+	const unsigned long budget = (unsigned long)(gkMax<gkScalar>(getInstancingBudget(), 0) * 1000.f);
+
+
+	if (m_instancingPhase == IP_OBJECTS)
+	{
+		// created by gkGameObjectManager::postProcessQueue
+		if (gkGameObjectManager::getSingleton().getQueueSize() > 0)
+		{
+			notifyInstancingProgress();
+			return;
+		}
+
+
+		gkGameObjectSet objs;
+
+		gkGameObjectSet::Iterator iter(m_instanceObjects);
+		while (iter.hasMoreElements())
+		{
+			gkGameObject* obj = iter.getNext();
+			if (!obj->isGroupInstance())
+			{
+				objs.insert(obj);
+				m_pendingObjects.push_back(obj);
+			}
+		}
+
+		// Build parent / child hierarchy.
+		_applyBuiltinParents(objs);
+
+		m_pendingCursor = 0;
+		m_instancingPhase = IP_PHYSICS;
+	}
+
+
+	if (m_instancingPhase == IP_PHYSICS)
+	{
+		while (m_pendingCursor < m_pendingObjects.size())
+		{
+			gkGameObject* obj = m_pendingObjects[m_pendingCursor++];
+			if (obj->isInstanced() && obj->getProperties().isPhysicsObject())
+			{
+				_createPhysicsObject(obj);
+				if (obj->getProperties().m_physics.isLinkedToOther())
+					m_pendingLinks.push_back(obj);
+			}
+
+			if (budget > 0 && timer.getMicroseconds() >= budget)
+				break;
+		}
+
+		if (m_pendingCursor < m_pendingObjects.size())
+		{
+			notifyInstancingProgress();
+			return;
+		}
+
+		m_pendingCursor = 0;
+		m_instancingPhase = IP_LINKS;
+	}
+
+
+	if (m_instancingPhase == IP_LINKS)
+	{
+		while (m_pendingCursor < m_pendingLinks.size())
+		{
+			gkGameObject* obj = m_pendingLinks[m_pendingCursor++];
+			if (obj->isInstanced())
+				_postCreatePhysicsObject(obj);
+
+			if (budget > 0 && timer.getMicroseconds() >= budget)
+				break;
+		}
+
+		if (m_pendingCursor < m_pendingLinks.size())
+		{
+			notifyInstancingProgress();
+			return;
+		}
+
+		finishInstancing();
+	}
+}
+
+
+
+void gkScene::notifyInstancingProgress(void)
+{
+	if (!m_instancingListener)
+		return;
+
+	// first half object creation, second half physics
+	gkScalar progress = 0.f;
+	if (m_instancingPhase == IP_OBJECTS)
+	{
+		UTsize left = gkMin<UTsize>(gkGameObjectManager::getSingleton().getQueueSize(), m_pendingTotal);
+		if (m_pendingTotal > 0)
+			progress = 0.5f * gkScalar(m_pendingTotal - left) / gkScalar(m_pendingTotal);
+	}
+	else
+	{
+		UTsize total = m_pendingObjects.size() + m_pendingLinks.size();
+		UTsize done = m_instancingPhase == IP_PHYSICS ? m_pendingCursor : m_pendingObjects.size() + m_pendingCursor;
+		progress = total > 0 ? 0.5f + 0.5f * gkScalar(done) / gkScalar(total) : 1.f;
+	}
+
+	m_instancingListener->notifyInstancingProgress(this, progress);
+}
+
+
+
+void gkScene::finishInstancing(void)
+{
+	m_pendingObjects.clear();
+	m_pendingLinks.clear();
+	m_pendingCursor = 0;
+	m_pendingTotal = 0;
+	m_instancingPhase = IP_NONE;
+	gkGameObjectManager::getSingleton().setQueueBudget(m_prevQueueBudget);
+
+	if (gkEngine::getSingleton().getUserDefs().buildStaticGeometry)
+		gkGroupManager::getSingleton().createStaticBatches(this);
+
+	createInstancedBatches();
+
+	m_markDBVT = true;
+	m_dbvtObjectsMoved = true;
+
+	executeStartupScript();
+
+	if (m_instancingListener)
+	{
+		m_instancingListener->notifyInstancingProgress(this, 1.f);
+		m_instancingListener->notifyInstancingFinished(this);
+	}
+}
+
+
+
+void gkScene::cancelInstancing(void)
+{
+	// Drop whatever is still waiting in the create queue.
+	gkInstancedManager::Instances queued;
+
+	gkGameObjectHashMap::Iterator it = m_objects.iterator();
+	while (it.hasMoreElements())
+	{
+		gkGameObject* gobj = it.getNext().second;
+		if (!gobj->isInstanced())
+			queued.insert(gobj);
+	}
+
+	gkResourceManager::ResourceIterator git = gkGroupManager::getSingleton().getResourceIterator();
+	while (git.hasMoreElements())
+	{
+		gkGameObjectGroup* group = static_cast<gkGameObjectGroup*>(git.getNext().second);
+
+		gkResourceManager::ResourceIterator iit = group->getInstances().getResourceIterator();
+		while (iit.hasMoreElements())
+		{
+			gkGameObjectInstance* inst = static_cast<gkGameObjectInstance*>(iit.getNext().second);
+			if (!inst->isInstanced() && inst->getRoot() && inst->getRoot()->getOwner() == this)
+				inst->_getQueued(queued);
+		}
+	}
+
+	gkGameObjectManager& mgr = gkGameObjectManager::getSingleton();
+	mgr.removeQueued(queued);
+	mgr.setQueueBudget(m_prevQueueBudget);
+
+	m_pendingObjects.clear();
+	m_pendingLinks.clear();
+	m_pendingCursor = 0;
+	m_pendingTotal = 0;
+	m_instancingPhase = IP_NONE;
+}
+
+
+
 
 void gkScene::destroyInstanceImpl(void)
 {
@@ -1183,6 +1705,9 @@ void gkScene::destroyInstanceImpl(void)
 	if (m_navMeshData.get())
 		m_navMeshData->destroyInstances();
 
+	if (m_instancingPhase != IP_NONE)
+		cancelInstancing();
+
 #ifdef OGREKIT_USE_LUA
 	// Free scripts
 	gkLuaManager::getSingleton().decompileGroup(getGroupName());
@@ -1196,9 +1721,8 @@ void gkScene::destroyInstanceImpl(void)
 	gkGroupManager::getSingleton().destroyGameObjectInstances(this);
 
 
-	// Destroy all batched geometry
-	if (gkEngine::getSingleton().getUserDefs().buildStaticGeometry)
-		gkGroupManager::getSingleton().destroyStaticBatches(this);
+	// Destroy all batched geometry, even if the user defs changed since it was built
+	gkGroupManager::getSingleton().destroyStaticBatches(this);
 
 
 
@@ -1240,6 +1764,18 @@ void gkScene::destroyInstanceImpl(void)
 		m_skybox = 0;
 	}
 
+	if (m_entityInstancer)
+	{
+		delete m_entityInstancer;
+		m_entityInstancer = 0;
+	}
+
+	if (m_activityCuller)
+	{
+		delete m_activityCuller;
+		m_activityCuller = 0;
+	}
+
 
 	m_startCam = 0;
 	m_limits = gkBoundingBox::BOX_NULL;
@@ -1343,8 +1879,8 @@ void gkScene::notifyInstanceCreated(gkGameObject* gobj)
 		m_navMeshData->updateOrCreate(gobj);
 
 
-	// apply physics
-	if (!isBeingCreated())
+	// apply physics (incremental instancing builds it in a later pass)
+	if (!isBeingCreated() && m_instancingPhase == IP_NONE)
 	{
 		_createPhysicsObject(gobj);
 		_postCreatePhysicsObject(gobj);
@@ -1362,6 +1898,10 @@ void gkScene::notifyInstanceDestroyed(gkGameObject* gobj)
 {
 	m_instanceObjects.erase(gobj);
 
+	// before physics, bodies it suspended are restored
+	if (m_activityCuller)
+		m_activityCuller->_notifyObjectDestroyed(gobj);
+
 
 	// Tell constraints
 	if (m_constraintManager)
@@ -1390,6 +1930,8 @@ void gkScene::notifyInstanceDestroyed(gkGameObject* gobj)
 void gkScene::notifyObjectUpdate(gkGameObject* gobj)
 {
 	m_markDBVT = true;
+	if (gobj != m_startCam)
+		m_dbvtObjectsMoved = true;
 
 	if (!isBeingCreated())
 	{
@@ -1426,43 +1968,103 @@ void gkScene::destroyClones(void)
 
 		m_clones.clear();
 	}
-	if (!m_tickClones.empty())
+
+	m_cloneTimers.clear();
+	m_cloneCount = 0;
+	m_cloneTick = 0;
+}
+
+
+
+void gkScene::pushCloneTimer(gkGameObject* obj, UTuint32 expire)
+{
+	CloneTimer timer = {expire, obj};
+
+	m_cloneTimers.push_back(timer);
+	siftCloneTimer(m_cloneTimers.size() - 1);
+}
+
+
+
+void gkScene::siftCloneTimer(UTsize slot)
+{
+	CloneTimerHeap::Pointer heap = m_cloneTimers.ptr();
+	UTsize size = m_cloneTimers.size();
+	CloneTimer timer = heap[slot];
+
+	// sift up
+	while (slot > 0)
+	{
+		UTsize parent = (slot - 1) >> 1;
+		if (heap[parent].expire <= timer.expire)
+			break;
+
+		heap[slot] = heap[parent];
+		heap[slot].object->_setLifeSlot(slot);
+		slot = parent;
+	}
+
+	// sift down
+	for (;;)
 	{
-		gkGameObjectArray::Pointer buffer = m_tickClones.ptr();
-		size_t size = m_tickClones.size();
-		size_t i = 0;
-		while (i < size)
-		{
-			gkGameObject* obj = buffer[i++];
-			obj->destroyInstance();
-			delete obj;
-		}
+		UTsize child = (slot << 1) + 1;
+		if (child >= size)
+			break;
 
-		m_tickClones.clear();
+		if (child + 1 < size && heap[child + 1].expire < heap[child].expire)
+			++child;
+
+		if (timer.expire <= heap[child].expire)
+			break;
+
+		heap[slot] = heap[child];
+		heap[slot].object->_setLifeSlot(slot);
+		slot = child;
 	}
-	m_cloneCount = 0;
+
+	heap[slot] = timer;
+	timer.object->_setLifeSlot(slot);
 }
 
 
 
+void gkScene::removeCloneTimer(gkGameObject* obj)
+{
+	UTsize slot = obj->_getLifeSlot();
+	if (slot == UT_NPOS)
+		return;
+
+	GK_ASSERT(slot < m_cloneTimers.size() && m_cloneTimers[slot].object == obj);
+
+	obj->_setLifeSlot(UT_NPOS);
+
+	UTsize last = m_cloneTimers.size() - 1;
+	if (slot != last)
+	{
+		m_cloneTimers[slot] = m_cloneTimers[last];
+		m_cloneTimers.pop_back();
+		siftCloneTimer(slot);
+	}
+	else
+		m_cloneTimers.pop_back();
+}
+
+
 
 void gkScene::tickClones(void)
 {
-	if (!m_tickClones.empty())
-	{
-		gkGameObjectArray::Pointer buffer = m_tickClones.ptr();
-		UTsize size = m_tickClones.size();
-		UTsize i = 0;
+	++m_cloneTick;
 
+	// only the expiring clones are touched, the rest wait in the heap
+	while (!m_cloneTimers.empty() && m_cloneTimers[0].expire <= m_cloneTick)
+	{
+		gkGameObject* obj = m_cloneTimers[0].object;
+		removeCloneTimer(obj);
 
-		while (i < size)
-		{
-			gkGameObject* obj = buffer[i++];
-			gkGameObject::LifeSpan& life = obj->getLifeSpan();
+		gkGameObject::LifeSpan& life = obj->getLifeSpan();
+		life.tick = life.timeToLive + 1;
 
-			if ((life.tick++) > life.timeToLive)
-				endObject(obj);
-		}
+		endObject(obj);
 	}
 }
 
@@ -1482,10 +2084,12 @@ gkGameObject* gkScene::cloneObject(gkGameObject* obj, int lifeSpan, bool instant
 	if (nobj->getOwner() != this)
 		nobj->setOwner(this);
 
+	nobj->_setCloneSlot(m_clones.size());
+	m_clones.push_back(nobj);
+
+	// Ends on the (lifeSpan + 2)th tick, same as counting each tick per clone.
 	if (lifeSpan > 0)
-		m_tickClones.push_back(nobj);
-	else
-		m_clones.push_back(nobj);
+		pushCloneTimer(nobj, m_cloneTick + (UTuint32)lifeSpan + 2);
 	
 
 	if (instantiate)
@@ -1510,6 +2114,65 @@ void gkScene::notifyGroupInstanceDestroyed(gkGameObjectInstance* ginst) {
 //		calculateLimits();
 }
 
+void gkScene::createInstancedBatches(void)
+{
+	if (!m_entityInstancer)
+		return;
+
+	const UTsize minCount = (UTsize)gkEngine::getSingleton().getUserDefs().instancingMinCount;
+
+
+	// Group the entities still rendered on their own by mesh.
+	typedef utArray<gkEntity*> Entities;
+	typedef utHashTable<utPointerHashKey, Entities> MeshUsers;
+	MeshUsers users;
+
+	gkGameObjectSet::Iterator it(m_instanceObjects);
+	while (it.hasMoreElements())
+	{
+		gkGameObject* gobj = it.getNext();
+		if (gobj->getType() != GK_ENTITY || !gobj->isInstanced())
+			continue;
+
+		gkEntity* ent = gobj->getEntity();
+		if (!ent->getEntity() || ent->getSkeleton() || !ent->getMesh())
+			continue;
+
+		UTsize pos = users.find(ent->getMesh());
+		if (pos == UT_NPOS)
+		{
+			users.insert(ent->getMesh(), Entities());
+			pos = users.find(ent->getMesh());
+		}
+
+		users.at(pos).push_back(ent);
+	}
+
+
+	bool changed = false;
+
+	MeshUsers::Iterator uit = users.iterator();
+	while (uit.hasMoreElements())
+	{
+		Entities& ents = uit.getNext().second;
+		if (ents.size() < minCount)
+			continue;
+
+		UTsize i;
+		for (i = 0; i < ents.size(); ++i)
+		{
+			if (!ents[i]->_createAsInstanced())
+				break;
+			changed = true;
+		}
+	}
+
+	if (changed)
+		m_entityInstancer->defragment();
+}
+
+
+
 void gkScene::_unloadAndDestroy(gkGameObject* gobj)
 {
 	if (!gobj)
@@ -1517,28 +2180,29 @@ void gkScene::_unloadAndDestroy(gkGameObject* gobj)
 
 	gobj->destroyInstance();
 
-	UTsize it;
 	if (gobj->isClone())
 	{
-		if ((it = m_clones.find(gobj)) != UT_NPOS)
+		UTsize slot = gobj->_getCloneSlot();
+		if (slot != UT_NPOS)
 		{
-			m_clones.erase(it);
+			GK_ASSERT(slot < m_clones.size() && m_clones[slot] == gobj);
 			UT_ASSERT(!gobj->isGroupInstance());
 
-			delete gobj;
+			// swap remove, the moved clone takes over the slot
+			UTsize last = m_clones.size() - 1;
+			if (slot != last)
+			{
+				m_clones[slot] = m_clones[last];
+				m_clones[slot]->_setCloneSlot(slot);
+			}
+			m_clones.pop_back();
 
-			if (m_clones.empty())
-				m_tickClones.clear(true);
-		}
-		else if ((it = m_tickClones.find(gobj)) != UT_NPOS)
-		{
-			m_tickClones.erase(it);
-			UT_ASSERT(!gobj->isGroupInstance());
+			removeCloneTimer(gobj);
 
 			delete gobj;
 
-			if (m_tickClones.empty())
-				m_tickClones.clear(true);
+			if (m_clones.empty())
+				m_clones.clear(true);
 		}
 		else
 		{
@@ -1596,7 +2260,11 @@ void gkScene::updateObjectsAnimations(const gkScalar tick)
 		{
 			gkGameObject* gobj = it.getNext();
 			if (gobj && gobj->isInstanced())
-				gobj->updateAnimationBlender(animtick);
+			{
+				gkScalar objtick = gobj->getActivityTick(animtick);
+				if (objtick > 0)
+					gobj->updateAnimationBlender(objtick);
+			}
 		}
 
 
@@ -1638,6 +2306,18 @@ void gkScene::update(gkScalar tickRate)
 
 	GK_ASSERT(m_physicsWorld);
 
+	if (m_instancingPhase != IP_NONE)
+	{
+		// physics, logic and animations wait until the scene is complete
+		stepInstancing();
+		if (m_instancingPhase != IP_NONE)
+			return;
+	}
+
+	// throttle objects far from the camera
+	if (m_activityCuller)
+		m_activityCuller->update(tickRate);
+
 	// update simulation
 	if (m_updateFlags & UF_PHYSICS)
 	{
@@ -1693,13 +2373,18 @@ void gkScene::update(gkScalar tickRate)
 	}
 #endif
 
+	// rebuild regions invalidated by added or removed group instances
+	if (gkEngine::getSingleton().getUserDefs().buildStaticGeometry)
+		gkGroupManager::getSingleton().updateStaticBatches(this);
+
 	if (m_updateFlags & UF_DBVT)
 	{
 		gkStats::getSingleton().startClock();
 		if (m_markDBVT)
 		{
 			m_markDBVT = false;
-			m_physicsWorld->handleDbvt(m_startCam);
+			m_physicsWorld->handleDbvt(m_startCam, m_dbvtObjectsMoved);
+			m_dbvtObjectsMoved = false;
 		}
 		gkStats::getSingleton().stopDbvtClock();
 	}
@@ -45,9 +45,25 @@
 #endif
 
 class gkCurve;
+class gkEntityInstancer;
+class gkActivityCuller;
+class gkSceneSnapshot;
 
 class gkScene : public gkInstancedObject
 {
+public:
+
+	///Listener for scenes that are instanced over several frames.
+	class InstancingListener
+	{
+	public:
+		virtual ~InstancingListener() {}
+
+		///progress is in the range [0, 1]
+		virtual void notifyInstancingProgress(gkScene* scene, gkScalar progress) {}
+		virtual void notifyInstancingFinished(gkScene* scene) {}
+	};
+
 public:
 
 	gkScene(gkInstancedManager* creator, const gkResourceName& name, const gkResourceHandle& handle);
@@ -78,6 +94,15 @@ public:
 
 	gkDynamicsWorld* getDynamicsWorld(void);
 
+
+	///Copies the transforms and variables of the instanced objects and the
+	///physics state into snap. Taken between two ticks, for rollback and replay.
+	void saveSnapshot(gkSceneSnapshot& snap);
+
+	///Returns to a saved snapshot. Objects ended since then are skipped and
+	///objects added later are left alone. Returns false for an empty snapshot.
+	bool restoreSnapshot(const gkSceneSnapshot& snap);
+
 	// Callback events
 
 	void notifyInstanceCreated(gkGameObject* gobject);
@@ -134,6 +159,16 @@ public:
 	void calculateLimits(void);
 
 
+	///Hardware instancing of repeated meshes, null unless gkUserDefs::hardwareInstancing is set.
+	GK_INLINE gkEntityInstancer* getEntityInstancer(void) {return m_entityInstancer;}
+
+	///Moves entities of meshes used at least gkUserDefs::instancingMinCount times to the instancer.
+	void createInstancedBatches(void);
+
+	///Distance based throttling, null unless gkSceneProperties::m_activityCulling is set.
+	GK_INLINE gkActivityCuller* getActivityCuller(void) {return m_activityCuller;}
+
+
 	GK_INLINE gkCamera*		getMainCamera(void)		{ return m_startCam; }
 	GK_INLINE bool			hasDefaultCamera(void)	{ return m_startCam != 0; }
 	GK_INLINE bool			hasCameras(void)		{ return !m_cameras.empty(); }
@@ -218,6 +253,16 @@ public:
 	GK_INLINE UTuint32 getUpdateFlags(void)					{ return m_updateFlags;		}
 	GK_INLINE void setUpdateFlags(UTuint32 flags)			{ m_updateFlags = flags;	}
 
+	///Milliseconds per frame spent on instancing this scene. Objects are then created
+	///through gkGameObjectManager's create queue, parents first, followed by physics,
+	///and logic starts once everything is in place. Zero creates the scene in one call,
+	///a negative value uses gkUserDefs::instancingBudget.
+	GK_INLINE void     setInstancingBudget(gkScalar ms)                 { m_instancingBudget = ms; }
+	gkScalar           getInstancingBudget(void);
+
+	GK_INLINE void     setInstancingListener(InstancingListener* li)    { m_instancingListener = li; }
+	GK_INLINE bool     isInstancingPending(void)                        { return m_instancingPhase != IP_NONE; }
+
 	GK_INLINE gkBlendFile* getLoadBlendFile(void)			{ return m_blendFile;		}
 	GK_INLINE void setLoadBlendFile(gkBlendFile* blendFile)	{ m_blendFile = blendFile;	}
 
@@ -229,14 +274,31 @@ public:
 
 private:
 
+	enum InstancingPhase
+	{
+		IP_NONE,
+		IP_OBJECTS,
+		IP_PHYSICS,
+		IP_LINKS,
+	};
+
 	void postCreateInstanceImpl(void);
 	void createInstanceImpl(void);
 	void destroyInstanceImpl(void);
 	void setShadows(void);
 	void tickClones(void);
 	void destroyClones(void);
+	void pushCloneTimer(gkGameObject* obj, UTuint32 expire);
+	void removeCloneTimer(gkGameObject* obj);
+	void siftCloneTimer(UTsize slot);
 	void endObjects(void);
 	void updateObjectsAnimations(const gkScalar tick);
+	void executeStartupScript(void);
+	void queueInstances(gkScalar budget);
+	void stepInstancing(void);
+	void finishInstancing(void);
+	void cancelInstancing(void);
+	void notifyInstancingProgress(void);
 
 	Ogre::SceneManager*     m_manager;
 	gkCamera*               m_startCam;
@@ -252,8 +314,17 @@ private:
 	gkGameObjectSet         m_instanceObjects;
 
 
+	// Life span timer, ordered by the scene tick the clone expires at.
+	struct CloneTimer
+	{
+		UTuint32      expire;
+		gkGameObject* object;
+	};
+	typedef utArray<CloneTimer> CloneTimerHeap;
+
 	gkGameObjectArray       m_clones;
-	gkGameObjectArray       m_tickClones;
+	CloneTimerHeap          m_cloneTimers;
+	UTuint32                m_cloneTick;
 	gkGameObjectSet         m_endObjects;
 	gkGameObjectSet         m_updateAnimObjects;
 	gkPhysicsControllerSet  m_staticControllers;
@@ -266,11 +337,14 @@ private:
 
 	bool                    m_hasLights;
 	bool                    m_markDBVT;
+	bool                    m_dbvtObjectsMoved;
 	int                     m_cloneCount;
 	UTuint32                m_layers;
 	gkBoundingBox           m_limits;
 	PNAVMESHDATA            m_navMeshData;
 	class gkSkyBoxGradient* m_skybox;
+	gkEntityInstancer*      m_entityInstancer;
+	gkActivityCuller*       m_activityCuller;
 
 	UTuint32				m_updateFlags;
 	gkBlendFile*			m_blendFile;
@@ -280,6 +354,15 @@ private:
 
 	gkLogicManager*			m_logicBrickManager;
 
+	int                     m_instancingPhase;
+	gkScalar                m_instancingBudget;
+	InstancingListener*     m_instancingListener;
+	gkGameObjectArray       m_pendingObjects;
+	gkGameObjectArray       m_pendingLinks;
+	UTsize                  m_pendingCursor;
+	UTsize                  m_pendingTotal;
+	gkScalar                m_prevQueueBudget;  // restored once instancing is done
+
 #ifdef OGREKIT_USE_PROCESSMANAGER
 	gkProcessManager*		m_processManager;
 #endif
@@ -106,6 +106,8 @@ void gkSceneManager::copyObjects(gkScene* fromScene, gkScene* toScene, int excep
 		if (gkEngine::getSingleton().getUserDefs().buildStaticGeometry)
 			gkGroupManager::getSingleton().createStaticBatches(toScene);
 
+		toScene->createInstancedBatches();
+
 		toScene->_applyBuiltinParents(objects);
 		toScene->_applyBuiltinPhysics(objects);
 	}
@@ -0,0 +1,93 @@
+/*
+-------------------------------------------------------------------------------
+    This file is part of OgreKit.
+    http://gamekit.googlecode.com/
+
+    Copyright (c) 2006-2013 Charlie C.
+
+    Contributor(s): none yet.
+-------------------------------------------------------------------------------
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#ifndef _gkSceneSnapshot_h_
+#define _gkSceneSnapshot_h_
+
+#include "gkCommon.h"
+#include "gkMathUtils.h"
+#include "gkTransformState.h"
+#include "Physics/gkPhysicsSnapshot.h"
+
+class gkVariable;
+
+
+///In memory copy of the game state of a gkScene, see gkScene::saveSnapshot.
+///
+///Holds the local transform and the variable values of every instanced object
+///plus a gkPhysicsSnapshot of the dynamics world. Arrays keep their storage
+///between saves.
+class gkSceneSnapshot
+{
+public:
+
+	struct Object
+	{
+		gkGameObject*       m_object;
+		gkTransformState    m_transform;
+		UTsize              m_firstVariable, m_variableCount;
+	};
+
+	struct Variable
+	{
+		gkVariable*     m_variable;
+		int             m_type;
+		int             m_int;          // bool and int values
+		UTsize          m_offset;       // into m_reals, or m_strings for strings
+	};
+
+	typedef utArray<Object>     Objects;
+	typedef utArray<Variable>   Variables;
+	typedef utArray<gkScalar>   Reals;
+	typedef utArray<gkString>   Strings;
+
+public:
+
+	gkSceneSnapshot() : m_stringCount(0), m_valid(false) {}
+
+	GK_INLINE bool isValid(void) const {return m_valid;}
+
+	void clear(void)
+	{
+		m_objects.resize(0);
+		m_variables.resize(0);
+		m_reals.resize(0);
+		m_stringCount = 0;
+		m_physics.clear();
+		m_valid = false;
+	}
+
+	Objects             m_objects;
+	Variables           m_variables;
+	Reals               m_reals;
+	Strings             m_strings;      // grows only, so strings keep their buffers
+	UTsize              m_stringCount;
+	gkPhysicsSnapshot   m_physics;
+	bool                m_valid;
+};
+
+
+#endif//_gkSceneSnapshot_h_
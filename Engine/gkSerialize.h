@@ -471,7 +471,8 @@ enum gkGameObjectMode
 	GK_OCCLUDER      = (1 << 3),  // Occluder
 	GK_HAS_LOGIC     = (1 << 4),  // Has game logic
 	GK_IMMOVABLE     = (1 << 5),  // Marked as an immovable object
-	GK_STATIC_GEOM   = (1 << 6)   // Is part of static batch geometry.
+	GK_STATIC_GEOM   = (1 << 6),  // Is part of static batch geometry.
+	GK_NO_ACTIVITY_CULLING = (1 << 7)  // Never throttled by gkActivityCuller
 };
 
 
@@ -517,6 +518,7 @@ public:
 	GK_INLINE bool isInvisible(void)          const { return (m_mode & GK_INVISIBLE) != 0; }
 	GK_INLINE bool isOccluder(void)           const { return (m_mode & GK_OCCLUDER)  != 0; }
 	GK_INLINE bool isGhost(void)              const { return (m_mode & GK_GHOST)     != 0; }
+	GK_INLINE bool isActivityCullable(void)   const { return (m_mode & GK_NO_ACTIVITY_CULLING) == 0; }
 
 	GK_INLINE bool hasParticles(void)         const { return !m_particleObjs.empty(); }
 };
@@ -631,6 +633,9 @@ public:
 	gkSceneProperties()
 		:   m_manager(MA_GENERIC),
 		    m_gravity(0.f, 0.f, -9.81f),
+		    m_activityCulling(false),
+		    m_logicRadius(0.f),
+		    m_physicsRadius(0.f),
 		    m_material(),
 		    m_fog()
 	{
@@ -638,6 +643,9 @@ public:
 
 	int             m_manager;
 	gkVector3       m_gravity;
+	bool            m_activityCulling;  // Throttle objects far from the main camera (gkActivityCuller)
+	gkScalar        m_logicRadius;      // Logic and animations run at full rate inside
+	gkScalar        m_physicsRadius;    // Dynamic bodies are suspended outside
 	gkSceneMaterial m_material;
 	gkFogParams     m_fog;
 };
@@ -32,6 +32,7 @@
 #include "gkPath.h"
 #include "gkWindowSystem.h"
 #include "gkViewport.h"
+#include "gkEntityInstancer.h"
 
 #include "OgreException.h"
 #include "OgreConfigFile.h"
@@ -68,7 +69,20 @@ gkUserDefs::gkUserDefs()
 	debugPhysicsAabb(false),
 	enableshadows(true),
 	buildStaticGeometry(false),
+	staticBatchRegion(64),
 	useBulletDbvt(true),
+	occlusionCulling(false),
+	physicsActivityRadius(-1),
+	jobThreads(3),
+	multithreadedPhysics(false),
+	collisionCachePath(""),
+	linkPlanCachePath(""),
+	instancingBudget(0),
+	hardwareInstancing(gkEntityInstancer::IT_NONE),
+	instancingMinCount(16),
+	meshLodValues(""),
+	meshLodReduction(0.5f),
+	meshLodStrategy("distance_sphere"),
 	showDebugProps(false),
 	debugSounds(false),
 	fsaa(false),
@@ -165,6 +179,22 @@ int gkUserDefs::getViewportFramingType(const gkString& val)
 	return framingType;
 }
 
+int gkUserDefs::getInstancingTechnique(const gkString& val)
+{
+	int technique = gkEntityInstancer::IT_NONE;
+
+	if (val.find("hwvtf") != val.npos)
+		technique = gkEntityInstancer::IT_HW_VTF;
+	else if (val.find("hwbasic") != val.npos)
+		technique = gkEntityInstancer::IT_HW_BASIC;
+	else if (val.find("vtf") != val.npos)
+		technique = gkEntityInstancer::IT_VTF;
+	else if (val.find("shader") != val.npos)
+		technique = gkEntityInstancer::IT_SHADER;
+
+	return technique;
+}
+
 void gkUserDefs::parseString(const gkString& key, const gkString& val)
 {
 #define KeyEq(b) (key == b)
@@ -257,6 +287,71 @@ void gkUserDefs::parseString(const gkString& key, const gkString& val)
 		useBulletDbvt = Ogre::StringConverter::parseBool(val);
 		return;
 	}
+	if (KeyEq("occlusionculling"))
+	{
+		occlusionCulling = Ogre::StringConverter::parseBool(val);
+		return;
+	}
+	if (KeyEq("physicsactivityradius"))
+	{
+		physicsActivityRadius = Ogre::StringConverter::parseReal(val);
+		return;
+	}
+	if (KeyEq("jobthreads"))
+	{
+		jobThreads = gkClamp<int>(Ogre::StringConverter::parseInt(val), 0, 64);
+		return;
+	}
+	if (KeyEq("multithreadedphysics"))
+	{
+		multithreadedPhysics = Ogre::StringConverter::parseBool(val);
+		return;
+	}
+	if (KeyEq("collisioncachepath"))
+	{
+		collisionCachePath = val;
+		return;
+	}
+	if (KeyEq("linkplancachepath"))
+	{
+		linkPlanCachePath = val;
+		return;
+	}
+	if (KeyEq("staticbatchregion"))
+	{
+		staticBatchRegion = gkMax<gkScalar>(0, Ogre::StringConverter::parseReal(val));
+		return;
+	}
+	if (KeyEq("instancingbudget"))
+	{
+		instancingBudget = gkMax<gkScalar>(0, Ogre::StringConverter::parseReal(val));
+		return;
+	}
+	if (KeyEq("hardwareinstancing"))
+	{
+		hardwareInstancing = getInstancingTechnique(val);
+		return;
+	}
+	if (KeyEq("instancingmincount"))
+	{
+		instancingMinCount = gkMax<int>(1, Ogre::StringConverter::parseInt(val));
+		return;
+	}
+	if (KeyEq("meshlodvalues"))
+	{
+		meshLodValues = val;
+		return;
+	}
+	if (KeyEq("meshlodreduction"))
+	{
+		meshLodReduction = gkClamp<gkScalar>(Ogre::StringConverter::parseReal(val), 0.f, 1.f);
+		return;
+	}
+	if (KeyEq("meshlodstrategy"))
+	{
+		meshLodStrategy = val;
+		return;
+	}
 	if (KeyEq("showdebugprops"))
 	{
 		showDebugProps = Ogre::StringConverter::parseBool(val);
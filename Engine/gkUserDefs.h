@@ -58,7 +58,20 @@ public:
 	bool                    debugPhysics;       // enable / disable physics debugging
 	bool                    debugPhysicsAabb;   // show / hide bounding box
 	bool                    buildStaticGeometry;// Use Static geometry
+	gkScalar                staticBatchRegion;  // Static geometry region size, dirty regions are rebuilt one per frame (0 = one batch per group)
 	bool                    useBulletDbvt;      // Use Bullet Dynamic AABB Tree
+	bool                    occlusionCulling;   // Hide objects behind occluders (needs useBulletDbvt)
+	gkScalar                physicsActivityRadius;// Activity culling radius of dynamic bodies (< 0 = the world activity radius, 0 = never suspended)
+	int                     jobThreads;         // Worker threads of the engine job pool (0 = run jobs on the caller)
+	bool                    multithreadedPhysics;// Step Bullet on the job pool (needs OGREKIT_BULLET_MULTITHREADED)
+	gkString                collisionCachePath; // Directory of cooked static mesh BVHs ("" = share in memory only)
+	gkString                linkPlanCachePath;  // Directory of .blend DNA conversion plans ("" = keep in memory only)
+	gkScalar                instancingBudget;   // Milliseconds per frame for incremental scene instancing (0 = all at once)
+	int                     hardwareInstancing; // gkEntityInstancer technique for repeated meshes (-1 = disabled)
+	int                     instancingMinCount; // Copies of a mesh needed before it is hardware instanced
+	gkString                meshLodValues;      // Generated mesh LOD thresholds, one level each ("" = disabled)
+	gkScalar                meshLodReduction;   // Triangles kept from one LOD level to the next
+	gkString                meshLodStrategy;    // Ogre LOD strategy of the thresholds (distance_sphere, pixel_count, ...)
 	bool                    showDebugProps;     // Show variable debugging information.
 	bool                    debugSounds;        // Show 3D sound debug info
 	bool                    disableSound;       // Disable OpenAL sound.
@@ -85,6 +98,7 @@ public:
 	static OgreRenderSystem getOgreRenderSystem(const gkString& val);
 	static bool isD3DRenderSystem(OgreRenderSystem rs);
 	static int getViewportFramingType(const gkString& val);
+	static int getInstancingTechnique(const gkString& val);
 };
 
 
@@ -37,6 +37,7 @@ class OgreKit : public gkCoreApplication, public gkWindowSystem::Listener
 {
 public:
 	gkString    m_blend;
+	gkString    m_cook;
 	gkScene*    m_scene;
 public:
 	OgreKit();
@@ -145,14 +146,17 @@ int OgreKit::setup(int argc, char** argv)
 		
 		TCLAP::ValueArg<std::string>			cfgfname_arg("c", "config-file", "Startup configuration file (.cfg) to use.", false, gkDefaultConfig, "string");
 		TCLAP::UnlabeledValueArg<std::string>	bfname_arg("blender-file", "Blender file to launch as game.", false, gkDefaultBlend, "string");
+		TCLAP::ValueArg<std::string>			cook_arg("", "cook", "Write the blender file as a cooked package to this path and exit.", false, "", "string");
 
 		cmdl.add(cfgfname_arg);
 		cmdl.add(bfname_arg);
+		cmdl.add(cook_arg);
 
 		cmdl.parse( argc, argv );
 
 		cfgfname						= cfgfname_arg.getValue();
 		m_blend							= bfname_arg.getValue();
+		m_cook							= cook_arg.getValue();
 
 		m_prefs.rendersystem			= gkUserDefs::getOgreRenderSystem(rendersystem_arg.getValue());
 		m_prefs.viewportOrientation		= viewportOrientation_arg.getValue();
@@ -228,6 +232,13 @@ int OgreKit::setup(int argc, char** argv)
 
 bool OgreKit::setup(void)
 {
+	if (!m_cook.empty())
+	{
+		if (!gkBlendLoader::getSingleton().cookFile(gkUtils::getFile(m_blend), m_cook))
+			gkPrintf("Cooking failed.\n");
+		return false;
+	}
+
 	gkBlendFile* blend = gkBlendLoader::getSingleton().loadFile(gkUtils::getFile(m_blend), gkBlendLoader::LO_ALL_SCENES);
 	if (!blend)
 	{
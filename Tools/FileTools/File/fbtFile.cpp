@@ -28,6 +28,8 @@
 #include "fbtFile.h"
 #include "fbtStreams.h"
 #include "fbtTables.h"
+#include "fbtLinkPlan.h"
+#include "fbtPackage.h"
 #include "fbtPlatformHeaders.h"
 
 // Common Identifiers
@@ -71,8 +73,9 @@ struct fbtChunk
 
 
 fbtFile::fbtFile(const char* uid)
-	:   m_version(-1), m_fileVersion(0), m_fileHeader(0), m_uhid(uid), m_aluhid(0),
-	    m_memory(0), m_file(0), m_curFile(0)
+	:   m_uhid(uid), m_aluhid(0), m_version(-1), m_fileVersion(0), m_fileHeader(0), m_curFile(0),
+	    m_memory(0), m_file(0), m_remapShift(0), m_mapped(0), m_package(0), m_runner(0), m_lazy(false),
+	    m_plan(0), m_planCache(0), m_ownsPlan(false)
 {
 }
 
@@ -86,12 +89,12 @@ fbtFile::~fbtFile()
 	MemoryChunk* node = (MemoryChunk*)m_chunks.first, *tnd;
 	while (node)
 	{
-		if (node->m_block)
+		if (node->m_block && !(node->m_flag & MemoryChunk::BLK_MAPPED))
 		{
 			//printf("free  m_block: 0x%x\n", node->m_block);fflush(stdout);
 			fbtFree(node->m_block);
 		}
-		if (node->m_newBlock)
+		if (node->m_newBlock && !(node->m_flag & MemoryChunk::BLK_IN_PLACE))
 		{
 			//printf("free m_newBlock: 0x%x\n", node->m_newBlock);fflush(stdout);
 			fbtFree(node->m_newBlock);
@@ -103,8 +106,13 @@ fbtFile::~fbtFile()
 		fbtFree(tnd);
 	}
 
+	if (m_ownsPlan)
+		delete m_plan;
+
 	delete m_file;
 	delete m_memory;
+	delete m_package;
+	delete m_mapped;
 }
 
 
@@ -113,11 +121,66 @@ int fbtFile::parse(const char* path, int mode)
 {
 	fbtStream* stream = 0;
 
-	if (mode == PM_UNCOMPRESSED || mode == PM_COMPRESSED)
+	if (mode == PM_MAPPED)
+	{
+		stream = new fbtMappedStream();
+		stream->open(path, fbtStream::SM_READ);
+
+		// cooked packages carry the file as a section
+		fbtMappedStream* mapped = static_cast<fbtMappedStream*>(stream);
+		fbtPackage* package = 0;
+		if (fbtPackage::isPackage(mapped->ptr(), mapped->size()))
+		{
+			// reads from the mapping, which window keeps
+			package = new fbtPackage();
+
+			const fbtPackage::Section* sec = 0;
+			if (package->open(mapped->ptr(), mapped->size()))
+				sec = package->find(FBT_ID('B', 'L', 'N', 'D'));
+
+			if (!sec || !mapped->window((FBTsize)sec->m_offset, (FBTsize)sec->m_len))
+			{
+				fbtPrintf("Package '%s' has no file section\n", path);
+				delete package;
+				delete stream;
+				return FS_FAILED;
+			}
+
+			const FBTuint8* magic = (const FBTuint8*)mapped->ptr();
+			if (mapped->size() >= 2 && magic[0] == 0x1F && magic[1] == 0x8B)
+			{
+				int result = parse(mapped->ptr(), mapped->size(), PM_COMPRESSED);
+
+				// inflated into the chunks, the mapping only backs the package
+				delete m_package;
+				delete m_mapped;
+				m_package = package;
+				m_mapped  = stream;
+				return result;
+			}
+		}
+
+		// gzip'ed files go through the regular streams
+		const FBTuint8* magic = (const FBTuint8*)mapped->ptr();
+		if (!stream->isOpen() || stream->size() < 2 || (magic[0] == 0x1F && magic[1] == 0x8B))
+		{
+			delete stream;
+			stream = 0;
+			mode = PM_COMPRESSED;
+		}
+		else
+		{
+			delete m_package;
+			m_package = package;
+		}
+	}
+
+	if (!stream && (mode == PM_UNCOMPRESSED || mode == PM_COMPRESSED))
 	{
 #if FBT_USE_GZ_FILE == 1
+		// inflated on worker threads while the chunks are scanned
 		if (mode == PM_COMPRESSED)
-			stream = new fbtGzStream();
+			stream = new fbtGzPipeStream();
 		else
 #endif
 		{
@@ -126,7 +189,7 @@ int fbtFile::parse(const char* path, int mode)
 
 		stream->open(path, fbtStream::SM_READ);
 	}
-	else
+	else if (!stream)
 	{
 		stream = new fbtMemoryStream();
 		stream->open(path, fbtStream::SM_READ);
@@ -152,7 +215,14 @@ int fbtFile::parse(const char* path, int mode)
 	}
 
 	int result = parseStreamImpl(stream);
-	delete stream;
+
+	if (mode == PM_MAPPED)
+	{
+		delete m_mapped;
+		m_mapped = stream;
+	}
+	else
+		delete stream;
 	return result;
 }
 
@@ -160,15 +230,40 @@ int fbtFile::parse(const char* path, int mode)
 
 int fbtFile::parse(const void* memory, FBTsize sizeInBytes, int mode, bool suppressHeaderWarning)
 {
+	// the package reads from memory, which has to outlive the file
+	fbtPackage* package = new fbtPackage();
+	if (package->open(memory, sizeInBytes))
+	{
+		const fbtPackage::Section* sec = package->find(FBT_ID('B', 'L', 'N', 'D'));
+		if (!sec)
+		{
+			delete package;
+			return FS_FAILED;
+		}
+
+		memory      = package->getData(sec);
+		sizeInBytes = (FBTsize)sec->m_len;
+		mode        = PM_UNCOMPRESSED;
+	}
+	else
+	{
+		delete package;
+		package = 0;
+	}
+
 	fbtMemoryStream ms;
 	ms.open( memory, sizeInBytes, fbtStream::SM_READ, mode==PM_COMPRESSED );
 
 	if (!ms.isOpen())
 	{
 		fbtPrintf("Memory %p(%i) loading failed\n", memory, sizeInBytes);
+		delete package;
 		return FS_FAILED;
 	}
 
+	delete m_package;
+	m_package = package;
+
 	return parseStreamImpl(&ms,suppressHeaderWarning);
 }
 
@@ -247,10 +342,6 @@ int fbtFile::parseStreamImpl(fbtStream* stream, bool suppressHeaderWarning)
 	}
 
 
-	// preallocate table
-	m_map.reserve(fbtDefaultAlloc);
-
-
 	Chunk chunk;
 
 
@@ -277,22 +368,32 @@ int fbtFile::parseStreamImpl(fbtStream* stream, bool suppressHeaderWarning)
 			break;
 
 
-		void* curPtr = fbtMalloc(chunk.m_len);
-		//printf("alloc curPtr: 0x%x\n", curPtr);fflush(stdout);
-		if (!curPtr)
-		{
-			FBT_MALLOC_FAILED;
-			return FS_BAD_ALLOC;
-		}
+		// the tables outlive the stream, always copy them
+		void* curPtr = chunk.m_code != DNA1 ? stream->map(chunk.m_len) : 0;
+		bool mapped = curPtr != 0;
 
-		if (stream->read(curPtr, chunk.m_len) <= 0)
+		if (!mapped)
 		{
-			FBT_INVALID_READ;
-			return FS_INV_READ;
+			curPtr = fbtMalloc(chunk.m_len);
+			//printf("alloc curPtr: 0x%x\n", curPtr);fflush(stdout);
+			if (!curPtr)
+			{
+				FBT_MALLOC_FAILED;
+				return FS_BAD_ALLOC;
+			}
+
+			if (stream->read(curPtr, chunk.m_len) <= 0)
+			{
+				FBT_INVALID_READ;
+				return FS_INV_READ;
+			}
 		}
 
 		if (chunk.m_code == DNA1)
 		{
+			// before read, it swaps in place
+			FBThash dnaHash = fbtLinkPlan::hash(curPtr, chunk.m_len);
+
 			m_file = new fbtBinTables(curPtr, chunk.m_len);
 			m_file->m_ptr = m_fileHeader & FH_CHUNK_64 ? 8 : 4;
 
@@ -303,7 +404,10 @@ int fbtFile::parseStreamImpl(fbtStream* stream, bool suppressHeaderWarning)
 				return FS_INV_READ;
 			}
 
-			compileOffsets();
+			compilePlan(dnaHash);
+
+			if ((status = buildRemap()) != FS_OK)
+				return status;
 
 			if ((status = link()) != FS_OK)
 			{
@@ -314,52 +418,24 @@ int fbtFile::parseStreamImpl(fbtStream* stream, bool suppressHeaderWarning)
 		}
 		else
 		{
-#if FBT_ASSERT_INSERT
-			FBTsizeType pos;
-			if ((pos = m_map.find(chunk.m_old)) != FBT_NPOS)
-			{
-				fbtFree(curPtr);
-				curPtr = 0;
-				int result = fbtMemcmp(&m_map.at(pos)->m_chunk, &chunk, fbtChunk::BlockSize);
-				if (result != 0)
-				{
-					FBT_INVALID_READ;
-					return FS_INV_READ;
-				}
-			}
-#else
-			if (m_map.find(chunk.m_old) != FBT_NPOS)
-			{
-				//printf("free  curPtr: 0x%x\n", curPtr);
-				fbtFree(curPtr);
-				curPtr = 0;
-			}
-#endif
-			else
+			// duplicate addresses are dropped by buildRemap
+			MemoryChunk* bin = static_cast<MemoryChunk*>(fbtMalloc(sizeof(MemoryChunk)));
+			if (!bin)
 			{
-				MemoryChunk* bin = static_cast<MemoryChunk*>(fbtMalloc(sizeof(MemoryChunk)));
-				if (!bin)
-				{
-					FBT_MALLOC_FAILED;
-					return FS_BAD_ALLOC;
-				}
-				fbtMemset(bin, 0, sizeof(MemoryChunk));
-				bin->m_block = curPtr;
-
-				Chunk* cp    = &bin->m_chunk;
-				cp->m_code   = chunk.m_code;
-				cp->m_len    = chunk.m_len;
-				cp->m_nr     = chunk.m_nr;
-				cp->m_typeid = chunk.m_typeid;
-				cp->m_old    = chunk.m_old;
-				m_chunks.push_back(bin);
-
-				if (m_map.insert(bin->m_chunk.m_old, bin) == false)
-				{
-					FBT_INVALID_INS;
-					return FS_INV_INSERT;
-				}
+				FBT_MALLOC_FAILED;
+				return FS_BAD_ALLOC;
 			}
+			fbtMemset(bin, 0, sizeof(MemoryChunk));
+			bin->m_block = curPtr;
+			bin->m_flag  = mapped ? MemoryChunk::BLK_MAPPED : 0;
+
+			Chunk* cp    = &bin->m_chunk;
+			cp->m_code   = chunk.m_code;
+			cp->m_len    = chunk.m_len;
+			cp->m_nr     = chunk.m_nr;
+			cp->m_typeid = chunk.m_typeid;
+			cp->m_old    = chunk.m_old;
+			m_chunks.push_back(bin);
 		}
 	}
 	while (!stream->eof());
@@ -378,8 +454,10 @@ class fbtLinkCompiler
 public:
 	fbtBinTables* m_mp;
 	fbtBinTables* m_fp;
+	bool          m_sameBase; // same pointer size and endianness
 
 	fbtStruct* find(const fbtCharHashKey& kvp);
+	bool       sameLayout(fbtStruct* strc);
 	fbtStruct* find(fbtStruct* strc, fbtStruct* member, bool isPointer, bool& needCast);
 	int        link(void);
 };
@@ -436,6 +514,30 @@ fbtStruct* fbtLinkCompiler::find(fbtStruct* strc, fbtStruct* member, bool isPoin
 	return 0;
 }
 
+bool fbtLinkCompiler::sameLayout(fbtStruct* strc)
+{
+	fbtStruct* fs = strc->m_link;
+	if (!m_sameBase || !fs || fs->m_len != strc->m_len)
+		return false;
+
+	fbtStruct::Members::Pointer p2 = strc->m_members.ptr();
+	FBTsizeType i, s = strc->m_members.size();
+
+	for (i = 0; i < s; ++i)
+	{
+		fbtStruct* dst = &p2[i];
+		fbtStruct* src = dst->m_link;
+
+		if (!src || (dst->m_flag & fbtStruct::NEED_CAST))
+			return false;
+
+		if (src->m_off != dst->m_off || src->m_len != dst->m_len || src->m_val.k32[0] != dst->m_val.k32[0])
+			return false;
+	}
+	return true;
+}
+
+
 int fbtLinkCompiler::link(void)
 {
 	fbtBinTables::OffsM::Pointer md = m_mp->m_offs.ptr();
@@ -482,6 +584,11 @@ int fbtLinkCompiler::link(void)
 			}
 		}
 
+		if (sameLayout(strc))
+			strc->m_flag |= fbtStruct::SAME_LAYOUT;
+		else
+			strc->m_flag &= ~fbtStruct::SAME_LAYOUT;
+
 	}
 
 	return fbtFile::FS_OK;
@@ -542,37 +649,75 @@ void castValue(FBTsize* srcPtr, FBTsize* dstPtr, FBT_PRIM_TYPE srctp, FBT_PRIM_T
 }
 
 
-int fbtFile::link(void)
+class fbtFile::ConvertJob : public fbtFile::Job
 {
-	fbtBinTables::OffsM::Pointer md = m_memory->m_offs.ptr();
-	fbtBinTables::OffsM::Pointer fd = m_file->m_offs.ptr();
-	FBTsizeType s2, i2, a2, n;
-	fbtStruct::Members::Pointer p2;
-	FBTsize mlen, malen, total, pi;
+public:
+	ConvertJob(fbtFile* file, MemoryChunk** chunks) : m_file(file), m_chunks(chunks) {}
 
-	char* dst, *src;
-	FBTsize* dstPtr, *srcPtr;
+	void run(int begin, int end)
+	{
+		for (int i = begin; i < end; ++i)
+			m_file->convertChunk(m_chunks[i]);
+	}
+
+private:
+	fbtFile*        m_file;
+	MemoryChunk**   m_chunks;
+};
+
+
+class fbtFile::PointerArrayJob : public fbtFile::Job
+{
+public:
+	PointerArrayJob(fbtFile* file, MemoryChunk** arrays) : m_file(file), m_arrays(arrays) {}
 
-	bool endianSwap = (m_fileHeader & FH_ENDIAN_SWAP) != 0;
+	void run(int begin, int end)
+	{
+		for (int i = begin; i < end; ++i)
+			m_file->fillPointerArray(m_arrays[i]);
+	}
 
-	static const FBThash hk = fbtCharHashKey("Link").hash();
+private:
+	fbtFile*        m_file;
+	MemoryChunk**   m_arrays;
+};
+
+
+// Mapped chunks are used as they are when the layout matches, as long as
+// they are aligned like a heap block would be.
+static bool fbtCanLinkInPlace(const fbtFile::MemoryChunk* node, FBTsize len)
+{
+	return (node->m_flag & fbtFile::MemoryChunk::BLK_MAPPED) != 0 && node->m_chunk.m_len >= len &&
+	       ((FBTsize)node->m_block & (sizeof(void*) - 1)) == 0;
+}
+
+
+int fbtFile::link(void)
+{
+	if (m_lazy)
+		return linkLazy();
 
 
 	MemoryChunk* node;
 	for (node = (MemoryChunk*)m_chunks.first; node; node = node->m_next)
 	{
-		if (node->m_chunk.m_typeid > m_file->m_strcNr || !( fd[node->m_chunk.m_typeid]->m_link))
+		const fbtLinkPlan::Struct* ps = m_plan->getStruct(node->m_chunk.m_typeid);
+		if (!ps)
 			continue;
 
-		fbtStruct* fs, *ms;
-		fs = fd[node->m_chunk.m_typeid];
-		ms = fs->m_link;
-
-		node->m_newTypeId = ms->m_strcId;
+		node->m_newTypeId = ps->m_memoryId;
 
-		if (m_memory->m_type[ms->m_key.k16[0]].m_typeId == hk)
+		if (ps->m_flag & fbtLinkPlan::SF_LINK_TYPE)
 		{
 			FBTsize totSize = node->m_chunk.m_len;
+
+			if (fbtCanLinkInPlace(node, totSize))
+			{
+				node->m_newBlock = node->m_block;
+				node->m_flag |= MemoryChunk::BLK_IN_PLACE;
+				continue;
+			}
+
 			node->m_newBlock = fbtMalloc(totSize);
 			//printf("alloc1 m_newBlock: 0x%x %d\n", node->m_newBlock, totSize);fflush(stdout);
 
@@ -587,11 +732,20 @@ int fbtFile::link(void)
 		}
 
 
-		if (skip(m_memory->m_type[ms->m_key.k16[0]].m_typeId))
+		if (skip(ps->m_typeId))
 			continue;
 
 
-		FBTsize totSize = (node->m_chunk.m_nr * ms->m_len);
+		FBTsize totSize = (node->m_chunk.m_nr * ps->m_memoryLen);
+
+		if ((ps->m_flag & fbtLinkPlan::SF_SAME_LAYOUT) && fbtCanLinkInPlace(node, totSize))
+		{
+			// only pointers are patched below
+			node->m_chunk.m_len = totSize;
+			node->m_newBlock = node->m_block;
+			node->m_flag |= MemoryChunk::BLK_IN_PLACE;
+			continue;
+		}
 
 		node->m_chunk.m_len = totSize;
 
@@ -613,213 +767,709 @@ int fbtFile::link(void)
 
 
 
-	FBTuint8 mps = m_memory->m_ptr, fps = m_file->m_ptr;
+	// Pointer arrays are swapped for native ones up front, the conversion
+	// then only writes into its own chunk and can run on any thread.
+	fbtArray<MemoryChunk*> chunks, arrays;
 
 	for (node = (MemoryChunk*)m_chunks.first; node; node = node->m_next)
 	{
-		if (node->m_newTypeId > m_memory->m_strcNr)
+		const fbtLinkPlan::Struct* ps = m_plan->getStruct(node->m_chunk.m_typeid);
+
+		// skipped chunks were never allocated
+		if (!ps || (ps->m_flag & fbtLinkPlan::SF_LINK_TYPE) || !node->m_newBlock)
 			continue;
 
+		if ((ps->m_flag & fbtLinkPlan::SF_POINTER_ARRAYS) && allocPointerArrays(node, arrays) != FS_OK)
+			return FS_BAD_ALLOC;
 
+		chunks.push_back(node);
+	}
 
-		fbtStruct* cs = md[node->m_newTypeId];
-		if (m_memory->m_type[cs->m_key.k16[0]].m_typeId == hk)
-			continue;
 
-		if (!cs->m_link || skip(m_memory->m_type[cs->m_key.k16[0]].m_typeId) || !node->m_newBlock)
-		{
-			//printf("free  m_newBlock: 0x%x \n", node->m_newBlock);fflush(stdout);
+	PointerArrayJob arrayJob(this, arrays.ptr());
+	ConvertJob convertJob(this, chunks.ptr());
 
-			fbtFree(node->m_newBlock);
-			node->m_newBlock = 0;
+	if (m_runner)
+	{
+		m_runner->parallelFor((int)arrays.size(), 64, &arrayJob);
+		m_runner->parallelFor((int)chunks.size(), 64, &convertJob);
+	}
+	else
+	{
+		arrayJob.run(0, (int)arrays.size());
+		convertJob.run(0, (int)chunks.size());
+	}
 
-			continue;
+
+	// in file order, subclasses collect lists here
+	FBTsizeType i;
+	for (i = 0; i < chunks.size(); ++i)
+		notifyData(chunks[i]->m_newBlock, chunks[i]->m_chunk);
+
+
+
+	for (node = (MemoryChunk*)m_chunks.first; node; node = node->m_next)
+	{
+		if (node->m_block)
+		{
+			if (!(node->m_flag & MemoryChunk::BLK_MAPPED))
+				fbtFree(node->m_block);
+			node->m_block = 0;
 		}
+	}
 
-		s2 = cs->m_members.size();
-		p2 = cs->m_members.ptr();
+	return fbtFile::FS_OK;
+}
+
+
+
+int fbtFile::allocPointerArrays(MemoryChunk* node, fbtArray<MemoryChunk*>& arrays)
+{
+	const fbtLinkPlan::Struct* ps = m_plan->getStruct(node->m_chunk.m_typeid);
+	const fbtLinkPlan::Op* ops = m_plan->getOps(ps);
+	FBTsizeType i, n;
+
+	FBTuint8 mps = m_memory->m_ptr, fps = m_file->m_ptr;
+
+	for (i = 0; i < ps->m_opCount; ++i)
+	{
+		if (ops[i].m_code != fbtLinkPlan::OP_POINTER_ARRAY)
+			continue;
 
 		for (n = 0; n < node->m_chunk.m_nr; ++n)
 		{
-			dst = static_cast<char*>(node->m_newBlock) + (cs->m_len * n);
-			src = static_cast<char*>(node->m_block) + (cs->m_link->m_len * n);
+			char* src = static_cast<char*>(node->m_block) + (ps->m_fileLen * n);
+			FBTsize* srcPtr = reinterpret_cast<FBTsize*>(src + ops[i].m_src);
+
+			if (!(*srcPtr))
+				continue;
 
+			MemoryChunk* bin = findBlock((FBTsize)(*srcPtr));
+			if (!bin || (bin->m_flag & MemoryChunk::BLK_MODIFIED))
+				continue;
 
-			for (i2 = 0; i2 < s2; ++i2)
+			// take pointer size out of the equation
+			FBTsize total = bin->m_chunk.m_len / fps;
+
+			FBTsize* nptr = (FBTsize*)fbtMalloc(total * mps);
+			if (!nptr)
 			{
-				fbtStruct* dstStrc = &p2[i2];
-				fbtStruct* srcStrc = dstStrc->m_link;
+				FBT_MALLOC_FAILED;
+				return FS_BAD_ALLOC;
+			}
+			fbtMemset(nptr, 0, total * mps);
 
-				// If it's missing we can safely skip this block
-				if (!srcStrc)
-					continue;
+			if (!(bin->m_flag & MemoryChunk::BLK_IN_PLACE))
+				fbtFree(bin->m_newBlock);
 
+			bin->m_flag &= ~MemoryChunk::BLK_IN_PLACE;
+			bin->m_flag |= MemoryChunk::BLK_MODIFIED;
+			bin->m_chunk.m_len = total * mps;
+			bin->m_newBlock = nptr;
 
-				dstPtr = reinterpret_cast<FBTsize*>(dst + dstStrc->m_off);
-				srcPtr = reinterpret_cast<FBTsize*>(src + srcStrc->m_off);
+			arrays.push_back(bin);
+		}
+	}
+	return FS_OK;
+}
 
 
 
-				const fbtName& nameD = m_memory->m_name[dstStrc->m_key.k16[1]];
-				const fbtName& nameS = m_file->m_name[srcStrc->m_key.k16[1]];
+void fbtFile::fillPointerArray(MemoryChunk* bin)
+{
+	FBTuint8 mps = m_memory->m_ptr, fps = m_file->m_ptr;
 
+	FBTsize total = bin->m_chunk.m_len / mps, pi;
+	FBTsize* nptr = (FBTsize*)bin->m_newBlock;
 
-				if (nameD.m_ptrCount > 0)
-				{
-					if ((*srcPtr))
-					{
-						if (nameD.m_ptrCount  > 1)
-						{
-							MemoryChunk* bin = findBlock((FBTsize)(*srcPtr));
-							if (bin)
-							{
-								if (bin->m_flag & MemoryChunk::BLK_MODIFIED)
-									(*dstPtr) = (FBTsize)bin->m_newBlock;
-								else
-								{
-									// take pointer size out of the equation
-									total = bin->m_chunk.m_len / fps;
+	// always use 32 bit, then offset + 2 for 64 bit (Old pointers are sorted in this mannor)
+	FBTuint32* optr = (FBTuint32*)bin->m_block;
 
+	for (pi = 0; pi < total; pi++, optr += (fps == 4 ? 1 : 2))
+		nptr[pi] = (FBTsize)resolvePtr((FBTsize) * optr);
+}
 
-									FBTsize* nptr = (FBTsize*)fbtMalloc(total * mps);
-									fbtMemset(nptr, 0, total * mps);
 
-									// always use 32 bit, then offset + 2 for 64 bit (Old pointers are sorted in this mannor)
-									FBTuint32* optr = (FBTuint32*)bin->m_block;
 
+// Runs the plan of the chunk's struct on every element.
+void fbtFile::convertChunk(MemoryChunk* node, int pass)
+{
+	const fbtLinkPlan::Struct* ps = m_plan->getStruct(node->m_chunk.m_typeid);
+	const fbtLinkPlan::Op* ops = m_plan->getOps(ps);
+	FBTsizeType i, a, n;
 
-									for (pi = 0; pi < total; pi++, optr += (fps == 4 ? 1 : 2))
-										nptr[pi] = (FBTsize)findPtr((FBTsize) * optr);
+	char* dst, *src;
 
-									(*dstPtr) = (FBTsize)(nptr);
+	FBTuint8 fps = m_file->m_ptr;
+	bool inPlace = (node->m_flag & MemoryChunk::BLK_IN_PLACE) != 0;
 
-									bin->m_chunk.m_len = total * mps;
-									bin->m_flag |= MemoryChunk::BLK_MODIFIED;
+	// lazy ID blocks keep the list links notifyData set
+	FBTuint32 keep = (m_lazy && node->m_chunk.m_code <= 0xFFFF) ? 2 * sizeof(void*) : 0;
 
-									fbtFree(bin->m_newBlock);
-									bin->m_newBlock = nptr;
-								}
-							}
-							else
-							{
-								//fbtPrintf("**block not found @ 0x%p)\n", src);
-							}
-						}
-						else
-						{
-							malen = nameD.m_arraySize > nameS.m_arraySize ? nameS.m_arraySize : nameD.m_arraySize;
+	bool values = !inPlace && (pass & CP_VALUES);
+	bool pointers = (pass & CP_POINTERS) != 0;
 
-							FBTsize* dptr = (FBTsize*)dstPtr;
+	for (n = 0; n < node->m_chunk.m_nr; ++n)
+	{
+		dst = static_cast<char*>(node->m_newBlock) + (ps->m_memoryLen * n);
+		src = static_cast<char*>(node->m_block) + (ps->m_fileLen * n);
 
-							// always use 32 bit, then offset + 2 for 64 bit (Old pointers are sorted in this mannor)
-							FBTuint32* sptr = (FBTuint32*)srcPtr;
 
+		for (i = 0; i < ps->m_opCount; ++i)
+		{
+			const fbtLinkPlan::Op& op = ops[i];
 
-							for (a2 = 0; a2 < malen; ++a2, sptr += (fps == 4 ? 1 : 2))
-								dptr[a2] = (FBTsize)findPtr((FBTsize) * sptr);
-						}
-					}
+			char* dstPtr = dst + op.m_dst;
+			char* srcPtr = src + op.m_src;
+
+			switch (op.m_code)
+			{
+			case fbtLinkPlan::OP_COPY:
+				if (values)
+					fbtMemcpy(dstPtr, srcPtr, op.m_count);
+				break;
+
+			case fbtLinkPlan::OP_POINTER_ARRAY:
+				if (pointers && op.m_dst >= keep)
+				{
+					// rebuilt by allocPointerArrays
+					FBTsize iptr = *reinterpret_cast<FBTsize*>(srcPtr);
+					*reinterpret_cast<FBTsize*>(dstPtr) = iptr ? (FBTsize)resolvePtr(iptr) : 0;
 				}
-				else
+				break;
+
+			case fbtLinkPlan::OP_POINTER:
+				if (pointers && op.m_dst >= keep)
 				{
-					FBTsize dstElmSize = dstStrc->m_len / nameD.m_arraySize;
-					FBTsize srcElmSize = srcStrc->m_len / nameS.m_arraySize;
+					FBTsize* dptr = reinterpret_cast<FBTsize*>(dstPtr);
 
-					bool needCast = (dstStrc->m_flag & fbtStruct::NEED_CAST) != 0;
-					bool needSwap = endianSwap && srcElmSize > 1;
+					// always use 32 bit, then offset + 2 for 64 bit (Old pointers are sorted in this mannor)
+					FBTuint32* sptr = reinterpret_cast<FBTuint32*>(srcPtr);
 
-					if (!needCast && !needSwap && srcStrc->m_val.k32[0] == dstStrc->m_val.k32[0]) //same type
-					{						
-						// Take the minimum length of any array.
-						mlen = fbtMin(srcStrc->m_len, dstStrc->m_len);
+					for (a = 0; a < op.m_count; ++a, sptr += (fps == 4 ? 1 : 2))
+						dptr[a] = (*sptr) ? (FBTsize)resolvePtr((FBTsize) * sptr) : 0;
+				}
+				break;
 
-						fbtMemcpy(dstPtr, srcPtr, mlen);
-						continue;
-					}
+			case fbtLinkPlan::OP_CONVERT:
+				if (values)
+					convertValues(op, reinterpret_cast<FBTbyte*>(dstPtr), reinterpret_cast<FBTbyte*>(srcPtr));
+				break;
+			}
+		}
+	}
+}
 
-					FBTbyte* dstBPtr = reinterpret_cast<FBTbyte*>(dstPtr);
-					FBTbyte* srcBPtr = reinterpret_cast<FBTbyte*>(srcPtr);
 
-					FBT_PRIM_TYPE stp = FBT_PRIM_UNKNOWN, dtp  = FBT_PRIM_UNKNOWN;
 
-					if (needCast || needSwap)
-					{
-						stp = fbtGetPrimType(srcStrc->m_val.k32[0]);
-						dtp = fbtGetPrimType(dstStrc->m_val.k32[0]);
+void fbtFile::convertValues(const fbtLinkPlan::Op& op, FBTbyte* dstBPtr, FBTbyte* srcBPtr)
+{
+	FBT_PRIM_TYPE stp = (FBT_PRIM_TYPE)op.m_srcType, dtp = (FBT_PRIM_TYPE)op.m_dstType;
 
-						FBT_ASSERT(fbtIsNumberType(stp) && fbtIsNumberType(dtp) && stp != dtp);
-					}
+	bool needCast = (op.m_flag & fbtLinkPlan::OF_CAST) != 0;
+	bool needSwap = (op.m_flag & fbtLinkPlan::OF_SWAP) != 0;
 
-					FBTsize alen = fbtMin(nameS.m_arraySize, nameD.m_arraySize);
-					FBTsize elen = fbtMin(srcElmSize, dstElmSize);
+	if (needCast || needSwap)
+	{
+		FBT_ASSERT(fbtIsNumberType(stp) && fbtIsNumberType(dtp) && stp != dtp);
+	}
 
-					FBTbyte tmpBuf[8] = {0, };
-					FBTsize i;
-					for (i = 0; i < alen; i++)
-					{
-						FBTbyte* tmp = srcBPtr;
-						if (needSwap)
-						{
-							tmp = tmpBuf;
-							fbtMemcpy(tmpBuf, srcBPtr, srcElmSize);
-
-							if (stp == FBT_PRIM_SHORT || stp == FBT_PRIM_USHORT) 
-								fbtSwap16((FBTuint16*)tmpBuf, 1);
-							else if (stp >= FBT_PRIM_INT && stp <= FBT_PRIM_FLOAT) 
-								fbtSwap32((FBTuint32*)tmpBuf, 1);
-							else if (stp == FBT_PRIM_DOUBLE)
-								fbtSwap64((FBTuint64*)tmpBuf, 1);
-							else
-								fbtMemset(tmpBuf, 0, sizeof(tmpBuf)); //unknown type
-						}
-						
-						if (needCast)
-							castValue((FBTsize*)tmp, (FBTsize*)dstBPtr, stp, dtp, 1);
-						else
-							fbtMemcpy(dstBPtr, tmp, elen);
-
-						dstBPtr += dstElmSize;
-						srcBPtr += srcElmSize;
-					}
-				}
+	FBTsize srcElmSize = op.m_srcElm, dstElmSize = op.m_dstElm;
+	FBTsize elen = fbtMin(srcElmSize, dstElmSize);
+
+	FBTbyte tmpBuf[8] = {0, };
+	FBTsize i;
+	for (i = 0; i < op.m_count; i++)
+	{
+		FBTbyte* tmp = srcBPtr;
+		if (needSwap)
+		{
+			tmp = tmpBuf;
+			fbtMemcpy(tmpBuf, srcBPtr, srcElmSize);
+
+			if (stp == FBT_PRIM_SHORT || stp == FBT_PRIM_USHORT) 
+				fbtSwap16((FBTuint16*)tmpBuf, 1);
+			else if (stp >= FBT_PRIM_INT && stp <= FBT_PRIM_FLOAT) 
+				fbtSwap32((FBTuint32*)tmpBuf, 1);
+			else if (stp == FBT_PRIM_DOUBLE)
+				fbtSwap64((FBTuint64*)tmpBuf, 1);
+			else
+				fbtMemset(tmpBuf, 0, sizeof(tmpBuf)); //unknown type
+		}
+		
+		if (needCast)
+			castValue((FBTsize*)tmp, (FBTsize*)dstBPtr, stp, dtp, 1);
+		else
+			fbtMemcpy(dstBPtr, tmp, elen);
+
+		dstBPtr += dstElmSize;
+		srcBPtr += srcElmSize;
+	}
+}
+
+
+
+// Lazy linking only allocates the blocks notifyData needs up front. Every
+// other block is allocated the first time a converted pointer refers to it
+// and is converted from m_pending, so linkBlock pulls in exactly the data
+// reachable from the ID it is called on. Runs on the calling thread.
+int fbtFile::linkLazy(void)
+{
+	MemoryChunk* node;
+	for (node = (MemoryChunk*)m_chunks.first; node; node = node->m_next)
+	{
+		const fbtLinkPlan::Struct* ps = m_plan->getStruct(node->m_chunk.m_typeid);
+		if (!ps)
+			continue;
+
+		node->m_newTypeId = ps->m_memoryId;
+
+		if (ps->m_flag & fbtLinkPlan::SF_LINK_TYPE)
+		{
+			if (fbtCanLinkInPlace(node, node->m_chunk.m_len))
+			{
+				node->m_newBlock = node->m_block;
+				node->m_flag |= MemoryChunk::BLK_IN_PLACE;
 			}
+			else
+				node->m_flag |= MemoryChunk::BLK_DEFERRED;
+			continue;
 		}
 
-		notifyData(node->m_newBlock, node->m_chunk);
+		if (skip(ps->m_typeId))
+			continue;
+
+
+		FBTsize totSize = (node->m_chunk.m_nr * ps->m_memoryLen);
+		bool inPlace = (ps->m_flag & fbtLinkPlan::SF_SAME_LAYOUT) && fbtCanLinkInPlace(node, totSize);
+
+		node->m_chunk.m_len = totSize;
+
+		if (inPlace)
+		{
+			node->m_newBlock = node->m_block;
+			node->m_flag |= MemoryChunk::BLK_IN_PLACE | MemoryChunk::BLK_PENDING;
+		}
+		else
+			node->m_flag |= MemoryChunk::BLK_DEFERRED;
 	}
 
 
+	const FBTuint8 lazyFlags = MemoryChunk::BLK_DEFERRED | MemoryChunk::BLK_PENDING;
 
 	for (node = (MemoryChunk*)m_chunks.first; node; node = node->m_next)
 	{
-		if (node->m_block)
+		if ((node->m_flag & lazyFlags) && !(node->m_flag & MemoryChunk::BLK_POINTERS) &&
+		        (m_plan->getStruct(node->m_chunk.m_typeid)->m_flag & fbtLinkPlan::SF_POINTER_ARRAYS))
+			markPointerArrays(node);
+	}
+
+
+	// IDs get their values now so names can be compared without linking,
+	// other top level blocks (GLOB, ...) are linked right away.
+	fbtArray<MemoryChunk*> notify;
+
+	for (node = (MemoryChunk*)m_chunks.first; node; node = node->m_next)
+	{
+		if (!(node->m_flag & lazyFlags) || node->m_chunk.m_code == DATA ||
+		        (node->m_flag & MemoryChunk::BLK_POINTERS) ||
+		        (m_plan->getStruct(node->m_chunk.m_typeid)->m_flag & fbtLinkPlan::SF_LINK_TYPE))
+			continue;
+
+		if ((node->m_flag & MemoryChunk::BLK_DEFERRED) && allocBlock(node) != FS_OK)
+			return FS_BAD_ALLOC;
+
+		if (node->m_chunk.m_code <= 0xFFFF)
 		{
-			fbtFree(node->m_block);
-			node->m_block = 0;
+			convertChunk(node, CP_VALUES);
+			m_ids.insert((FBTsize)node->m_newBlock, node);
 		}
+
+		notify.push_back(node);
+	}
+
+	FBTsizeType i;
+	for (i = 0; i < notify.size(); ++i)
+	{
+		if (notify[i]->m_chunk.m_code > 0xFFFF)
+			requireBlock(notify[i]);
 	}
 
+	linkPending();
+
+
+	for (i = 0; i < notify.size(); ++i)
+		notifyData(notify[i]->m_newBlock, notify[i]->m_chunk);
+
+	// m_block stays until the file is deleted
 	return fbtFile::FS_OK;
 }
 
 
 
+void fbtFile::markPointerArrays(MemoryChunk* node)
+{
+	const fbtLinkPlan::Struct* ps = m_plan->getStruct(node->m_chunk.m_typeid);
+	const fbtLinkPlan::Op* ops = m_plan->getOps(ps);
+	FBTsizeType i, n;
 
-void* fbtFile::findPtr(const FBTsize& iptr)
+	for (i = 0; i < ps->m_opCount; ++i)
+	{
+		if (ops[i].m_code != fbtLinkPlan::OP_POINTER_ARRAY)
+			continue;
+
+		for (n = 0; n < node->m_chunk.m_nr; ++n)
+		{
+			char* src = static_cast<char*>(node->m_block) + (ps->m_fileLen * n);
+			FBTsize* srcPtr = reinterpret_cast<FBTsize*>(src + ops[i].m_src);
+
+			if (!(*srcPtr))
+				continue;
+
+			MemoryChunk* bin = findBlock((FBTsize)(*srcPtr));
+			if (!bin || (bin->m_flag & MemoryChunk::BLK_POINTERS))
+				continue;
+
+			if (bin->m_flag & MemoryChunk::BLK_IN_PLACE)
+				bin->m_newBlock = 0;
+
+			bin->m_flag &= ~(MemoryChunk::BLK_IN_PLACE | MemoryChunk::BLK_PENDING);
+			bin->m_flag |= MemoryChunk::BLK_POINTERS | MemoryChunk::BLK_DEFERRED;
+		}
+	}
+}
+
+
+
+int fbtFile::allocBlock(MemoryChunk* bin)
+{
+	FBTsize len = bin->m_chunk.m_len;
+	bool copy = false;
+
+	if (bin->m_flag & MemoryChunk::BLK_POINTERS)
+	{
+		// take pointer size out of the equation
+		len = (len / m_file->m_ptr) * m_memory->m_ptr;
+	}
+	else
+		copy = (m_plan->getStruct(bin->m_chunk.m_typeid)->m_flag & fbtLinkPlan::SF_LINK_TYPE) != 0;
+
+	bin->m_newBlock = fbtMalloc(len);
+	if (!bin->m_newBlock)
+	{
+		FBT_MALLOC_FAILED;
+		return FS_BAD_ALLOC;
+	}
+
+	if (copy)
+		fbtMemcpy(bin->m_newBlock, bin->m_block, len);
+	else
+	{
+		fbtMemset(bin->m_newBlock, 0, len);
+		bin->m_flag |= MemoryChunk::BLK_PENDING;
+	}
+
+	bin->m_chunk.m_len = len;
+	bin->m_flag &= ~MemoryChunk::BLK_DEFERRED;
+	return FS_OK;
+}
+
+
+
+void* fbtFile::requireBlock(MemoryChunk* bin)
+{
+	if ((bin->m_flag & MemoryChunk::BLK_DEFERRED) && allocBlock(bin) != FS_OK)
+		return 0;
+
+	if (bin->m_flag & MemoryChunk::BLK_PENDING)
+	{
+		bin->m_flag &= ~MemoryChunk::BLK_PENDING;
+		m_pending.push_back(bin);
+	}
+	return bin->m_newBlock;
+}
+
+
+
+void fbtFile::linkPending(void)
+{
+	while (!m_pending.empty())
+	{
+		MemoryChunk* node = m_pending.back();
+		m_pending.pop_back();
+
+		if (node->m_flag & MemoryChunk::BLK_POINTERS)
+			fillPointerArray(node);
+		else
+			convertChunk(node, node->m_chunk.m_code <= 0xFFFF ? CP_POINTERS : CP_ALL);
+	}
+}
+
+
+
+void* fbtFile::linkBlock(void* block)
 {
 	FBTsizeType i;
-	if ((i = m_map.find(iptr)) != FBT_NPOS)
-		return m_map.at(i)->m_newBlock;
-	return 0;
+	if (!m_lazy || !block || (i = m_ids.find((FBTsize)block)) == FBT_NPOS)
+		return block;
+
+	requireBlock(m_ids.at(i));
+	linkPending();
+	return block;
+}
+
+
+
+void* fbtFile::resolvePtr(const FBTsize& iptr)
+{
+	if (!m_lazy)
+		return findPtr(iptr);
+
+	FBTsizeType i = findRemapExact(iptr);
+	if (i != FBT_NPOS)
+		return requireBlock(m_remapBins[i]);
+
+	if ((i = findRemap(iptr)) == FBT_NPOS)
+		return 0;
+
+	void* base = requireBlock(m_remapBins[i]);
+	return remapInterior(m_remapBins[i], (FBTuint32)iptr - m_remapKeys[i], base);
+}
+
+
+
+// called from the link jobs, read only
+void* fbtFile::findPtr(const FBTsize& iptr)
+{
+	FBTsizeType i = findRemapExact(iptr);
+	if (i != FBT_NPOS)
+		return m_remapBins[i]->m_newBlock;
+
+	if ((i = findRemap(iptr)) == FBT_NPOS)
+		return 0;
+
+	MemoryChunk* bin = m_remapBins[i];
+	return remapInterior(bin, (FBTuint32)iptr - m_remapKeys[i], bin->m_newBlock);
 }
 
 
 fbtFile::MemoryChunk* fbtFile::findBlock(const FBTsize& iptr)
 {
-	FBTsizeType i;
-	if ((i = m_map.find(iptr)) != FBT_NPOS)
-		return m_map.at(i);
-	return 0;
+	FBTsizeType i = findRemapExact(iptr);
+	return i != FBT_NPOS ? m_remapBins[i] : 0;
+}
+
+
+
+struct fbtRemapEntry
+{
+	FBTuint32               m_key;
+	FBTuint32               m_seq;
+	fbtFile::MemoryChunk*   m_bin;
+};
+
+static bool fbtRemapLess(const fbtRemapEntry& a, const fbtRemapEntry& b)
+{
+	return a.m_key < b.m_key || (a.m_key == b.m_key && a.m_seq < b.m_seq);
+}
+
+
+// Old pointers only compare their low 32 bits, as fbtSizeHashKey did.
+int fbtFile::buildRemap(void)
+{
+	fbtArray<fbtRemapEntry> entries;
+	MemoryChunk* node;
+	FBTuint32 seq = 0;
+
+	for (node = (MemoryChunk*)m_chunks.first; node; node = node->m_next)
+	{
+		fbtRemapEntry ent = {(FBTuint32)node->m_chunk.m_old, seq++, node};
+		entries.push_back(ent);
+	}
+
+	entries.sort(fbtRemapLess);
+
+	m_remapKeys.clear();
+	m_remapLens.clear();
+	m_remapBins.clear();
+	m_remapSlots.clear();
+
+	FBTsizeType i, n = entries.size();
+	for (i = 0; i < n; ++i)
+	{
+		node = entries[i].m_bin;
+
+		if (!m_remapKeys.empty() && m_remapKeys.back() == entries[i].m_key)
+		{
+			// the first chunk in file order wins
+#if FBT_ASSERT_INSERT
+			if (fbtMemcmp(&m_remapBins.back()->m_chunk, &node->m_chunk, fbtChunk::BlockSize) != 0)
+			{
+				FBT_INVALID_READ;
+				return FS_INV_READ;
+			}
+#endif
+			if (node->m_prev)
+				node->m_prev->m_next = node->m_next;
+			else
+				m_chunks.first = (fbtList::Link*)node->m_next;
+
+			if (node->m_next)
+				node->m_next->m_prev = node->m_prev;
+			else
+				m_chunks.last = (fbtList::Link*)node->m_prev;
+
+			if (!(node->m_flag & MemoryChunk::BLK_MAPPED))
+				fbtFree(node->m_block);
+			fbtFree(node);
+			continue;
+		}
+
+		m_remapKeys.push_back(entries[i].m_key);
+		m_remapLens.push_back((FBTuint32)node->m_chunk.m_len);
+		m_remapBins.push_back(node);
+	}
+
+
+	// at most half full
+	FBTuint32 bits = 4;
+	n = m_remapKeys.size();
+	while (((FBTsizeType)1 << bits) < n * 2)
+		++bits;
+
+	RemapSlot empty = {0, 0};
+	m_remapSlots.resize((FBTsizeType)1 << bits, empty);
+	m_remapShift = 32 - bits;
+
+	FBTuint32 mask = (1 << bits) - 1;
+	for (i = 0; i < n; ++i)
+	{
+		FBTuint32 s = (m_remapKeys[i] * 2654435761U) >> m_remapShift;
+		while (m_remapSlots[s].m_index)
+			s = (s + 1) & mask;
+
+		m_remapSlots[s].m_key   = m_remapKeys[i];
+		m_remapSlots[s].m_index = (FBTuint32)i + 1;
+	}
+	return FS_OK;
+}
+
+
+FBTsizeType fbtFile::findRemapExact(const FBTsize& iptr) const
+{
+	if (m_remapSlots.empty())
+		return FBT_NPOS;
+
+	FBTuint32 key  = (FBTuint32)iptr;
+	FBTuint32 mask = (FBTuint32)m_remapSlots.size() - 1;
+	FBTuint32 s    = (key * 2654435761U) >> m_remapShift;
+
+	const RemapSlot* slots = m_remapSlots.ptr();
+	while (slots[s].m_index)
+	{
+		if (slots[s].m_key == key)
+			return slots[s].m_index - 1;
+		s = (s + 1) & mask;
+	}
+	return FBT_NPOS;
+}
+
+
+// Index of the last block starting at or before iptr, if iptr is inside it.
+FBTsizeType fbtFile::findRemap(const FBTsize& iptr) const
+{
+	FBTuint32 key = (FBTuint32)iptr;
+	FBTsizeType n = m_remapKeys.size();
+
+	const FBTuint32* keys = m_remapKeys.ptr();
+	if (n == 0 || key < keys[0])
+		return FBT_NPOS;
+
+	// branch free, the compare turns into a conditional move
+	const FBTuint32* base = keys;
+	while (n > 1)
+	{
+		FBTsizeType half = n >> 1;
+		base = base[half] <= key ? base + half : base;
+		n -= half;
+	}
+
+	FBTsizeType i = base - keys;
+	FBTuint32 offset = key - keys[i];
+	if (offset && offset >= m_remapLens[i])
+		return FBT_NPOS;
+	return i;
+}
+
+
+// Pointers into a block, translated to the converted layout when they
+// fall on an element.
+void* fbtFile::remapInterior(MemoryChunk* bin, FBTsize offset, void* base)
+{
+	if (!base)
+		return 0;
+
+	FBTsize fileLen, memLen;
+
+	if (bin->m_flag & (MemoryChunk::BLK_MODIFIED | MemoryChunk::BLK_POINTERS))
+	{
+		fileLen = m_file->m_ptr;
+		memLen  = m_memory->m_ptr;
+	}
+	else
+	{
+		const fbtLinkPlan::Struct* ps = m_plan->getStruct(bin->m_chunk.m_typeid);
+		if (!ps)
+			return 0;
+
+		if (ps->m_flag & fbtLinkPlan::SF_LINK_TYPE)
+			return static_cast<char*>(base) + offset;
+
+		fileLen = ps->m_fileLen;
+		memLen  = ps->m_memoryLen;
+	}
+
+	if (!fileLen || (offset % fileLen) != 0)
+		return 0;
+	return static_cast<char*>(base) + (offset / fileLen) * memLen;
+}
+
+
+
+void fbtFile::compilePlan(FBThash dnaHash)
+{
+	if (m_ownsPlan)
+		delete m_plan;
+	m_ownsPlan = false;
+
+	fbtLinkPlan::Key key;
+	key.m_file   = dnaHash;
+	key.m_memory = fbtLinkPlan::hash(getFBT(), getFBTlength());
+	key.m_header = m_fileHeader;
+	key.m_ptr    = sizeof(void*);
+
+	m_plan = m_planCache ? m_planCache->find(key) : 0;
+	if (m_plan && m_plan->fits(m_memory, m_file))
+		return;
+
+	// a damaged cached plan stays in the cache, this file links with its own
+	bool damaged = m_plan != 0;
+	if (damaged)
+		fbtPrintf("Ignoring damaged link plan\n");
+
+
+	compileOffsets();
+
+	fbtLinkPlan* plan = new fbtLinkPlan(key);
+	plan->compile(m_memory, m_file, (m_fileHeader & FH_ENDIAN_SWAP) != 0);
+
+	if (m_planCache && !damaged)
+		m_plan = m_planCache->insert(plan);
+	else
+	{
+		m_plan = plan;
+		m_ownsPlan = true;
+	}
 }
 
 
@@ -829,6 +1479,7 @@ int fbtFile::compileOffsets(void)
 	fbtLinkCompiler lnk;
 	lnk.m_mp = m_memory;
 	lnk.m_fp = m_file;
+	lnk.m_sameBase = (m_fileHeader & (FH_ENDIAN_SWAP | FH_VAR_BITS)) == 0;
 	return lnk.link();
 }
 
@@ -845,8 +1496,9 @@ int fbtFile::reflect(const char* path, const int mode, const fbtEndian& endian)
 	fbtStream* fs;
 	
 #if FBT_USE_GZ_FILE == 1
+	// tagged members, read back in parallel by fbtGzPipeStream
 	if (mode == PM_COMPRESSED)
-		fs = new fbtGzStream();
+		fs = new fbtGzPipeStream();
 	else
 #endif
 	{
@@ -27,6 +27,7 @@
 #define _fbtFile_h_
 
 #include "fbtTypes.h"
+#include "fbtLinkPlan.h"
 
 /** \addtogroup FBT
 *  @{
@@ -34,6 +35,7 @@
 
 class fbtStream;
 class fbtBinTables;
+class fbtPackage;
 
 
 class fbtFile
@@ -70,7 +72,7 @@ public:
 		PM_UNCOMPRESSED,
 		PM_COMPRESSED,
 		PM_READTOMEMORY,
-
+		PM_MAPPED,      // map the file, chunks are read and converted in place
 	};
 
 	enum FileHeader
@@ -115,6 +117,11 @@ public:
 		enum Flag
 		{
 			BLK_MODIFIED = (1 << 0),
+			BLK_MAPPED   = (1 << 1), // m_block points into the mapped file
+			BLK_IN_PLACE = (1 << 2), // m_newBlock is m_block, converted in the mapping
+			BLK_DEFERRED = (1 << 3), // lazy, m_newBlock is not allocated yet
+			BLK_PENDING  = (1 << 4), // lazy, m_newBlock is not converted yet
+			BLK_POINTERS = (1 << 5), // lazy, rebuilt as a native pointer array
 		};
 
 		MemoryChunk* m_next, *m_prev;
@@ -127,6 +134,23 @@ public:
 		FBTtype      m_newTypeId;
 	};
 
+	/// Range of link work, run() may be called from any thread.
+	class Job
+	{
+	public:
+		virtual ~Job() {}
+		virtual void run(int begin, int end) = 0;
+	};
+
+	/// Runs job over [0, count) in ranges of about grain items and returns
+	/// once every range ran. Used to convert chunks in parallel while linking.
+	class JobRunner
+	{
+	public:
+		virtual ~JobRunner() {}
+		virtual void parallelFor(int count, int grain, Job* job) = 0;
+	};
+
 public:
 
 
@@ -152,8 +176,27 @@ public:
 
 	fbtList& getChunks(void) {return m_chunks;}
 
+	/// Package the file was parsed from, 0 for plain files. It reads
+	/// from the mapping (or the memory) the chunks point into.
+	fbtPackage* getPackage(void) {return m_package;}
+
     virtual void setIgnoreList(FBTuint32 *stripList) {}
 
+	/// Without a runner chunks are converted on the calling thread.
+	void setJobRunner(JobRunner* runner) {m_runner = runner;}
+
+	/// Lazy linking hands only the top level blocks to notifyData and
+	/// converts ID blocks without their pointers. linkBlock converts one
+	/// of them together with every block reachable from it, the first time
+	/// it is called on it. Not thread safe, has to be set before parse.
+	void setLazyLink(bool lazy) {m_lazy = lazy;}
+	bool isLazyLink(void) const {return m_lazy;}
+	void* linkBlock(void* block);
+
+	/// Files with a DNA the cache has seen skip matching it against the
+	/// builtin tables. The cache has to outlive the file.
+	void setLinkPlanCache(fbtLinkPlanCache* cache) {m_planCache = cache;}
+
 	bool _setuid(const char* uid);
 
 protected:
@@ -183,9 +226,35 @@ protected:
 
 	typedef fbtHashTable<fbtSizeHashKey, MemoryChunk*> ChunkMap;
 	fbtList     m_chunks;
-	ChunkMap    m_map;
 	fbtBinTables* m_memory, *m_file;
 
+	// Old addresses (low 32 bits) sorted once the chunks are read, with the
+	// file length and chunk of each. Exact addresses are found through a
+	// flat open addressing index, interior ones by searching the keys.
+	struct RemapSlot
+	{
+		FBTuint32 m_key;
+		FBTuint32 m_index; // + 1, 0 is empty
+	};
+
+	fbtArray<FBTuint32>     m_remapKeys;
+	fbtArray<FBTuint32>     m_remapLens;
+	fbtArray<MemoryChunk*>  m_remapBins;
+	fbtArray<RemapSlot>     m_remapSlots;
+	FBTuint32               m_remapShift;
+
+	// kept open for PM_MAPPED, chunks point into it
+	fbtStream*  m_mapped;
+	fbtPackage* m_package;
+	JobRunner*  m_runner;
+
+	bool        m_lazy;
+	ChunkMap    m_ids;      // lazy, ID blocks by m_newBlock
+	fbtArray<MemoryChunk*> m_pending;
+
+	fbtLinkPlan*        m_plan;
+	fbtLinkPlanCache*   m_planCache;
+	bool                m_ownsPlan;
 
 	virtual bool skip(const FBTuint32& id) {return false;}
 	void* findPtr(const FBTsize& iptr);
@@ -197,8 +266,33 @@ private:
 	int parseHeader(fbtStream* stream, bool suppressHeaderWarning=false);
 	int parseStreamImpl(fbtStream* stream, bool suppressHeaderWarning=false);
 
+	class ConvertJob;
+	class PointerArrayJob;
+
 	int compileOffsets(void);
+	int buildRemap(void);
+	FBTsizeType findRemap(const FBTsize& iptr) const;
+	FBTsizeType findRemapExact(const FBTsize& iptr) const;
+	void* remapInterior(MemoryChunk* bin, FBTsize offset, void* base);
+	void compilePlan(FBThash dnaHash);
 	int link(void);
+	int linkLazy(void);
+	int allocBlock(MemoryChunk* bin);
+	void markPointerArrays(MemoryChunk* node);
+	void* requireBlock(MemoryChunk* bin);
+	void* resolvePtr(const FBTsize& iptr);
+	void linkPending(void);
+	int allocPointerArrays(MemoryChunk* node, fbtArray<MemoryChunk*>& arrays);
+	void fillPointerArray(MemoryChunk* bin);
+
+	enum ConvertPass
+	{
+		CP_VALUES   = (1 << 0),
+		CP_POINTERS = (1 << 1),
+		CP_ALL      = CP_VALUES | CP_POINTERS,
+	};
+	void convertChunk(MemoryChunk* node, int pass = CP_ALL);
+	void convertValues(const fbtLinkPlan::Op& op, FBTbyte* dst, FBTbyte* src);
 };
 
 /** @}*/
@@ -0,0 +1,380 @@
+/*
+-------------------------------------------------------------------------------
+    This file is part of FBT (File Binary Tables).
+    http://gamekit.googlecode.com/
+
+    Copyright (c) 2010 Charlie C & Erwin Coumans.
+
+-------------------------------------------------------------------------------
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#define FBT_IN_SOURCE
+
+#include "fbtLinkPlan.h"
+#include "fbtFile.h"
+#include "fbtStreams.h"
+#include "fbtTables.h"
+#include "fbtPlatformHeaders.h"
+
+
+#define FBT_PLAN_VERSION 1
+
+struct fbtLinkPlanHeader
+{
+	char                m_magic[4];
+	FBTuint32           m_version;
+	fbtLinkPlan::Key    m_key;
+	FBTuint32           m_structs, m_ops;
+};
+
+
+
+FBThash fbtLinkPlan::hash(const void* ptr, FBTsize len)
+{
+	// Fowler / Noll / Vo (FNV) Hash
+	const FBTuint8* cp = static_cast<const FBTuint8*>(ptr);
+
+	FBThash h = (FBThash)_FBT_INITIAL_FNV;
+	for (FBTsize i = 0; i < len; ++i)
+	{
+		h ^= cp[i];
+		h *= _FBT_MULTIPLE_FNV;
+	}
+	return h;
+}
+
+
+
+void fbtLinkPlan::compile(fbtBinTables* mp, fbtBinTables* fp, bool endianSwap)
+{
+	static const FBThash hk = fbtCharHashKey("Link").hash();
+
+	FBTsizeType i, i2, s = fp->m_offs.size();
+
+	m_structs.resize(s);
+	m_ops.clear();
+
+	for (i = 0; i < s; ++i)
+	{
+		Struct& ps = m_structs.at(i);
+		fbtMemset(&ps, 0, sizeof(Struct));
+
+		fbtStruct* fs = fp->m_offs.at(i);
+		fbtStruct* ms = fs->m_link;
+		if (!ms)
+			continue;
+
+		ps.m_flag       = SF_LINKED;
+		ps.m_memoryId   = ms->m_strcId;
+		ps.m_typeId     = mp->m_type[ms->m_key.k16[0]].m_typeId;
+		ps.m_fileLen    = fs->m_len;
+		ps.m_memoryLen  = ms->m_len;
+		ps.m_firstOp    = m_ops.size();
+
+		if (ps.m_typeId == hk)
+		{
+			ps.m_flag |= SF_LINK_TYPE;
+			continue;
+		}
+
+		if (ms->m_flag & fbtStruct::SAME_LAYOUT)
+			ps.m_flag |= SF_SAME_LAYOUT;
+
+
+		fbtStruct::Members::Pointer p2 = ms->m_members.ptr();
+		for (i2 = 0; i2 < ms->m_members.size(); ++i2)
+		{
+			fbtStruct* dstStrc = &p2[i2];
+			fbtStruct* srcStrc = dstStrc->m_link;
+
+			// If it's missing we can safely skip this block
+			if (!srcStrc)
+				continue;
+
+			const fbtName& nameD = mp->m_name[dstStrc->m_key.k16[1]];
+			const fbtName& nameS = fp->m_name[srcStrc->m_key.k16[1]];
+
+			Op op;
+			fbtMemset(&op, 0, sizeof(Op));
+			op.m_dst = dstStrc->m_off;
+			op.m_src = srcStrc->m_off;
+
+			if (nameD.m_ptrCount > 1)
+			{
+				op.m_code  = OP_POINTER_ARRAY;
+				op.m_count = 1;
+				ps.m_flag |= SF_POINTER_ARRAYS;
+			}
+			else if (nameD.m_ptrCount > 0)
+			{
+				op.m_code  = OP_POINTER;
+				op.m_count = fbtMin(nameD.m_arraySize, nameS.m_arraySize);
+			}
+			else
+			{
+				FBTsize dstElmSize = dstStrc->m_len / nameD.m_arraySize;
+				FBTsize srcElmSize = srcStrc->m_len / nameS.m_arraySize;
+
+				bool needCast = (dstStrc->m_flag & fbtStruct::NEED_CAST) != 0;
+				bool needSwap = endianSwap && srcElmSize > 1;
+
+				if (!needCast && !needSwap && srcStrc->m_val.k32[0] == dstStrc->m_val.k32[0]) //same type
+				{
+					// Take the minimum length of any array.
+					op.m_code  = OP_COPY;
+					op.m_count = fbtMin(srcStrc->m_len, dstStrc->m_len);
+
+					// members following each other in both structs are one copy
+					if (m_ops.size() > ps.m_firstOp)
+					{
+						Op& last = m_ops.back();
+						if (last.m_code == OP_COPY && last.m_dst + last.m_count == op.m_dst && last.m_src + last.m_count == op.m_src)
+						{
+							last.m_count += op.m_count;
+							continue;
+						}
+					}
+				}
+				else
+				{
+					op.m_code   = OP_CONVERT;
+					op.m_flag   = (needCast ? OF_CAST : 0) | (needSwap ? OF_SWAP : 0);
+					op.m_count  = fbtMin(nameS.m_arraySize, nameD.m_arraySize);
+					op.m_srcElm = (FBTuint16)srcElmSize;
+					op.m_dstElm = (FBTuint16)dstElmSize;
+
+					if (needCast || needSwap)
+					{
+						op.m_srcType = (FBTuint8)fbtGetPrimType(srcStrc->m_val.k32[0]);
+						op.m_dstType = (FBTuint8)fbtGetPrimType(dstStrc->m_val.k32[0]);
+					}
+				}
+			}
+
+			m_ops.push_back(op);
+		}
+
+		ps.m_opCount = m_ops.size() - ps.m_firstOp;
+	}
+}
+
+
+
+bool fbtLinkPlan::load(fbtStream* stream)
+{
+	fbtLinkPlanHeader header;
+	if (stream->read(&header, sizeof(header)) != sizeof(header))
+		return false;
+
+	if (fbtMemcmp(header.m_magic, "FBTP", 4) != 0 || header.m_version != FBT_PLAN_VERSION || !(header.m_key == m_key))
+		return false;
+
+	if (header.m_structs > 0xFFFF || stream->size() != sizeof(header) + header.m_structs * sizeof(Struct) + header.m_ops * sizeof(Op))
+		return false;
+
+	m_structs.resize(header.m_structs);
+	m_ops.resize(header.m_ops);
+
+	if (header.m_structs && stream->read(m_structs.ptr(), header.m_structs * sizeof(Struct)) != header.m_structs * sizeof(Struct))
+		return false;
+	if (header.m_ops && stream->read(m_ops.ptr(), header.m_ops * sizeof(Op)) != header.m_ops * sizeof(Op))
+		return false;
+
+	const FBTuint64 fps = (m_key.m_header & fbtFile::FH_CHUNK_64) ? 8 : 4, mps = m_key.m_ptr;
+
+	for (FBTsizeType i = 0; i < m_structs.size(); ++i)
+	{
+		const Struct& ps = m_structs.at(i);
+		if (ps.m_firstOp > header.m_ops || ps.m_opCount > header.m_ops - ps.m_firstOp)
+			return false;
+
+		// the linker copies without checks, every op has to fit both structs
+		for (FBTuint32 j = 0; j < ps.m_opCount; ++j)
+		{
+			const Op& op = m_ops.at(ps.m_firstOp + j);
+
+			FBTuint64 src, dst;
+			switch (op.m_code)
+			{
+			case OP_COPY:
+				src = dst = op.m_count;
+				break;
+			case OP_POINTER:
+				src = fps * op.m_count;
+				dst = mps * op.m_count;
+				break;
+			case OP_POINTER_ARRAY:
+				src = fps;
+				dst = mps;
+				break;
+			case OP_CONVERT:
+				if (op.m_srcElm > 8 || op.m_dstElm > 8)
+					return false;
+				src = (FBTuint64)op.m_srcElm * op.m_count;
+				dst = (FBTuint64)op.m_dstElm * op.m_count;
+				break;
+			default:
+				return false;
+			}
+
+			if (op.m_src + src > ps.m_fileLen || op.m_dst + dst > ps.m_memoryLen)
+				return false;
+		}
+	}
+	return true;
+}
+
+
+
+bool fbtLinkPlan::fits(fbtBinTables* mp, fbtBinTables* fp) const
+{
+	if (m_structs.size() != fp->m_offs.size())
+		return false;
+
+	for (FBTsizeType i = 0; i < m_structs.size(); ++i)
+	{
+		const Struct& ps = m_structs.at(i);
+		if (!(ps.m_flag & SF_LINKED))
+			continue;
+
+		if (ps.m_fileLen != fp->m_offs.at(i)->m_len)
+			return false;
+		if (ps.m_memoryId >= mp->m_offs.size() || ps.m_memoryLen != mp->m_offs.at(ps.m_memoryId)->m_len)
+			return false;
+	}
+	return true;
+}
+
+
+
+bool fbtLinkPlan::save(fbtStream* stream) const
+{
+	fbtLinkPlanHeader header;
+	fbtMemset(&header, 0, sizeof(header));
+	fbtMemcpy(header.m_magic, "FBTP", 4);
+	header.m_version = FBT_PLAN_VERSION;
+	header.m_key     = m_key;
+	header.m_structs = m_structs.size();
+	header.m_ops     = m_ops.size();
+
+	if (stream->write(&header, sizeof(header)) != sizeof(header))
+		return false;
+	if (header.m_structs && stream->write(m_structs.ptr(), header.m_structs * sizeof(Struct)) != header.m_structs * sizeof(Struct))
+		return false;
+	if (header.m_ops && stream->write(m_ops.ptr(), header.m_ops * sizeof(Op)) != header.m_ops * sizeof(Op))
+		return false;
+	return true;
+}
+
+
+
+fbtLinkPlanCache::fbtLinkPlanCache(const char* dir)
+	:   m_dir(dir ? dir : "")
+{
+}
+
+
+fbtLinkPlanCache::~fbtLinkPlanCache()
+{
+	clear();
+}
+
+
+void fbtLinkPlanCache::clear(void)
+{
+	for (FBTsizeType i = 0; i < m_plans.size(); ++i)
+		delete m_plans[i];
+	m_plans.clear();
+}
+
+
+static void fbtLinkPlanPath(char* path, FBTsize len, const char* fmt, ...)
+{
+	va_list lst;
+	va_start(lst, fmt);
+	fbtp_printf(path, len, fmt, lst);
+	va_end(lst);
+}
+
+
+void fbtLinkPlanCache::getPath(const fbtLinkPlan::Key& key, char* path, FBTsize len) const
+{
+	fbtLinkPlanPath(path, len, "%s/%08x%08x%02x%02x.fbtplan", m_dir.c_str(), key.m_file, key.m_memory, key.m_header, key.m_ptr);
+}
+
+
+fbtLinkPlan* fbtLinkPlanCache::find(const fbtLinkPlan::Key& key)
+{
+	FBTsizeType i;
+	for (i = 0; i < m_plans.size(); ++i)
+	{
+		if (m_plans[i]->getKey() == key)
+			return m_plans[i];
+	}
+
+	if (m_dir.empty())
+		return 0;
+
+
+	char path[512];
+	getPath(key, path, sizeof(path));
+
+	fbtFileStream fs;
+	fs.open(path, fbtStream::SM_READ);
+	if (!fs.isOpen())
+		return 0;
+
+	fbtLinkPlan* plan = new fbtLinkPlan(key);
+	if (!plan->load(&fs))
+	{
+		fbtPrintf("Ignoring stale link plan %s\n", path);
+		delete plan;
+		return 0;
+	}
+
+	m_plans.push_back(plan);
+	return plan;
+}
+
+
+fbtLinkPlan* fbtLinkPlanCache::insert(fbtLinkPlan* plan)
+{
+	FBTsizeType i;
+	for (i = 0; i < m_plans.size(); ++i)
+	{
+		if (m_plans[i]->getKey() == plan->getKey())
+		{
+			delete plan;
+			return m_plans[i];
+		}
+	}
+
+	m_plans.push_back(plan);
+
+	if (!m_dir.empty())
+	{
+		char path[512];
+		getPath(plan->getKey(), path, sizeof(path));
+
+		fbtFileStream fs;
+		fs.open(path, fbtStream::SM_WRITE);
+		if (fs.isOpen())
+			plan->save(&fs);
+	}
+	return plan;
+}
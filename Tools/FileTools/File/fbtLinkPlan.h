@@ -0,0 +1,162 @@
+/*
+-------------------------------------------------------------------------------
+    This file is part of FBT (File Binary Tables).
+    http://gamekit.googlecode.com/
+
+    Copyright (c) 2010 Charlie C & Erwin Coumans.
+
+-------------------------------------------------------------------------------
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#ifndef _fbtLinkPlan_h_
+#define _fbtLinkPlan_h_
+
+#include "fbtTypes.h"
+
+/** \addtogroup FBT
+*  @{
+*/
+
+class fbtStream;
+class fbtBinTables;
+
+
+/// Per struct conversion program of one file DNA against the memory DNA.
+/// Compiled once from the linked tables, after that chunks are converted
+/// with straight copies and pointer patches, without any table lookups.
+class fbtLinkPlan
+{
+public:
+
+	enum OpCode
+	{
+		OP_COPY,            // m_count bytes
+		OP_POINTER,         // m_count file pointers
+		OP_POINTER_ARRAY,   // one pointer to a pointer array
+		OP_CONVERT,         // m_count values, swapped and/or cast
+	};
+
+	enum OpFlag
+	{
+		OF_SWAP = (1 << 0),
+		OF_CAST = (1 << 1),
+	};
+
+	struct Op
+	{
+		FBTuint8    m_code;
+		FBTuint8    m_flag;
+		FBTuint8    m_srcType, m_dstType;   // FBT_PRIM_TYPE of OP_CONVERT
+		FBTuint32   m_dst, m_src;
+		FBTuint32   m_count;
+		FBTuint16   m_srcElm, m_dstElm;
+	};
+
+	enum StructFlag
+	{
+		SF_LINKED         = (1 << 0), // has a memory struct
+		SF_LINK_TYPE      = (1 << 1), // raw "Link" data, copied as is
+		SF_SAME_LAYOUT    = (1 << 2),
+		SF_POINTER_ARRAYS = (1 << 3), // has OP_POINTER_ARRAY ops
+	};
+
+	struct Struct
+	{
+		FBThash     m_typeId;   // memory type name hash, see fbtFile::skip
+		FBTuint32   m_fileLen, m_memoryLen;
+		FBTuint32   m_firstOp, m_opCount;
+		FBTtype     m_memoryId;
+		FBTuint16   m_flag;
+	};
+
+	/// A plan only fits files with the same DNA, header and memory tables.
+	struct Key
+	{
+		FBThash     m_file, m_memory;
+		FBTuint32   m_header;
+		FBTuint32   m_ptr;
+
+		bool operator == (const Key& k) const
+		{
+			return m_file == k.m_file && m_memory == k.m_memory && m_header == k.m_header && m_ptr == k.m_ptr;
+		}
+	};
+
+public:
+
+	fbtLinkPlan(const Key& key) : m_key(key) {}
+
+	const Key& getKey(void) const {return m_key;}
+
+	/// Needs tables linked by fbtFile::compileOffsets.
+	void compile(fbtBinTables* memory, fbtBinTables* file, bool endianSwap);
+
+	/// 0 for unknown struct ids and structs missing in memory.
+	FBT_INLINE const Struct* getStruct(FBTuint32 fileTypeId) const
+	{
+		if (fileTypeId >= m_structs.size() || !(m_structs.at(fileTypeId).m_flag & SF_LINKED))
+			return 0;
+		return &m_structs.at(fileTypeId);
+	}
+
+	FBT_INLINE const Op* getOps(const Struct* strc) const {return m_ops.ptr() + strc->m_firstOp;}
+
+	/// Rejects plans whose ops reach past their structs.
+	bool load(fbtStream* stream);
+
+	/// False if the struct lengths differ from the tables, for loaded plans.
+	bool fits(fbtBinTables* memory, fbtBinTables* file) const;
+	bool save(fbtStream* stream) const;
+
+	static FBThash hash(const void* ptr, FBTsize len);
+
+private:
+
+	Key                 m_key;
+	fbtArray<Struct>    m_structs;  // by file struct id
+	fbtArray<Op>        m_ops;
+};
+
+
+/// Keeps plans for later loads, in memory and optionally in a directory.
+/// Plans are read only once cached and can be shared by files on several
+/// threads, find and insert have to be guarded by a subclass if needed.
+class fbtLinkPlanCache
+{
+public:
+	fbtLinkPlanCache(const char* dir = 0);
+	virtual ~fbtLinkPlanCache();
+
+	virtual fbtLinkPlan* find(const fbtLinkPlan::Key& key);
+
+	/// Takes the plan, returns the one to use.
+	virtual fbtLinkPlan* insert(fbtLinkPlan* plan);
+
+	void clear(void);
+
+protected:
+
+	void getPath(const fbtLinkPlan::Key& key, char* path, FBTsize len) const;
+
+	fbtArray<fbtLinkPlan*>  m_plans;
+	fbtFixedString<256>     m_dir;
+};
+
+
+/** @}*/
+#endif//_fbtLinkPlan_h_
@@ -0,0 +1,292 @@
+/*
+-------------------------------------------------------------------------------
+    This file is part of FBT (File Binary Tables).
+    http://gamekit.googlecode.com/
+
+    Copyright (c) 2010 Charlie C & Erwin Coumans.
+
+-------------------------------------------------------------------------------
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#define FBT_IN_SOURCE
+
+#include "fbtPackage.h"
+#include "fbtFile.h"
+#include "fbtStreams.h"
+#include "fbtPlatformHeaders.h"
+
+
+#define FBT_PACKAGE_ID      "FBPK"
+#define FBT_PACKAGE_ENDIAN  0x01020304
+
+
+static FBThash fbtPackageHash(FBTuint32 code, const char* name)
+{
+	FBThash h = (FBThash)_FBT_INITIAL_FNV;
+	h = (h ^ code) * _FBT_MULTIPLE_FNV;
+
+	for (int i = 0; i < fbtPackage::NAME_LEN && name[i]; ++i)
+		h = (h ^ name[i]) * _FBT_MULTIPLE_FNV;
+	return h;
+}
+
+
+static FBTsize fbtPackageAlign(FBTsize v)
+{
+	return (v + (fbtPackage::ALIGN - 1)) & ~(FBTsize)(fbtPackage::ALIGN - 1);
+}
+
+
+fbtPackage::fbtPackage()
+	:   m_mapped(0), m_data(0), m_toc(0), m_count(0)
+{
+}
+
+
+fbtPackage::~fbtPackage()
+{
+	close();
+
+	for (FBTsizeType i = 0; i < m_pending.size(); ++i)
+		fbtFree(m_pending[i].m_data);
+}
+
+
+bool fbtPackage::isPackage(const void* memory, FBTsize len)
+{
+	if (!memory || len < sizeof(Header))
+		return false;
+
+	const Header* header = (const Header*)memory;
+	return fbtCharNEq(header->m_magic, FBT_PACKAGE_ID, 4)
+	       && header->m_version == VERSION
+	       && header->m_endian == FBT_PACKAGE_ENDIAN;
+}
+
+
+bool fbtPackage::open(const char* path)
+{
+	close();
+
+	m_mapped = new fbtMappedStream();
+	m_mapped->open(path, fbtStream::SM_READ);
+
+	if (!m_mapped->isOpen() || !open(m_mapped->ptr(), m_mapped->size()))
+	{
+		close();
+		return false;
+	}
+	return true;
+}
+
+
+bool fbtPackage::open(const void* memory, FBTsize len)
+{
+	if (!isPackage(memory, len))
+		return false;
+
+	const Header* header = (const Header*)memory;
+	if (header->m_toc > len || header->m_count > (len - header->m_toc) / sizeof(Section))
+		return false;
+
+	const Section* toc = (const Section*)((const char*)memory + header->m_toc);
+	for (FBTuint32 i = 0; i < header->m_count; ++i)
+	{
+		if (toc[i].m_offset > len || toc[i].m_len > len - toc[i].m_offset)
+			return false;
+	}
+
+	m_data  = (const char*)memory;
+	m_toc   = toc;
+	m_count = header->m_count;
+
+	// power of two, at least twice the sections
+	FBTsize nr = 16;
+	while (nr < m_count * 2)
+		nr <<= 1;
+
+	m_buckets.clear();
+	m_next.clear();
+	m_buckets.resize(nr, FBT_NPOS);
+	m_next.resize(m_count, FBT_NPOS);
+
+	// backwards, so chains keep the first of equal sections in front
+	for (FBTsize i = m_count; i-- > 0;)
+	{
+		FBTsize b = fbtPackageHash(toc[i].m_code, toc[i].m_name) & (nr - 1);
+		m_next[i]    = m_buckets[b];
+		m_buckets[b] = i;
+	}
+	return true;
+}
+
+
+void fbtPackage::close(void)
+{
+	delete m_mapped;
+	m_mapped = 0;
+	m_data   = 0;
+	m_toc    = 0;
+	m_count  = 0;
+	m_buckets.clear();
+	m_next.clear();
+}
+
+
+const fbtPackage::Section* fbtPackage::find(FBTuint32 code, const char* name) const
+{
+	if (name)
+	{
+		if (m_buckets.empty())
+			return 0;
+
+		FBTsize i = m_buckets[fbtPackageHash(code, name) & (m_buckets.size() - 1)];
+		for (; i != FBT_NPOS; i = m_next[i])
+		{
+			const Section& sec = m_toc[i];
+			if (sec.m_code == code && fbtCharNEq(sec.m_name, name, NAME_LEN))
+				return &sec;
+		}
+		return 0;
+	}
+
+	for (FBTsize i = 0; i < m_count; ++i)
+	{
+		const Section& sec = m_toc[i];
+		if (sec.m_code == code && (!name || fbtCharNEq(sec.m_name, name, NAME_LEN)))
+			return &sec;
+	}
+	return 0;
+}
+
+
+bool fbtPackage::addSection(FBTuint32 code, const char* name, const void* data, FBTsize len, FBTuint32 flag)
+{
+	Pending pending;
+	fbtMemset(&pending.m_section, 0, sizeof(Section));
+
+	pending.m_section.m_code = code;
+	pending.m_section.m_flag = flag;
+	pending.m_section.m_len  = len;
+
+	if (name)
+	{
+		FBTsize nl = fbtMin<FBTsize>(strlen(name), NAME_LEN - 1);
+		fbtMemcpy(pending.m_section.m_name, name, nl);
+	}
+
+	pending.m_data = fbtMalloc(len ? len : 1);
+	if (!pending.m_data)
+		return false;
+
+	if (len)
+		fbtMemcpy(pending.m_data, data, len);
+
+	m_pending.push_back(pending);
+	return true;
+}
+
+
+bool fbtPackage::addFile(FBTuint32 code, const char* name, const char* path, FBTuint32 flag)
+{
+	fbtStream* stream;
+#if FBT_USE_GZ_FILE == 1
+	stream = new fbtGzPipeStream();
+#else
+	stream = new fbtFileStream();
+#endif
+
+	stream->open(path, fbtStream::SM_READ);
+	if (!stream->isOpen())
+	{
+		delete stream;
+		return false;
+	}
+
+	FBTsize len = 0, capacity = 1024 * 1024;
+	char* data = (char*)fbtMalloc(capacity);
+
+	while (data)
+	{
+		if (len == capacity)
+		{
+			char* grown = (char*)fbtMalloc(capacity * 2);
+			if (grown)
+				fbtMemcpy(grown, data, len);
+
+			fbtFree(data);
+			data = grown;
+			capacity *= 2;
+			continue;
+		}
+
+		FBTsize nr = stream->read(data + len, capacity - len);
+		if (nr == 0 || nr == FBT_NPOS)
+			break;
+		len += nr;
+	}
+	delete stream;
+
+	if (!data)
+		return false;
+
+	bool result = len != 0 && addSection(code, name, data, len, flag);
+	fbtFree(data);
+	return result;
+}
+
+
+int fbtPackage::save(const char* path)
+{
+	fbtFileStream fs;
+	fs.open(path, fbtStream::SM_WRITE);
+	if (!fs.isOpen())
+		return fbtFile::FS_FAILED;
+
+	static const char zeros[ALIGN] = {0};
+
+	FBTsize offset = fbtPackageAlign(sizeof(Header));
+	for (FBTsizeType i = 0; i < m_pending.size(); ++i)
+	{
+		m_pending[i].m_section.m_offset = offset;
+		offset = fbtPackageAlign(offset + (FBTsize)m_pending[i].m_section.m_len);
+	}
+
+	Header header;
+	fbtMemset(&header, 0, sizeof(Header));
+	fbtMemcpy(header.m_magic, FBT_PACKAGE_ID, 4);
+	header.m_version = VERSION;
+	header.m_endian  = FBT_PACKAGE_ENDIAN;
+	header.m_count   = m_pending.size();
+	header.m_toc     = offset;
+
+	FBTsize pos = fs.write(&header, sizeof(Header));
+	for (FBTsizeType i = 0; i < m_pending.size(); ++i)
+	{
+		const Section& sec = m_pending[i].m_section;
+
+		pos += fs.write(zeros, (FBTsize)sec.m_offset - pos);
+		pos += fs.write(m_pending[i].m_data, (FBTsize)sec.m_len);
+	}
+	pos += fs.write(zeros, offset - pos);
+
+	for (FBTsizeType i = 0; i < m_pending.size(); ++i)
+		pos += fs.write(&m_pending[i].m_section, sizeof(Section));
+
+	return pos == offset + m_pending.size() * sizeof(Section) ? fbtFile::FS_OK : fbtFile::FS_FAILED;
+}
@@ -0,0 +1,131 @@
+/*
+-------------------------------------------------------------------------------
+    This file is part of FBT (File Binary Tables).
+    http://gamekit.googlecode.com/
+
+    Copyright (c) 2010 Charlie C & Erwin Coumans.
+
+-------------------------------------------------------------------------------
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#ifndef _fbtPackage_h_
+#define _fbtPackage_h_
+
+#include "fbtTypes.h"
+
+/** \addtogroup FBT
+*  @{
+*/
+
+class fbtMappedStream;
+
+
+/// Memory mappable container of named binary sections.
+///
+/// Sections start at 16 byte boundaries so their contents can be used in
+/// place from the mapping. A table of contents at the end of the file lists
+/// them by a four character code and a name. Packages are only read on
+/// platforms with the byte order they were written with.
+class fbtPackage
+{
+public:
+
+	enum
+	{
+		VERSION     = 1,
+		ALIGN       = 16,
+		NAME_LEN    = 64,
+	};
+
+	struct Header
+	{
+		char        m_magic[4];     // "FBPK"
+		FBTuint32   m_version;
+		FBTuint32   m_endian;       // 0x01020304 as written
+		FBTuint32   m_count;        // sections
+		FBTuint64   m_toc;          // offset of the section table
+		FBTuint64   m_reserved;
+	};
+
+	struct Section
+	{
+		FBTuint32   m_code;         // FBT_ID
+		FBTuint32   m_flag;         // user data
+		FBTuint64   m_offset;
+		FBTuint64   m_len;
+		char        m_name[NAME_LEN];
+	};
+
+public:
+	fbtPackage();
+	~fbtPackage();
+
+	/// Maps path, false if it is not a package.
+	bool open(const char* path);
+
+	/// Reads a package already in memory, the buffer has to outlive it.
+	bool open(const void* memory, FBTsize len);
+
+	void close(void);
+
+	bool isOpen(void) const {return m_data != 0;}
+
+	/// First section with code, and name if given. 0 if there is none.
+	/// Lookups by name are hashed, code only lookups scan the table.
+	const Section* find(FBTuint32 code, const char* name = 0) const;
+
+	const void* getData(const Section* section) const {return m_data + section->m_offset;}
+
+	FBTsize        getSectionCount(void)   const {return m_count;}
+	const Section* getSection(FBTsize i)   const {return m_toc + i;}
+
+
+	/// Queues a copy of data for save, false if it could not be allocated.
+	bool addSection(FBTuint32 code, const char* name, const void* data, FBTsize len, FBTuint32 flag = 0);
+
+	/// Queues the contents of path, gzip'ed files are stored inflated. False if
+	/// the file is empty, unreadable or could not be allocated.
+	bool addFile(FBTuint32 code, const char* name, const char* path, FBTuint32 flag = 0);
+
+	/// Writes the queued sections, returns fbtFile::FS_OK on success.
+	int save(const char* path);
+
+	static bool isPackage(const void* memory, FBTsize len);
+
+private:
+
+	struct Pending
+	{
+		Section     m_section;
+		void*       m_data;
+	};
+
+	fbtMappedStream*    m_mapped;
+	const char*         m_data;
+	const Section*      m_toc;
+	FBTsize             m_count;
+
+	// code and name hash of the table, chained in table order
+	fbtArray<FBTsize>   m_buckets;
+	fbtArray<FBTsize>   m_next;
+
+	fbtArray<Pending>   m_pending;
+};
+
+/** @}*/
+#endif//_fbtPackage_h_
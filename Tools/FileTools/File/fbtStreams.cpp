@@ -33,6 +33,14 @@
 #include "zconf.h"
 #endif
 
+#if FBT_PLATFORM != FBT_PLATFORM_WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#endif
+
 
 fbtFileStream::fbtFileStream() 
 	:    m_file(), m_handle(0), m_mode(0), m_size(0)
@@ -279,6 +287,844 @@ FBTsize fbtGzStream::writef(const char* fmt, ...)
 
 
 
+fbtMappedStream::fbtMappedStream()
+	:   m_buffer(0), m_pos(0), m_size(0), m_mapping(0), m_base(0), m_baseSize(0)
+{
+}
+
+
+fbtMappedStream::~fbtMappedStream()
+{
+	close();
+}
+
+
+void fbtMappedStream::open(const char* path, fbtStream::StreamMode mode)
+{
+	close();
+
+	if (!(mode & fbtStream::SM_READ) || !path)
+		return;
+
+#if FBT_PLATFORM == FBT_PLATFORM_WIN32
+
+	HANDLE fh = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+	if (fh == INVALID_HANDLE_VALUE)
+		return;
+
+	DWORD high = 0, low = GetFileSize(fh, &high);
+	if (low == INVALID_FILE_SIZE || high != 0 || low == 0)
+	{
+		CloseHandle(fh);
+		return;
+	}
+
+	HANDLE mh = CreateFileMappingA(fh, 0, PAGE_WRITECOPY, 0, 0, 0);
+	CloseHandle(fh);
+	if (!mh)
+		return;
+
+	void* base = MapViewOfFile(mh, FILE_MAP_COPY, 0, 0, 0);
+	if (!base)
+	{
+		CloseHandle(mh);
+		return;
+	}
+
+	m_mapping = mh;
+	m_size    = low;
+
+#else
+
+	int fd = ::open(path, O_RDONLY);
+	if (fd < 0)
+		return;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size <= 0)
+	{
+		::close(fd);
+		return;
+	}
+
+	void* base = mmap(0, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (base == MAP_FAILED)
+		return;
+
+	m_size = (FBTsize)st.st_size;
+
+#endif
+
+	m_buffer   = (char*)base;
+	m_base     = m_buffer;
+	m_baseSize = m_size;
+	m_pos      = 0;
+}
+
+
+void fbtMappedStream::close(void)
+{
+	if (!m_buffer)
+		return;
+
+#if FBT_PLATFORM == FBT_PLATFORM_WIN32
+	UnmapViewOfFile(m_base);
+	CloseHandle((HANDLE)m_mapping);
+#else
+	munmap(m_base, m_baseSize);
+#endif
+
+	m_buffer   = 0;
+	m_base     = 0;
+	m_mapping  = 0;
+	m_pos      = 0;
+	m_size     = 0;
+	m_baseSize = 0;
+}
+
+
+bool fbtMappedStream::window(FBTsize offset, FBTsize len)
+{
+	if (!m_base || offset > m_baseSize || len > m_baseSize - offset)
+		return false;
+
+	m_buffer = m_base + offset;
+	m_size   = len;
+	m_pos    = 0;
+	return true;
+}
+
+
+FBTsize fbtMappedStream::read(void* dest, FBTsize nr) const
+{
+	if (m_pos > m_size) return 0;
+	if (!dest || !m_buffer) return 0;
+
+	if ((m_size - m_pos) < nr) nr = m_size - m_pos;
+
+	fbtMemcpy(dest, &m_buffer[m_pos], nr);
+	m_pos += nr;
+	return nr;
+}
+
+
+FBTsize fbtMappedStream::seek(FBTint32 off, FBTint32 way)
+{
+	if (way == SEEK_SET)
+		m_pos = fbtClamp<FBTsize>(off, 0, m_size);
+	else if (way == SEEK_CUR)
+		m_pos = fbtClamp<FBTsize>(m_pos + off, 0, m_size);
+	else if (way == SEEK_END)
+		m_pos = m_size;
+	return m_pos;
+}
+
+
+void* fbtMappedStream::map(FBTsize nr)
+{
+	if (!m_buffer || m_pos > m_size || (m_size - m_pos) < nr)
+		return 0;
+
+	void* p = &m_buffer[m_pos];
+	m_pos += nr;
+	return p;
+}
+
+
+
+
+#if FBT_USE_GZ_FILE == 1
+
+
+#define FBT_GZ_TAG0         'F'
+#define FBT_GZ_TAG1         'B'
+#define FBT_GZ_HEADER       20
+#define FBT_GZ_TRAILER      8
+#define FBT_GZ_MAX_MEMBER   (64 * 1024 * 1024)
+
+
+static FBTuint32 fbtGzGet32(const FBTuint8* p)
+{
+	return (FBTuint32)p[0] | ((FBTuint32)p[1] << 8) | ((FBTuint32)p[2] << 16) | ((FBTuint32)p[3] << 24);
+}
+
+static void fbtGzPut32(FBTuint8* p, FBTuint32 v)
+{
+	p[0] = (FBTuint8)v;
+	p[1] = (FBTuint8)(v >> 8);
+	p[2] = (FBTuint8)(v >> 16);
+	p[3] = (FBTuint8)(v >> 24);
+}
+
+
+// Lock and wake up signal shared by the reader and the inflate workers.
+class fbtGzSignal
+{
+public:
+#if FBT_PLATFORM == FBT_PLATFORM_WIN32
+
+	fbtGzSignal()   {InitializeCriticalSection(&m_cs); m_event = CreateEvent(0, TRUE, FALSE, 0);}
+	~fbtGzSignal()  {CloseHandle(m_event); DeleteCriticalSection(&m_cs);}
+
+	void lock(void)      {EnterCriticalSection(&m_cs);}
+	void unlock(void)    {LeaveCriticalSection(&m_cs);}
+	void broadcast(void) {SetEvent(m_event);}
+
+	// predicates are tested again by the callers, a lost wake up costs one time out
+	void wait(void)
+	{
+		ResetEvent(m_event);
+		LeaveCriticalSection(&m_cs);
+		WaitForSingleObject(m_event, 5);
+		EnterCriticalSection(&m_cs);
+	}
+
+private:
+	CRITICAL_SECTION m_cs;
+	HANDLE           m_event;
+
+#else
+
+	fbtGzSignal()   {pthread_mutex_init(&m_mutex, 0); pthread_cond_init(&m_cond, 0);}
+	~fbtGzSignal()  {pthread_cond_destroy(&m_cond); pthread_mutex_destroy(&m_mutex);}
+
+	void lock(void)      {pthread_mutex_lock(&m_mutex);}
+	void unlock(void)    {pthread_mutex_unlock(&m_mutex);}
+	void broadcast(void) {pthread_cond_broadcast(&m_cond);}
+	void wait(void)      {pthread_cond_wait(&m_cond, &m_mutex);}
+
+private:
+	pthread_mutex_t m_mutex;
+	pthread_cond_t  m_cond;
+
+#endif
+};
+
+
+#if FBT_PLATFORM == FBT_PLATFORM_WIN32
+typedef HANDLE      fbtGzThread;
+#else
+typedef pthread_t   fbtGzThread;
+#endif
+
+
+struct fbtGzPipeStream::Ring
+{
+	struct Member
+	{
+		const FBTuint8* m_data;
+		FBTsize         m_len;
+		FBTsize         m_outLen;
+	};
+
+	struct Slot
+	{
+		char*   m_data;
+		FBTsize m_len;
+		FBTsize m_capacity;
+		FBTsize m_seq;
+		bool    m_ready;
+	};
+
+	Ring(const FBTuint8* data, FBTsize len)
+		:   m_data(data), m_len(len), m_consumed(0), m_nextMember(0),
+		    m_blocks(FBT_NPOS), m_stop(false), m_failed(false)
+	{
+		fbtMemset(m_slots, 0, sizeof(m_slots));
+	}
+
+	~Ring()
+	{
+		for (int i = 0; i < RING_SIZE; ++i)
+		{
+			if (m_slots[i].m_capacity)
+				fbtFree(m_slots[i].m_data);
+		}
+	}
+
+	Slot& slot(FBTsize seq) {return m_slots[seq % RING_SIZE];}
+
+	bool reserve(Slot& sl, FBTsize len)
+	{
+		if (sl.m_capacity >= len)
+			return true;
+
+		if (sl.m_capacity)
+			fbtFree(sl.m_data);
+
+		sl.m_data     = (char*)fbtMalloc(len);
+		sl.m_capacity = sl.m_data ? len : 0;
+		return sl.m_data != 0;
+	}
+
+	// blocks until the slot of seq has been handed back by the reader
+	bool waitSlot(FBTsize seq)
+	{
+		m_signal.lock();
+		while (!m_stop && seq >= m_consumed + RING_SIZE)
+			m_signal.wait();
+		bool stop = m_stop;
+		m_signal.unlock();
+		return !stop;
+	}
+
+	void publish(Slot& sl, FBTsize seq, FBTsize len, bool ok, bool last)
+	{
+		m_signal.lock();
+		sl.m_len   = len;
+		sl.m_seq   = seq;
+		sl.m_ready = true;
+		if (!ok)
+			m_failed = true;
+		if (last)
+			m_blocks = seq + 1;
+		m_signal.broadcast();
+		m_signal.unlock();
+	}
+
+	void inflateMembers(void);
+	void inflateStream(void);
+
+	const FBTuint8*         m_data;
+	FBTsize                 m_len;
+	fbtArray<Member>        m_members;
+	Slot                    m_slots[RING_SIZE];
+	fbtArray<fbtGzThread>   m_threads;
+	fbtGzSignal             m_signal;
+
+	FBTsize                 m_consumed;     // blocks handed back by the reader
+	FBTsize                 m_nextMember;
+	FBTsize                 m_blocks;       // known once the last block is inflated
+	bool                    m_stop;
+	bool                    m_failed;
+};
+
+
+void fbtGzPipeStream::Ring::inflateMembers(void)
+{
+	z_stream zs;
+	fbtMemset(&zs, 0, sizeof(z_stream));
+	if (inflateInit2(&zs, 16 + MAX_WBITS) != Z_OK)
+	{
+		m_signal.lock();
+		m_failed = true;
+		m_signal.broadcast();
+		m_signal.unlock();
+		return;
+	}
+
+	for (;;)
+	{
+		m_signal.lock();
+		FBTsize seq = m_nextMember++;
+		bool done = m_stop || m_failed || seq >= m_members.size();
+		m_signal.unlock();
+
+		if (done || !waitSlot(seq))
+			break;
+
+		const Member& mb = m_members[seq];
+		Slot& sl = slot(seq);
+
+		bool ok = reserve(sl, mb.m_outLen ? mb.m_outLen : 1);
+		if (ok)
+		{
+			inflateReset(&zs);
+			zs.next_in   = (Bytef*)mb.m_data;
+			zs.avail_in  = (uInt)mb.m_len;
+			zs.next_out  = (Bytef*)sl.m_data;
+			zs.avail_out = (uInt)mb.m_outLen;
+
+			ok = inflate(&zs, Z_FINISH) == Z_STREAM_END && zs.avail_out == 0;
+		}
+
+		publish(sl, seq, ok ? mb.m_outLen : 0, ok, false);
+	}
+
+	inflateEnd(&zs);
+}
+
+
+void fbtGzPipeStream::Ring::inflateStream(void)
+{
+	z_stream zs;
+	fbtMemset(&zs, 0, sizeof(z_stream));
+
+	bool ok = inflateInit2(&zs, 16 + MAX_WBITS) == Z_OK;
+	zs.next_in  = (Bytef*)m_data;
+	zs.avail_in = (uInt)m_len;
+
+	for (FBTsize seq = 0; ; ++seq)
+	{
+		if (!waitSlot(seq))
+			break;
+
+		Slot& sl = slot(seq);
+		ok = ok && reserve(sl, BLOCK_SIZE);
+
+		FBTsize len = 0;
+		bool last = !ok;
+
+		if (ok)
+		{
+			zs.next_out  = (Bytef*)sl.m_data;
+			zs.avail_out = BLOCK_SIZE;
+
+			while (zs.avail_out)
+			{
+				int ret = inflate(&zs, Z_NO_FLUSH);
+				if (ret == Z_STREAM_END)
+				{
+					// concatenated members
+					if (zs.avail_in >= 2 && zs.next_in[0] == 0x1F && zs.next_in[1] == 0x8B)
+					{
+						inflateReset(&zs);
+						continue;
+					}
+
+					last = true;
+					break;
+				}
+				if (ret != Z_OK)
+				{
+					// truncated or corrupt, what came out so far is still read
+					ok = false;
+					last = true;
+					break;
+				}
+			}
+
+			len = BLOCK_SIZE - zs.avail_out;
+		}
+
+		publish(sl, seq, len, ok, last);
+		if (last)
+			break;
+	}
+
+	inflateEnd(&zs);
+}
+
+
+#if FBT_PLATFORM == FBT_PLATFORM_WIN32
+static DWORD WINAPI fbtGzMembersEntry(LPVOID arg)
+{
+	((fbtGzPipeStream::Ring*)arg)->inflateMembers();
+	return 0;
+}
+
+static DWORD WINAPI fbtGzStreamEntry(LPVOID arg)
+{
+	((fbtGzPipeStream::Ring*)arg)->inflateStream();
+	return 0;
+}
+#else
+static void* fbtGzMembersEntry(void* arg)
+{
+	((fbtGzPipeStream::Ring*)arg)->inflateMembers();
+	return 0;
+}
+
+static void* fbtGzStreamEntry(void* arg)
+{
+	((fbtGzPipeStream::Ring*)arg)->inflateStream();
+	return 0;
+}
+#endif
+
+
+static int fbtGzProcessorCount(void)
+{
+#if FBT_PLATFORM == FBT_PLATFORM_WIN32
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return (int)info.dwNumberOfProcessors;
+#else
+	long nr = sysconf(_SC_NPROCESSORS_ONLN);
+	return nr > 0 ? (int)nr : 1;
+#endif
+}
+
+
+
+fbtGzPipeStream::fbtGzPipeStream(int workers)
+	:   m_ring(0), m_workers(workers), m_block(0), m_blockLen(0), m_blockPos(0),
+	    m_seq(0), m_held(false), m_pos(0), m_size(0),
+	    m_member(0), m_memberLen(0), m_deflated(0)
+{
+}
+
+
+fbtGzPipeStream::~fbtGzPipeStream()
+{
+	close();
+}
+
+
+void fbtGzPipeStream::open(const char* path, fbtStream::StreamMode mode)
+{
+	close();
+
+	if (mode & fbtStream::SM_WRITE)
+	{
+		m_out.open(path, fbtStream::SM_WRITE);
+		if (!m_out.isOpen())
+			return;
+
+		m_member   = (char*)fbtMalloc(MEMBER_SIZE);
+		m_deflated = (char*)fbtMalloc(FBT_GZ_HEADER + compressBound(MEMBER_SIZE) + FBT_GZ_TRAILER);
+		if (!m_member || !m_deflated)
+			close();
+		return;
+	}
+
+	m_source.open(path, fbtStream::SM_READ);
+	if (!m_source.isOpen())
+		return;
+
+	const FBTuint8* data = (const FBTuint8*)m_source.ptr();
+	FBTsize len = m_source.size();
+
+	m_ring = new Ring(data, len);
+
+	if (len < 18 || data[0] != 0x1F || data[1] != 0x8B)
+	{
+		// not compressed, the mapping is the only block
+		Ring::Slot& sl = m_ring->m_slots[0];
+		sl.m_data   = (char*)data;
+		sl.m_len    = len;
+		sl.m_ready  = true;
+		m_ring->m_blocks = 1;
+		m_size = len;
+		return;
+	}
+
+
+	// Locate tagged members, any untagged one falls back to inflating in order.
+	FBTsize off = 0, total = 0;
+	while (off < len)
+	{
+		const FBTuint8* hp = data + off;
+		if (len - off < FBT_GZ_HEADER + FBT_GZ_TRAILER || hp[0] != 0x1F || hp[1] != 0x8B || hp[2] != 8 || !(hp[3] & 4))
+			break;
+
+		FBTsize xlen = hp[10] | (hp[11] << 8);
+		if (xlen != 8 || hp[12] != FBT_GZ_TAG0 || hp[13] != FBT_GZ_TAG1 || hp[14] != 4 || hp[15] != 0)
+			break;
+
+		FBTsize mlen = fbtGzGet32(hp + 16);
+		if (mlen < FBT_GZ_HEADER + FBT_GZ_TRAILER || mlen > len - off)
+			break;
+
+		Ring::Member mb;
+		mb.m_data   = hp;
+		mb.m_len    = mlen;
+		mb.m_outLen = fbtGzGet32(hp + mlen - 4);
+		if (mb.m_outLen > FBT_GZ_MAX_MEMBER)
+			break;
+
+		m_ring->m_members.push_back(mb);
+		total += mb.m_outLen;
+		off   += mlen;
+	}
+
+	int threads = 1;
+	if (off == len)
+	{
+		m_ring->m_blocks = m_ring->m_members.size();
+		m_size = total;
+
+		threads = m_workers > 0 ? m_workers : fbtGzProcessorCount();
+		threads = fbtMin<int>(threads, fbtMin<int>(RING_SIZE, (int)m_ring->m_members.size()));
+		threads = fbtMax<int>(threads, 1);
+	}
+	else
+	{
+		m_ring->m_members.clear();
+
+		// exact for single member files
+		m_size = fbtGzGet32(data + len - 4);
+	}
+
+	for (int i = 0; i < threads; ++i)
+	{
+		bool members = !m_ring->m_members.empty();
+		fbtGzThread th;
+
+#if FBT_PLATFORM == FBT_PLATFORM_WIN32
+		th = CreateThread(0, 0, members ? fbtGzMembersEntry : fbtGzStreamEntry, m_ring, 0, 0);
+		if (!th)
+			break;
+#else
+		if (pthread_create(&th, 0, members ? fbtGzMembersEntry : fbtGzStreamEntry, m_ring) != 0)
+			break;
+#endif
+		m_ring->m_threads.push_back(th);
+	}
+
+	if (m_ring->m_threads.empty())
+		close();
+}
+
+
+void fbtGzPipeStream::close(void)
+{
+	if (m_out.isOpen())
+	{
+		if (m_memberLen)
+			writeMember();
+		m_out.close();
+	}
+
+	if (m_member)
+		fbtFree(m_member);
+	if (m_deflated)
+		fbtFree(m_deflated);
+	m_member    = 0;
+	m_deflated  = 0;
+	m_memberLen = 0;
+
+
+	if (m_ring)
+	{
+		m_ring->m_signal.lock();
+		m_ring->m_stop = true;
+		m_ring->m_signal.broadcast();
+		m_ring->m_signal.unlock();
+
+		for (FBTsize i = 0; i < m_ring->m_threads.size(); ++i)
+		{
+#if FBT_PLATFORM == FBT_PLATFORM_WIN32
+			WaitForSingleObject(m_ring->m_threads[i], INFINITE);
+			CloseHandle(m_ring->m_threads[i]);
+#else
+			pthread_join(m_ring->m_threads[i], 0);
+#endif
+		}
+
+		delete m_ring;
+		m_ring = 0;
+	}
+
+	m_source.close();
+
+	m_block    = 0;
+	m_blockLen = 0;
+	m_blockPos = 0;
+	m_seq      = 0;
+	m_held     = false;
+	m_pos      = 0;
+	m_size     = 0;
+}
+
+
+bool fbtGzPipeStream::nextBlock(void) const
+{
+	if (!m_ring)
+		return false;
+
+	Ring* ring = m_ring;
+	ring->m_signal.lock();
+
+	if (m_held)
+	{
+		ring->slot(m_seq).m_ready = false;
+		ring->m_consumed = ++m_seq;
+		m_held = false;
+		ring->m_signal.broadcast();
+	}
+
+	for (;;)
+	{
+		Ring::Slot& sl = ring->slot(m_seq);
+		if (sl.m_ready && sl.m_seq == m_seq)
+		{
+			m_block    = sl.m_data;
+			m_blockLen = sl.m_len;
+			m_blockPos = 0;
+			m_held     = true;
+			break;
+		}
+
+		if (ring->m_failed || m_seq >= ring->m_blocks)
+		{
+			m_block    = 0;
+			m_blockLen = 0;
+			m_blockPos = 0;
+			break;
+		}
+
+		ring->m_signal.wait();
+	}
+
+	ring->m_signal.unlock();
+	return m_held;
+}
+
+
+bool fbtGzPipeStream::eof(void) const
+{
+	if (!m_ring)
+		return true;
+
+	while (m_blockPos >= m_blockLen)
+	{
+		if (!nextBlock())
+			return true;
+	}
+	return false;
+}
+
+
+FBTsize fbtGzPipeStream::read(void* dest, FBTsize nr) const
+{
+	if (!dest || !m_ring)
+		return -1;
+
+	FBTsize done = 0;
+	while (done < nr)
+	{
+		if (m_blockPos >= m_blockLen)
+		{
+			if (!nextBlock())
+				break;
+			continue;
+		}
+
+		FBTsize cp = fbtMin<FBTsize>(nr - done, m_blockLen - m_blockPos);
+		fbtMemcpy((char*)dest + done, m_block + m_blockPos, cp);
+
+		m_blockPos += cp;
+		m_pos      += cp;
+		done       += cp;
+	}
+	return done;
+}
+
+
+FBTsize fbtGzPipeStream::seek(FBTint32 off, FBTint32 way)
+{
+	if (!m_ring)
+		return 0;
+
+	FBTint64 rel = off;
+	if (way == SEEK_SET)
+		rel = (FBTint64)off - (FBTint64)m_pos;
+	else if (way != SEEK_CUR)
+		return m_pos;
+
+	if (rel < 0)
+	{
+		// only inside the current block
+		FBTsize back = fbtMin<FBTsize>((FBTsize)-rel, m_blockPos);
+		m_blockPos -= back;
+		m_pos      -= back;
+		return m_pos;
+	}
+
+	while (rel > 0)
+	{
+		if (m_blockPos >= m_blockLen && !nextBlock())
+			break;
+
+		FBTsize skip = fbtMin<FBTsize>((FBTsize)rel, m_blockLen - m_blockPos);
+		m_blockPos += skip;
+		m_pos      += skip;
+		rel        -= skip;
+	}
+	return m_pos;
+}
+
+
+FBTsize fbtGzPipeStream::getMemberCount(void) const
+{
+	return m_ring ? m_ring->m_members.size() : 0;
+}
+
+
+bool fbtGzPipeStream::writeMember(void)
+{
+	z_stream zs;
+	fbtMemset(&zs, 0, sizeof(z_stream));
+
+	if (deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+		return false;
+
+	FBTuint8* out = (FBTuint8*)m_deflated;
+
+	zs.next_in   = (Bytef*)m_member;
+	zs.avail_in  = (uInt)m_memberLen;
+	zs.next_out  = out + FBT_GZ_HEADER;
+	zs.avail_out = (uInt)compressBound(MEMBER_SIZE);
+
+	int ret = deflate(&zs, Z_FINISH);
+	FBTsize clen = zs.total_out;
+	deflateEnd(&zs);
+
+	if (ret != Z_STREAM_END)
+		return false;
+
+	FBTsize mlen = FBT_GZ_HEADER + clen + FBT_GZ_TRAILER;
+
+	// gzip header with the member size as extra field
+	fbtMemset(out, 0, FBT_GZ_HEADER);
+	out[0]  = 0x1F;
+	out[1]  = 0x8B;
+	out[2]  = 8;        // deflate
+	out[3]  = 4;        // FEXTRA
+	out[9]  = 255;      // unknown OS
+	out[10] = 8;        // extra length
+	out[12] = FBT_GZ_TAG0;
+	out[13] = FBT_GZ_TAG1;
+	out[14] = 4;
+	fbtGzPut32(out + 16, (FBTuint32)mlen);
+
+	fbtGzPut32(out + FBT_GZ_HEADER + clen, (FBTuint32)crc32(0, (const Bytef*)m_member, (uInt)m_memberLen));
+	fbtGzPut32(out + FBT_GZ_HEADER + clen + 4, (FBTuint32)m_memberLen);
+
+	m_memberLen = 0;
+	return m_out.write(out, mlen) == mlen;
+}
+
+
+FBTsize fbtGzPipeStream::write(const void* src, FBTsize nr)
+{
+	if (!src || !m_member)
+		return -1;
+
+	FBTsize done = 0;
+	while (done < nr)
+	{
+		FBTsize cp = fbtMin<FBTsize>(nr - done, MEMBER_SIZE - m_memberLen);
+		fbtMemcpy(m_member + m_memberLen, (const char*)src + done, cp);
+
+		m_memberLen += cp;
+		done        += cp;
+
+		if (m_memberLen == MEMBER_SIZE && !writeMember())
+			return -1;
+	}
+	return done;
+}
+
+
+FBTsize fbtGzPipeStream::writef(const char* fmt, ...)
+{
+	char tmp[1024];
+
+	va_list lst;
+	va_start(lst, fmt);
+	int size = fbtp_printf(tmp, 1024, fmt, lst);
+	va_end(lst);
+
+	if (size > 0)
+		return write(tmp, size);
+	return -1;
+}
+
+#endif
+
 
 fbtMemoryStream::fbtMemoryStream()
 	:   m_buffer(0), m_pos(0), m_size(0), m_capacity(0), m_mode(0)
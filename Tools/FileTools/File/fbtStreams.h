@@ -62,8 +62,12 @@ public:
 
 	virtual FBTsize seek(FBTint32 off, FBTint32 way) {return 0;}
 
+	/// Returns the next nr bytes in place and skips them, or 0 when the
+	/// stream has to copy. The memory stays valid while the stream is open.
+	virtual void* map(FBTsize /*nr*/) {return 0;}
+
 protected:
-	virtual void reserve(FBTsize nr) {}
+	virtual void reserve(FBTsize /*nr*/) {}
 };
 
 
@@ -143,6 +147,116 @@ protected:
 #endif
 
 
+
+/// Read only view of a whole file mapped into memory.
+/// Pages are copy on write, writing through map() never reaches the file.
+class fbtMappedStream : public fbtStream
+{
+public:
+	fbtMappedStream();
+	~fbtMappedStream();
+
+	void open(const char* path, fbtStream::StreamMode mode);
+	void close(void);
+
+	bool     isOpen(void)    const   {return m_buffer != 0;}
+	bool     eof(void)       const   {return !m_buffer || m_pos >= m_size;}
+	FBTsize  position(void)  const   {return m_pos;}
+	FBTsize  size(void)      const   {return m_size;}
+
+	FBTsize  read(void* dest, FBTsize nr) const;
+	FBTsize  write(const void* /*src*/, FBTsize /*nr*/) {return -1;}
+
+	FBTsize seek(FBTint32 off, FBTint32 way);
+
+	void* map(FBTsize nr);
+
+	const void* ptr(void) const {return m_buffer;}
+
+	/// Narrows the stream to len bytes at offset of the mapping,
+	/// for files embedded in a fbtPackage.
+	bool window(FBTsize offset, FBTsize len);
+
+protected:
+
+	char*            m_buffer;
+	mutable FBTsize  m_pos;
+	FBTsize          m_size;
+	fbtFileHandle    m_mapping;
+	char*            m_base;     // whole mapping
+	FBTsize          m_baseSize;
+};
+
+
+#if FBT_USE_GZ_FILE == 1
+
+/// gzip stream inflated ahead of the reader.
+///
+/// Worker threads inflate into a ring of buffers while the caller scans the
+/// ones already filled. Files written by this stream are cut into gzip members
+/// tagged with their compressed size, such members are located up front and
+/// inflated in parallel. Other gzip files are inflated in order by one worker,
+/// uncompressed files are read as they are.
+/// Seeking back is limited to the buffer being read.
+class fbtGzPipeStream : public fbtStream
+{
+public:
+	enum
+	{
+		RING_SIZE   = 8,
+		BLOCK_SIZE  = 256 * 1024,   // inflated bytes per buffer of untagged files
+		MEMBER_SIZE = 1024 * 1024,  // uncompressed bytes per written member
+	};
+
+	struct Ring;
+
+public:
+	/// workers = 0 uses one thread per processor for tagged files.
+	fbtGzPipeStream(int workers = 0);
+	~fbtGzPipeStream();
+
+	void open(const char* path, fbtStream::StreamMode mode);
+	void close(void);
+
+	bool isOpen(void)   const {return m_ring != 0 || m_out.isOpen();}
+	bool eof(void)      const;
+
+	FBTsize  read(void* dest, FBTsize nr) const;
+	FBTsize  write(const void* src, FBTsize nr);
+	FBTsize  writef(const char* buf, ...);
+
+	FBTsize  position(void) const {return m_pos;}
+	FBTsize  size(void)     const {return m_size;}
+	FBTsize  seek(FBTint32 off, FBTint32 way);
+
+	/// Members inflated in parallel, 0 when the file is read in order.
+	FBTsize getMemberCount(void) const;
+
+protected:
+
+	bool nextBlock(void) const;
+	bool writeMember(void);
+
+	fbtMappedStream     m_source;
+	Ring*               m_ring;
+	int                 m_workers;
+
+	mutable const char* m_block;
+	mutable FBTsize     m_blockLen, m_blockPos;
+	mutable FBTsize     m_seq;
+	mutable bool        m_held;
+	mutable FBTsize     m_pos;
+	FBTsize             m_size;
+
+	fbtFileStream       m_out;
+	char*               m_member;
+	FBTsize             m_memberLen;
+	char*               m_deflated;
+};
+
+#endif
+
+
 class fbtMemoryStream : public fbtStream
 {
 public:
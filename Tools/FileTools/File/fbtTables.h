@@ -107,7 +107,8 @@ public:
 		MISSING     = (1 << 0),
 		MISALIGNED  = (1 << 1),
 		SKIP        = (1 << 2),
-		NEED_CAST	= (1 << 3)
+		NEED_CAST	= (1 << 3),
+		SAME_LAYOUT = (1 << 4), // memory struct is byte identical to the file struct
 	};
 
 
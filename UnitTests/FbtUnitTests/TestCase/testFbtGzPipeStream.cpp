@@ -0,0 +1,211 @@
+#include "StdAfx.h"
+
+#include <stdio.h>
+#include <algorithm>
+#include <vector>
+#include "fbtFile.h"
+#include "fbtStreams.h"
+#include "customFile.h"
+#include "Custom.h"
+
+#define TEST_CASE_NAME testFbtGzPipeStream
+
+#if FBT_USE_GZ_FILE == 1
+
+// testFbtCustomFile.cpp
+void cstmFillGlobal(Custom::cstmGlobal& global);
+bool cstmGlobEq(Custom::cstmGlobal& a, Custom::cstmGlobal& b);
+
+
+static void gzPipeFill(std::vector<char>& data, size_t len)
+{
+	data.resize(len);
+	for (size_t i = 0; i < len; ++i)
+		data[i] = (char)(i * 31 + (i >> 9));
+}
+
+static bool gzPipeWrite(fbtStream& stream, const char* path, const std::vector<char>& data)
+{
+	stream.open(path, fbtStream::SM_WRITE);
+	if (!stream.isOpen())
+		return false;
+
+	return data.empty() || stream.write(&data[0], data.size()) == (FBTsize)data.size();
+}
+
+static void gzPipeReadAll(const char* path, std::vector<char>& data, FBTsize& members)
+{
+	fbtGzPipeStream stream(2);
+	stream.open(path, fbtStream::SM_READ);
+
+	data.clear();
+	members = stream.getMemberCount();
+
+	char buf[4096];
+	FBTsize nr;
+	while (stream.isOpen() && (nr = stream.read(buf, sizeof(buf))) > 0 && nr != (FBTsize)-1)
+		data.insert(data.end(), buf, buf + nr);
+}
+
+// keeps the first len bytes of path
+static bool gzPipeTruncate(const char* path, long len)
+{
+	std::vector<char> buf(len);
+
+	FILE* fp = fopen(path, "rb");
+	if (!fp)
+		return false;
+	bool ok = fread(&buf[0], 1, len, fp) == (size_t)len;
+	fclose(fp);
+
+	fp = fopen(path, "wb");
+	if (!ok || !fp)
+		return false;
+	ok = fwrite(&buf[0], 1, len, fp) == (size_t)len;
+	fclose(fp);
+	return ok;
+}
+
+static long gzPipeFileSize(const char* path)
+{
+	FILE* fp = fopen(path, "rb");
+	if (!fp)
+		return 0;
+	fseek(fp, 0, SEEK_END);
+	long len = ftell(fp);
+	fclose(fp);
+	return len;
+}
+
+
+TEST(TEST_CASE_NAME, reflectCompressed)
+{
+	const char* path = "TestTemp/gzPipeReflect.cstm";
+
+	cstmFile file1, file2;
+	cstmFillGlobal(*file1.m_global);
+
+	ASSERT_EQ(file1.reflect(path, fbtFile::PM_COMPRESSED), fbtFile::FS_OK);
+	ASSERT_EQ(file2.parse(path, fbtFile::PM_COMPRESSED), fbtFile::FS_OK);
+
+	EXPECT_TRUE(cstmGlobEq(*file1.m_global, *file2.m_global));
+}
+
+
+TEST(TEST_CASE_NAME, taggedMembers)
+{
+	const char* path = "TestTemp/gzPipeTagged.gz";
+
+	std::vector<char> in, out;
+	gzPipeFill(in, fbtGzPipeStream::MEMBER_SIZE * 2 + 12345);
+
+	fbtGzPipeStream writer;
+	ASSERT_TRUE(gzPipeWrite(writer, path, in));
+	writer.close();
+
+	FBTsize members;
+	gzPipeReadAll(path, out, members);
+
+	EXPECT_EQ(members, 3);
+	EXPECT_TRUE(in == out);
+}
+
+
+TEST(TEST_CASE_NAME, untaggedGzip)
+{
+	const char* path = "TestTemp/gzPipeUntagged.gz";
+
+	std::vector<char> in, out;
+	gzPipeFill(in, fbtGzPipeStream::BLOCK_SIZE * 3 + 777);
+
+	fbtGzStream writer;
+	ASSERT_TRUE(gzPipeWrite(writer, path, in));
+	writer.close();
+
+	FBTsize members;
+	gzPipeReadAll(path, out, members);
+
+	// inflated in order by one worker
+	EXPECT_EQ(members, 0);
+	EXPECT_TRUE(in == out);
+}
+
+
+TEST(TEST_CASE_NAME, truncatedFile)
+{
+	const char* path = "TestTemp/gzPipeTruncated.gz";
+
+	std::vector<char> in, out;
+	gzPipeFill(in, fbtGzPipeStream::MEMBER_SIZE * 2 + 12345);
+
+	fbtGzPipeStream writer;
+	ASSERT_TRUE(gzPipeWrite(writer, path, in));
+	writer.close();
+	ASSERT_TRUE(gzPipeTruncate(path, gzPipeFileSize(path) - 100));
+
+	FBTsize members;
+	gzPipeReadAll(path, out, members);
+
+	// the complete members are still read, in order
+	EXPECT_EQ(members, 0);
+	EXPECT_GE(out.size(), (size_t)fbtGzPipeStream::MEMBER_SIZE * 2);
+	EXPECT_LT(out.size(), in.size());
+	EXPECT_TRUE(std::equal(out.begin(), out.end(), in.begin()));
+}
+
+
+TEST(TEST_CASE_NAME, truncatedReflect)
+{
+	const char* path = "TestTemp/gzPipeTruncated.cstm";
+
+	cstmFile file1, file2;
+	cstmFillGlobal(*file1.m_global);
+
+	ASSERT_EQ(file1.reflect(path, fbtFile::PM_COMPRESSED), fbtFile::FS_OK);
+	ASSERT_TRUE(gzPipeTruncate(path, gzPipeFileSize(path) / 2));
+
+	EXPECT_NE(file2.parse(path, fbtFile::PM_COMPRESSED), fbtFile::FS_OK);
+}
+
+
+TEST(TEST_CASE_NAME, shorterThanMember)
+{
+	const char* path = "TestTemp/gzPipeShort.gz";
+
+	std::vector<char> in, out;
+	gzPipeFill(in, 1000);
+
+	fbtGzPipeStream writer;
+	ASSERT_TRUE(gzPipeWrite(writer, path, in));
+	writer.close();
+
+	FBTsize members;
+	gzPipeReadAll(path, out, members);
+
+	EXPECT_EQ(members, 1);
+	EXPECT_TRUE(in == out);
+}
+
+
+TEST(TEST_CASE_NAME, shorterThanHeader)
+{
+	const char* path = "TestTemp/gzPipeRaw.bin";
+
+	// too short for a gzip header, read as it is
+	std::vector<char> in, out;
+	gzPipeFill(in, 10);
+	in[0] = 0x1F;
+	in[1] = (char)0x8B;
+
+	fbtFileStream writer;
+	ASSERT_TRUE(gzPipeWrite(writer, path, in));
+	writer.close();
+
+	FBTsize members;
+	gzPipeReadAll(path, out, members);
+
+	EXPECT_EQ(members, 0);
+	EXPECT_TRUE(in == out);
+}
+
+#endif
@@ -0,0 +1,174 @@
+#include "StdAfx.h"
+
+#include <stdio.h>
+#include <vector>
+#include "fbtFile.h"
+#include "fbtLinkPlan.h"
+#include "customFile.h"
+#include "Custom.h"
+
+#define TEST_CASE_NAME testFbtLinkPlan
+
+// testFbtCustomFile.cpp
+void cstmFillGlobal(Custom::cstmGlobal& global);
+bool cstmGlobEq(Custom::cstmGlobal& a, Custom::cstmGlobal& b);
+
+
+// counts where the plans come from
+class planTestCache : public fbtLinkPlanCache
+{
+public:
+	planTestCache() : fbtLinkPlanCache("TestTemp"), m_found(0), m_inserted(0) {}
+
+	fbtLinkPlan* find(const fbtLinkPlan::Key& key)
+	{
+		m_key = key;
+
+		fbtLinkPlan* plan = fbtLinkPlanCache::find(key);
+		if (plan)
+			++m_found;
+		return plan;
+	}
+
+	fbtLinkPlan* insert(fbtLinkPlan* plan)
+	{
+		++m_inserted;
+		return fbtLinkPlanCache::insert(plan);
+	}
+
+	void getLastPath(char* path, FBTsize len) const {getPath(m_key, path, len);}
+
+	fbtLinkPlan::Key m_key;
+	int m_found, m_inserted;
+};
+
+
+static const char* linkPlanFile = "TestTemp/linkPlan.cstm";
+
+
+static bool linkPlanParse(planTestCache& cache)
+{
+	cstmFile ref, file;
+	cstmFillGlobal(*ref.m_global);
+
+	file.setLinkPlanCache(&cache);
+	return file.parse(linkPlanFile) == fbtFile::FS_OK && cstmGlobEq(*ref.m_global, *file.m_global);
+}
+
+// writes the test file and a fresh plan for it, returns the plan path
+static bool linkPlanSetup(char* path, FBTsize len)
+{
+	cstmFile file;
+	cstmFillGlobal(*file.m_global);
+	if (file.reflect(linkPlanFile) != fbtFile::FS_OK)
+		return false;
+
+	planTestCache cache;
+	if (!linkPlanParse(cache))
+		return false;
+
+	cache.getLastPath(path, len);
+	remove(path);
+
+	planTestCache compile;
+	return linkPlanParse(compile) && compile.m_inserted == 1;
+}
+
+static bool linkPlanRewrite(const char* path, long len, long flip)
+{
+	std::vector<char> buf(len);
+
+	FILE* fp = fopen(path, "rb");
+	if (!fp)
+		return false;
+	bool ok = fread(&buf[0], 1, len, fp) == (size_t)len;
+	fclose(fp);
+
+	if (flip >= 0)
+		buf[flip] ^= 0xFF;
+
+	fp = fopen(path, "wb");
+	if (!ok || !fp)
+		return false;
+	ok = fwrite(&buf[0], 1, len, fp) == (size_t)len;
+	fclose(fp);
+	return ok;
+}
+
+static long linkPlanFileSize(const char* path)
+{
+	FILE* fp = fopen(path, "rb");
+	if (!fp)
+		return 0;
+	fseek(fp, 0, SEEK_END);
+	long len = ftell(fp);
+	fclose(fp);
+	return len;
+}
+
+
+TEST(TEST_CASE_NAME, roundTrip)
+{
+	char path[512];
+	ASSERT_TRUE(linkPlanSetup(path, sizeof(path)));
+	ASSERT_GT(linkPlanFileSize(path), 0);
+
+	// a new cache reads the saved plan instead of compiling one
+	planTestCache cache;
+	EXPECT_TRUE(linkPlanParse(cache));
+	EXPECT_EQ(cache.m_found, 1);
+	EXPECT_EQ(cache.m_inserted, 0);
+}
+
+
+TEST(TEST_CASE_NAME, staleIgnored)
+{
+	char path[512];
+	ASSERT_TRUE(linkPlanSetup(path, sizeof(path)));
+
+	// version
+	ASSERT_TRUE(linkPlanRewrite(path, linkPlanFileSize(path), 4));
+
+	planTestCache stale;
+	EXPECT_TRUE(linkPlanParse(stale));
+	EXPECT_EQ(stale.m_found, 0);
+	EXPECT_EQ(stale.m_inserted, 1);
+
+	// replaced by the compiled plan
+	planTestCache cache;
+	EXPECT_TRUE(linkPlanParse(cache));
+	EXPECT_EQ(cache.m_found, 1);
+}
+
+
+TEST(TEST_CASE_NAME, truncatedIgnored)
+{
+	char path[512];
+	ASSERT_TRUE(linkPlanSetup(path, sizeof(path)));
+	ASSERT_TRUE(linkPlanRewrite(path, linkPlanFileSize(path) / 2, -1));
+
+	planTestCache truncated;
+	EXPECT_TRUE(linkPlanParse(truncated));
+	EXPECT_EQ(truncated.m_found, 0);
+	EXPECT_EQ(truncated.m_inserted, 1);
+
+	planTestCache cache;
+	EXPECT_TRUE(linkPlanParse(cache));
+	EXPECT_EQ(cache.m_found, 1);
+}
+
+
+TEST(TEST_CASE_NAME, opOutOfRangeIgnored)
+{
+	char path[512];
+	ASSERT_TRUE(linkPlanSetup(path, sizeof(path)));
+
+	// high byte of the last op's destination offset
+	long len = linkPlanFileSize(path);
+	ASSERT_TRUE(linkPlanRewrite(path, len, len - (long)sizeof(fbtLinkPlan::Op) + 7));
+
+	planTestCache damaged;
+	EXPECT_TRUE(linkPlanParse(damaged));
+	EXPECT_EQ(damaged.m_found, 0);
+	EXPECT_EQ(damaged.m_inserted, 1);
+}
@@ -0,0 +1,99 @@
+#include "StdAfx.h"
+
+#include "fbtFile.h"
+#include "fbtStreams.h"
+#include "fbtTables.h"
+#include "customFile.h"
+#include "Custom.h"
+
+#define TEST_CASE_NAME testFbtRemap
+
+#define REMAP_COUNT 4
+
+
+// Writes the list as one block of REMAP_COUNT elements, so every link
+// but the first points into the middle of it.
+class remapTestFile : public cstmFile
+{
+public:
+	Custom::cstmStruct m_array[REMAP_COUNT];
+
+	remapTestFile()
+	{
+		fbtMemset(m_array, 0, sizeof(m_array));
+
+		for (int i = 0; i < REMAP_COUNT; ++i)
+		{
+			m_array[i].intValue = 100 + i;
+			m_global->main.structList.push_back(&m_array[i]);
+		}
+		m_global->main.structPtr = &m_array[2];
+	}
+
+	~remapTestFile()
+	{
+		m_global->main.structList.m_first = 0;
+		m_global->main.structList.m_last  = 0;
+	}
+
+protected:
+
+	void writeBlock(fbtStream* stream, const char* type, FBTuint32 code, FBTuint32 nr, FBTsize len, void* data)
+	{
+		Chunk ch;
+		ch.m_code   = code;
+		ch.m_len    = len * nr;
+		ch.m_nr     = nr;
+		ch.m_old    = (FBTsize)data;
+		ch.m_typeid = m_memory->findTypeId(type);
+
+		stream->write(&ch, sizeof(Chunk));
+		stream->write(data, ch.m_len);
+	}
+
+	int writeData(fbtStream* stream)
+	{
+		writeBlock(stream, "cstmGlobal", FBT_ID('G', 'L', 'O', 'B'), 1, sizeof(Custom::cstmGlobal), m_global);
+		writeBlock(stream, "cstmStruct", FBT_ID2('S', 'T'), REMAP_COUNT, sizeof(Custom::cstmStruct), m_array);
+		return FS_OK;
+	}
+};
+
+
+static void remapTest(int mode)
+{
+	const char* path = "TestTemp/remap.cstm";
+
+	remapTestFile out;
+	ASSERT_EQ(out.reflect(path), fbtFile::FS_OK);
+
+	cstmFile file;
+	ASSERT_EQ(file.parse(path, mode), fbtFile::FS_OK);
+
+	Custom::cstmMain& main = file.m_global->main;
+	Custom::cstmStruct* first = main.structList.m_first;
+	ASSERT_TRUE(first != 0);
+
+	// interior pointers land on the converted elements of the same block
+	EXPECT_EQ(main.structPtr, first + 2);
+	EXPECT_EQ(main.structList.m_last, first + REMAP_COUNT - 1);
+
+	for (int i = 0; i < REMAP_COUNT; ++i)
+	{
+		EXPECT_EQ(first[i].intValue, 100 + i);
+		EXPECT_EQ(first[i].m_next, i + 1 < REMAP_COUNT ? first + i + 1 : 0);
+		EXPECT_EQ(first[i].m_prev, i > 0 ? first + i - 1 : 0);
+	}
+}
+
+
+TEST(TEST_CASE_NAME, interiorPointers)
+{
+	remapTest(fbtFile::PM_UNCOMPRESSED);
+}
+
+
+TEST(TEST_CASE_NAME, interiorPointersMapped)
+{
+	remapTest(fbtFile::PM_MAPPED);
+}
@@ -0,0 +1,238 @@
+#include "StdAfx.h"
+
+#define TEST_CASE_NAME testBlendPackage
+
+#define PACKAGE_SOURCE  "TestData/Test0.blend"
+#define PACKAGE_COOKED  "Test0.gkpkg"
+
+
+// Cooked scenes are read by gkPackageSceneConverter, not by the .blend converters.
+// Whatever the converters set has to come back the same from the package.
+class TEST_CASE_NAME : public ::testing::Test
+{
+protected:
+	static void SetUpTestCase()
+	{
+		gkUserDefs defs;
+		defs.winsize = gkVector2(64, 64);
+		defs.wintitle = "testBlendPackage";
+		defs.verbose = false;
+		defs.disableSound = true;
+
+		m_engine = new gkEngine(&defs);
+		m_engine->initialize();
+	}
+
+	static void TearDownTestCase()
+	{
+		delete m_engine;
+		m_engine = 0;
+		remove(PACKAGE_COOKED);
+	}
+
+	static gkEngine* m_engine;
+};
+
+gkEngine* TEST_CASE_NAME::m_engine = 0;
+
+
+static void packageTestVariables(gkGameObject* a, gkGameObject* b)
+{
+	const gkGameObject::VariableMap& va = a->getVariables();
+	const gkGameObject::VariableMap& vb = b->getVariables();
+	ASSERT_EQ(va.size(), vb.size());
+
+	for (UTsize i = 0; i < va.size(); ++i)
+	{
+		gkVariable* var = va.at(i);
+		UTsize pos = vb.find(var->getName());
+		ASSERT_NE(pos, UT_NPOS) << var->getName();
+
+		EXPECT_EQ(var->getType(), vb.at(pos)->getType()) << var->getName();
+		EXPECT_EQ(var->getValueString(), vb.at(pos)->getValueString()) << var->getName();
+	}
+}
+
+
+static void packageTestPhysics(gkGameObject* a, gkGameObject* b)
+{
+	gkPhysicsProperties& pa = a->getProperties().m_physics;
+	gkPhysicsProperties& pb = b->getProperties().m_physics;
+
+	EXPECT_EQ(pa.m_type, pb.m_type);
+	EXPECT_EQ(pa.m_mode, pb.m_mode);
+	EXPECT_EQ(pa.m_shape, pb.m_shape);
+	EXPECT_EQ(pa.m_margin, pb.m_margin);
+	EXPECT_EQ(pa.m_mass, pb.m_mass);
+	EXPECT_EQ(pa.m_radius, pb.m_radius);
+	EXPECT_EQ(pa.m_linearDamp, pb.m_linearDamp);
+	EXPECT_EQ(pa.m_angularDamp, pb.m_angularDamp);
+	EXPECT_EQ(pa.m_restitution, pb.m_restitution);
+	EXPECT_EQ(pa.m_friction, pb.m_friction);
+	EXPECT_EQ(pa.m_colMask, pb.m_colMask);
+	EXPECT_EQ(pa.m_colGroupMask, pb.m_colGroupMask);
+
+	ASSERT_EQ(pa.m_constraints.size(), pb.m_constraints.size());
+	for (UTsize i = 0; i < pa.m_constraints.size(); ++i)
+	{
+		EXPECT_EQ(pa.m_constraints[i].m_type, pb.m_constraints[i].m_type);
+		EXPECT_EQ(pa.m_constraints[i].m_target, pb.m_constraints[i].m_target);
+	}
+}
+
+
+static void packageTestConstraints(gkScene* sa, gkGameObject* a, gkScene* sb, gkGameObject* b)
+{
+	gkConstraintManager* ma = sa->getConstraintManager();
+	gkConstraintManager* mb = sb->getConstraintManager();
+
+	ASSERT_EQ(ma->hasConstraints(a), mb->hasConstraints(b));
+	if (!ma->hasConstraints(a))
+		return;
+
+	gkConstraintManager::Constraints& ca = ma->getConstraints(a);
+	gkConstraintManager::Constraints& cb = mb->getConstraints(b);
+	ASSERT_EQ(ca.size(), cb.size());
+
+	for (UTsize i = 0; i < ca.size(); ++i)
+	{
+		EXPECT_EQ(ca[i]->getSpace(), cb[i]->getSpace());
+		EXPECT_EQ(ca[i]->getInfluence(), cb[i]->getInfluence());
+	}
+}
+
+
+static void packageTestBricks(gkLogicLink::BrickList& la, gkLogicLink::BrickList& lb)
+{
+	ASSERT_EQ(la.size(), lb.size());
+
+	gkLogicLink::BrickList::Iterator ia = la.iterator(), ib = lb.iterator();
+	while (ia.hasMoreElements() && ib.hasMoreElements())
+	{
+		gkLogicBrick* ba = ia.getNext();
+		gkLogicBrick* bb = ib.getNext();
+		EXPECT_EQ(ba->getName(), bb->getName());
+	}
+}
+
+
+static void packageTestLogic(gkGameObject* a, gkGameObject* b)
+{
+	gkLogicLink* la = a->getLogicBricks();
+	gkLogicLink* lb = b->getLogicBricks();
+
+	ASSERT_EQ(la != 0, lb != 0);
+	if (!la)
+		return;
+
+	EXPECT_EQ(la->getState(), lb->getState());
+	packageTestBricks(la->getSensors(), lb->getSensors());
+	packageTestBricks(la->getControllers(), lb->getControllers());
+	packageTestBricks(la->getActuators(), lb->getActuators());
+}
+
+
+static void packageTestObject(gkScene* sa, gkGameObject* a, gkScene* sb, gkGameObject* b)
+{
+	EXPECT_EQ(a->getType(), b->getType());
+	EXPECT_EQ(a->getLayer(), b->getLayer());
+	EXPECT_EQ(a->isInActiveLayer(), b->isInActiveLayer());
+
+	gkGameObjectProperties& pa = a->getProperties();
+	gkGameObjectProperties& pb = b->getProperties();
+
+	EXPECT_FALSE(pa.m_transform != pb.m_transform);
+	EXPECT_EQ(pa.m_mode, pb.m_mode);
+	EXPECT_EQ(pa.m_state, pb.m_state);
+	EXPECT_EQ(pa.m_parent, pb.m_parent);
+	EXPECT_EQ(pa.m_boneParent, pb.m_boneParent);
+
+	switch (a->getType())
+	{
+	case GK_CAMERA:
+		{
+			gkCameraProperties& ca = static_cast<gkCamera*>(a)->getCameraProperties();
+			gkCameraProperties& cb = static_cast<gkCamera*>(b)->getCameraProperties();
+			EXPECT_EQ(ca.m_clipstart, cb.m_clipstart);
+			EXPECT_EQ(ca.m_clipend, cb.m_clipend);
+			EXPECT_EQ(ca.m_fov, cb.m_fov);
+			EXPECT_EQ(ca.m_start, cb.m_start);
+		} break;
+	case GK_LIGHT:
+		{
+			gkLightProperties& la = static_cast<gkLight*>(a)->getLightProperties();
+			gkLightProperties& lb = static_cast<gkLight*>(b)->getLightProperties();
+			EXPECT_EQ(la.m_type, lb.m_type);
+			EXPECT_EQ(la.m_power, lb.m_power);
+			EXPECT_EQ(la.m_range, lb.m_range);
+			EXPECT_EQ(la.m_casts, lb.m_casts);
+		} break;
+	case GK_ENTITY:
+		{
+			gkEntityProperties& ea = static_cast<gkEntity*>(a)->getEntityProperties();
+			gkEntityProperties& eb = static_cast<gkEntity*>(b)->getEntityProperties();
+			ASSERT_TRUE(ea.m_mesh && eb.m_mesh);
+			EXPECT_EQ(ea.m_mesh->getResourceName().getName(), eb.m_mesh->getResourceName().getName());
+			EXPECT_EQ(ea.m_mesh->m_submeshes.size(), eb.m_mesh->m_submeshes.size());
+			EXPECT_EQ(ea.m_casts, eb.m_casts);
+			EXPECT_EQ(ea.m_startPose, eb.m_startPose);
+		} break;
+	default:
+		break;
+	}
+
+	packageTestVariables(a, b);
+	packageTestPhysics(a, b);
+	packageTestConstraints(sa, a, sb, b);
+	packageTestLogic(a, b);
+}
+
+
+TEST_F(TEST_CASE_NAME, roundTrip)
+{
+	ASSERT_TRUE(m_engine->isInitialized());
+
+	gkBlendLoader& loader = gkBlendLoader::getSingleton();
+	ASSERT_TRUE(loader.cookFile(PACKAGE_SOURCE, PACKAGE_COOKED));
+
+	gkBlendFile* ref = loader.loadFile(PACKAGE_SOURCE, gkBlendLoader::LO_ALL_SCENES | gkBlendLoader::LO_CREATE_UNIQUE_GROUP);
+	gkBlendFile* cooked = loader.loadFile(PACKAGE_COOKED, gkBlendLoader::LO_ALL_SCENES | gkBlendLoader::LO_CREATE_UNIQUE_GROUP);
+	ASSERT_TRUE(ref && cooked);
+	ASSERT_TRUE(cooked->getPackage() != 0);
+
+	gkBlendFile::Scenes& sref = ref->getScenes();
+	gkBlendFile::Scenes& scooked = cooked->getScenes();
+	ASSERT_GT(sref.size(), 0);
+	ASSERT_EQ(sref.size(), scooked.size());
+
+	for (UTsize i = 0; i < sref.size(); ++i)
+	{
+		gkScene* sa = sref[i];
+		gkScene* sb = 0;
+		for (UTsize j = 0; j < scooked.size() && !sb; ++j)
+		{
+			if (scooked[j]->getName() == sa->getName())
+				sb = scooked[j];
+		}
+		ASSERT_TRUE(sb != 0) << sa->getName();
+
+		// not converted from the embedded .blend
+		EXPECT_TRUE(cooked->getPackage()->hasScene(sa->getName()));
+
+		gkGameObjectHashMap& oa = sa->getObjects();
+		gkGameObjectHashMap& ob = sb->getObjects();
+		ASSERT_EQ(oa.size(), ob.size());
+
+		for (UTsize k = 0; k < oa.size(); ++k)
+		{
+			UTsize pos = ob.find(oa.keyAt(k));
+			ASSERT_NE(pos, UT_NPOS) << oa.keyAt(k).str();
+
+			SCOPED_TRACE(oa.keyAt(k).str());
+			packageTestObject(sa, oa.at(k), sb, ob.at(pos));
+		}
+	}
+
+	loader.unloadFile(cooked);
+	loader.unloadFile(ref);
+}